@@ -44,6 +44,8 @@ public:
     DirectX::XMFLOAT3 GetPosition() const { return _position; }
     DirectX::XMFLOAT4X4 GetView() const { return viewMatrix; }
     DirectX::XMFLOAT4X4 GetProjection() const { return projMatrix; }
+    float GetNearClip() const { return nearClip; }
+    float GetFarClip() const { return farClip; }
 
 private:
     // Camera matrices
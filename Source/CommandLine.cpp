@@ -0,0 +1,65 @@
+#include "CommandLine.hpp"
+#include <string.h>
+
+std::vector<std::string> CommandLine::_arguments;
+
+// Gets every argument
+const std::vector<std::string>& CommandLine::GetArguments()
+{
+    return _arguments;
+}
+
+// Checks to see if the given flag was passed
+bool CommandLine::HasFlag( const std::string& flag )
+{
+    for ( auto& argument : _arguments )
+    {
+        if ( 0 == _stricmp( argument.c_str(), flag.c_str() ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits the given command line into arguments
+void CommandLine::Initialize( const char* commandLine )
+{
+    _arguments.clear();
+    if ( !commandLine )
+    {
+        return;
+    }
+
+    std::string argument;
+    bool isQuoted = false;
+    bool hasArgument = false;
+    for ( const char* current = commandLine; *current; ++current )
+    {
+        char c = *current;
+        if ( c == '"' )
+        {
+            isQuoted = !isQuoted;
+            hasArgument = true;
+        }
+        else if ( !isQuoted && ( c == ' ' || c == '\t' ) )
+        {
+            if ( hasArgument )
+            {
+                _arguments.push_back( argument );
+                argument.clear();
+                hasArgument = false;
+            }
+        }
+        else
+        {
+            argument += c;
+            hasArgument = true;
+        }
+    }
+
+    if ( hasArgument )
+    {
+        _arguments.push_back( argument );
+    }
+}
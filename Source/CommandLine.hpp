@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Config.hpp"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines the static command line, split into arguments.
+/// </summary>
+class CommandLine
+{
+    ImplementStaticClass( CommandLine );
+
+    static std::vector<std::string> _arguments;
+
+public:
+    /// <summary>
+    /// Gets every argument the program was started with.
+    /// </summary>
+    static const std::vector<std::string>& GetArguments();
+
+    /// <summary>
+    /// Checks to see if the given flag was passed (case-insensitively).
+    /// </summary>
+    /// <param name="flag">The flag, such as "-benchmark-particles".</param>
+    static bool HasFlag( const std::string& flag );
+
+    /// <summary>
+    /// Splits the given command line into arguments. Arguments are separated by whitespace, and may be quoted.
+    /// </summary>
+    /// <param name="commandLine">The command line, without the program name.</param>
+    static void Initialize( const char* commandLine );
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Camera.hpp"
+#include "Light.hpp"
 
 #include "Rigidbody.hpp"
 #include "BoxCollider.hpp"
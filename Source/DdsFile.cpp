@@ -0,0 +1,371 @@
+#include "DdsFile.hpp"
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+// Builds a four character code
+#define MakeFourCC(a, b, c, d) \
+    ( static_cast<UINT>( a ) | ( static_cast<UINT>( b ) << 8 ) | ( static_cast<UINT>( c ) << 16 ) | ( static_cast<UINT>( d ) << 24 ) )
+
+static const UINT DdsMagic            = MakeFourCC( 'D', 'D', 'S', ' ' );
+static const UINT DdsFlagCaps         = 0x00000001;
+static const UINT DdsFlagHeight       = 0x00000002;
+static const UINT DdsFlagWidth        = 0x00000004;
+static const UINT DdsFlagPixelFormat  = 0x00001000;
+static const UINT DdsFlagMipMapCount  = 0x00020000;
+static const UINT DdsFlagLinearSize   = 0x00080000;
+static const UINT DdsPixelFourCC      = 0x00000004;
+static const UINT DdsCapsComplex      = 0x00000008;
+static const UINT DdsCapsTexture      = 0x00001000;
+static const UINT DdsCapsMipMap       = 0x00400000;
+static const UINT DdsDimensionTexture2D = 3;
+
+/// <summary>
+/// Defines a DDS pixel format.
+/// </summary>
+struct DdsPixelFormat
+{
+    UINT Size;
+    UINT Flags;
+    UINT FourCC;
+    UINT RGBBitCount;
+    UINT RBitMask;
+    UINT GBitMask;
+    UINT BBitMask;
+    UINT ABitMask;
+};
+
+/// <summary>
+/// Defines the header that follows the magic number of a DDS file.
+/// </summary>
+struct DdsHeader
+{
+    UINT Size;
+    UINT Flags;
+    UINT Height;
+    UINT Width;
+    UINT PitchOrLinearSize;
+    UINT Depth;
+    UINT MipMapCount;
+    UINT Reserved1[ 11 ];
+    DdsPixelFormat PixelFormat;
+    UINT Caps;
+    UINT Caps2;
+    UINT Caps3;
+    UINT Caps4;
+    UINT Reserved2;
+};
+
+/// <summary>
+/// Defines the extended header DDS files use for DXGI formats.
+/// </summary>
+struct DdsHeaderDX10
+{
+    UINT Format;
+    UINT ResourceDimension;
+    UINT MiscFlag;
+    UINT ArraySize;
+    UINT MiscFlags2;
+};
+
+// Gets the format a legacy four character code describes
+static DXGI_FORMAT GetFormatFromFourCC( UINT fourCC )
+{
+    if ( fourCC == MakeFourCC( 'D', 'X', 'T', '1' ) ) return DXGI_FORMAT_BC1_UNORM;
+    if ( fourCC == MakeFourCC( 'D', 'X', 'T', '5' ) ) return DXGI_FORMAT_BC3_UNORM;
+    if ( fourCC == MakeFourCC( 'A', 'T', 'I', '2' ) ) return DXGI_FORMAT_BC5_UNORM;
+    if ( fourCC == MakeFourCC( 'B', 'C', '5', 'U' ) ) return DXGI_FORMAT_BC5_UNORM;
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+// Gets the size of one side of a mip level
+static unsigned int GetLevelDimension( unsigned int size, unsigned int level )
+{
+    return std::max( size >> level, 1U );
+}
+
+// Creates a new DDS file
+DdsFile::DdsFile()
+    : _width( 0 )
+    , _height( 0 )
+    , _format( DXGI_FORMAT_UNKNOWN )
+{
+}
+
+// Destroys this DDS file
+DdsFile::~DdsFile()
+{
+    _width = 0;
+    _height = 0;
+}
+
+// Adds the next mip level
+bool DdsFile::AddLevel( const void* data, size_t size )
+{
+    unsigned int level = GetLevelCount();
+    unsigned int blocksHigh = ( GetLevelDimension( _height, level ) + 3 ) / 4;
+    if ( _format == DXGI_FORMAT_UNKNOWN || size != GetRowPitch( level ) * blocksHigh )
+    {
+        return false;
+    }
+
+    _levelOffsets.push_back( _data.size() );
+    _data.insert( _data.end(), static_cast<const unsigned char*>( data ), static_cast<const unsigned char*>( data ) + size );
+    return true;
+}
+
+// Gets the size of a block
+unsigned int DdsFile::GetBlockSize( DXGI_FORMAT format )
+{
+    switch ( format )
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return 8;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// Gets the format
+DXGI_FORMAT DdsFile::GetFormat() const
+{
+    return _format;
+}
+
+// Gets the height
+unsigned int DdsFile::GetHeight() const
+{
+    return _height;
+}
+
+// Gets a mip level's data
+const unsigned char* DdsFile::GetLevelData( unsigned int level ) const
+{
+    return &_data[ _levelOffsets[ level ] ];
+}
+
+// Gets a mip level's size
+size_t DdsFile::GetLevelSize( unsigned int level ) const
+{
+    size_t end = ( level + 1 < _levelOffsets.size() ) ? _levelOffsets[ level + 1 ] : _data.size();
+    return end - _levelOffsets[ level ];
+}
+
+// Gets the number of mip levels
+unsigned int DdsFile::GetLevelCount() const
+{
+    return static_cast<unsigned int>( _levelOffsets.size() );
+}
+
+// Gets the row pitch of a mip level
+unsigned int DdsFile::GetRowPitch( unsigned int level ) const
+{
+    return ( ( GetLevelDimension( _width, level ) + 3 ) / 4 ) * GetBlockSize( _format );
+}
+
+// Gets the width
+unsigned int DdsFile::GetWidth() const
+{
+    return _width;
+}
+
+// Checks to see if a mip level can be the top level of a block-compressed texture
+bool DdsFile::IsBlockAligned( unsigned int width, unsigned int height )
+{
+    return width != 0 && height != 0 && ( width % 4 ) == 0 && ( height % 4 ) == 0;
+}
+
+// Attempts to load a DDS file
+bool DdsFile::LoadFromFile( const std::string& fname, unsigned int firstLevel )
+{
+    _data.clear();
+    _levelOffsets.clear();
+
+    std::ifstream file( fname, std::ios::in | std::ios::binary );
+    if ( !file.is_open() )
+    {
+        return false;
+    }
+
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int levelCount = 0;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    if ( !ReadHeader( file, width, height, format, levelCount ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "'" << fname << "' is not a block-aligned BC1, BC3 or BC5 texture." << std::endl;
+#endif
+        return false;
+    }
+
+    // Skip over the levels that weren't asked for
+    firstLevel = std::min( firstLevel, levelCount - 1 );
+    Reset( width, height, format );
+    std::streamoff skipped = 0;
+    for ( unsigned int index = 0; index < firstLevel; ++index )
+    {
+        skipped += GetRowPitch( index ) * ( ( GetLevelDimension( height, index ) + 3 ) / 4 );
+    }
+    file.seekg( skipped, std::ios::cur );
+    if ( !Reset( GetLevelDimension( width, firstLevel ), GetLevelDimension( height, firstLevel ), format ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Mip level " << firstLevel << " of '" << fname << "' is not a whole number of blocks." << std::endl;
+#endif
+        return false;
+    }
+
+    // Read each of the remaining mip levels
+    std::vector<unsigned char> level;
+    for ( unsigned int index = 0; index < levelCount - firstLevel; ++index )
+    {
+        level.resize( GetRowPitch( index ) * ( ( GetLevelDimension( _height, index ) + 3 ) / 4 ) );
+        file.read( reinterpret_cast<char*>( &level[ 0 ] ), level.size() );
+        if ( !file || !AddLevel( &level[ 0 ], level.size() ) )
+        {
+#if defined( _DEBUG ) || defined( DEBUG )
+            std::cout << "'" << fname << "' is missing mip level " << ( firstLevel + index ) << "." << std::endl;
+#endif
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Reads and checks a DDS file's headers
+bool DdsFile::ReadHeader( std::istream& file, unsigned int& width, unsigned int& height, DXGI_FORMAT& format, unsigned int& levelCount )
+{
+    UINT magic = 0;
+    DdsHeader header;
+    file.read( reinterpret_cast<char*>( &magic ), sizeof( magic ) );
+    file.read( reinterpret_cast<char*>( &header ), sizeof( header ) );
+    if ( !file || magic != DdsMagic || header.Size != sizeof( DdsHeader ) || !( header.PixelFormat.Flags & DdsPixelFourCC ) )
+    {
+        return false;
+    }
+
+    format = GetFormatFromFourCC( header.PixelFormat.FourCC );
+    if ( header.PixelFormat.FourCC == MakeFourCC( 'D', 'X', '1', '0' ) )
+    {
+        DdsHeaderDX10 extension;
+        file.read( reinterpret_cast<char*>( &extension ), sizeof( extension ) );
+        if ( !file || extension.ResourceDimension != DdsDimensionTexture2D || extension.ArraySize != 1 )
+        {
+            return false;
+        }
+        format = static_cast<DXGI_FORMAT>( extension.Format );
+    }
+
+    width = header.Width;
+    height = header.Height;
+    levelCount = std::max( header.MipMapCount, 1U );
+    if ( GetBlockSize( format ) == 0 || !IsBlockAligned( width, height ) )
+    {
+        return false;
+    }
+
+    // A full mip chain halves the larger side down to 1, so anything claiming more levels is broken
+    unsigned int maxLevelCount = 1;
+    for ( unsigned int size = std::max( width, height ); size > 1; size >>= 1 )
+    {
+        ++maxLevelCount;
+    }
+    return levelCount <= maxLevelCount;
+}
+
+// Reads the size and format of the texture in a DDS file
+bool DdsFile::ReadInfo( const std::string& fname, unsigned int& width, unsigned int& height, DXGI_FORMAT& format, unsigned int& levelCount )
+{
+    std::ifstream file( fname, std::ios::in | std::ios::binary );
+    if ( !file.is_open() )
+    {
+        return false;
+    }
+    return ReadHeader( file, width, height, format, levelCount );
+}
+
+// Clears this file and sets its size and format
+bool DdsFile::Reset( unsigned int width, unsigned int height, DXGI_FORMAT format )
+{
+    _data.clear();
+    _levelOffsets.clear();
+    _width = width;
+    _height = height;
+    _format = format;
+
+    if ( GetBlockSize( format ) == 0 || !IsBlockAligned( width, height ) )
+    {
+        _format = DXGI_FORMAT_UNKNOWN;
+        return false;
+    }
+    return true;
+}
+
+// Attempts to save this file
+bool DdsFile::Save( const std::string& fname ) const
+{
+    if ( _levelOffsets.empty() )
+    {
+        return false;
+    }
+
+    // BC1 and BC3 are written with their legacy codes so that any DDS viewer can open them
+    DdsHeader header;
+    ZeroMemory( &header, sizeof( header ) );
+    header.Size = sizeof( DdsHeader );
+    header.Flags = DdsFlagCaps | DdsFlagHeight | DdsFlagWidth | DdsFlagPixelFormat | DdsFlagMipMapCount | DdsFlagLinearSize;
+    header.Height = _height;
+    header.Width = _width;
+    header.PitchOrLinearSize = static_cast<UINT>( GetLevelSize( 0 ) );
+    header.MipMapCount = GetLevelCount();
+    header.PixelFormat.Size = sizeof( DdsPixelFormat );
+    header.PixelFormat.Flags = DdsPixelFourCC;
+    header.Caps = DdsCapsTexture | ( GetLevelCount() > 1 ? DdsCapsComplex | DdsCapsMipMap : 0 );
+
+    DdsHeaderDX10 extension;
+    ZeroMemory( &extension, sizeof( extension ) );
+    bool isExtended = false;
+    switch ( _format )
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+            header.PixelFormat.FourCC = MakeFourCC( 'D', 'X', 'T', '1' );
+            break;
+        case DXGI_FORMAT_BC3_UNORM:
+            header.PixelFormat.FourCC = MakeFourCC( 'D', 'X', 'T', '5' );
+            break;
+        default:
+            header.PixelFormat.FourCC = MakeFourCC( 'D', 'X', '1', '0' );
+            extension.Format = _format;
+            extension.ResourceDimension = DdsDimensionTexture2D;
+            extension.ArraySize = 1;
+            isExtended = true;
+            break;
+    }
+
+    // Now write everything out
+    std::ofstream file( fname, std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !file.is_open() )
+    {
+        return false;
+    }
+
+    file.write( reinterpret_cast<const char*>( &DdsMagic ), sizeof( DdsMagic ) );
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    if ( isExtended )
+    {
+        file.write( reinterpret_cast<const char*>( &extension ), sizeof( extension ) );
+    }
+    file.write( reinterpret_cast<const char*>( &_data[ 0 ] ), _data.size() );
+
+    return static_cast<bool>( file );
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include <istream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines a DDS file holding a block-compressed 2D texture and its mip chain.
+/// </summary>
+class DdsFile
+{
+    ImplementNonCopyableClass( DdsFile );
+    ImplementNonMovableClass( DdsFile );
+
+    std::vector<unsigned char> _data;
+    std::vector<size_t> _levelOffsets;
+    unsigned int _width;
+    unsigned int _height;
+    DXGI_FORMAT _format;
+
+    /// <summary>
+    /// Reads and checks a DDS file's headers.
+    /// </summary>
+    /// <param name="file">The file, positioned at its start.</param>
+    /// <param name="width">Receives the width of the top mip level.</param>
+    /// <param name="height">Receives the height of the top mip level.</param>
+    /// <param name="format">Receives the format.</param>
+    /// <param name="levelCount">Receives the number of mip levels.</param>
+    static bool ReadHeader( std::istream& file, unsigned int& width, unsigned int& height, DXGI_FORMAT& format, unsigned int& levelCount );
+
+public:
+    /// <summary>
+    /// Creates a new, empty DDS file.
+    /// </summary>
+    DdsFile();
+
+    /// <summary>
+    /// Destroys this DDS file.
+    /// </summary>
+    ~DdsFile();
+
+    /// <summary>
+    /// Gets the number of bytes in one 4x4 block of the given format, or 0 if the format is not supported.
+    /// </summary>
+    /// <param name="format">The format.</param>
+    static unsigned int GetBlockSize( DXGI_FORMAT format );
+
+    /// <summary>
+    /// Gets the number of bytes in one row of blocks of the given mip level.
+    /// </summary>
+    /// <param name="level">The mip level.</param>
+    unsigned int GetRowPitch( unsigned int level ) const;
+
+    /// <summary>
+    /// Gets the format of this file's texture.
+    /// </summary>
+    DXGI_FORMAT GetFormat() const;
+
+    /// <summary>
+    /// Gets the height of this file's top mip level.
+    /// </summary>
+    unsigned int GetHeight() const;
+
+    /// <summary>
+    /// Gets the data of the given mip level.
+    /// </summary>
+    /// <param name="level">The mip level.</param>
+    const unsigned char* GetLevelData( unsigned int level ) const;
+
+    /// <summary>
+    /// Gets the number of bytes in the given mip level.
+    /// </summary>
+    /// <param name="level">The mip level.</param>
+    size_t GetLevelSize( unsigned int level ) const;
+
+    /// <summary>
+    /// Gets the number of mip levels in this file.
+    /// </summary>
+    unsigned int GetLevelCount() const;
+
+    /// <summary>
+    /// Gets the width of this file's top mip level.
+    /// </summary>
+    unsigned int GetWidth() const;
+
+    /// <summary>
+    /// Adds the next mip level. Levels must be added from largest to smallest.
+    /// </summary>
+    /// <param name="data">The level's blocks.</param>
+    /// <param name="size">The number of bytes of block data.</param>
+    bool AddLevel( const void* data, size_t size );
+
+    /// <summary>
+    /// Checks to see if a mip level of the given size can be the top level of a block-compressed
+    /// texture. D3D11 only accepts a top level that is a whole number of 4x4 blocks.
+    /// </summary>
+    /// <param name="width">The level's width.</param>
+    /// <param name="height">The level's height.</param>
+    static bool IsBlockAligned( unsigned int width, unsigned int height );
+
+    /// <summary>
+    /// Attempts to load a BC1, BC3 or BC5 texture from the given file.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    /// <param name="firstLevel">The first mip level to load. Larger levels are skipped, and this level becomes level 0, so it must be block aligned.</param>
+    bool LoadFromFile( const std::string& fname, unsigned int firstLevel = 0 );
+
+    /// <summary>
+    /// Reads the size, format and mip count of the texture in the given file without loading it.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    /// <param name="width">Receives the width of the top mip level.</param>
+    /// <param name="height">Receives the height of the top mip level.</param>
+    /// <param name="format">Receives the format.</param>
+    /// <param name="levelCount">Receives the number of mip levels.</param>
+    static bool ReadInfo( const std::string& fname, unsigned int& width, unsigned int& height, DXGI_FORMAT& format, unsigned int& levelCount );
+
+    /// <summary>
+    /// Clears this file and sets the size and format of the texture it will hold. The size must be block aligned.
+    /// </summary>
+    /// <param name="width">The width of the top mip level.</param>
+    /// <param name="height">The height of the top mip level.</param>
+    /// <param name="format">The block-compressed format.</param>
+    bool Reset( unsigned int width, unsigned int height, DXGI_FORMAT format );
+
+    /// <summary>
+    /// Attempts to save this file.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    bool Save( const std::string& fname ) const;
+};
@@ -1,30 +1,46 @@
 #include "DefaultMaterial.hpp"
 #include "Camera.hpp"
 #include "GameObject.hpp"
-#include <DirectXTK/WICTextureLoader.h>
+#include "Mesh.hpp"
+#include "TextureStreamer.hpp"
+#include <algorithm>
 #include <assert.h>
 
+std::weak_ptr<MaterialTemplate> DefaultMaterial::DefaultTemplate;
+
 // Create a new default material
 DefaultMaterial::DefaultMaterial( GameObject* gameObject )
     : Material( gameObject )
     , _diffuseMap( nullptr )
     , _normalMap( nullptr )
-    , _samplerState( nullptr )
     , _ambientColor( 0.4f, 0.4f, 0.4f, 1.0f )
     , _useNormalMap( false )
 {
-    // Create our default sampler state
-    CreateSamplerState( &_samplerState, D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_TEXTURE_ADDRESS_WRAP, 1, 0, D3D11_FLOAT32_MAX );
-
-    // Load the default vertex and pixel shaders
-    assert( _vertexShader->LoadShaderFile( L"Shaders\\DefaultVertexShader.cso" ) );
-    assert( _pixelShader->LoadShaderFile( L"Shaders\\DefaultPixelShader.cso" ) );
+    // Every default material shares one template, which only the first one has to create
+    _template = DefaultTemplate.lock();
+    if ( !_template )
+    {
+        _template = std::make_shared<MaterialTemplate>( _device, _deviceContext );
+        bool isLoaded = _template->LoadShaders( L"Shaders\\DefaultVertexShader.cso",
+                                                L"Shaders\\DefaultCompactVertexShader.cso",
+                                                L"Shaders\\DefaultPixelShader.cso" );
+        assert( isLoaded && "Failed to load the default material's shaders!" );
+
+        _template->AddSamplerState( "TextureSampler", D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_TEXTURE_ADDRESS_WRAP, 1, 0, D3D11_FLOAT32_MAX );
+        _template->AddTextureSlot( "DiffuseMap" );
+        _template->AddTextureSlot( "NormalMap" );
+        _template->SetDefaultParameter( "AmbientColor", &_ambientColor, sizeof( DirectX::XMFLOAT4 ) );
+
+        DefaultTemplate = _template;
+    }
+
+    _vertexShader = _template->GetVertexShader( VertexFormat::Standard );
+    _pixelShader = _template->GetPixelShader();
 }
 
 // Destroy this default material
 DefaultMaterial::~DefaultMaterial()
 {
-    ReleaseMacro( _samplerState );
     _useNormalMap = false;
 }
 
@@ -34,6 +50,38 @@ DirectX::XMFLOAT4 DefaultMaterial::GetAmbientColor() const
     return _ambientColor;
 }
 
+// Gets the parameter block for this material
+MaterialParameterBlock& DefaultMaterial::GetParameterBlock()
+{
+    if ( !_parameterBlock )
+    {
+        std::vector<std::shared_ptr<Texture2D>> textures;
+        textures.push_back( _diffuseMap );
+        textures.push_back( _normalMap );
+        _parameterBlock = _template->GetParameterBlock( _overrides, textures );
+    }
+    return *_parameterBlock;
+}
+
+// Gets the number of shared parameter blocks
+size_t DefaultMaterial::GetParameterBlockCount()
+{
+    std::shared_ptr<MaterialTemplate> materialTemplate = DefaultTemplate.lock();
+    return materialTemplate ? materialTemplate->GetBlockCount() : 0;
+}
+
+// Gets the pipeline state this material draws with
+const PipelineState& DefaultMaterial::GetPipelineState() const
+{
+    return _template->GetPipelineState();
+}
+
+// Gets the key to sort this material's draws by
+UINT64 DefaultMaterial::GetSortKey()
+{
+    return ( static_cast<UINT64>( _template->GetId() ) << 32 ) | GetParameterBlock().GetId();
+}
+
 // Check if we use the normal map
 bool DefaultMaterial::UsesNormalMap() const
 {
@@ -46,7 +94,8 @@ bool DefaultMaterial::LoadDiffuseMap( const std::string& fname )
     ID3D11Device* device = _gameObject->GetDevice();
     ID3D11DeviceContext* deviceContext = _gameObject->GetDeviceContext();
 
-    _diffuseMap = Texture2D::FromFile( device, deviceContext, fname );
+    _diffuseMap = Texture2D::FromFile( device, deviceContext, fname, true );
+    _parameterBlock.reset();
 
     return static_cast<bool>( _diffuseMap );
 }
@@ -57,16 +106,67 @@ bool DefaultMaterial::LoadNormalMap( const std::string& fname )
     ID3D11Device* device = _gameObject->GetDevice();
     ID3D11DeviceContext* deviceContext = _gameObject->GetDeviceContext();
 
-    _normalMap = Texture2D::FromFile( device, deviceContext, fname );
-    _useNormalMap = static_cast<bool>( _diffuseMap );
+    _normalMap = Texture2D::FromFile( device, deviceContext, fname, true );
+    UseNormalMap( static_cast<bool>( _normalMap ) );
 
     return _useNormalMap;
 }
 
+// Pass the screen size on to the texture streamer
+void DefaultMaterial::RequestTextureResolution( float screenSize )
+{
+    if ( _diffuseMap ) TextureStreamer::RequestScreenSize( _diffuseMap.get(), screenSize );
+    if ( _normalMap  ) TextureStreamer::RequestScreenSize( _normalMap.get(), screenSize );
+}
+
+// Switch to the vertex shader for a mesh
+void DefaultMaterial::SelectVertexShader( const Mesh& mesh )
+{
+    _vertexShader = _template->GetVertexShader( mesh.GetVertexFormat() );
+    if ( mesh.GetVertexFormat() == VertexFormat::Compact )
+    {
+        _vertexShader->SetFloat3( "PositionOffset", mesh.GetPositionOffset() );
+        _vertexShader->SetFloat3( "PositionScale", mesh.GetPositionScale() );
+    }
+}
+
 // Set the first test light
 void DefaultMaterial::SetDirectionalLight( const DirectionalLight& light )
 {
-    assert( _pixelShader->SetData( "Light", &light, sizeof( DirectionalLight ) ) );
+    SetParameter( "Light", &light, sizeof( DirectionalLight ) );
+}
+
+// Sets one of this material's parameters
+bool DefaultMaterial::SetParameter( const std::string& name, const void* data, unsigned int size )
+{
+    unsigned int offset = 0;
+    unsigned int parameterSize = 0;
+    if ( !_template->FindParameter( name, offset, parameterSize ) )
+    {
+        return false;
+    }
+
+    // Replace the override if we already have one for this parameter
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    std::vector<unsigned char> value( bytes, bytes + std::min( size, parameterSize ) );
+    auto search = std::find_if( _overrides.begin(), _overrides.end(), [ offset ]( const MaterialParameter& parameter )
+    {
+        return parameter.Offset == offset;
+    } );
+    if ( search != _overrides.end() )
+    {
+        search->Data = value;
+    }
+    else
+    {
+        MaterialParameter parameter;
+        parameter.Offset = offset;
+        parameter.Data = value;
+        _overrides.push_back( parameter );
+    }
+
+    _parameterBlock.reset();
+    return true;
 }
 
 // Send shader data
@@ -75,14 +175,10 @@ void DefaultMaterial::UpdateShaderData()
     // Apply the camera
     Camera* activeCamera = Camera::GetActiveCamera();
     ApplyCamera( activeCamera );
-    assert( _pixelShader->SetFloat3( "CameraPosition", activeCamera->GetPosition() ) );
+    _vertexShader->SetFloat3( "CameraPosition", activeCamera->GetPosition() );
 
-    // Send stuff
-    if ( _diffuseMap ) assert( _pixelShader->SetShaderResourceView( "DiffuseMap", _diffuseMap->GetShaderResourceView() ) );
-    if ( _normalMap  ) assert( _pixelShader->SetShaderResourceView( "NormalMap", _normalMap->GetShaderResourceView() ) );
-    assert( _pixelShader->SetSamplerState( "TextureSampler", _samplerState ) );
-    assert( _pixelShader->SetFloat4( "AmbientColor", _ambientColor ) );
-    assert( _pixelShader->SetFloat( "UseNormalMap", static_cast<float>( _useNormalMap ) ) );
+    // Bind the parameters and textures we share with every material like us
+    _template->Apply( GetParameterBlock() );
 
     // Perform the base update
     Material::UpdateShaderData();
@@ -92,4 +188,7 @@ void DefaultMaterial::UpdateShaderData()
 void DefaultMaterial::UseNormalMap( bool value )
 {
     _useNormalMap = value;
+
+    float useNormalMap = static_cast<float>( _useNormalMap );
+    SetParameter( "UseNormalMap", &useNormalMap, sizeof( float ) );
 }
@@ -1,21 +1,40 @@
 #pragma once
 
 #include "Material.hpp"
+#include "MaterialTemplate.hpp"
 #include "Texture2D.hpp"
 #include "Shaders\DirectionalLight.hpp"
 #include "Shaders\PointLight.hpp"
 
 /// <summary>
-/// Defines the default material.
+/// Defines the default material. Default materials are instances of one shared template, so each
+/// only keeps the parameters and textures it sets itself.
 /// </summary>
 class DefaultMaterial : public Material
 {
+    static std::weak_ptr<MaterialTemplate> DefaultTemplate;
+
+    std::shared_ptr<MaterialTemplate> _template;
+    std::shared_ptr<MaterialParameterBlock> _parameterBlock;
+    std::vector<MaterialParameter> _overrides;
     DirectX::XMFLOAT4 _ambientColor;
-    ID3D11SamplerState* _samplerState;
     std::shared_ptr<Texture2D> _diffuseMap;
     std::shared_ptr<Texture2D> _normalMap;
     bool _useNormalMap;
 
+    /// <summary>
+    /// Gets the parameter block for this material's parameters and textures, creating it if they've changed.
+    /// </summary>
+    MaterialParameterBlock& GetParameterBlock();
+
+    /// <summary>
+    /// Sets one of this material's parameters instead of using the template's default.
+    /// </summary>
+    /// <param name="name">The name of the parameter.</param>
+    /// <param name="data">The value.</param>
+    /// <param name="size">The size of the value.</param>
+    bool SetParameter( const std::string& name, const void* data, unsigned int size );
+
 public:
     /// <summary>
     /// Creates a new default material.
@@ -33,6 +52,21 @@ public:
     /// </summary>
     DirectX::XMFLOAT4 GetAmbientColor() const;
 
+    /// <summary>
+    /// Gets the pipeline state this material draws with, which its template decides.
+    /// </summary>
+    const PipelineState& GetPipelineState() const override;
+
+    /// <summary>
+    /// Gets the key to sort this material's draws by: its template, then its parameter block.
+    /// </summary>
+    UINT64 GetSortKey() override;
+
+    /// <summary>
+    /// Gets the number of parameter blocks the default materials share between them.
+    /// </summary>
+    static size_t GetParameterBlockCount();
+
     /// <summary>
     /// Checks to see if this material uses the normal map.
     /// </summary>
@@ -50,6 +84,18 @@ public:
     /// <param name="fname">The name of the file to load.</param>
     bool LoadNormalMap( const std::string& fname );
 
+    /// <summary>
+    /// Passes how large this material was drawn on to the texture streamer.
+    /// </summary>
+    /// <param name="screenSize">The size of the surface on screen, in pixels.</param>
+    void RequestTextureResolution( float screenSize ) override;
+
+    /// <summary>
+    /// Switches between the standard and compact vertex shaders to match the given mesh.
+    /// </summary>
+    /// <param name="mesh">The mesh about to be drawn.</param>
+    void SelectVertexShader( const Mesh& mesh ) override;
+
     /// <summary>
     /// Sets the first directional light's value.
     /// </summary>
@@ -10,9 +10,18 @@
 // -------------------------------------------------------------
 
 #include "DirectXGameCore.h"
+#include "CommandLine.hpp"
+#include "FontManager.hpp"
 #include "Input.hpp"
+#include "LightManager.hpp"
+#include "ParticleManager.hpp"
 #include "Physics.hpp"
 #include "RenderManager.hpp"
+#include "ResourceManager.hpp"
+#include "ShaderCache.hpp"
+#include "StateCache.hpp"
+#include "TextureStreamer.hpp"
+#include "ThreadPool.hpp"
 #include "Time.hpp"
 #include <DirectXTK\Keyboard.h>
 #include <DirectXTK\Mouse.h>
@@ -74,6 +83,30 @@ DirectXGameCore::DirectXGameCore(HINSTANCE hInstance)
 // --------------------------------------------------------
 DirectXGameCore::~DirectXGameCore(void)
 {
+    // Stop streaming textures
+    TextureStreamer::Shutdown();
+
+    // Release the particle systems and their buffers
+    ParticleManager::Shutdown();
+
+    // Release the light and cluster buffers
+    LightManager::Shutdown();
+
+    // Release the fonts and FreeType
+    FontManager::Shutdown();
+
+    // Stop the worker threads
+    ThreadPool::Shutdown();
+
+    // Release the cached meshes and textures
+    ResourceManager::Clear();
+
+    // Release the shared shader programs
+    ShaderCache::Clear();
+
+    // Release the shared sampler, blend, depth and rasterizer states
+    StateCache::Clear();
+
     // Release the core DirectX "stuff" we set up
     ReleaseMacro(renderTargetView);
     ReleaseMacro(depthStencilView);
@@ -103,6 +136,12 @@ bool DirectXGameCore::Init()
     if(!InitDirect3D())
         return false;
 
+    // Attempt to start the worker threads
+    if ( !ThreadPool::Initialize() )
+    {
+        return false;
+    }
+
     // Attempt to initialize the physics system
     if ( !Physics::Initialize() )
     {
@@ -121,6 +160,36 @@ bool DirectXGameCore::Init()
         return false;
     }
 
+    // Attempt to initialize the font manager
+    if ( !FontManager::Initialize( device, deviceContext ) )
+    {
+        return false;
+    }
+
+    // Attempt to initialize the particle manager
+    if ( !ParticleManager::Initialize( device, deviceContext ) )
+    {
+        return false;
+    }
+
+    // Simulate particles on the CPU if asked to
+    if ( CommandLine::HasFlag( "-cpu-particles" ) )
+    {
+        ParticleManager::SetBackend( ParticleBackend::Cpu );
+    }
+
+    // Attempt to initialize the light manager
+    if ( !LightManager::Initialize( device, deviceContext ) )
+    {
+        return false;
+    }
+
+    // Attempt to start streaming textures
+    if ( !TextureStreamer::Initialize( device, deviceContext ) )
+    {
+        return false;
+    }
+
     // Everything was set up properly
     return true;
 }
@@ -384,6 +453,14 @@ void DirectXGameCore::CalculateFrameStats()
             << L"FPS: " << fps << L"    " 
             << L"Frame Time: " << mspf << L"ms";
 
+        // Include how many state changes reached the device versus how many were redundant
+        StateTracker* stateTracker = RenderManager::GetStateTracker();
+        if ( stateTracker )
+        {
+            outs << L"    State Calls: " << stateTracker->GetCallsIssued()
+                 << L" (" << stateTracker->GetCallsAvoided() << L" avoided)";
+        }
+
         // Include feature level
         switch(featureLevel)
         {
@@ -7,87 +7,218 @@
 ************************************************************************************/
 
 #include "Font.hpp"
+#include "FontManager.hpp"
+#include "ThreadPool.hpp"
+#include "Utf8.hpp"
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
 #include FT_OUTLINE_H
 #include FT_BITMAP_H
+#include <algorithm>
+#include <math.h>
 #if defined( _DEBUG ) || defined( DEBUG )
 #   include <iostream>
 #endif
 
-// Helper macro for a Font's FreeType library
-#define _myLibrary reinterpret_cast<FT_Library>( _library )
-
 // Helper macro for a Font's FreeType font face
 #define _myFontFace reinterpret_cast<FT_Face>( _fontFace )
 
 // The scale needed for non-bitmap fonts
 static const float KerningScale = 1.0f / ( 1 << 6 );
 
-#pragma region Font Structures
+// The padding left around characters, so that filtering doesn't pollute them with pixels from neighbors
+static const unsigned int GlyphPadding = 1;
 
-// Creates a new glyph
-Font::Glyph::Glyph()
-    : Advance( 0.0f )
+// The size distance field glyphs are generated at, regardless of the size they're drawn at
+static const unsigned int DistanceFieldSize = 48;
+
+// How far (in distance field pixels) the field extends past a glyph's outline
+static const unsigned int DistanceFieldSpread = 6;
+
+// How much larger than the distance field glyphs are rasterized, so that edges land between pixels
+static const unsigned int DistanceFieldOversample = 4;
+
+// Removes the glyph padding from an atlas rectangle
+static UintRect RemovePadding( const UintRect& rect )
 {
+    return UintRect( rect.X + GlyphPadding,
+                     rect.Y + GlyphPadding,
+                     rect.Width  - 2 * GlyphPadding,
+                     rect.Height - 2 * GlyphPadding );
 }
 
-// Destroys this glyph
-Font::Glyph::~Glyph()
+#pragma region Distance Fields
+
+// Defines the offset from a pixel to the closest pixel on the other side of an outline
+struct DistanceOffset
 {
-    Advance = 0.0f;
-}
+    int X;
+    int Y;
 
-// Create a new, empty glyph row
-Font::GlyphRow::GlyphRow()
-    : GlyphRow( 0, 0, 0 )
+    // Gets the squared length of the offset
+    int GetLengthSquared() const
+    {
+        return X * X + Y * Y;
+    }
+};
+
+// Gets whether or not a bitmap pixel is inside the glyph's outline
+static bool IsInsideOutline( const FT_Bitmap& bitmap, int x, int y )
 {
+    if ( x < 0 || y < 0 || x >= static_cast<int>( bitmap.width ) || y >= static_cast<int>( bitmap.rows ) )
+    {
+        return false;
+    }
+
+    const unsigned char* row = bitmap.buffer + y * bitmap.pitch;
+    if ( bitmap.pixel_mode == FT_PIXEL_MODE_MONO )
+    {
+        return ( row[ x / 8 ] & ( 1 << ( 7 - ( x % 8 ) ) ) ) != 0;
+    }
+    return row[ x ] >= 128;
 }
 
-// Create a new glyph row
-Font::GlyphRow::GlyphRow( unsigned int y, unsigned int height, unsigned int width )
-    : Y( y )
-    , Height( height )
-    , Width( width )
+// Compares a pixel's offset against one of its neighbors' offsets
+static inline void CompareOffset( std::vector<DistanceOffset>& grid, int width, int height, int x, int y, int offsetX, int offsetY )
 {
+    int neighborX = x + offsetX;
+    int neighborY = y + offsetY;
+    if ( neighborX < 0 || neighborY < 0 || neighborX >= width || neighborY >= height )
+    {
+        return;
+    }
+
+    DistanceOffset candidate = grid[ neighborX + neighborY * width ];
+    candidate.X += offsetX;
+    candidate.Y += offsetY;
+
+    DistanceOffset& current = grid[ x + y * width ];
+    if ( candidate.GetLengthSquared() < current.GetLengthSquared() )
+    {
+        current = candidate;
+    }
 }
 
-// Destroys this glyph row 
-Font::GlyphRow::~GlyphRow()
+// Propagates offsets over the grid with the 8-point sequential Euclidean distance transform
+static void PropagateOffsets( std::vector<DistanceOffset>& grid, int width, int height )
 {
-    Y = 0;
-    Width = 0;
-    Height = 0;
+    // Top to bottom
+    for ( int y = 0; y < height; ++y )
+    {
+        for ( int x = 0; x < width; ++x )
+        {
+            CompareOffset( grid, width, height, x, y, -1,  0 );
+            CompareOffset( grid, width, height, x, y,  0, -1 );
+            CompareOffset( grid, width, height, x, y, -1, -1 );
+            CompareOffset( grid, width, height, x, y,  1, -1 );
+        }
+        for ( int x = width - 1; x >= 0; --x )
+        {
+            CompareOffset( grid, width, height, x, y,  1,  0 );
+        }
+    }
+
+    // Bottom to top
+    for ( int y = height - 1; y >= 0; --y )
+    {
+        for ( int x = width - 1; x >= 0; --x )
+        {
+            CompareOffset( grid, width, height, x, y,  1,  0 );
+            CompareOffset( grid, width, height, x, y,  0,  1 );
+            CompareOffset( grid, width, height, x, y, -1,  1 );
+            CompareOffset( grid, width, height, x, y,  1,  1 );
+        }
+        for ( int x = 0; x < width; ++x )
+        {
+            CompareOffset( grid, width, height, x, y, -1,  0 );
+        }
+    }
 }
 
-// Create a new glyph page
-Font::GlyphPage::GlyphPage()
-    : NextRowY( 2 )
+// Generates a padded RGBA distance field (stored in alpha, 0.5 on the outline) from an oversampled glyph bitmap
+static void GenerateDistanceField( const FT_Bitmap& bitmap, std::vector<unsigned char>& pixels, unsigned int& fieldWidth, unsigned int& fieldHeight )
 {
+    const int scale  = static_cast<int>( DistanceFieldOversample );
+    const int spread = static_cast<int>( DistanceFieldSpread );
+
+    // The field covers the bitmap plus the spread on every side
+    fieldWidth  = ( bitmap.width + scale - 1 ) / scale + 2 * spread;
+    fieldHeight = ( bitmap.rows  + scale - 1 ) / scale + 2 * spread;
+    const int gridWidth  = fieldWidth  * scale;
+    const int gridHeight = fieldHeight * scale;
+    const int border     = spread * scale;
+
+    // Find the offset to the closest outside pixel from every inside one, and vice versa
+    const DistanceOffset far  = { 0x3FFF, 0x3FFF };
+    const DistanceOffset zero = { 0, 0 };
+    std::vector<DistanceOffset> toOutside( gridWidth * gridHeight );
+    std::vector<DistanceOffset> toInside( gridWidth * gridHeight );
+    for ( int y = 0; y < gridHeight; ++y )
+    {
+        for ( int x = 0; x < gridWidth; ++x )
+        {
+            bool isInside = IsInsideOutline( bitmap, x - border, y - border );
+            toOutside[ x + y * gridWidth ] = isInside ? far : zero;
+            toInside [ x + y * gridWidth ] = isInside ? zero : far;
+        }
+    }
+    PropagateOffsets( toOutside, gridWidth, gridHeight );
+    PropagateOffsets( toInside, gridWidth, gridHeight );
+
+    // Sample the signed distance at the center of each field pixel (the padding stays white, but fully transparent)
+    const unsigned int paddedWidth  = fieldWidth  + 2 * GlyphPadding;
+    const unsigned int paddedHeight = fieldHeight + 2 * GlyphPadding;
+    pixels.assign( paddedWidth * paddedHeight * 4, 255 );
+    for ( std::size_t index = 3; index < pixels.size(); index += 4 )
+    {
+        pixels[ index ] = 0;
+    }
+    for ( unsigned int y = 0; y < fieldHeight; ++y )
+    {
+        for ( unsigned int x = 0; x < fieldWidth; ++x )
+        {
+            int sample = ( x * scale + scale / 2 ) + ( y * scale + scale / 2 ) * gridWidth;
+            float inside   = sqrtf( static_cast<float>( toOutside[ sample ].GetLengthSquared() ) );
+            float outside  = sqrtf( static_cast<float>( toInside[ sample ].GetLengthSquared() ) );
+            float distance = ( inside - outside ) / scale;
+            float value    = 0.5f + 0.5f * distance / spread;
+            value = ( value < 0.0f ) ? 0.0f : ( ( value > 1.0f ) ? 1.0f : value );
+
+            std::size_t index = ( ( x + GlyphPadding ) + ( y + GlyphPadding ) * paddedWidth ) * 4 + 3;
+            pixels[ index ] = static_cast<unsigned char>( value * 255.0f + 0.5f );
+        }
+    }
 }
 
-// Destroy this glyph page
-Font::GlyphPage::~GlyphPage()
+#pragma endregion
+
+#pragma region Font Structures
+
+// Creates a new glyph
+Font::Glyph::Glyph()
+    : Advance( 0.0f )
+    , AtlasEntry( GlyphAtlas::InvalidEntry )
+    , IsLoaded( false )
 {
-    NextRowY = 0;
 }
 
-// Get a normalized rectangle
-FloatRect Font::GlyphPage::GetNormalizedRect( const UintRect& rect )
+// Destroys this glyph
+Font::Glyph::~Glyph()
 {
-    if ( !this->Texture )
-    {
-        return FloatRect( 0, 0, 0, 0 );
-    }
+    Advance = 0.0f;
+}
 
-    float invWidth  = 1.0f / this->Texture->GetWidth();
-    float invHeight = 1.0f / this->Texture->GetHeight();
+// Create a new glyph page
+Font::GlyphPage::GlyphPage()
+    : Size( 0 )
+    , LineSpacing( 0.0f )
+{
+}
 
-    return FloatRect( rect.X * invWidth,
-                      rect.Y * invHeight,
-                      rect.Width * invWidth,
-                      rect.Height * invHeight );
+// Destroy this glyph page
+Font::GlyphPage::~GlyphPage()
+{
 }
 
 #pragma endregion
@@ -95,8 +226,10 @@ FloatRect Font::GlyphPage::GetNormalizedRect( const UintRect& rect )
 // Creates a new, empty font
 Font::Font( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
     : _fontName( "" )
-    , _library( nullptr )
+    , _lastPage( nullptr )
     , _fontFace( nullptr )
+    , _currentSize( 0 )
+    , _isDistanceField( false )
     , _device( nullptr )
     , _deviceContext( nullptr )
 {
@@ -113,176 +246,232 @@ Font::~Font()
     ReleaseMacro( _device );
 }
 
-// Finds a suitable location for a glyph on a page
-UintRect Font::FindGlyphRect( GlyphPage& page, unsigned int width, unsigned int height ) const
+// Get the font family name
+std::string Font::GetFontName() const
+{
+    return _fontName;
+}
+
+// Get the current size
+unsigned int Font::GetCurrentSize() const
 {
-    // First we need to ensure the glyph page has a texture
-    if ( !page.Texture )
+    if ( _fontFace )
     {
-        page.Texture = Texture2D::Create( _device, _deviceContext, 256U, 256U );
+        return _currentSize;
     }
+    return 0;
+}
 
-    // Attempt to find the best-fit row
-    GlyphRow* bestRow   = nullptr;
-    float     bestRatio = 0.0f;
-    for ( auto iter = page.Rows.begin(); iter != page.Rows.end(); ++iter )
-    {
-        float ratio = static_cast<float>( height ) / iter->Height;
+// Disposes of this font
+void Font::Dispose()
+{
+    // Glyphs from the old face are no longer valid
+    _pages.clear();
+    _lastPage = nullptr;
 
-        // Ignore too small or too tall rows
-        if ( ratio < 0.7f || ratio > 1.0f )
-        {
-            continue;
-        }
+    // The font manager owns the face, we just stop using it
+    _fontFace = nullptr;
+    _currentSize = 0;
+}
 
-        // Check if there's enough horizontal space left in the row
-        if ( width > page.Texture->GetWidth() - iter->Width )
-        {
-            continue;
-        }
+// Adds a rasterized glyph to the given page's atlas
+Font::Glyph Font::AddGlyph( GlyphPage& page, const RasterizedGlyph& rasterized )
+{
+    Glyph glyph;
+    glyph.IsLoaded = true;
+    glyph.Advance = rasterized.Advance;
 
-        // Finally, make sure this is the best row
-        if ( ratio >= bestRatio )
-        {
-            bestRow   = &( *iter );
-            bestRatio = ratio;
-        }
+    // Glyphs without any pixels (like spaces) never need the atlas
+    if ( rasterized.Pixels.empty() )
+    {
+        return glyph;
     }
 
-    // If we didn't find a good row, then we need to create a new one that is 10% taller than the glyph
-    if ( !bestRow )
+    // Copy the pixels into the atlas (they are uploaded with everything else on the next flush)
+    GlyphAtlas* atlas = page.Atlas.get();
+    if ( atlas->Add( rasterized.Width, rasterized.Height, &rasterized.Pixels[ 0 ], glyph.AtlasEntry ) )
     {
-        unsigned int rowHeight = height + height / 10;
-        while ( ( page.NextRowY + rowHeight >= page.Texture->GetHeight() ) || ( width >= page.Texture->GetWidth() ) )
-        {
-            // If we don't have enough space, resize the texture
-            unsigned int textureWidth = page.Texture->GetWidth();
-            unsigned int textureHeight = page.Texture->GetHeight();
-            if ( ( textureWidth * 2 <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ) && ( textureHeight * 2 <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ) )
-            {
-                // Load the old texture
-                Image oldTexture;
-                oldTexture.LoadFromTexture( *page.Texture );
-
-                // Create the new texture
-                std::shared_ptr<Texture2D> newTexture = Texture2D::Create( _device, _deviceContext, textureWidth * 2, textureHeight * 2 );
-                newTexture->UpdateArea( 0, 0, oldTexture.GetWidth(), oldTexture.GetHeight(), &( oldTexture._pixels[ 0 ] ) );
-
-                // Update the texture
-                page.Texture = newTexture;
-            }
-            else
-            {
-#if defined( _DEBUG ) || defined( DEBUG )
-                std::cout << "Could not find a suitable location in the font texture; maximum size reached." << std::endl;
-#endif
-                return UintRect( 0, 0, 2, 2 );
-            }
-        }
-
-        // Create and record the row
-        page.Rows.push_back( GlyphRow( page.NextRowY, rowHeight ) );
-        page.NextRowY += rowHeight;
-        bestRow = &page.Rows.back();
+        glyph.Bounds = rasterized.Bounds;
+        glyph.TextureBounds = RemovePadding( atlas->GetRect( glyph.AtlasEntry ) );
     }
 
-    // Get the best-fit rectangle in the row
-    UintRect rect = UintRect( bestRow->Width, bestRow->Y, width, height );
-    bestRow->Width += width;
-
-    return rect;
+    // Don't draw anything for glyphs that didn't fit
+    return glyph;
 }
 
-// Get the font family name
-std::string Font::GetFontName() const
+// Get the generation of the atlas for the given size
+unsigned int Font::GetAtlasGeneration( unsigned int size )
 {
-    return _fontName;
+    return GetPage( size ).Atlas->GetGeneration();
 }
 
-// Get the current size
-unsigned int Font::GetCurrentSize() const
+// Builds the dense kerning table for the given page
+void Font::BuildKerningTable( GlyphPage& page )
 {
-    if ( _fontFace )
+    page.DenseKerning.clear();
+    if ( !FT_HAS_KERNING( _myFontFace ) || !SetFaceSize( page.Size ) )
     {
-        return _myFontFace->size->metrics.x_ppem;
+        return;
     }
-    return 0;
-}
 
-// Disposes of this font
-void Font::Dispose()
-{
-    // Cleanup the font face
-    if ( _fontFace )
+    // Look up every glyph index once
+    FT_UInt indices[ DenseGlyphCount ];
+    for ( unsigned int codepoint = 0; codepoint < DenseGlyphCount; ++codepoint )
     {
-        FT_Done_Face( _myFontFace );
-        _fontFace = nullptr;
+        indices[ codepoint ] = FT_Get_Char_Index( _myFontFace, codepoint );
     }
 
-    // Cleanup the library
-    if ( _library )
+    // Now record the kerning for every pair (we don't need to apply the kerning scale to bitmap fonts)
+    float scale = ( FT_IS_SCALABLE( _myFontFace ) ? KerningScale : 1.0f );
+    page.DenseKerning.resize( DenseGlyphCount * DenseGlyphCount, 0.0f );
+    for ( unsigned int first = 1; first < DenseGlyphCount; ++first )
     {
-        FT_Done_FreeType( _myLibrary );
-        _library = nullptr;
+        if ( indices[ first ] == 0 )
+        {
+            continue;
+        }
+
+        for ( unsigned int second = 1; second < DenseGlyphCount; ++second )
+        {
+            if ( indices[ second ] == 0 )
+            {
+                continue;
+            }
+
+            FT_Vector kerning;
+            if ( 0 == FT_Get_Kerning( _myFontFace, indices[ first ], indices[ second ], FT_KERNING_DEFAULT, &kerning ) )
+            {
+                page.DenseKerning[ first * DenseGlyphCount + second ] = kerning.x * scale;
+            }
+        }
     }
 }
 
-// Get the given character's glyph
-Font::Glyph& Font::GetGlyph( char ch, unsigned int size )
+// Get the given codepoint's glyph on the given page
+Font::Glyph& Font::GetGlyph( GlyphPage& page, unsigned int codepoint )
 {
-    GlyphTable& glyphTable = _pages[ size ].Glyphs;
+    // Basic Latin lives in a flat array, everything else falls back to the hash table
+    Glyph& glyph = ( codepoint < DenseGlyphCount ) ? page.DenseGlyphs[ codepoint ] : page.Glyphs[ codepoint ];
 
-    // If the character already exists
-    auto search = glyphTable.find( ch );
-    if ( search != glyphTable.end() )
+    // Load the glyph the first time it's asked for
+    if ( !glyph.IsLoaded )
     {
-        // Return its glyph
-        return search->second;
+        glyph = LoadGlyph( page, codepoint );
+        return glyph;
     }
-    else
+
+    // Glyphs without any pixels never need the atlas
+    if ( glyph.AtlasEntry == GlyphAtlas::InvalidEntry )
     {
-        // Otherwise we need to add the glyph
-        Glyph glyph = LoadGlyph( ch, size );
-        return glyphTable.insert( std::make_pair( ch, glyph ) ).first->second;
+        return glyph;
     }
+
+    // Otherwise return the glyph if it's still in the atlas (it may have been moved by a repack)
+    if ( page.Atlas->IsResident( glyph.AtlasEntry ) )
+    {
+        page.Atlas->Touch( glyph.AtlasEntry );
+        glyph.TextureBounds = RemovePadding( page.Atlas->GetRect( glyph.AtlasEntry ) );
+        return glyph;
+    }
+
+    // The glyph was evicted, so we need to load it again
+    glyph = LoadGlyph( page, codepoint );
+    return glyph;
 }
 
-// Get the kerning between two characters
-float Font::GetKerning( char first, char second, unsigned int size )
+// Get the given codepoint's glyph
+Font::Glyph& Font::GetGlyph( unsigned int codepoint, unsigned int size )
+{
+    return GetGlyph( GetPage( size ), codepoint );
+}
+
+// Get the kerning between two codepoints on the given page
+float Font::GetKerning( GlyphPage& page, unsigned int first, unsigned int second )
 {
     // If anything is invalid, there's no kerning
-    if ( first == 0 || second == 0 || size == 0 || !_fontFace )
+    if ( first == 0 || second == 0 || !_fontFace )
     {
         return 0.0f;
     }
 
-    if ( FT_HAS_KERNING( _myFontFace ) && SetCurrentSize( size ) )
+    // Basic Latin pairs come straight out of the dense table
+    if ( first < DenseGlyphCount && second < DenseGlyphCount )
     {
-        // Get the characters as indices
-        FT_UInt firstIndex = FT_Get_Char_Index( _myFontFace, first );
-        FT_UInt secondIndex = FT_Get_Char_Index( _myFontFace, second );
+        return page.DenseKerning.empty() ? 0.0f : page.DenseKerning[ first * DenseGlyphCount + second ];
+    }
 
+    // Otherwise check the fallback table before asking FreeType
+    unsigned long long key = ( static_cast<unsigned long long>( first ) << 32 ) | second;
+    auto search = page.Kerning.find( key );
+    if ( search != page.Kerning.end() )
+    {
+        return search->second;
+    }
+
+    float value = 0.0f;
+    if ( FT_HAS_KERNING( _myFontFace ) && SetFaceSize( page.Size ) )
+    {
         // Get the kerning vector
         FT_Vector kerning;
-        FT_Get_Kerning( _myFontFace, firstIndex, secondIndex, FT_KERNING_DEFAULT, &kerning );
-
-        // We don't need to apply the kerning scale to bitmap fonts
-        float scale = ( FT_IS_SCALABLE( _myFontFace ) ? KerningScale : 1.0f );
-        return kerning.x * scale;
+        FT_UInt firstIndex = FT_Get_Char_Index( _myFontFace, first );
+        FT_UInt secondIndex = FT_Get_Char_Index( _myFontFace, second );
+        if ( 0 == FT_Get_Kerning( _myFontFace, firstIndex, secondIndex, FT_KERNING_DEFAULT, &kerning ) )
+        {
+            // We don't need to apply the kerning scale to bitmap fonts
+            float scale = ( FT_IS_SCALABLE( _myFontFace ) ? KerningScale : 1.0f );
+            value = kerning.x * scale;
+        }
     }
 
-    return 0.0f;
+    page.Kerning[ key ] = value;
+    return value;
+}
+
+// Get the kerning between two codepoints
+float Font::GetKerning( unsigned int first, unsigned int second, unsigned int size )
+{
+    if ( size == 0 )
+    {
+        return 0.0f;
+    }
+    return GetKerning( GetPage( size ), first, second );
 }
 
 // Get the spacing between two lines
 float Font::GetLineSpacing( unsigned int size )
 {
-    if ( _fontFace && SetCurrentSize( size ) )
+    return GetPage( size ).LineSpacing;
+}
+
+// Get the glyph page for the given size
+Font::GlyphPage& Font::GetPage( unsigned int size )
+{
+    if ( _isDistanceField )
     {
-        return _myFontFace->size->metrics.height * KerningScale;
+        size = DistanceFieldSize;
     }
 
-    return 0.0f;
+    // Text is almost always laid out a whole string at a time at one size
+    if ( _lastPage && _lastPage->Size == size )
+    {
+        return *_lastPage;
+    }
+
+    GlyphPage& page = _pages[ size ];
+    if ( !page.Atlas )
+    {
+        // Set up everything that only depends on the size once
+        page.Atlas = std::make_shared<GlyphAtlas>( _device, _deviceContext );
+        page.Size = size;
+        if ( _fontFace && SetFaceSize( size ) )
+        {
+            page.LineSpacing = _myFontFace->size->metrics.height * KerningScale;
+            BuildKerningTable( page );
+        }
+    }
+
+    _lastPage = &page;
+    return page;
 }
 
 // Get the texture for the given size
@@ -290,46 +479,67 @@ std::shared_ptr<Texture2D> Font::GetTexture( unsigned int size )
 {
     std::shared_ptr<Texture2D> texture;
 
-    // Find the texture in the glyph page for the given font size
-    auto search = _pages.find( size );
-    if ( search != _pages.end() )
+    // Find the atlas in the glyph page for the given font size
+    auto search = _pages.find( _isDistanceField ? DistanceFieldSize : size );
+    if ( search != _pages.end() && search->second.Atlas )
     {
-        GlyphPage& page = search->second;
-        texture = page.Texture;
-
-        // If the texture doesn't exist, create it
-        if ( !texture )
-        {
-            texture = Texture2D::Create( _device, _deviceContext, 256, 256 );
-            page.Texture = texture;
-        }
+        // Upload every glyph added since the last call before handing out the texture
+        GlyphAtlas* atlas = search->second.Atlas.get();
+        atlas->Flush();
+        texture = atlas->GetTexture();
     }
 
     return texture;
 }
 
-// Load a character glyph
-Font::Glyph Font::LoadGlyph( char ch, unsigned int size )
+// Load a codepoint's glyph
+Font::Glyph Font::LoadGlyph( GlyphPage& page, unsigned int codepoint )
 {
-    Glyph glyph;
+    // Distance field glyphs are rasterized larger than the page and scaled back down
+    const unsigned int oversample = _isDistanceField ? DistanceFieldOversample : 1;
 
     // Ensure we can even retrieve the glyph
-    if ( !_fontFace || !SetCurrentSize( size ) )
+    if ( !_fontFace || !SetFaceSize( page.Size * oversample ) ||
+         !RasterizeGlyph( _fontFace, page.Size, codepoint, _isDistanceField, _rasterizedGlyph ) )
     {
+        Glyph glyph;
+        glyph.IsLoaded = true;
         return glyph;
     }
 
-    // Attempt to load the font's glyph for the given character
-    if ( 0 != FT_Load_Char( _myFontFace, ch, FT_LOAD_TARGET_NORMAL | FT_LOAD_FORCE_AUTOHINT ) )
+    return AddGlyph( page, _rasterizedGlyph );
+}
+
+// Rasterizes a codepoint's glyph with the given face
+bool Font::RasterizeGlyph( void* face, unsigned int size, unsigned int codepoint, bool isDistanceField, RasterizedGlyph& rasterized )
+{
+    FT_Face fontFace = reinterpret_cast<FT_Face>( face );
+
+    rasterized.Advance = 0.0f;
+    rasterized.Bounds  = FloatRect( 0, 0, 0, 0 );
+    rasterized.Width   = 0;
+    rasterized.Height  = 0;
+    rasterized.Pixels.clear();
+
+    // Distance field glyphs are rasterized larger than the page and scaled back down
+    const unsigned int oversample = isDistanceField ? DistanceFieldOversample : 1;
+    const unsigned int pixelSize = size * oversample;
+    if ( fontFace->size->metrics.x_ppem != pixelSize && 0 != FT_Set_Pixel_Sizes( fontFace, 0, pixelSize ) )
     {
-        return glyph;
+        return false;
+    }
+
+    // Attempt to load the font's glyph for the given codepoint
+    if ( 0 != FT_Load_Char( fontFace, codepoint, FT_LOAD_TARGET_NORMAL | FT_LOAD_FORCE_AUTOHINT ) )
+    {
+        return false;
     }
 
     // Get the glyph's description
     FT_Glyph ftGlyph;
-    if ( 0 != FT_Get_Glyph( _myFontFace->glyph, &ftGlyph ) )
+    if ( 0 != FT_Get_Glyph( fontFace->glyph, &ftGlyph ) )
     {
-        return glyph;
+        return false;
     }
 
     // Rasterize the glyph
@@ -337,39 +547,43 @@ Font::Glyph Font::LoadGlyph( char ch, unsigned int size )
     FT_Bitmap& bitmap = reinterpret_cast<FT_BitmapGlyph>( ftGlyph )->bitmap;
 
     // Get the glyph's advance
-    glyph.Advance = static_cast<float>( _myFontFace->glyph->metrics.horiAdvance ) * KerningScale;
+    rasterized.Advance = static_cast<float>( fontFace->glyph->metrics.horiAdvance ) * KerningScale / oversample;
 
     int width = bitmap.width;
     int height = bitmap.rows;
 
-    if ( ( width > 0 ) && ( height > 0 ) )
+    if ( ( width > 0 ) && ( height > 0 ) && isDistanceField )
+    {
+        // Generate the distance field, then place it so that the outline lines up with the bitmap's origin
+        unsigned int fieldWidth  = 0;
+        unsigned int fieldHeight = 0;
+        GenerateDistanceField( bitmap, rasterized.Pixels, fieldWidth, fieldHeight );
+
+        const FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>( ftGlyph );
+        rasterized.Bounds.X      =  static_cast<float>( bitmapGlyph->left ) / oversample - DistanceFieldSpread;
+        rasterized.Bounds.Y      = -static_cast<float>( bitmapGlyph->top  ) / oversample - DistanceFieldSpread;
+        rasterized.Bounds.Width  =  static_cast<float>( fieldWidth  );
+        rasterized.Bounds.Height =  static_cast<float>( fieldHeight );
+        rasterized.Width  = fieldWidth  + 2 * GlyphPadding;
+        rasterized.Height = fieldHeight + 2 * GlyphPadding;
+    }
+    else if ( ( width > 0 ) && ( height > 0 ) )
     {
-        // Get the glyph's page
-        GlyphPage& page = _pages[ size ];
-
-        // Leave a small padding around characters, so that filtering doesn't
-        // pollute them with pixels from neighbors
-        const unsigned int padding = 1;
-        
-        // Find a good position for the new glyph into the texture
-        UintRect emptyArea = FindGlyphRect( page, width + 2 * padding, height + 2 * padding );;
-
-        // Ensure the texture data is in the center of the texture rectangle
-        emptyArea.X += padding;
-        emptyArea.Y += padding;
-        emptyArea.Width -= 2 * padding;
-        emptyArea.Height -= 2 * padding;
-        glyph.TextureBounds = emptyArea;
-
         // Set the glyph's bounding box
-        glyph.Bounds.X      =  ( _myFontFace->glyph->metrics.horiBearingX ) * KerningScale;
-        glyph.Bounds.Y      = -( _myFontFace->glyph->metrics.horiBearingY ) * KerningScale;
-        glyph.Bounds.Width  =  ( _myFontFace->glyph->metrics.width        ) * KerningScale;
-        glyph.Bounds.Height =  ( _myFontFace->glyph->metrics.height       ) * KerningScale;
-
-
-        // Extract the glyph's pixels from the bitmap
-        _pixelBuffer.resize( width * height * 4, 255 );
+        rasterized.Bounds.X      =  ( fontFace->glyph->metrics.horiBearingX ) * KerningScale;
+        rasterized.Bounds.Y      = -( fontFace->glyph->metrics.horiBearingY ) * KerningScale;
+        rasterized.Bounds.Width  =  ( fontFace->glyph->metrics.width        ) * KerningScale;
+        rasterized.Bounds.Height =  ( fontFace->glyph->metrics.height       ) * KerningScale;
+
+        // Extract the glyph's pixels from the bitmap (the padding stays white, but fully transparent)
+        const unsigned int paddedWidth  = width  + 2 * GlyphPadding;
+        const unsigned int paddedHeight = height + 2 * GlyphPadding;
+        std::vector<unsigned char>& buffer = rasterized.Pixels;
+        buffer.assign( paddedWidth * paddedHeight * 4, 255 );
+        for ( std::size_t index = 3; index < buffer.size(); index += 4 )
+        {
+            buffer[ index ] = 0;
+        }
         const unsigned char* pixels = bitmap.buffer;
         if ( bitmap.pixel_mode == FT_PIXEL_MODE_MONO )
         {
@@ -379,8 +593,8 @@ Font::Glyph Font::LoadGlyph( char ch, unsigned int size )
                 for ( int x = 0; x < width; ++x )
                 {
                     // The color channels remain white, just fill the alpha channel
-                    std::size_t index = ( x + y * width ) * 4 + 3;
-                    _pixelBuffer[ index ] = ( ( pixels[ x / 8 ] ) & ( 1 << ( 7 - ( x % 8 ) ) ) ) ? 255 : 0;
+                    std::size_t index = ( ( x + GlyphPadding ) + ( y + GlyphPadding ) * paddedWidth ) * 4 + 3;
+                    buffer[ index ] = ( ( pixels[ x / 8 ] ) & ( 1 << ( 7 - ( x % 8 ) ) ) ) ? 255 : 0;
                 }
                 pixels += bitmap.pitch;
             }
@@ -393,21 +607,27 @@ Font::Glyph Font::LoadGlyph( char ch, unsigned int size )
                 for ( int x = 0; x < width; ++x )
                 {
                     // The color channels remain white, just fill the alpha channel
-                    std::size_t index = ( x + y * width ) * 4 + 3;
-                    _pixelBuffer[ index ] = pixels[ x ];
+                    std::size_t index = ( ( x + GlyphPadding ) + ( y + GlyphPadding ) * paddedWidth ) * 4 + 3;
+                    buffer[ index ] = pixels[ x ];
                 }
                 pixels += bitmap.pitch;
             }
         }
 
-        // Write the pixels to the texture
-        page.Texture->UpdateArea( emptyArea.X, emptyArea.Y, emptyArea.Width, emptyArea.Height, &_pixelBuffer[ 0 ] );
+        rasterized.Width  = paddedWidth;
+        rasterized.Height = paddedHeight;
     }
 
     // Cleanup
     FT_Done_Glyph( ftGlyph );
 
-    return glyph;
+    return true;
+}
+
+// Check if we use distance fields
+bool Font::IsDistanceField() const
+{
+    return _isDistanceField;
 }
 
 // Attempts to load font information from a file
@@ -416,43 +636,124 @@ bool Font::LoadFromFile( const std::string& fname )
     // Remove any loaded information
     Dispose();
 
-    // Attempt to create our FreeType library
-    FT_Library library;
-    if ( 0 != FT_Init_FreeType( &library ) )
+    // Get the font face from the font manager (it's shared with every other font using the same file)
+    FT_Face fontFace = reinterpret_cast<FT_Face>( FontManager::GetFace( fname ) );
+    if ( !fontFace )
     {
-#if defined( _DEBUG ) || defined( DEBUG )
-        std::cout << "Failed to initialize FreeType for '" << fname << "'." << std::endl;
-#endif
-        return false;
-    }
-    _library = library;
-
-    // Attempt to load the font face
-    FT_Face fontFace;
-    if ( 0 != FT_New_Face( library, fname.c_str(), 0, &fontFace ) )
-    {
-#if defined( _DEBUG ) || defined( DEBUG )
-        std::cout << "Failed to create font face for '" << fname << "'." << std::endl;
-#endif
         return false;
     }
     _fontFace = fontFace;
+    _fileName = fname;
 
     // Get the font name
     _fontName = fontFace->family_name ? fontFace->family_name : "N/A";
 
-    // Attempt to select the Unicode character map
-    if ( 0 != FT_Select_Charmap( fontFace, FT_ENCODING_UNICODE ) )
+    // Set our default font size to be 12
+    SetCurrentSize( 12U );
+
+    return true;
+}
+
+// Rasterize the given characters at each of the given sizes ahead of time
+bool Font::Preload( const std::string& characters, const std::vector<unsigned int>& sizes )
+{
+    if ( !_fontFace )
     {
-#if defined( _DEBUG ) || defined( DEBUG )
-        std::cout << "Failed to select unicode font for '" << fname << "'." << std::endl;
-#endif
-        Dispose();
         return false;
     }
 
-    // Set our default font size to be 12
-    SetCurrentSize( 12U );
+    std::vector<unsigned int> codepoints;
+    Utf8::Decode( characters, codepoints );
+
+    // Get each page up front (distance field fonts share one page between every size)
+    std::vector<GlyphPage*> pages;
+    for ( unsigned int size : sizes )
+    {
+        GlyphPage* page = &GetPage( size );
+        if ( std::find( pages.begin(), pages.end(), page ) == pages.end() )
+        {
+            pages.push_back( page );
+        }
+    }
+
+    // Find every glyph that isn't in an atlas yet (pages live in a node-based map, so the pointers stay valid)
+    struct PreloadJob
+    {
+        GlyphPage* Page;
+        unsigned int Codepoint;
+    };
+    std::vector<PreloadJob> jobs;
+    for ( GlyphPage* page : pages )
+    {
+        for ( unsigned int codepoint : codepoints )
+        {
+            Glyph& glyph = ( codepoint < DenseGlyphCount ) ? page->DenseGlyphs[ codepoint ] : page->Glyphs[ codepoint ];
+            bool isResident = glyph.AtlasEntry == GlyphAtlas::InvalidEntry || page->Atlas->IsResident( glyph.AtlasEntry );
+            if ( !glyph.IsLoaded || !isResident )
+            {
+                PreloadJob job = { page, codepoint };
+                jobs.push_back( job );
+            }
+        }
+    }
+    if ( jobs.empty() )
+    {
+        return true;
+    }
+
+    // FreeType faces can't be shared between threads, so each chunk opens its own face over the memory-mapped file
+    std::vector<RasterizedGlyph> rasterized( jobs.size() );
+    const void* fileData = nullptr;
+    size_t fileSize = 0;
+    if ( FontManager::GetFileData( _fileName, fileData, fileSize ) )
+    {
+        bool isDistanceField = _isDistanceField;
+        size_t grainSize = std::max<size_t>( 1, jobs.size() / ( ThreadPool::GetThreadCount() * 2 ) );
+        ThreadPool::ParallelFor( jobs.size(), grainSize, [ & ]( size_t begin, size_t end )
+        {
+            FT_Library library;
+            if ( 0 != FT_Init_FreeType( &library ) )
+            {
+                return;
+            }
+
+            FT_Face face;
+            if ( 0 == FT_New_Memory_Face( library, reinterpret_cast<const FT_Byte*>( fileData ), static_cast<FT_Long>( fileSize ), 0, &face ) )
+            {
+                if ( 0 == FT_Select_Charmap( face, FT_ENCODING_UNICODE ) )
+                {
+                    for ( size_t index = begin; index < end; ++index )
+                    {
+                        RasterizeGlyph( face, jobs[ index ].Page->Size, jobs[ index ].Codepoint, isDistanceField, rasterized[ index ] );
+                    }
+                }
+                FT_Done_Face( face );
+            }
+
+            FT_Done_FreeType( library );
+        } );
+    }
+    else
+    {
+        // Fall back to rasterizing everything here with the shared face
+        for ( size_t index = 0; index < jobs.size(); ++index )
+        {
+            RasterizeGlyph( _fontFace, jobs[ index ].Page->Size, jobs[ index ].Codepoint, _isDistanceField, rasterized[ index ] );
+        }
+    }
+
+    // Now pack every glyph in order, and upload each atlas once
+    for ( size_t index = 0; index < jobs.size(); ++index )
+    {
+        GlyphPage& page = *jobs[ index ].Page;
+        unsigned int codepoint = jobs[ index ].Codepoint;
+        Glyph& glyph = ( codepoint < DenseGlyphCount ) ? page.DenseGlyphs[ codepoint ] : page.Glyphs[ codepoint ];
+        glyph = AddGlyph( page, rasterized[ index ] );
+    }
+    for ( GlyphPage* page : pages )
+    {
+        page->Atlas->Flush();
+    }
 
     return true;
 }
@@ -460,10 +761,20 @@ bool Font::LoadFromFile( const std::string& fname )
 // Set the current font size
 bool Font::SetCurrentSize( unsigned int size )
 {
-    unsigned int currentSize = GetCurrentSize();
+    if ( !_fontFace || !SetFaceSize( size ) )
+    {
+        return false;
+    }
 
-    // Only change the size if necessary
-    if ( currentSize != size )
+    _currentSize = size;
+    return true;
+}
+
+// Set the pixel size of the shared face
+bool Font::SetFaceSize( unsigned int size )
+{
+    // Only change the size if necessary (another font may have changed it since we last used the face)
+    if ( _myFontFace->size->metrics.x_ppem != size )
     {
         FT_Error error = FT_Set_Pixel_Sizes( _myFontFace, 0, size );
 
@@ -486,9 +797,19 @@ bool Font::SetCurrentSize( unsigned int size )
     return true;
 }
 
+// Set whether or not we use distance fields
+void Font::SetDistanceField( bool value )
+{
+    if ( _isDistanceField != value )
+    {
+        _isDistanceField = value;
+        _pages.clear();
+        _lastPage = nullptr;
+    }
+}
+
 // Check if we have valid data
 Font::operator bool() const
 {
-    return ( _fontFace != nullptr )
-        && ( _library != nullptr );
+    return _fontFace != nullptr;
 }
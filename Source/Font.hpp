@@ -9,6 +9,7 @@
  ************************************************************************************/
 
 #include "Config.hpp"
+#include "GlyphAtlas.hpp"
 #include "Rect.hpp"
 #include "Texture2D.hpp"
 #include <string>
@@ -36,6 +37,8 @@ class Font
         float Advance;
         FloatRect Bounds;
         UintRect TextureBounds;
+        unsigned int AtlasEntry;
+        bool IsLoaded;
 
         /// <summary>
         /// Creates an empty glyph.
@@ -49,47 +52,32 @@ class Font
     };
 
     /// <summary>
-    /// Defines a row of glyphs.
+    /// Defines a glyph table, keyed by codepoint.
     /// </summary>
-    struct GlyphRow
-    {
-        unsigned int Y;
-        unsigned int Width;
-        unsigned int Height;
-
-        /// <summary>
-        /// Creates an empty glyph row.
-        /// </summary>
-        GlyphRow();
-
-        /// <summary>
-        /// Creates a new glyph row.
-        /// </summary>
-        /// <param name="y">The initial Y position of the row.</param>
-        /// <param name="width">The initial width of the row.</param>
-        /// <param name="height">The initial height of the row.</param>
-        GlyphRow( unsigned int y, unsigned int height, unsigned int width = 0 );
+    typedef std::unordered_map<unsigned int, Glyph> GlyphTable;
 
-        /// <summary>
-        /// Destroys this glyph row.
-        /// </summary>
-        ~GlyphRow();
-    };
+    /// <summary>
+    /// Defines a kerning table, keyed by both codepoints of a pair.
+    /// </summary>
+    typedef std::unordered_map<unsigned long long, float> KerningTable;
 
     /// <summary>
-    /// Defines a glyph table.
+    /// The number of codepoints (Basic Latin) that get dense glyph and kerning tables.
     /// </summary>
-    typedef std::unordered_map<char, Glyph> GlyphTable;
+    static const unsigned int DenseGlyphCount = 128;
 
     /// <summary>
-    /// Defines a page of glyphs.
+    /// Defines a page of glyphs for a single character size.
     /// </summary>
     struct GlyphPage
     {
+        Glyph DenseGlyphs[ DenseGlyphCount ];
         GlyphTable Glyphs;
-        std::vector<GlyphRow> Rows;
-        std::shared_ptr<Texture2D> Texture;
-        unsigned int NextRowY;
+        std::vector<float> DenseKerning;
+        KerningTable Kerning;
+        std::shared_ptr<GlyphAtlas> Atlas;
+        unsigned int Size;
+        float LineSpacing;
 
         /// <summary>
         /// Creates a new glyph page.
@@ -100,12 +88,6 @@ class Font
         /// Destroys this glyph page.
         /// </summary>
         ~GlyphPage();
-
-        /// <summary>
-        /// Gets the texture coordinate-normalized rectangle version of the given pixel rectangle.
-        /// </summary>
-        /// <param name="rect">The rectangle.</param>
-        FloatRect GetNormalizedRect( const UintRect& rect );
     };
 
     /// <summary>
@@ -113,45 +95,94 @@ class Font
     /// </summary>
     typedef std::unordered_map<unsigned int, GlyphPage> GlyphPageTable;
 
+    /// <summary>
+    /// Defines a glyph that has been rasterized, but not yet added to an atlas.
+    /// </summary>
+    struct RasterizedGlyph
+    {
+        float Advance;
+        FloatRect Bounds;
+        unsigned int Width;
+        unsigned int Height;
+        std::vector<unsigned char> Pixels;
+    };
+
     #pragma endregion
 
 private:
     GlyphPageTable _pages;
-    std::vector<unsigned char> _pixelBuffer;
+    GlyphPage* _lastPage;
+    RasterizedGlyph _rasterizedGlyph;
+    std::string _fileName;
     std::string _fontName;
     ID3D11Device* _device;
     ID3D11DeviceContext* _deviceContext;
-    void* _library;
     void* _fontFace;
+    unsigned int _currentSize;
+    bool _isDistanceField;
 
 private:
     /// <summary>
-    /// Finds a suitable location for a glyph on a glyph page.
+    /// Disposes of this font.
     /// </summary>
-    /// <param name="page">The glyph page to search on.</param>
-    /// <param name="width">The width of the glyph.</param>
-    /// <param name="height">The height of the glyph.</param>
-    UintRect FindGlyphRect( GlyphPage& page, unsigned int width, unsigned int height ) const;
+    void Dispose();
 
     /// <summary>
-    /// Disposes of this font.
+    /// Adds a rasterized glyph to the given page's atlas.
     /// </summary>
-    void Dispose();
+    /// <param name="page">The glyph page.</param>
+    /// <param name="rasterized">The rasterized glyph.</param>
+    Glyph AddGlyph( GlyphPage& page, const RasterizedGlyph& rasterized );
 
     /// <summary>
-    /// Gets the glyph for the given character at the given size.
+    /// Gets the generation of the atlas used for the given font size. Glyphs looked up before the
+    /// generation last changed may have moved or been evicted.
     /// </summary>
-    /// <param name="ch">The character.</param>
     /// <param name="size">The character size.</param>
-    Glyph& GetGlyph( char ch, unsigned int size );
+    unsigned int GetAtlasGeneration( unsigned int size );
 
     /// <summary>
-    /// Gets the kerning between two characters.
+    /// Builds the dense kerning table for the given page.
     /// </summary>
-    /// <param name="first">The first character.</param>
-    /// <param name="second">The second character.</param>
+    /// <param name="page">The glyph page.</param>
+    void BuildKerningTable( GlyphPage& page );
+
+    /// <summary>
+    /// Gets the glyph page for the given size, creating it if necessary. Distance field fonts
+    /// share a single page between every size.
+    /// </summary>
+    /// <param name="size">The character size.</param>
+    GlyphPage& GetPage( unsigned int size );
+
+    /// <summary>
+    /// Gets the glyph for the given codepoint on the given page.
+    /// </summary>
+    /// <param name="page">The glyph page.</param>
+    /// <param name="codepoint">The codepoint.</param>
+    Glyph& GetGlyph( GlyphPage& page, unsigned int codepoint );
+
+    /// <summary>
+    /// Gets the glyph for the given codepoint at the given size.
+    /// </summary>
+    /// <param name="codepoint">The codepoint.</param>
     /// <param name="size">The character size.</param>
-    float GetKerning( char first, char second, unsigned int size );
+    Glyph& GetGlyph( unsigned int codepoint, unsigned int size );
+
+    /// <summary>
+    /// Gets the kerning between two codepoints on the given page.
+    /// </summary>
+    /// <param name="page">The glyph page.</param>
+    /// <param name="first">The first codepoint.</param>
+    /// <param name="second">The second codepoint.</param>
+    float GetKerning( GlyphPage& page, unsigned int first, unsigned int second );
+
+    /// <summary>
+    /// Gets the kerning between two codepoints.
+    /// </summary>
+    /// <param name="first">The first codepoint.</param>
+    /// <param name="second">The second codepoint.</param>
+    /// <param name="size">The character size.</param>
+    float GetKerning( unsigned int first, unsigned int second, unsigned int size );
 
     /// <summary>
     /// Gets the amount of space between two lines of text.
@@ -160,17 +191,35 @@ private:
     float GetLineSpacing( unsigned int size );
 
     /// <summary>
-    /// Gets the texture used for the given font size.
+    /// Gets the texture used for the given font size, uploading any glyphs added since the last call.
     /// </summary>
     /// <param name="size">The character size.</param>
     std::shared_ptr<Texture2D> GetTexture( unsigned int size );
 
     /// <summary>
-    /// Loads the glyph for the given character at the given size.
+    /// Loads the glyph for the given codepoint on the given page.
     /// </summary>
-    /// <param name="ch">The character.</param>
-    /// <param name="size">The character size.</param>
-    Glyph LoadGlyph( char ch, unsigned int size );
+    /// <param name="page">The glyph page.</param>
+    /// <param name="codepoint">The codepoint.</param>
+    Glyph LoadGlyph( GlyphPage& page, unsigned int codepoint );
+
+    /// <summary>
+    /// Rasterizes the glyph for the given codepoint. This only touches the given face, so it is
+    /// safe to call from several threads at once as long as each one has its own face.
+    /// </summary>
+    /// <param name="face">The FreeType face.</param>
+    /// <param name="size">The size of the glyph page.</param>
+    /// <param name="codepoint">The codepoint.</param>
+    /// <param name="isDistanceField">True to generate a distance field.</param>
+    /// <param name="rasterized">The rasterized glyph.</param>
+    static bool RasterizeGlyph( void* face, unsigned int size, unsigned int codepoint, bool isDistanceField, RasterizedGlyph& rasterized );
+
+    /// <summary>
+    /// Sets the pixel size of the face. The face is shared with every other font using the same
+    /// file, so this has to be called before each use of it rather than once per font.
+    /// </summary>
+    /// <param name="size">The pixel size.</param>
+    bool SetFaceSize( unsigned int size );
 
 public:
     /// <summary>
@@ -195,18 +244,39 @@ public:
     /// </summary>
     unsigned int GetCurrentSize() const;
 
+    /// <summary>
+    /// Checks to see if this font renders its glyphs as signed distance fields.
+    /// </summary>
+    bool IsDistanceField() const;
+
     /// <summary>
     /// Attempts to load font information from the given file.
     /// </summary>
     /// <param name="fname">The file name.</param>
     bool LoadFromFile( const std::string& fname );
 
+    /// <summary>
+    /// Rasterizes the glyphs for the given characters at each of the given sizes on every thread,
+    /// then uploads each size's atlas once, so that the first frame to draw them doesn't stall.
+    /// </summary>
+    /// <param name="characters">The UTF-8 encoded characters to load.</param>
+    /// <param name="sizes">The character sizes to load them at.</param>
+    bool Preload( const std::string& characters, const std::vector<unsigned int>& sizes );
+
     /// <summary>
     /// Sets the current size of this font.
     /// </summary>
     /// <param name="size">The new size.</param>
     bool SetCurrentSize( unsigned int size );
 
+    /// <summary>
+    /// Sets whether this font renders its glyphs as signed distance fields. A distance field font
+    /// rasterizes each glyph once and draws it sharply at any size or scale. Changing this discards
+    /// every glyph that has been loaded so far.
+    /// </summary>
+    /// <param name="value">True to use distance fields, false to rasterize each size separately.</param>
+    void SetDistanceField( bool value );
+
     /// <summary>
     /// Checks to see if this font contains valid data.
     /// </summary>
@@ -0,0 +1,157 @@
+#include "FontManager.hpp"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+void*                                                   FontManager::_library = nullptr;
+ID3D11Device*                                           FontManager::_device = nullptr;
+ID3D11DeviceContext*                                    FontManager::_deviceContext = nullptr;
+std::unordered_map<std::string, FontManager::FontFile>  FontManager::_files;
+std::unordered_map<std::string, std::shared_ptr<Font>>  FontManager::_fonts;
+
+// Releases a font file's face and unmaps the file
+void FontManager::CloseFile( FontFile& file )
+{
+    if ( file.Face )
+    {
+        FT_Done_Face( reinterpret_cast<FT_Face>( file.Face ) );
+        file.Face = nullptr;
+    }
+    file.Contents.reset();
+}
+
+// Gets the font face for the given file
+void* FontManager::GetFace( const std::string& fname )
+{
+    // Check if the face has already been created
+    auto search = _files.find( fname );
+    if ( search != _files.end() )
+    {
+        return search->second.Face;
+    }
+
+    if ( !_library )
+    {
+        return nullptr;
+    }
+
+    FontFile file;
+    file.Face = nullptr;
+
+    // Map the whole file into memory (FreeType reads straight out of the mapping for as long as the face lives)
+    file.Contents = std::make_shared<MappedFile>();
+    if ( !file.Contents->Open( fname ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Failed to map font file '" << fname << "'." << std::endl;
+#endif
+        CloseFile( file );
+        return nullptr;
+    }
+
+    // Attempt to create the font face
+    FT_Face face;
+    FT_Library library = reinterpret_cast<FT_Library>( _library );
+    if ( 0 != FT_New_Memory_Face( library, file.Contents->GetData(), static_cast<FT_Long>( file.Contents->GetSize() ), 0, &face ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Failed to create font face for '" << fname << "'." << std::endl;
+#endif
+        CloseFile( file );
+        return nullptr;
+    }
+    file.Face = face;
+
+    // Attempt to select the Unicode character map
+    if ( 0 != FT_Select_Charmap( face, FT_ENCODING_UNICODE ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Failed to select unicode font for '" << fname << "'." << std::endl;
+#endif
+        CloseFile( file );
+        return nullptr;
+    }
+
+    _files[ fname ] = file;
+    return file.Face;
+}
+
+// Gets the memory-mapped contents of the given font file
+bool FontManager::GetFileData( const std::string& fname, const void*& data, size_t& size )
+{
+    auto search = _files.find( fname );
+    if ( search == _files.end() )
+    {
+        return false;
+    }
+
+    data = search->second.Contents->GetData();
+    size = search->second.Contents->GetSize();
+    return true;
+}
+
+// Gets the font for the given file
+std::shared_ptr<Font> FontManager::GetFont( const std::string& fname, bool isDistanceField )
+{
+    // Distance field fonts have their own glyphs, so they're cached separately
+    std::string key = isDistanceField ? fname + "|DistanceField" : fname;
+    auto search = _fonts.find( key );
+    if ( search != _fonts.end() )
+    {
+        return search->second;
+    }
+
+    // Attempt to load the font
+    std::shared_ptr<Font> font = std::make_shared<Font>( _device, _deviceContext );
+    font->SetDistanceField( isDistanceField );
+    if ( !font->LoadFromFile( fname ) )
+    {
+        return nullptr;
+    }
+
+    _fonts[ key ] = font;
+    return font;
+}
+
+// Attempts to initialize the font manager
+bool FontManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+
+    // Attempt to create the one FreeType library
+    FT_Library library;
+    if ( 0 != FT_Init_FreeType( &library ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Failed to initialize FreeType." << std::endl;
+#endif
+        return false;
+    }
+    _library = library;
+
+    return true;
+}
+
+// Releases every cached font and face, and the FreeType library
+void FontManager::Shutdown()
+{
+    _fonts.clear();
+
+    for ( auto& pair : _files )
+    {
+        CloseFile( pair.second );
+    }
+    _files.clear();
+
+    if ( _library )
+    {
+        FT_Done_FreeType( reinterpret_cast<FT_Library>( _library ) );
+        _library = nullptr;
+    }
+
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Font.hpp"
+#include "MappedFile.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Defines the static font manager. It owns the one FreeType library, memory-maps each font file
+/// once and shares a single face per file between every font, and caches fonts by file name.
+/// </summary>
+class FontManager
+{
+    ImplementStaticClass( FontManager );
+
+    /// <summary>
+    /// Defines a memory-mapped font file and its face.
+    /// </summary>
+    struct FontFile
+    {
+        std::shared_ptr<MappedFile> Contents;
+        void* Face;
+    };
+
+    static void* _library;
+    static ID3D11Device* _device;
+    static ID3D11DeviceContext* _deviceContext;
+    static std::unordered_map<std::string, FontFile> _files;
+    static std::unordered_map<std::string, std::shared_ptr<Font>> _fonts;
+
+    /// <summary>
+    /// Releases a font file's face, then unmaps the file.
+    /// </summary>
+    /// <param name="file">The font file.</param>
+    static void CloseFile( FontFile& file );
+
+public:
+    /// <summary>
+    /// Gets the font face for the given file, memory-mapping and creating it the first time it's needed.
+    /// </summary>
+    /// <param name="fname">The font file name.</param>
+    /// <returns>The FreeType face, or null if the file could not be loaded.</returns>
+    static void* GetFace( const std::string& fname );
+
+    /// <summary>
+    /// Gets the memory-mapped contents of the given font file, so that other threads can create their own faces from it.
+    /// </summary>
+    /// <param name="fname">The font file name.</param>
+    /// <param name="data">The file's contents.</param>
+    /// <param name="size">The file's size, in bytes.</param>
+    /// <returns>True if the file is mapped, false if not.</returns>
+    static bool GetFileData( const std::string& fname, const void*& data, size_t& size );
+
+    /// <summary>
+    /// Gets the font for the given file, loading it the first time it's needed.
+    /// </summary>
+    /// <param name="fname">The font file name.</param>
+    /// <param name="isDistanceField">True to get the signed distance field version of the font.</param>
+    /// <returns>The font, or null if the file could not be loaded.</returns>
+    static std::shared_ptr<Font> GetFont( const std::string& fname, bool isDistanceField = false );
+
+    /// <summary>
+    /// Attempts to initialize the font manager.
+    /// </summary>
+    /// <param name="device">The device to create fonts on.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    static bool Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Releases every cached font and face, and the FreeType library.
+    /// </summary>
+    static void Shutdown();
+};
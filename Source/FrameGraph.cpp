@@ -0,0 +1,645 @@
+#include "FrameGraph.hpp"
+#include <algorithm>
+#include <new>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+static const size_t NoTexture = static_cast<size_t>( -1 );
+
+// Gets the typeless texture format and the shader resource view format behind a depth format
+static bool GetDepthFormats( DXGI_FORMAT format, DXGI_FORMAT& textureFormat, DXGI_FORMAT& viewFormat )
+{
+    switch ( format )
+    {
+    case DXGI_FORMAT_D32_FLOAT:
+        textureFormat = DXGI_FORMAT_R32_TYPELESS;
+        viewFormat = DXGI_FORMAT_R32_FLOAT;
+        return true;
+    case DXGI_FORMAT_D24_UNORM_S8_UINT:
+        textureFormat = DXGI_FORMAT_R24G8_TYPELESS;
+        viewFormat = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+        return true;
+    case DXGI_FORMAT_D16_UNORM:
+        textureFormat = DXGI_FORMAT_R16_TYPELESS;
+        viewFormat = DXGI_FORMAT_R16_UNORM;
+        return true;
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        textureFormat = DXGI_FORMAT_R32G8X24_TYPELESS;
+        viewFormat = DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS;
+        return true;
+    default:
+        textureFormat = format;
+        viewFormat = format;
+        return false;
+    }
+}
+
+// Checks whether two texture descriptions are the same
+static bool IsSameDesc( const FrameTextureDesc& left, const FrameTextureDesc& right )
+{
+    return left.Width == right.Width && left.Height == right.Height && left.Format == right.Format;
+}
+
+// Creates a new frame graph
+FrameGraph::FrameGraph( ID3D11Device* device, ID3D11DeviceContext* deviceContext, StateTracker* stateTracker )
+    : _device( nullptr )
+    , _deviceContext( nullptr )
+    , _stateTracker( stateTracker )
+    , _culledPassCount( 0 )
+    , _isCompiled( false )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+}
+
+// Destroys this frame graph
+FrameGraph::~FrameGraph()
+{
+    _textures.clear();
+
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Adds a pass
+bool FrameGraph::AddPass( const std::string& name, const std::vector<FrameResource>& reads, const std::vector<FrameResource>& writes, PassFunction execute )
+{
+    if ( FindPass( name ) != _passes.size() )
+    {
+        return false;
+    }
+    for ( int list = 0; list < 2; ++list )
+    {
+        for ( FrameResource resource : ( list == 0 ) ? reads : writes )
+        {
+            if ( resource >= _resources.size() )
+            {
+                return false;
+            }
+        }
+    }
+
+    Pass pass;
+    pass.Name = name;
+    pass.Reads = reads;
+    pass.Writes = writes;
+    pass.Execute = execute;
+    pass.IsEnabled = true;
+    _passes.push_back( pass );
+
+    _isCompiled = false;
+    return true;
+}
+
+// Creates a GPU texture and its views
+bool FrameGraph::AllocateTexture( const FrameTextureDesc& desc, Texture& texture )
+{
+    DXGI_FORMAT textureFormat;
+    DXGI_FORMAT viewFormat;
+    bool isDepth = GetDepthFormats( desc.Format, textureFormat, viewFormat );
+
+    D3D11_TEXTURE2D_DESC textureDesc;
+    ZeroMemory( &textureDesc, sizeof( D3D11_TEXTURE2D_DESC ) );
+    textureDesc.Width = desc.Width;
+    textureDesc.Height = desc.Height;
+    textureDesc.MipLevels = 1;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = textureFormat;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | ( isDepth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET );
+    texture.Desc = desc;
+    if ( FAILED( _device->CreateTexture2D( &textureDesc, nullptr, texture.Resource.GetAddress() ) ) )
+    {
+        return false;
+    }
+
+    if ( isDepth )
+    {
+        D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+        ZeroMemory( &dsvDesc, sizeof( D3D11_DEPTH_STENCIL_VIEW_DESC ) );
+        dsvDesc.Format = desc.Format;
+        dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+        if ( FAILED( _device->CreateDepthStencilView( texture.Resource.Get(), &dsvDesc, texture.DepthStencil.GetAddress() ) ) )
+        {
+            return false;
+        }
+    }
+    else if ( FAILED( _device->CreateRenderTargetView( texture.Resource.Get(), nullptr, texture.RenderTarget.GetAddress() ) ) )
+    {
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    ZeroMemory( &srvDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    srvDesc.Format = viewFormat;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    return SUCCEEDED( _device->CreateShaderResourceView( texture.Resource.Get(), &srvDesc, texture.ShaderResource.GetAddress() ) );
+}
+
+// Orders and culls the passes, then places the transient textures
+bool FrameGraph::Compile()
+{
+    const size_t passCount = _passes.size();
+    const size_t resourceCount = _resources.size();
+    _executionOrder.clear();
+    _clears.clear();
+    _culledPassCount = 0;
+
+    // Find the passes that write each texture, and the ones that only read it
+    std::vector<std::vector<size_t>> writers( resourceCount );
+    std::vector<std::vector<size_t>> readers( resourceCount );
+    for ( size_t pass = 0; pass < passCount; ++pass )
+    {
+        if ( !_passes[ pass ].IsEnabled )
+        {
+            continue;
+        }
+
+        const std::vector<FrameResource>& writes = _passes[ pass ].Writes;
+        for ( FrameResource resource : writes )
+        {
+            writers[ resource ].push_back( pass );
+        }
+        for ( FrameResource resource : _passes[ pass ].Reads )
+        {
+            if ( std::find( writes.begin(), writes.end(), resource ) == writes.end() )
+            {
+                readers[ resource ].push_back( pass );
+            }
+        }
+    }
+
+    // Start from the passes that write an output, then keep adding the passes that write what they read
+    std::vector<bool> isNeeded( passCount, false );
+    std::vector<size_t> pending;
+    for ( size_t resource = 0; resource < resourceCount; ++resource )
+    {
+        if ( _resources[ resource ].IsOutput )
+        {
+            pending.insert( pending.end(), writers[ resource ].begin(), writers[ resource ].end() );
+        }
+    }
+    while ( !pending.empty() )
+    {
+        size_t pass = pending.back();
+        pending.pop_back();
+        if ( isNeeded[ pass ] )
+        {
+            continue;
+        }
+
+        isNeeded[ pass ] = true;
+        for ( FrameResource resource : _passes[ pass ].Reads )
+        {
+            pending.insert( pending.end(), writers[ resource ].begin(), writers[ resource ].end() );
+        }
+    }
+
+    size_t neededCount = 0;
+    for ( size_t pass = 0; pass < passCount; ++pass )
+    {
+        if ( isNeeded[ pass ] )
+        {
+            ++neededCount;
+        }
+        else if ( _passes[ pass ].IsEnabled )
+        {
+            ++_culledPassCount;
+        }
+    }
+
+    // Each write of a texture has to happen after the one before it, and before anything only reads it
+    std::vector<std::vector<size_t>> successors( passCount );
+    std::vector<size_t> dependencyCount( passCount, 0 );
+    auto addDependency = [ & ]( size_t from, size_t to )
+    {
+        if ( isNeeded[ from ] && isNeeded[ to ] )
+        {
+            successors[ from ].push_back( to );
+            ++dependencyCount[ to ];
+        }
+    };
+    for ( size_t resource = 0; resource < resourceCount; ++resource )
+    {
+        for ( size_t index = 0; index < writers[ resource ].size(); ++index )
+        {
+            if ( index > 0 )
+            {
+                addDependency( writers[ resource ][ index - 1 ], writers[ resource ][ index ] );
+            }
+            for ( size_t reader : readers[ resource ] )
+            {
+                addDependency( writers[ resource ][ index ], reader );
+            }
+        }
+    }
+
+    // Run whichever ready pass was added first, so independent passes keep the order they were added in
+    std::vector<bool> isScheduled( passCount, false );
+    while ( _executionOrder.size() < neededCount )
+    {
+        size_t next = passCount;
+        for ( size_t pass = 0; pass < passCount; ++pass )
+        {
+            if ( isNeeded[ pass ] && !isScheduled[ pass ] && dependencyCount[ pass ] == 0 )
+            {
+                next = pass;
+                break;
+            }
+        }
+
+        // Passes that depend on each other can't be ordered, so they just run in the order they were added
+        if ( next == passCount )
+        {
+#if defined( _DEBUG ) || defined( DEBUG )
+            std::cout << "The frame graph's passes depend on each other in a cycle" << std::endl;
+#endif
+            for ( size_t pass = 0; pass < passCount; ++pass )
+            {
+                if ( isNeeded[ pass ] && !isScheduled[ pass ] )
+                {
+                    _executionOrder.push_back( pass );
+                }
+            }
+            break;
+        }
+
+        isScheduled[ next ] = true;
+        _executionOrder.push_back( next );
+        for ( size_t successor : successors[ next ] )
+        {
+            --dependencyCount[ successor ];
+        }
+    }
+
+    // Find when each transient texture is first and last used
+    std::vector<size_t> firstUse( resourceCount, NoTexture );
+    std::vector<size_t> lastUse( resourceCount, 0 );
+    for ( size_t position = 0; position < _executionOrder.size(); ++position )
+    {
+        const Pass& pass = _passes[ _executionOrder[ position ] ];
+        for ( int list = 0; list < 2; ++list )
+        {
+            for ( FrameResource resource : ( list == 0 ) ? pass.Reads : pass.Writes )
+            {
+                firstUse[ resource ] = std::min( firstUse[ resource ], position );
+                lastUse[ resource ] = std::max( lastUse[ resource ], position );
+            }
+        }
+    }
+
+    std::vector<FrameResource> transients;
+    for ( FrameResource resource = 0; resource < resourceCount; ++resource )
+    {
+        _resources[ resource ].Texture = NoTexture;
+        if ( !_resources[ resource ].IsImported && firstUse[ resource ] != NoTexture )
+        {
+            transients.push_back( resource );
+        }
+    }
+    std::stable_sort( transients.begin(), transients.end(), [ & ]( FrameResource left, FrameResource right )
+    {
+        return firstUse[ left ] < firstUse[ right ];
+    } );
+
+    // Put each transient texture in the first GPU texture like it that's free by the time it's needed.
+    // Last compile's GPU textures are reused before any are created, and the rest are released
+    std::vector<Texture> oldTextures;
+    oldTextures.swap( _textures );
+    std::vector<size_t> busyUntil;
+    _clears.resize( _executionOrder.size() );
+    bool isAllocated = true;
+    for ( FrameResource resource : transients )
+    {
+        const FrameTextureDesc& desc = _resources[ resource ].Desc;
+        size_t texture = 0;
+        while ( texture < _textures.size() && ( busyUntil[ texture ] >= firstUse[ resource ] || !IsSameDesc( _textures[ texture ].Desc, desc ) ) )
+        {
+            ++texture;
+        }
+
+        if ( texture == _textures.size() )
+        {
+            auto reusable = std::find_if( oldTextures.begin(), oldTextures.end(), [ & ]( const Texture& old )
+            {
+                return IsSameDesc( old.Desc, desc );
+            } );
+            if ( reusable != oldTextures.end() )
+            {
+                _textures.push_back( *reusable );
+                oldTextures.erase( reusable );
+            }
+            else
+            {
+                Texture created;
+                if ( !AllocateTexture( desc, created ) )
+                {
+#if defined( _DEBUG ) || defined( DEBUG )
+                    std::cout << "Failed to create the frame graph texture '" << _resources[ resource ].Name << "'" << std::endl;
+#endif
+                    isAllocated = false;
+                    continue;
+                }
+                _textures.push_back( created );
+            }
+            busyUntil.push_back( 0 );
+        }
+
+        busyUntil[ texture ] = lastUse[ resource ];
+        _resources[ resource ].Texture = texture;
+        _clears[ firstUse[ resource ] ].push_back( resource );
+    }
+
+    // Released views may still be remembered as bound
+    if ( !oldTextures.empty() && _stateTracker )
+    {
+        _stateTracker->Invalidate();
+    }
+
+    // Try again next frame if a texture couldn't be created
+    _isCompiled = isAllocated;
+    return isAllocated;
+}
+
+// Creates a transient texture
+FrameResource FrameGraph::CreateTexture( const std::string& name, const FrameTextureDesc& desc )
+{
+    FrameResource existing = FindResource( name );
+    if ( existing != InvalidResource )
+    {
+        return existing;
+    }
+
+    Resource resource;
+    resource.Name = name;
+    resource.Desc = desc;
+    resource.RenderTarget = nullptr;
+    resource.DepthStencil = nullptr;
+    resource.ShaderResource = nullptr;
+    resource.Texture = NoTexture;
+    resource.IsImported = false;
+    resource.IsOutput = false;
+    _resources.push_back( resource );
+
+    _isCompiled = false;
+    return static_cast<FrameResource>( _resources.size() - 1 );
+}
+
+// Creates a new frame graph
+std::shared_ptr<FrameGraph> FrameGraph::Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext, StateTracker* stateTracker )
+{
+    if ( !device || !deviceContext )
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<FrameGraph>( new ( std::nothrow ) FrameGraph( device, deviceContext, stateTracker ) );
+}
+
+// Runs the passes
+void FrameGraph::Execute()
+{
+    if ( !_isCompiled )
+    {
+        Compile();
+    }
+
+    for ( size_t position = 0; position < _executionOrder.size(); ++position )
+    {
+        // Transient textures start out cleared, since whatever used their GPU texture last left its contents behind
+        for ( FrameResource resource : _clears[ position ] )
+        {
+            Texture& texture = _textures[ _resources[ resource ].Texture ];
+            if ( texture.DepthStencil )
+            {
+                _deviceContext->ClearDepthStencilView( texture.DepthStencil.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0 );
+            }
+            else
+            {
+                const float black[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                _deviceContext->ClearRenderTargetView( texture.RenderTarget.Get(), black );
+            }
+        }
+
+        // Skip the passes whose transient textures couldn't be created rather than run them on null views
+        const Pass& pass = _passes[ _executionOrder[ position ] ];
+        bool isRunnable = true;
+        for ( int list = 0; list < 2 && isRunnable; ++list )
+        {
+            for ( FrameResource resource : ( list == 0 ) ? pass.Reads : pass.Writes )
+            {
+                if ( !_resources[ resource ].IsImported && _resources[ resource ].Texture == NoTexture )
+                {
+                    isRunnable = false;
+                }
+            }
+        }
+        if ( isRunnable )
+        {
+            pass.Execute( *this );
+        }
+    }
+}
+
+// Finds a pass by name
+size_t FrameGraph::FindPass( const std::string& name ) const
+{
+    size_t pass = 0;
+    while ( pass < _passes.size() && _passes[ pass ].Name != name )
+    {
+        ++pass;
+    }
+    return pass;
+}
+
+// Finds a texture by name
+FrameResource FrameGraph::FindResource( const std::string& name ) const
+{
+    for ( size_t resource = 0; resource < _resources.size(); ++resource )
+    {
+        if ( _resources[ resource ].Name == name )
+        {
+            return static_cast<FrameResource>( resource );
+        }
+    }
+    return InvalidResource;
+}
+
+// Gets the number of culled passes
+size_t FrameGraph::GetCulledPassCount() const
+{
+    return _culledPassCount;
+}
+
+// Gets a texture's depth/stencil view
+ID3D11DepthStencilView* FrameGraph::GetDepthStencilView( FrameResource resource )
+{
+    Resource& found = _resources[ resource ];
+    if ( found.IsImported )
+    {
+        return found.DepthStencil;
+    }
+    return ( found.Texture != NoTexture ) ? _textures[ found.Texture ].DepthStencil.Get() : nullptr;
+}
+
+// Gets the number of passes run every frame
+size_t FrameGraph::GetExecutedPassCount() const
+{
+    return _executionOrder.size();
+}
+
+// Gets the number of passes
+size_t FrameGraph::GetPassCount() const
+{
+    return _passes.size();
+}
+
+// Gets a texture's render target view
+ID3D11RenderTargetView* FrameGraph::GetRenderTargetView( FrameResource resource )
+{
+    Resource& found = _resources[ resource ];
+    if ( found.IsImported )
+    {
+        return found.RenderTarget;
+    }
+    return ( found.Texture != NoTexture ) ? _textures[ found.Texture ].RenderTarget.Get() : nullptr;
+}
+
+// Gets a texture's shader resource view
+ID3D11ShaderResourceView* FrameGraph::GetShaderResourceView( FrameResource resource )
+{
+    Resource& found = _resources[ resource ];
+    if ( found.IsImported )
+    {
+        return found.ShaderResource;
+    }
+    return ( found.Texture != NoTexture ) ? _textures[ found.Texture ].ShaderResource.Get() : nullptr;
+}
+
+// Gets the number of bytes a texture uses
+size_t FrameGraph::GetTextureSize( const FrameTextureDesc& desc )
+{
+    size_t bytesPerPixel = 4;
+    switch ( desc.Format )
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+        bytesPerPixel = 16;
+        break;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        bytesPerPixel = 8;
+        break;
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_D16_UNORM:
+        bytesPerPixel = 2;
+        break;
+    case DXGI_FORMAT_R8_UNORM:
+        bytesPerPixel = 1;
+        break;
+    default:
+        break;
+    }
+    return bytesPerPixel * desc.Width * desc.Height;
+}
+
+// Gets the number of bytes the transient textures use
+size_t FrameGraph::GetTransientMemorySize() const
+{
+    size_t size = 0;
+    for ( auto& texture : _textures )
+    {
+        size += GetTextureSize( texture.Desc );
+    }
+    return size;
+}
+
+// Imports a texture from outside the graph
+FrameResource FrameGraph::ImportTexture( const std::string& name, ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, ID3D11ShaderResourceView* shaderResource )
+{
+    FrameResource existing = FindResource( name );
+    if ( existing != InvalidResource )
+    {
+        return existing;
+    }
+
+    Resource resource;
+    resource.Name = name;
+    ZeroMemory( &resource.Desc, sizeof( FrameTextureDesc ) );
+    resource.RenderTarget = renderTarget;
+    resource.DepthStencil = depthStencil;
+    resource.ShaderResource = shaderResource;
+    resource.Texture = NoTexture;
+    resource.IsImported = true;
+    resource.IsOutput = false;
+    _resources.push_back( resource );
+
+    _isCompiled = false;
+    return static_cast<FrameResource>( _resources.size() - 1 );
+}
+
+// Checks whether a pass is enabled
+bool FrameGraph::IsPassEnabled( const std::string& name ) const
+{
+    size_t pass = FindPass( name );
+    return pass != _passes.size() && _passes[ pass ].IsEnabled;
+}
+
+// Removes a pass
+bool FrameGraph::RemovePass( const std::string& name )
+{
+    size_t pass = FindPass( name );
+    if ( pass == _passes.size() )
+    {
+        return false;
+    }
+
+    _passes.erase( _passes.begin() + pass );
+    _isCompiled = false;
+    return true;
+}
+
+// Sets an imported texture's views
+void FrameGraph::SetImportedViews( FrameResource resource, ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, ID3D11ShaderResourceView* shaderResource )
+{
+    Resource& found = _resources[ resource ];
+    if ( found.IsImported )
+    {
+        found.RenderTarget = renderTarget;
+        found.DepthStencil = depthStencil;
+        found.ShaderResource = shaderResource;
+    }
+}
+
+// Sets whether a texture is an output
+void FrameGraph::SetOutput( FrameResource resource, bool isOutput )
+{
+    if ( _resources[ resource ].IsOutput != isOutput )
+    {
+        _resources[ resource ].IsOutput = isOutput;
+        _isCompiled = false;
+    }
+}
+
+// Enables or disables a pass
+bool FrameGraph::SetPassEnabled( const std::string& name, bool isEnabled )
+{
+    size_t pass = FindPass( name );
+    if ( pass == _passes.size() )
+    {
+        return false;
+    }
+
+    if ( _passes[ pass ].IsEnabled != isEnabled )
+    {
+        _passes[ pass ].IsEnabled = isEnabled;
+        _isCompiled = false;
+    }
+    return true;
+}
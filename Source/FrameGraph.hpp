@@ -0,0 +1,269 @@
+#pragma once
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "StateTracker.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Identifies a texture in a frame graph.
+/// </summary>
+typedef UINT FrameResource;
+
+/// <summary>
+/// Describes a transient texture. A depth format makes a depth target, anything else makes a
+/// render target, and either can be read as a texture by later passes.
+/// </summary>
+struct FrameTextureDesc
+{
+    UINT Width;
+    UINT Height;
+    DXGI_FORMAT Format;
+};
+
+/// <summary>
+/// Defines a frame graph. Passes declare the textures they read and write instead of being called
+/// in a fixed order, and the graph works out the rest: passes run after the passes that write what
+/// they read, passes nothing needs are skipped, and transient textures whose lifetimes don't overlap
+/// share the same GPU texture. Passes can be added, removed, enabled and disabled at any time, and
+/// the graph is compiled again before the next frame it executes.
+/// </summary>
+/// <remarks>
+/// A pass that only reads a texture runs after every pass that writes it. Passes that write the same
+/// texture run in the order they were added. Transient textures are cleared before their first pass.
+/// </remarks>
+class FrameGraph
+{
+    ImplementNonCopyableClass( FrameGraph );
+    ImplementNonMovableClass( FrameGraph );
+
+public:
+    /// <summary>
+    /// The function that records a pass's draws.
+    /// </summary>
+    typedef std::function<void( FrameGraph& graph )> PassFunction;
+
+    static const FrameResource InvalidResource = 0xFFFFFFFF;
+
+private:
+    /// <summary>
+    /// Defines a render pass.
+    /// </summary>
+    struct Pass
+    {
+        std::string Name;
+        std::vector<FrameResource> Reads;
+        std::vector<FrameResource> Writes;
+        PassFunction Execute;
+        bool IsEnabled;
+    };
+
+    /// <summary>
+    /// Defines a texture as passes see it. Imported textures keep the views they were given, and
+    /// transient textures borrow the views of the GPU texture they were given when compiling.
+    /// </summary>
+    struct Resource
+    {
+        std::string Name;
+        FrameTextureDesc Desc;
+        ID3D11RenderTargetView* RenderTarget;
+        ID3D11DepthStencilView* DepthStencil;
+        ID3D11ShaderResourceView* ShaderResource;
+        size_t Texture;
+        bool IsImported;
+        bool IsOutput;
+    };
+
+    /// <summary>
+    /// Defines a GPU texture that transient textures are placed in.
+    /// </summary>
+    struct Texture
+    {
+        FrameTextureDesc Desc;
+        ComPtr<ID3D11Texture2D> Resource;
+        ComPtr<ID3D11RenderTargetView> RenderTarget;
+        ComPtr<ID3D11DepthStencilView> DepthStencil;
+        ComPtr<ID3D11ShaderResourceView> ShaderResource;
+    };
+
+    ID3D11Device* _device;
+    ID3D11DeviceContext* _deviceContext;
+    StateTracker* _stateTracker;
+    std::vector<Pass> _passes;
+    std::vector<Resource> _resources;
+    std::vector<Texture> _textures;
+    std::vector<size_t> _executionOrder;
+    std::vector<std::vector<FrameResource>> _clears;
+    size_t _culledPassCount;
+    bool _isCompiled;
+
+    /// <summary>
+    /// Creates a new frame graph.
+    /// </summary>
+    /// <param name="device">The device to create transient textures with.</param>
+    /// <param name="deviceContext">The device context to clear transient textures with.</param>
+    /// <param name="stateTracker">The state tracker passes draw through.</param>
+    FrameGraph( ID3D11Device* device, ID3D11DeviceContext* deviceContext, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Creates a GPU texture and its views.
+    /// </summary>
+    /// <param name="desc">The texture's description.</param>
+    /// <param name="texture">Receives the texture.</param>
+    /// <returns>True if the texture was created, false if not.</returns>
+    bool AllocateTexture( const FrameTextureDesc& desc, Texture& texture );
+
+    /// <summary>
+    /// Orders and culls the passes, then places the transient textures.
+    /// </summary>
+    /// <returns>True if every transient texture could be created, false if not. The graph stays
+    /// uncompiled until they all are, so the next frame tries again.</returns>
+    bool Compile();
+
+    /// <summary>
+    /// Finds a pass by name.
+    /// </summary>
+    /// <param name="name">The name of the pass.</param>
+    /// <returns>The index of the pass, or the pass count if there is none.</returns>
+    size_t FindPass( const std::string& name ) const;
+
+    /// <summary>
+    /// Gets the number of bytes a texture uses.
+    /// </summary>
+    /// <param name="desc">The texture's description.</param>
+    static size_t GetTextureSize( const FrameTextureDesc& desc );
+
+public:
+    /// <summary>
+    /// Creates a new frame graph.
+    /// </summary>
+    /// <param name="device">The device to create transient textures with.</param>
+    /// <param name="deviceContext">The device context to clear transient textures with.</param>
+    /// <param name="stateTracker">The state tracker passes draw through.</param>
+    static std::shared_ptr<FrameGraph> Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Destroys this frame graph.
+    /// </summary>
+    ~FrameGraph();
+
+    /// <summary>
+    /// Adds a pass after every pass added so far.
+    /// </summary>
+    /// <param name="name">The pass's unique name.</param>
+    /// <param name="reads">The textures the pass reads.</param>
+    /// <param name="writes">The textures the pass writes.</param>
+    /// <param name="execute">Records the pass's draws.</param>
+    /// <returns>True if the pass was added, false if there already is a pass with its name or a texture doesn't exist.</returns>
+    bool AddPass( const std::string& name, const std::vector<FrameResource>& reads, const std::vector<FrameResource>& writes, PassFunction execute );
+
+    /// <summary>
+    /// Creates a transient texture, which only lives between the first and last passes that use it.
+    /// </summary>
+    /// <param name="name">The texture's unique name.</param>
+    /// <param name="desc">The texture's description.</param>
+    /// <returns>The texture, or the existing texture with the same name.</returns>
+    FrameResource CreateTexture( const std::string& name, const FrameTextureDesc& desc );
+
+    /// <summary>
+    /// Runs every pass that is enabled and needed, in order.
+    /// </summary>
+    void Execute();
+
+    /// <summary>
+    /// Finds a texture by name.
+    /// </summary>
+    /// <param name="name">The name of the texture.</param>
+    /// <returns>The texture, or InvalidResource if there is none.</returns>
+    FrameResource FindResource( const std::string& name ) const;
+
+    /// <summary>
+    /// Gets the number of enabled passes that were skipped because nothing needs what they write.
+    /// </summary>
+    size_t GetCulledPassCount() const;
+
+    /// <summary>
+    /// Gets a texture's depth/stencil view.
+    /// </summary>
+    /// <param name="resource">The texture.</param>
+    ID3D11DepthStencilView* GetDepthStencilView( FrameResource resource );
+
+    /// <summary>
+    /// Gets the number of passes that run every frame.
+    /// </summary>
+    size_t GetExecutedPassCount() const;
+
+    /// <summary>
+    /// Gets the number of passes, including disabled ones.
+    /// </summary>
+    size_t GetPassCount() const;
+
+    /// <summary>
+    /// Gets a texture's render target view.
+    /// </summary>
+    /// <param name="resource">The texture.</param>
+    ID3D11RenderTargetView* GetRenderTargetView( FrameResource resource );
+
+    /// <summary>
+    /// Gets a texture's shader resource view.
+    /// </summary>
+    /// <param name="resource">The texture.</param>
+    ID3D11ShaderResourceView* GetShaderResourceView( FrameResource resource );
+
+    /// <summary>
+    /// Gets the number of bytes the GPU textures behind the transient textures use.
+    /// </summary>
+    size_t GetTransientMemorySize() const;
+
+    /// <summary>
+    /// Imports a texture that lives outside of the graph, like the back buffer. Imported textures
+    /// are never cleared or reallocated.
+    /// </summary>
+    /// <param name="name">The texture's unique name.</param>
+    /// <param name="renderTarget">The render target view, if any.</param>
+    /// <param name="depthStencil">The depth/stencil view, if any.</param>
+    /// <param name="shaderResource">The shader resource view, if any.</param>
+    /// <returns>The texture, or the existing texture with the same name.</returns>
+    FrameResource ImportTexture( const std::string& name, ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, ID3D11ShaderResourceView* shaderResource );
+
+    /// <summary>
+    /// Checks whether a pass is enabled.
+    /// </summary>
+    /// <param name="name">The name of the pass.</param>
+    bool IsPassEnabled( const std::string& name ) const;
+
+    /// <summary>
+    /// Removes a pass.
+    /// </summary>
+    /// <param name="name">The name of the pass.</param>
+    /// <returns>True if the pass was removed, false if there is no such pass.</returns>
+    bool RemovePass( const std::string& name );
+
+    /// <summary>
+    /// Sets the views of an imported texture, for when the texture outside the graph is recreated.
+    /// </summary>
+    /// <param name="resource">The imported texture.</param>
+    /// <param name="renderTarget">The render target view, if any.</param>
+    /// <param name="depthStencil">The depth/stencil view, if any.</param>
+    /// <param name="shaderResource">The shader resource view, if any.</param>
+    void SetImportedViews( FrameResource resource, ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil, ID3D11ShaderResourceView* shaderResource );
+
+    /// <summary>
+    /// Sets whether a texture is one of the graph's outputs. Only passes that lead to an output run.
+    /// </summary>
+    /// <param name="resource">The texture.</param>
+    /// <param name="isOutput">True to make the texture an output, false not to.</param>
+    void SetOutput( FrameResource resource, bool isOutput );
+
+    /// <summary>
+    /// Enables or disables a pass.
+    /// </summary>
+    /// <param name="name">The name of the pass.</param>
+    /// <param name="isEnabled">True to enable the pass, false to disable it.</param>
+    /// <returns>True if the pass exists, false if not.</returns>
+    bool SetPassEnabled( const std::string& name, bool isEnabled );
+};
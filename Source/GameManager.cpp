@@ -1,8 +1,10 @@
 #include "GameManager.hpp"
 #include "Components.hpp"
+#include "FontManager.hpp"
 #include "GameObject.hpp"
 #include "Input.hpp"
 #include "MeshLoader.hpp"
+#include "ParticleManager.hpp"
 #include "RenderManager.hpp"
 #include "Scene.hpp"
 #include "Time.hpp"
@@ -48,6 +50,12 @@ GameManager::GameManager( GameObject* gameObject )
 {
     RenderManager::SetLightDirection( XMFLOAT3( 0.0f, -0.1f, 1.0f ) );
 
+    // Load the player and arrow meshes together now, rather than one at a time when they're first used
+    std::vector<std::string> prefabMeshes;
+    prefabMeshes.push_back( "Models\\arrow.obj" );
+    prefabMeshes.push_back( "Models\\cube.obj" );
+    MeshLoader::LoadBatch( prefabMeshes, gameObject->GetDevice(), gameObject->GetDeviceContext() );
+
     // Create the players
     _player1 = CreatePlayer( 1, XMFLOAT3( -20, 0, 10 ), XMFLOAT3( 1, 1, 1 ) );
     _player2 = CreatePlayer( 2, XMFLOAT3(  20, 0, 10 ), XMFLOAT3( 1, 1, 1 ) );
@@ -157,34 +165,30 @@ GameObject* GameManager::CreatePlayer( uint32_t index, const XMFLOAT3& position,
     return player;
 }
 
-//Create particles
-ParticleSystem* GameManager::CreateParticleSystem(XMFLOAT3 startPos, XMFLOAT3 startVel)
+// Emits a burst of blood particles
+bool GameManager::CreateParticleSystem( const XMFLOAT3& startPos, const XMFLOAT3& startVel )
 {
-    auto device = _gameObject->GetDevice();
-    auto deviceContext = _gameObject->GetDeviceContext();
-    auto bloodTexture = Texture2D::FromFile( device, deviceContext, "Textures\\Blood.png" );
-
-    //set some default values
-    XMFLOAT4 particleStartColor = XMFLOAT4(1, 0, 0, 1);
-    XMFLOAT4 particleMidColor = XMFLOAT4(1, 0, 0, 0.1f);
-    XMFLOAT4 particleEndColor = XMFLOAT4(1, 0, 0, 0);
-    float particleStartSize = 5;
-    float particleMidSize = 10;
-    float particleEndSize = 3;
-
-    float particleAgeToSpawn = 0.00001f;
-    float particleMaxLifetime = 5.0f;
-    XMFLOAT3 particleConstantAccel = XMFLOAT3(startVel.x, -1.0f, 0);
-
-    //initialize the particle system
-    _particleSystem = new ParticleSystem(startPos, startVel, particleStartColor, particleMidColor, particleEndColor,
-        particleStartSize, particleMidSize, particleEndSize, particleAgeToSpawn, particleMaxLifetime, particleConstantAccel, bloodTexture);
-    
-    //create geometry and load shaders
-    _particleSystem->CreateGeometry(device);
-    _particleSystem->LoadShaders(device, deviceContext);
+    // Only load the blood texture once
+    if ( !_bloodTexture )
+    {
+        _bloodTexture = Texture2D::FromFile( _gameObject->GetDevice(), _gameObject->GetDeviceContext(), "Textures\\Blood.png" );
+    }
 
-    return _particleSystem;
+    ParticleSystemDescription description;
+    description.StartPosition = startPos;
+    description.StartVelocity = startVel;
+    description.StartColor = XMFLOAT4( 1, 0, 0, 1 );
+    description.MidColor = XMFLOAT4( 1, 0, 0, 0.1f );
+    description.EndColor = XMFLOAT4( 1, 0, 0, 0 );
+    description.StartMidEndSize = XMFLOAT3( 5, 10, 3 );
+    description.Acceleration = XMFLOAT3( startVel.x, -1.0f, 0 );
+    description.SpawnInterval = 0.00001f;
+    description.MaxLifetime = 5.0f;
+    description.EmitDuration = 0.5f;
+    description.Texture = _bloodTexture;
+
+    // The particle manager retires the system once all of its particles have died
+    return ParticleManager::Emit( description );
 }
 
 // Creates the UI
@@ -200,18 +204,21 @@ void GameManager::CreateUI()
     _line->SetEnabled( false );
     lineObj->AddComponent<LineMaterial>()->SetLineColor( XMFLOAT4( Colors::White ) );
 
-    // Load our font
-    std::shared_ptr<Font> font = std::make_shared<Font>( _gameObject->GetDevice(), _gameObject->GetDeviceContext() );
-    std::shared_ptr<Font> bigFont = std::make_shared<Font>( _gameObject->GetDevice(), _gameObject->GetDeviceContext() );
-    assert( font   ->LoadFromFile( "Fonts\\OpenSans-Regular.ttf" ) &&
-            bigFont->LoadFromFile( "Fonts\\OpenSans-Regular.ttf" ) );
-    font->SetCurrentSize( 21U );
-    bigFont->SetCurrentSize( 80U );
+    // Load our font (as distance fields, so one atlas serves every size and the tweened scale)
+    std::shared_ptr<Font> font = FontManager::GetFont( "Fonts\\OpenSans-Regular.ttf", true );
+    assert( font );
+
+    // Rasterize every character the UI can show up front, so that nothing hitches when the text first changes
+    std::vector<unsigned int> sizes;
+    sizes.push_back( 21U );
+    sizes.push_back( 80U );
+    font->Preload( " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~", sizes );
 
     // Create the text renderer
     GameObject* textObj = _gameObject->AddChild( _gameObject->GetName() + "_UIText" );
     _lineText = textObj->AddComponent<TextRenderer>();
     _lineText->SetFont( font );
+    _lineText->SetFontSize( 21U );
     _lineText->SetEnabled( false );
     textObj->AddComponent<TextMaterial>()->SetTextColor( XMFLOAT4( Colors::White ) );
 
@@ -222,6 +229,7 @@ void GameManager::CreateUI()
     obj->GetTransform()->SetPosition( XMFLOAT3( 10, 10, 0 ) );
     _player1HealthUI = obj->AddComponent<TextRenderer>();
     _player1HealthUI->SetFont( font );
+    _player1HealthUI->SetFontSize( 21U );
     obj->AddComponent<TextMaterial>()->SetTextColor( XMFLOAT4( Colors::White ) );
 
     // Create the UI for player 2
@@ -229,6 +237,7 @@ void GameManager::CreateUI()
     obj->GetTransform()->SetPosition( XMFLOAT3( 1100, 10, 0 ) );
     _player2HealthUI = obj->AddComponent<TextRenderer>();
     _player2HealthUI->SetFont( font );
+    _player2HealthUI->SetFontSize( 21U );
     obj->AddComponent<TextMaterial>()->SetTextColor( XMFLOAT4( Colors::White ) );
 
 
@@ -238,7 +247,8 @@ void GameManager::CreateUI()
     obj->GetTransform()->SetPosition( XMFLOAT3( 540, 670, 0 ) );
     obj->GetTransform()->SetScale( XMFLOAT3( 0.25f, 0.25f, 0.25f ) );
     _turnIndicator = obj->AddComponent<TextRenderer>();
-    _turnIndicator->SetFont( bigFont );
+    _turnIndicator->SetFont( font );
+    _turnIndicator->SetFontSize( 80U );
     obj->AddComponent<TextMaterial>()->SetTextColor( XMFLOAT4( Colors::White ) );
 }
 
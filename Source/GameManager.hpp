@@ -5,8 +5,8 @@
 #include "LineRenderer.hpp"
 #include "Rigidbody.hpp"
 #include "TextRenderer.hpp"
+#include "Texture2D.hpp"
 #include "TweenPosition.hpp"
-#include "ParticleSystem.h"
 
 /// <summary>
 /// Defines a game manager.
@@ -49,8 +49,7 @@ private:
     int _player1Health;
     int _player2Health;
     int _arrowCount;
-
-	ParticleSystem* _particleSystem;
+    std::shared_ptr<Texture2D> _bloodTexture;
 
     /// <summary>
     /// Checks to see if we can shoot an arrow.
@@ -75,10 +74,12 @@ private:
     /// </summary>
     void CreateUI();
 
-	/// <summary>
-	/// Creates the blood particle system
-	/// </summary>
-	ParticleSystem* CreateParticleSystem(XMFLOAT3 startPos, XMFLOAT3 startVel);
+    /// <summary>
+    /// Emits a burst of blood particles.
+    /// </summary>
+    /// <param name="startPos">The position to emit from.</param>
+    /// <param name="startVel">The particles' starting velocity.</param>
+    bool CreateParticleSystem( const DirectX::XMFLOAT3& startPos, const DirectX::XMFLOAT3& startVel );
 
     /// <summary>
     /// Handles the current game state.
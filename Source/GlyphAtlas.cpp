@@ -0,0 +1,395 @@
+#include "GlyphAtlas.hpp"
+#include <algorithm>
+#include <string.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+const unsigned int GlyphAtlas::InitialSize  = 256;
+const unsigned int GlyphAtlas::MaximumSize  = 2048; // Keeps the CPU copy of a single atlas at 16MB or less
+const unsigned int GlyphAtlas::EntryIndexBits = 20; // The rest of an entry holds its slot's serial
+const unsigned int GlyphAtlas::MaximumEntries = ( 1 << GlyphAtlas::EntryIndexBits ) - 1;
+const unsigned int GlyphAtlas::InvalidEntry = 0xFFFFFFFF;
+
+// Creates a new glyph atlas
+GlyphAtlas::GlyphAtlas( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+    : _device( nullptr )
+    , _deviceContext( nullptr )
+    , _size( InitialSize )
+    , _useClock( 0 )
+    , _generation( 0 )
+    , _isDirty( false )
+    , _isTextureStale( true )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+
+    _pixels.resize( _size * _size * 4, 0 );
+    ResetSkyline();
+}
+
+// Destroys this glyph atlas
+GlyphAtlas::~GlyphAtlas()
+{
+    _texture.reset();
+
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Attempts to add a block of pixels to the atlas
+bool GlyphAtlas::Add( unsigned int width, unsigned int height, const unsigned char* pixels, unsigned int& entry )
+{
+    entry = InvalidEntry;
+    if ( width == 0 || height == 0 || !pixels )
+    {
+        return false;
+    }
+
+    if ( _freeEntries.empty() && _entries.size() >= MaximumEntries )
+    {
+        return false;
+    }
+
+    // Find room for the pixels, growing the atlas first and only evicting once it can't grow any more
+    UintRect rect;
+    bool hasEvicted = false;
+    while ( !Allocate( width, height, rect ) )
+    {
+        if ( Grow() )
+        {
+            continue;
+        }
+        if ( hasEvicted )
+        {
+#if defined( _DEBUG ) || defined( DEBUG )
+            std::cout << "Could not fit a " << width << "x" << height << " glyph in the font atlas." << std::endl;
+#endif
+            return false;
+        }
+
+        EvictLeastRecentlyUsed();
+        hasEvicted = true;
+    }
+
+    // Record the entry, reusing an evicted glyph's if there is one, and copy the pixels in
+    unsigned int index = static_cast<unsigned int>( _entries.size() );
+    if ( _freeEntries.empty() )
+    {
+        Entry newEntry;
+        newEntry.Serial = 0;
+        _entries.push_back( newEntry );
+    }
+    else
+    {
+        index = _freeEntries.back();
+        _freeEntries.pop_back();
+    }
+
+    Entry& newEntry = _entries[ index ];
+    newEntry.Rect = rect;
+    newEntry.LastUsed = ++_useClock;
+    newEntry.IsResident = true;
+    entry = ( newEntry.Serial << EntryIndexBits ) | index;
+
+    CopyPixels( rect, pixels, width * 4 );
+    return true;
+}
+
+// Attempts to allocate a rectangle from the skyline
+bool GlyphAtlas::Allocate( unsigned int width, unsigned int height, UintRect& rect )
+{
+    // Find the segment that keeps the top of the new rectangle lowest, breaking ties on the narrowest segment
+    size_t       bestIndex  = _skyline.size();
+    unsigned int bestY      = 0;
+    unsigned int bestBottom = 0xFFFFFFFF;
+    unsigned int bestWidth  = 0xFFFFFFFF;
+    for ( size_t index = 0; index < _skyline.size(); ++index )
+    {
+        unsigned int x = _skyline[ index ].X;
+        if ( x + width > _size )
+        {
+            break;
+        }
+
+        // The rectangle has to sit on the highest segment it spans
+        unsigned int y = 0;
+        unsigned int remaining = width;
+        for ( size_t span = index; remaining > 0; ++span )
+        {
+            y = std::max( y, _skyline[ span ].Y );
+            if ( _skyline[ span ].Width >= remaining )
+            {
+                break;
+            }
+            remaining -= _skyline[ span ].Width;
+        }
+
+        if ( y + height > _size )
+        {
+            continue;
+        }
+
+        if ( ( y + height < bestBottom ) || ( y + height == bestBottom && _skyline[ index ].Width < bestWidth ) )
+        {
+            bestIndex  = index;
+            bestY      = y;
+            bestBottom = y + height;
+            bestWidth  = _skyline[ index ].Width;
+        }
+    }
+
+    if ( bestIndex == _skyline.size() )
+    {
+        return false;
+    }
+
+    // Raise the skyline over the new rectangle
+    SkylineNode node = { _skyline[ bestIndex ].X, bestBottom, width };
+    _skyline.insert( _skyline.begin() + bestIndex, node );
+
+    // Shrink or remove the segments now covered by the new one
+    size_t index = bestIndex + 1;
+    while ( index < _skyline.size() )
+    {
+        unsigned int previousRight = _skyline[ index - 1 ].X + _skyline[ index - 1 ].Width;
+        if ( _skyline[ index ].X >= previousRight )
+        {
+            break;
+        }
+
+        unsigned int shrink = previousRight - _skyline[ index ].X;
+        if ( _skyline[ index ].Width <= shrink )
+        {
+            _skyline.erase( _skyline.begin() + index );
+            continue;
+        }
+
+        _skyline[ index ].X     += shrink;
+        _skyline[ index ].Width -= shrink;
+        break;
+    }
+
+    // Merge neighboring segments at the same height
+    for ( index = 0; index + 1 < _skyline.size(); )
+    {
+        if ( _skyline[ index ].Y == _skyline[ index + 1 ].Y )
+        {
+            _skyline[ index ].Width += _skyline[ index + 1 ].Width;
+            _skyline.erase( _skyline.begin() + index + 1 );
+        }
+        else
+        {
+            ++index;
+        }
+    }
+
+    rect = UintRect( node.X, bestY, width, height );
+    return true;
+}
+
+// Copies pixels into the CPU copy of the atlas
+void GlyphAtlas::CopyPixels( const UintRect& rect, const unsigned char* pixels, unsigned int pitch )
+{
+    for ( unsigned int row = 0; row < rect.Height; ++row )
+    {
+        unsigned char* dest = &_pixels[ ( ( rect.Y + row ) * _size + rect.X ) * 4 ];
+        memcpy( dest, pixels + row * pitch, rect.Width * 4 );
+    }
+
+    // Grow the dirty area to include the new pixels
+    if ( !_isDirty )
+    {
+        _dirtyArea = rect;
+        _isDirty = true;
+    }
+    else
+    {
+        unsigned int left   = std::min( _dirtyArea.X, rect.X );
+        unsigned int top    = std::min( _dirtyArea.Y, rect.Y );
+        unsigned int right  = std::max( _dirtyArea.X + _dirtyArea.Width,  rect.X + rect.Width );
+        unsigned int bottom = std::max( _dirtyArea.Y + _dirtyArea.Height, rect.Y + rect.Height );
+        _dirtyArea = UintRect( left, top, right - left, bottom - top );
+    }
+}
+
+// Removes an entry from the atlas
+void GlyphAtlas::Evict( unsigned int index )
+{
+    // Bumping the serial keeps handles to the old glyph from finding whatever reuses the entry
+    Entry& entry = _entries[ index ];
+    entry.IsResident = false;
+    entry.Serial = ( entry.Serial + 1 ) & ( 0xFFFFFFFF >> EntryIndexBits );
+    _freeEntries.push_back( index );
+}
+
+// Evicts the least recently used glyphs
+void GlyphAtlas::EvictLeastRecentlyUsed()
+{
+    // Order the resident entries from most to least recently used
+    std::vector<unsigned int> order;
+    for ( unsigned int index = 0; index < _entries.size(); ++index )
+    {
+        if ( _entries[ index ].IsResident )
+        {
+            order.push_back( index );
+        }
+    }
+    std::sort( order.begin(), order.end(), [ this ]( unsigned int a, unsigned int b )
+    {
+        return _entries[ a ].LastUsed > _entries[ b ].LastUsed;
+    } );
+
+    // Keep the most recently used glyphs until they cover half of the atlas, leaving room for new ones
+    const unsigned int areaBudget = _size * _size / 2;
+    unsigned int keptArea = 0;
+    size_t keptCount = 0;
+    for ( ; keptCount < order.size(); ++keptCount )
+    {
+        const UintRect& rect = _entries[ order[ keptCount ] ].Rect;
+        if ( keptArea + rect.Width * rect.Height > areaBudget )
+        {
+            break;
+        }
+        keptArea += rect.Width * rect.Height;
+    }
+    size_t evictedCount = order.size() - keptCount;
+    for ( size_t index = keptCount; index < order.size(); ++index )
+    {
+        Evict( order[ index ] );
+    }
+    order.resize( keptCount );
+
+    // Repack the survivors tallest first (which suits the skyline) from the old CPU copy
+    std::sort( order.begin(), order.end(), [ this ]( unsigned int a, unsigned int b )
+    {
+        return _entries[ a ].Rect.Height > _entries[ b ].Rect.Height;
+    } );
+
+    std::vector<unsigned char> oldPixels( _size * _size * 4, 0 );
+    oldPixels.swap( _pixels );
+    ResetSkyline();
+    for ( unsigned int index : order )
+    {
+        Entry& entry = _entries[ index ];
+        UintRect rect;
+        if ( !Allocate( entry.Rect.Width, entry.Rect.Height, rect ) )
+        {
+            Evict( index );
+            ++evictedCount;
+            continue;
+        }
+
+        CopyPixels( rect, &oldPixels[ ( entry.Rect.Y * _size + entry.Rect.X ) * 4 ], _size * 4 );
+        entry.Rect = rect;
+    }
+
+    // Everything has moved, so the whole atlas needs uploading and every user needs to look their glyphs up again
+    _dirtyArea = UintRect( 0, 0, _size, _size );
+    _isDirty = true;
+    ++_generation;
+
+#if defined( _DEBUG ) || defined( DEBUG )
+    std::cout << "Evicted " << evictedCount << " glyphs from a full font atlas." << std::endl;
+#endif
+}
+
+// Uploads everything that has changed since the last flush
+void GlyphAtlas::Flush()
+{
+    // A new or resized atlas gets its texture created straight from the CPU copy
+    if ( _isTextureStale )
+    {
+        _texture = std::shared_ptr<Texture2D>( new ( std::nothrow ) Texture2D( _device, _deviceContext, _size, _size, &_pixels[ 0 ], false ) );
+        _isTextureStale = false;
+        _isDirty = false;
+        return;
+    }
+
+    // Otherwise upload all of the new glyphs in one go
+    if ( _isDirty && _texture )
+    {
+        const unsigned char* source = &_pixels[ ( _dirtyArea.Y * _size + _dirtyArea.X ) * 4 ];
+        _texture->UpdateArea( _dirtyArea.X, _dirtyArea.Y, _dirtyArea.Width, _dirtyArea.Height, source, _size * 4 );
+        _isDirty = false;
+    }
+}
+
+// Gets this atlas's generation
+unsigned int GlyphAtlas::GetGeneration() const
+{
+    return _generation;
+}
+
+// Gets the rectangle of the given entry
+UintRect GlyphAtlas::GetRect( unsigned int entry ) const
+{
+    if ( IsResident( entry ) )
+    {
+        return _entries[ entry & MaximumEntries ].Rect;
+    }
+    return UintRect( 0, 0, 0, 0 );
+}
+
+// Gets this atlas's size
+unsigned int GlyphAtlas::GetSize() const
+{
+    return _size;
+}
+
+// Gets the texture for this atlas
+std::shared_ptr<Texture2D> GlyphAtlas::GetTexture() const
+{
+    return _texture;
+}
+
+// Attempts to double the size of the atlas
+bool GlyphAtlas::Grow()
+{
+    unsigned int newSize = _size * 2;
+    if ( newSize > MaximumSize || newSize > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION )
+    {
+        return false;
+    }
+
+    // Copy the old pixels into the top-left of the new CPU copy (existing glyphs keep their pixel rectangles)
+    std::vector<unsigned char> newPixels( newSize * newSize * 4, 0 );
+    for ( unsigned int row = 0; row < _size; ++row )
+    {
+        memcpy( &newPixels[ row * newSize * 4 ], &_pixels[ row * _size * 4 ], _size * 4 );
+    }
+    _pixels.swap( newPixels );
+
+    // The new columns on the right start out empty
+    SkylineNode node = { _size, 0, newSize - _size };
+    _skyline.push_back( node );
+
+    // The texture is recreated from the CPU copy on the next flush
+    _size = newSize;
+    _isTextureStale = true;
+    return true;
+}
+
+// Checks to see if the given entry is still in the atlas
+bool GlyphAtlas::IsResident( unsigned int entry ) const
+{
+    const unsigned int index = entry & MaximumEntries;
+    return ( index < _entries.size() ) && _entries[ index ].IsResident && ( _entries[ index ].Serial == entry >> EntryIndexBits );
+}
+
+// Resets the skyline to a single empty segment
+void GlyphAtlas::ResetSkyline()
+{
+    SkylineNode node = { 0, 0, _size };
+    _skyline.clear();
+    _skyline.push_back( node );
+}
+
+// Marks the given entry as having just been used
+void GlyphAtlas::Touch( unsigned int entry )
+{
+    if ( IsResident( entry ) )
+    {
+        _entries[ entry & MaximumEntries ].LastUsed = ++_useClock;
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Config.hpp"
+#include "Rect.hpp"
+#include "Texture2D.hpp"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Defines a glyph atlas. Glyphs are packed with a skyline packer into a CPU-side copy of the
+/// atlas, and all of the rectangles touched since the last flush are uploaded together. The GPU
+/// texture is never read back; growing or repacking the atlas works entirely off of the CPU copy.
+/// </summary>
+class GlyphAtlas
+{
+    ImplementNonCopyableClass( GlyphAtlas );
+    ImplementNonMovableClass( GlyphAtlas );
+
+    /// <summary>
+    /// Defines one segment of the skyline.
+    /// </summary>
+    struct SkylineNode
+    {
+        unsigned int X;
+        unsigned int Y;
+        unsigned int Width;
+    };
+
+    /// <summary>
+    /// Defines a rectangle allocated in the atlas.
+    /// </summary>
+    struct Entry
+    {
+        UintRect Rect;
+        unsigned int LastUsed;
+        unsigned int Serial;
+        bool IsResident;
+    };
+
+    static const unsigned int InitialSize;
+    static const unsigned int MaximumSize;
+    static const unsigned int EntryIndexBits;
+    static const unsigned int MaximumEntries;
+
+    ID3D11Device* _device;
+    ID3D11DeviceContext* _deviceContext;
+    std::shared_ptr<Texture2D> _texture;
+    std::vector<unsigned char> _pixels;
+    std::vector<SkylineNode> _skyline;
+    std::vector<Entry> _entries;
+    std::vector<unsigned int> _freeEntries;
+    UintRect _dirtyArea;
+    unsigned int _size;
+    unsigned int _useClock;
+    unsigned int _generation;
+    bool _isDirty;
+    bool _isTextureStale;
+
+    /// <summary>
+    /// Attempts to allocate a rectangle from the skyline.
+    /// </summary>
+    /// <param name="width">The width of the rectangle.</param>
+    /// <param name="height">The height of the rectangle.</param>
+    /// <param name="rect">Receives the allocated rectangle.</param>
+    bool Allocate( unsigned int width, unsigned int height, UintRect& rect );
+
+    /// <summary>
+    /// Copies pixels into the CPU copy of the atlas and marks the area as dirty.
+    /// </summary>
+    /// <param name="rect">The destination area.</param>
+    /// <param name="pixels">The RGBA pixels to copy.</param>
+    /// <param name="pitch">The number of bytes between rows of the source pixels.</param>
+    void CopyPixels( const UintRect& rect, const unsigned char* pixels, unsigned int pitch );
+
+    /// <summary>
+    /// Removes an entry from the atlas and queues it to be reused by the next glyph added.
+    /// </summary>
+    /// <param name="index">The entry's index.</param>
+    void Evict( unsigned int index );
+
+    /// <summary>
+    /// Evicts the least recently used glyphs, repacking the rest from the CPU copy.
+    /// </summary>
+    void EvictLeastRecentlyUsed();
+
+    /// <summary>
+    /// Attempts to double the size of the atlas.
+    /// </summary>
+    bool Grow();
+
+    /// <summary>
+    /// Resets the skyline to a single empty segment.
+    /// </summary>
+    void ResetSkyline();
+
+public:
+    /// <summary>
+    /// The entry given to glyphs that do not have any pixels in the atlas. Entries of evicted glyphs
+    /// are reused, but an entry handed out before its glyph was evicted never becomes resident again.
+    /// </summary>
+    static const unsigned int InvalidEntry;
+
+    /// <summary>
+    /// Creates a new glyph atlas.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    GlyphAtlas( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Destroys this glyph atlas.
+    /// </summary>
+    ~GlyphAtlas();
+
+    /// <summary>
+    /// Attempts to add a block of pixels to the atlas, growing it or evicting old glyphs if necessary.
+    /// </summary>
+    /// <param name="width">The width of the pixels.</param>
+    /// <param name="height">The height of the pixels.</param>
+    /// <param name="pixels">The RGBA pixels.</param>
+    /// <param name="entry">Receives the new atlas entry.</param>
+    bool Add( unsigned int width, unsigned int height, const unsigned char* pixels, unsigned int& entry );
+
+    /// <summary>
+    /// Uploads everything that has changed since the last flush to the GPU.
+    /// </summary>
+    void Flush();
+
+    /// <summary>
+    /// Gets this atlas's generation, which changes whenever existing glyphs are moved or evicted.
+    /// </summary>
+    unsigned int GetGeneration() const;
+
+    /// <summary>
+    /// Gets the rectangle of the given entry.
+    /// </summary>
+    /// <param name="entry">The entry.</param>
+    UintRect GetRect( unsigned int entry ) const;
+
+    /// <summary>
+    /// Gets this atlas's size, in pixels.
+    /// </summary>
+    unsigned int GetSize() const;
+
+    /// <summary>
+    /// Gets the texture for this atlas. Call Flush first to ensure the texture is up to date.
+    /// </summary>
+    std::shared_ptr<Texture2D> GetTexture() const;
+
+    /// <summary>
+    /// Checks to see if the given entry is still in the atlas.
+    /// </summary>
+    /// <param name="entry">The entry.</param>
+    bool IsResident( unsigned int entry ) const;
+
+    /// <summary>
+    /// Marks the given entry as having just been used.
+    /// </summary>
+    /// <param name="entry">The entry.</param>
+    void Touch( unsigned int entry );
+};
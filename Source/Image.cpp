@@ -3,14 +3,161 @@
 #include "Image.hpp"
 #include "Texture2D.hpp"
 #include "DirectX.hpp"
+#include "ThreadPool.hpp"
 #include <FreeImage.h>
+#include <algorithm>
 #include <locale>
+#include <math.h>
+#include <mutex>
+#include <xmmintrin.h>
 #if defined( _DEBUG ) || defined( DEBUG )
 #   include <iostream>
 #endif
 
 using namespace DirectX;
 
+// The number of entries in the linear to sRGB table
+static const unsigned int LinearToSrgbEntries = 4096;
+
+// The Kaiser filter's radius (in destination pixels) and shape
+static const float KaiserRadius = 3.0f;
+static const float KaiserAlpha = 4.0f;
+
+// The number of rows each thread pool job works on
+static const size_t RowsPerJob = 16;
+
+static float SrgbToLinearTable[ 256 ];
+static unsigned char LinearToSrgbTable[ LinearToSrgbEntries ];
+static std::once_flag ConversionTablesBuilt;
+
+/// <summary>
+/// Defines the taps a separable filter reads for each destination pixel along one axis.
+/// </summary>
+struct FilterWeights
+{
+    std::vector<unsigned int> Offsets;
+    std::vector<unsigned int> Indices;
+    std::vector<float> Weights;
+};
+
+// Builds the sRGB conversion tables
+static void BuildConversionTables()
+{
+    for ( unsigned int i = 0; i < 256; ++i )
+    {
+        float value = i / 255.0f;
+        SrgbToLinearTable[ i ] = ( value <= 0.04045f ) ? value / 12.92f : powf( ( value + 0.055f ) / 1.055f, 2.4f );
+    }
+
+    for ( unsigned int i = 0; i < LinearToSrgbEntries; ++i )
+    {
+        float value = i / static_cast<float>( LinearToSrgbEntries - 1 );
+        float encoded = ( value <= 0.0031308f ) ? value * 12.92f : 1.055f * powf( value, 1.0f / 2.4f ) - 0.055f;
+        LinearToSrgbTable[ i ] = static_cast<unsigned char>( encoded * 255.0f + 0.5f );
+    }
+}
+
+// Evaluates the zeroth order modified Bessel function of the first kind
+static float BesselI0( float x )
+{
+    float halfX = x * 0.5f;
+    float sum = 1.0f;
+    float term = 1.0f;
+    for ( int k = 1; k < 32; ++k )
+    {
+        float factor = halfX / k;
+        term *= factor * factor;
+        sum += term;
+        if ( term < sum * 1e-7f )
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Evaluates the normalized sinc function
+static float Sinc( float x )
+{
+    if ( fabsf( x ) < 1e-5f )
+    {
+        return 1.0f;
+    }
+    float pix = XM_PI * x;
+    return sinf( pix ) / pix;
+}
+
+// Builds the taps for resampling one axis
+static void BuildFilterWeights( unsigned int sourceSize, unsigned int destinationSize, ImageFilter filter, FilterWeights& weights )
+{
+    // When shrinking, the filter is widened to cover every source pixel that lands in a destination pixel
+    const float scale = sourceSize / static_cast<float>( destinationSize );
+    const float footprint = std::max( scale, 1.0f );
+    const float radius = ( filter == ImageFilter::Box ? 0.5f : KaiserRadius ) * footprint;
+    const float kaiserScale = 1.0f / BesselI0( KaiserAlpha );
+
+    weights.Offsets.clear();
+    weights.Indices.clear();
+    weights.Weights.clear();
+    weights.Offsets.push_back( 0 );
+
+    for ( unsigned int index = 0; index < destinationSize; ++index )
+    {
+        float center = ( index + 0.5f ) * scale;
+        int first = static_cast<int>( floorf( center - radius ) );
+        int last = static_cast<int>( ceilf( center + radius ) );
+        size_t start = weights.Weights.size();
+        float total = 0.0f;
+
+        for ( int source = first; source <= last; ++source )
+        {
+            float weight = 0.0f;
+            if ( filter == ImageFilter::Box )
+            {
+                // A box weighs each source pixel by how much of it the destination pixel covers
+                weight = std::min( source + 1.0f, center + radius ) - std::max( static_cast<float>( source ), center - radius );
+            }
+            else
+            {
+                float x = ( source + 0.5f - center ) / footprint;
+                float window = x / KaiserRadius;
+                if ( fabsf( window ) < 1.0f )
+                {
+                    weight = Sinc( x ) * BesselI0( KaiserAlpha * sqrtf( 1.0f - window * window ) ) * kaiserScale;
+                }
+            }
+
+            if ( filter == ImageFilter::Box ? weight <= 0.0f : weight == 0.0f )
+            {
+                continue;
+            }
+
+            int clamped = std::min( std::max( source, 0 ), static_cast<int>( sourceSize ) - 1 );
+            weights.Indices.push_back( static_cast<unsigned int>( clamped ) );
+            weights.Weights.push_back( weight );
+            total += weight;
+        }
+
+        // Normalize the taps so that flat areas stay flat
+        if ( total != 0.0f )
+        {
+            for ( size_t tap = start; tap < weights.Weights.size(); ++tap )
+            {
+                weights.Weights[ tap ] /= total;
+            }
+        }
+        else
+        {
+            weights.Indices.resize( start );
+            weights.Weights.resize( start );
+            weights.Indices.push_back( std::min( static_cast<unsigned int>( center ), sourceSize - 1 ) );
+            weights.Weights.push_back( 1.0f );
+        }
+
+        weights.Offsets.push_back( static_cast<unsigned int>( weights.Weights.size() ) );
+    }
+}
+
 // Gets an image format based on a file name
 static FREE_IMAGE_FORMAT GetImageFormatFromFileName( const std::string& fname )
 {
@@ -137,6 +284,181 @@ void Image::Dispose()
     _pixels.clear();
 }
 
+// Converts this image's pixels to linear floating point RGBA
+void Image::DecodeLinear( bool isSrgb, std::vector<float>& linear ) const
+{
+    std::call_once( ConversionTablesBuilt, BuildConversionTables );
+
+    linear.resize( _pixels.size() );
+    const unsigned char* pixels = &_pixels[ 0 ];
+    float* output = &linear[ 0 ];
+    const unsigned int width = _width;
+    ThreadPool::ParallelFor( _height, RowsPerJob, [ = ]( size_t begin, size_t end )
+    {
+        for ( size_t index = begin * width * 4; index < end * width * 4; index += 4 )
+        {
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                unsigned char value = pixels[ index + channel ];
+                output[ index + channel ] = isSrgb ? SrgbToLinearTable[ value ] : value / 255.0f;
+            }
+            output[ index + 3 ] = pixels[ index + 3 ] / 255.0f;
+        }
+    } );
+}
+
+// Replaces this image's pixels with linear floating point RGBA pixels
+void Image::EncodeLinear( const std::vector<float>& linear, unsigned int width, unsigned int height, bool isSrgb )
+{
+    std::call_once( ConversionTablesBuilt, BuildConversionTables );
+
+    _width = width;
+    _height = height;
+    _pixels.resize( width * height * 4 );
+
+    // sRGB colors are scaled to an entry in the conversion table, everything else straight to a byte
+    const float* input = &linear[ 0 ];
+    unsigned char* pixels = &_pixels[ 0 ];
+    const float colorRange = isSrgb ? LinearToSrgbEntries - 1.0f : 255.0f;
+    ThreadPool::ParallelFor( height, RowsPerJob, [ = ]( size_t begin, size_t end )
+    {
+        // Sharpening filters can overshoot, so clamp before converting
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps( 1.0f );
+        const __m128 scale = _mm_set_ps( 255.0f, colorRange, colorRange, colorRange );
+        const __m128 half = _mm_set1_ps( 0.5f );
+
+        for ( size_t index = begin * width * 4; index < end * width * 4; index += 4 )
+        {
+            __m128 value = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( input + index ), zero ), one );
+            value = _mm_add_ps( _mm_mul_ps( value, scale ), half );
+
+            float scaled[ 4 ];
+            _mm_storeu_ps( scaled, value );
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                unsigned int entry = static_cast<unsigned int>( scaled[ channel ] );
+                pixels[ index + channel ] = isSrgb ? LinearToSrgbTable[ entry ] : static_cast<unsigned char>( entry );
+            }
+            pixels[ index + 3 ] = static_cast<unsigned char>( scaled[ 3 ] );
+        }
+    } );
+}
+
+// Builds every mip level below this image
+bool Image::GenerateMips( ImageFilter filter, bool isSrgb, std::vector<Image>& mips ) const
+{
+    mips.clear();
+    if ( _width == 0 || _height == 0 )
+    {
+        return false;
+    }
+
+    // Count the levels up front so the images never have to be copied when the list grows
+    unsigned int levelCount = 0;
+    for ( unsigned int width = _width, height = _height; width > 1 || height > 1; ++levelCount )
+    {
+        width = std::max( width / 2, 1U );
+        height = std::max( height / 2, 1U );
+    }
+    mips.resize( levelCount );
+
+    // Each level is filtered from the previous one while it is still linear floating point
+    std::vector<float> current;
+    std::vector<float> next;
+    DecodeLinear( isSrgb, current );
+
+    unsigned int width = _width;
+    unsigned int height = _height;
+    for ( unsigned int level = 0; level < levelCount; ++level )
+    {
+        unsigned int nextWidth = std::max( width / 2, 1U );
+        unsigned int nextHeight = std::max( height / 2, 1U );
+        Resample( current, width, height, next, nextWidth, nextHeight, filter );
+        mips[ level ].EncodeLinear( next, nextWidth, nextHeight, isSrgb );
+
+        current.swap( next );
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    return true;
+}
+
+// Resamples linear floating point RGBA pixels
+void Image::Resample( const std::vector<float>& source, unsigned int sourceWidth, unsigned int sourceHeight,
+                      std::vector<float>& destination, unsigned int width, unsigned int height, ImageFilter filter )
+{
+    FilterWeights horizontal;
+    FilterWeights vertical;
+    BuildFilterWeights( sourceWidth, width, filter, horizontal );
+    BuildFilterWeights( sourceHeight, height, filter, vertical );
+
+    std::vector<float> intermediate( width * sourceHeight * 4 );
+    destination.resize( width * height * 4 );
+
+    // Filter each row horizontally, one RGBA pixel per SSE register
+    const float* input = &source[ 0 ];
+    float* temporary = &intermediate[ 0 ];
+    ThreadPool::ParallelFor( sourceHeight, RowsPerJob, [ & ]( size_t begin, size_t end )
+    {
+        for ( size_t y = begin; y < end; ++y )
+        {
+            const float* row = input + y * sourceWidth * 4;
+            float* output = temporary + y * width * 4;
+            for ( unsigned int x = 0; x < width; ++x )
+            {
+                __m128 sum = _mm_setzero_ps();
+                for ( unsigned int tap = horizontal.Offsets[ x ]; tap < horizontal.Offsets[ x + 1 ]; ++tap )
+                {
+                    __m128 pixel = _mm_loadu_ps( row + horizontal.Indices[ tap ] * 4 );
+                    sum = _mm_add_ps( sum, _mm_mul_ps( pixel, _mm_set1_ps( horizontal.Weights[ tap ] ) ) );
+                }
+                _mm_storeu_ps( output + x * 4, sum );
+            }
+        }
+    } );
+
+    // Then filter vertically by accumulating whole weighted rows, which keeps the reads sequential
+    float* output = &destination[ 0 ];
+    ThreadPool::ParallelFor( height, RowsPerJob, [ & ]( size_t begin, size_t end )
+    {
+        for ( size_t y = begin; y < end; ++y )
+        {
+            float* target = output + y * width * 4;
+            std::fill( target, target + width * 4, 0.0f );
+
+            for ( unsigned int tap = vertical.Offsets[ y ]; tap < vertical.Offsets[ y + 1 ]; ++tap )
+            {
+                const float* row = temporary + vertical.Indices[ tap ] * width * 4;
+                const __m128 weight = _mm_set1_ps( vertical.Weights[ tap ] );
+                for ( unsigned int x = 0; x < width * 4; x += 4 )
+                {
+                    __m128 sum = _mm_loadu_ps( target + x );
+                    sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( row + x ), weight ) );
+                    _mm_storeu_ps( target + x, sum );
+                }
+            }
+        }
+    } );
+}
+
+// Resizes this image into another image
+bool Image::Resize( unsigned int width, unsigned int height, ImageFilter filter, bool isSrgb, Image& destination ) const
+{
+    if ( _width == 0 || _height == 0 || width == 0 || height == 0 )
+    {
+        return false;
+    }
+
+    std::vector<float> linear;
+    std::vector<float> resized;
+    DecodeLinear( isSrgb, linear );
+    Resample( linear, _width, _height, resized, width, height, filter );
+    destination.EncodeLinear( resized, width, height, isSrgb );
+    return true;
+}
+
 // Attempt to load an image file
 bool Image::LoadFromFile( const std::string& fname )
 {
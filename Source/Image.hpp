@@ -4,6 +4,15 @@
 #include <string>
 #include <vector>
 
+/// <summary>
+/// An enumeration of the filters an image can be resampled with.
+/// </summary>
+enum class ImageFilter
+{
+    Box,
+    Kaiser
+};
+
 /// <summary>
 /// Defines an image.
 /// </summary>
@@ -11,6 +20,7 @@ class Image
 {
     friend class Font;
     friend class Texture2D;
+    friend class TextureCompressor;
 
     std::vector<unsigned char> _pixels;
     unsigned int _width;
@@ -29,6 +39,35 @@ class Image
     /// </summary>
     void Dispose();
 
+    /// <summary>
+    /// Converts this image's pixels to linear floating point RGBA.
+    /// </summary>
+    /// <param name="isSrgb">True if the color channels are sRGB encoded.</param>
+    /// <param name="linear">Receives the linear pixels.</param>
+    void DecodeLinear( bool isSrgb, std::vector<float>& linear ) const;
+
+    /// <summary>
+    /// Replaces this image's pixels with the given linear floating point RGBA pixels.
+    /// </summary>
+    /// <param name="linear">The linear pixels.</param>
+    /// <param name="width">The width of the pixels.</param>
+    /// <param name="height">The height of the pixels.</param>
+    /// <param name="isSrgb">True to sRGB encode the color channels.</param>
+    void EncodeLinear( const std::vector<float>& linear, unsigned int width, unsigned int height, bool isSrgb );
+
+    /// <summary>
+    /// Resamples linear floating point RGBA pixels with a separable filter.
+    /// </summary>
+    /// <param name="source">The source pixels.</param>
+    /// <param name="sourceWidth">The width of the source pixels.</param>
+    /// <param name="sourceHeight">The height of the source pixels.</param>
+    /// <param name="destination">Receives the resampled pixels.</param>
+    /// <param name="width">The width to resample to.</param>
+    /// <param name="height">The height to resample to.</param>
+    /// <param name="filter">The filter to use.</param>
+    static void Resample( const std::vector<float>& source, unsigned int sourceWidth, unsigned int sourceHeight,
+                          std::vector<float>& destination, unsigned int width, unsigned int height, ImageFilter filter );
+
 public:
     /// <summary>
     /// Creates a new image.
@@ -40,6 +79,15 @@ public:
     /// </summary>
     ~Image();
 
+    /// <summary>
+    /// Builds every mip level below this image, down to 1x1. Filtering happens in linear space, and
+    /// large levels are split across the thread pool.
+    /// </summary>
+    /// <param name="filter">The filter to use.</param>
+    /// <param name="isSrgb">True if the color channels are sRGB encoded, false if they hold linear data such as normals.</param>
+    /// <param name="mips">Receives the mip levels, largest first.</param>
+    bool GenerateMips( ImageFilter filter, bool isSrgb, std::vector<Image>& mips ) const;
+
     /// <summary>
     /// Gets this image's height.
     /// </summary>
@@ -50,6 +98,16 @@ public:
     /// </summary>
     unsigned int GetWidth() const;
 
+    /// <summary>
+    /// Resizes this image into another image. Filtering happens in linear space, and large images are split across the thread pool.
+    /// </summary>
+    /// <param name="width">The new width.</param>
+    /// <param name="height">The new height.</param>
+    /// <param name="filter">The filter to use.</param>
+    /// <param name="isSrgb">True if the color channels are sRGB encoded, false if they hold linear data such as normals.</param>
+    /// <param name="destination">Receives the resized image.</param>
+    bool Resize( unsigned int width, unsigned int height, ImageFilter filter, bool isSrgb, Image& destination ) const;
+
     /// <summary>
     /// Attempts to save this image's data to the given file.
     /// </summary>
@@ -0,0 +1,58 @@
+#include "Light.hpp"
+#include "GameObject.hpp"
+#include "LightManager.hpp"
+#include <algorithm>
+
+// Creates a new light
+Light::Light( GameObject* gameObject )
+    : Component( gameObject )
+    , _diffuseColor( 1.0f, 1.0f, 1.0f, 1.0f )
+    , _range( 10.0f )
+{
+    LightManager::AddLight( this );
+}
+
+// Destroys this light
+Light::~Light()
+{
+    LightManager::RemoveLight( this );
+}
+
+// Gets this light's color
+DirectX::XMFLOAT4 Light::GetDiffuseColor() const
+{
+    return _diffuseColor;
+}
+
+// Gets this light as a point light
+PointLight Light::GetPointLight() const
+{
+    PointLight light;
+    light.DiffuseColor = _diffuseColor;
+    light.Position = _gameObject->GetTransform()->GetPosition();
+    light.Range = _range;
+    return light;
+}
+
+// Gets this light's range
+float Light::GetRange() const
+{
+    return _range;
+}
+
+// Sets this light's color
+void Light::SetDiffuseColor( const DirectX::XMFLOAT4& color )
+{
+    _diffuseColor = color;
+}
+
+// Sets this light's range
+void Light::SetRange( float range )
+{
+    _range = std::max( range, 0.001f );
+}
+
+// Updates this light
+void Light::Update()
+{
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Component.hpp"
+#include "Shaders\PointLight.hpp"
+
+/// <summary>
+/// Defines a point light component. The light sits at its game object's position.
+/// </summary>
+class Light : public Component
+{
+    DirectX::XMFLOAT4 _diffuseColor;
+    float _range;
+
+public:
+    /// <summary>
+    /// Creates a new light.
+    /// </summary>
+    /// <param name="gameObject">The game object this light belongs to.</param>
+    Light( GameObject* gameObject );
+
+    /// <summary>
+    /// Destroys this light.
+    /// </summary>
+    ~Light();
+
+    /// <summary>
+    /// Gets this light's color.
+    /// </summary>
+    DirectX::XMFLOAT4 GetDiffuseColor() const;
+
+    /// <summary>
+    /// Gets this light as a point light, positioned where its game object is.
+    /// </summary>
+    PointLight GetPointLight() const;
+
+    /// <summary>
+    /// Gets the distance at which this light fades out completely.
+    /// </summary>
+    float GetRange() const;
+
+    /// <summary>
+    /// Sets this light's color.
+    /// </summary>
+    /// <param name="color">The color.</param>
+    void SetDiffuseColor( const DirectX::XMFLOAT4& color );
+
+    /// <summary>
+    /// Sets the distance at which this light fades out completely.
+    /// </summary>
+    /// <param name="range">The range.</param>
+    void SetRange( float range );
+
+    /// <summary>
+    /// Updates this light.
+    /// </summary>
+    void Update() override;
+};
@@ -0,0 +1,328 @@
+#include "LightManager.hpp"
+#include "GameObject.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+using namespace DirectX;
+
+ID3D11Device*                               LightManager::_device = nullptr;
+ID3D11DeviceContext*                        LightManager::_deviceContext = nullptr;
+Cache<Light*>                               LightManager::_lights;
+std::vector<PointLight>                     LightManager::_pointLights;
+std::vector<float>                          LightManager::_viewX;
+std::vector<float>                          LightManager::_viewY;
+std::vector<float>                          LightManager::_viewZ;
+std::vector<float>                          LightManager::_radius;
+std::vector<LightManager::SliceBins>        LightManager::_slices;
+ComPtr<ID3D11Buffer>                        LightManager::_lightBuffer;
+ComPtr<ID3D11Buffer>                        LightManager::_clusterBuffer;
+ComPtr<ID3D11Buffer>                        LightManager::_indexBuffer;
+ComPtr<ID3D11ShaderResourceView>            LightManager::_lightView;
+ComPtr<ID3D11ShaderResourceView>            LightManager::_clusterView;
+ComPtr<ID3D11ShaderResourceView>            LightManager::_indexView;
+XMFLOAT4                                    LightManager::_clusterScale( 0.0f, 0.0f, 0.0f, 0.0f );
+UINT                                        LightManager::_lightCount = 0;
+UINT                                        LightManager::_indexCount = 0;
+
+// Converts a normalized device coordinate into the index of the cluster it's in
+static UINT ToClusterIndex( float ndc, UINT count )
+{
+    float index = ( ndc * 0.5f + 0.5f ) * count;
+    return static_cast<UINT>( std::min( std::max( index, 0.0f ), count - 1.0f ) );
+}
+
+// Adds a light
+void LightManager::AddLight( Light* light )
+{
+    _lights.Add( light );
+}
+
+// Binds this frame's lights to a shader
+bool LightManager::Apply( ISimpleShader* shader )
+{
+    if ( !shader->SetShaderResourceView( "LightClusters", _clusterView.Get() ) )
+    {
+        return false;
+    }
+
+    UINT clusterCount[ 4 ] = { ClusterCountX, ClusterCountY, ClusterCountZ, _lightCount };
+    shader->SetShaderResourceView( "PointLights", _lightView.Get() );
+    shader->SetShaderResourceView( "LightIndices", _indexView.Get() );
+    shader->SetFloat4( "ClusterScale", _clusterScale );
+    shader->SetData( "ClusterCount", clusterCount, sizeof( clusterCount ) );
+    return true;
+}
+
+// Bins the lights that reach into one depth slice
+void LightManager::BinSlice( UINT slice, float nearDepth, float farDepth, float projectionX, float projectionY )
+{
+    SliceBins& bins = _slices[ slice ];
+    bins.Counts.assign( ClustersPerSlice, 0 );
+    bins.Rects.clear();
+
+    // Test four lights' depth ranges against the slice at once. The padding lights have no radius
+    // and sit behind the camera, so they never pass
+    const __m128 sliceNear = _mm_set1_ps( nearDepth );
+    const __m128 sliceFar = _mm_set1_ps( farDepth );
+    for ( size_t first = 0; first < _viewZ.size(); first += 4 )
+    {
+        __m128 z = _mm_loadu_ps( &_viewZ[ first ] );
+        __m128 r = _mm_loadu_ps( &_radius[ first ] );
+        __m128 reaches = _mm_and_ps( _mm_cmple_ps( _mm_sub_ps( z, r ), sliceFar ),
+                                     _mm_cmpge_ps( _mm_add_ps( z, r ), sliceNear ) );
+        int mask = _mm_movemask_ps( reaches );
+        while ( mask )
+        {
+            UINT lane = 0;
+            while ( !( mask & ( 1 << lane ) ) )
+            {
+                ++lane;
+            }
+            mask &= ~( 1 << lane );
+            size_t light = first + lane;
+
+            // Bound the light's sphere across the part of the slice it reaches. Each edge is
+            // furthest out where the slice is shallowest, unless it's on the other side of the center
+            float x = _viewX[ light ];
+            float y = _viewY[ light ];
+            float radius = _radius[ light ];
+            float z0 = std::max( nearDepth, _viewZ[ light ] - radius );
+            float z1 = std::min( farDepth, _viewZ[ light ] + radius );
+            float left   = ( ( x - radius >= 0.0f ) ? ( x - radius ) / z1 : ( x - radius ) / z0 ) * projectionX;
+            float right  = ( ( x + radius >= 0.0f ) ? ( x + radius ) / z0 : ( x + radius ) / z1 ) * projectionX;
+            float bottom = ( ( y - radius >= 0.0f ) ? ( y - radius ) / z1 : ( y - radius ) / z0 ) * projectionY;
+            float top    = ( ( y + radius >= 0.0f ) ? ( y + radius ) / z0 : ( y + radius ) / z1 ) * projectionY;
+            if ( left > 1.0f || right < -1.0f || bottom > 1.0f || top < -1.0f )
+            {
+                continue;
+            }
+
+            // Rows count down from the top of the screen, like pixels do
+            UINT minX = ToClusterIndex( left, ClusterCountX );
+            UINT maxX = ToClusterIndex( right, ClusterCountX );
+            UINT minY = ClusterCountY - 1 - ToClusterIndex( top, ClusterCountY );
+            UINT maxY = ClusterCountY - 1 - ToClusterIndex( bottom, ClusterCountY );
+            bins.Rects.push_back( static_cast<UINT>( light ) );
+            bins.Rects.push_back( minX | ( maxX << 8 ) | ( minY << 16 ) | ( maxY << 24 ) );
+            for ( UINT row = minY; row <= maxY; ++row )
+            {
+                for ( UINT column = minX; column <= maxX; ++column )
+                {
+                    ++bins.Counts[ row * ClusterCountX + column ];
+                }
+            }
+        }
+    }
+
+    // Lay every cluster's list out one after the other, then fill them in
+    bins.Offsets.resize( ClustersPerSlice );
+    UINT total = 0;
+    for ( UINT cluster = 0; cluster < ClustersPerSlice; ++cluster )
+    {
+        bins.Offsets[ cluster ] = total;
+        total += bins.Counts[ cluster ];
+    }
+
+    bins.Indices.resize( total );
+    std::vector<UINT>& cursors = bins.Counts;
+    cursors.assign( ClustersPerSlice, 0 );
+    for ( size_t rect = 0; rect < bins.Rects.size(); rect += 2 )
+    {
+        UINT light = bins.Rects[ rect ];
+        UINT bounds = bins.Rects[ rect + 1 ];
+        for ( UINT row = ( bounds >> 16 ) & 0xFF; row <= ( bounds >> 24 ); ++row )
+        {
+            for ( UINT column = bounds & 0xFF; column <= ( ( bounds >> 8 ) & 0xFF ); ++column )
+            {
+                UINT cluster = row * ClusterCountX + column;
+                bins.Indices[ bins.Offsets[ cluster ] + cursors[ cluster ]++ ] = light;
+            }
+        }
+    }
+}
+
+// Creates a dynamic structured buffer and its view
+bool LightManager::CreateStructuredBuffer( UINT stride, UINT count, ComPtr<ID3D11Buffer>& buffer, ComPtr<ID3D11ShaderResourceView>& view )
+{
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.ByteWidth = stride * count;
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = stride;
+    if ( FAILED( _device->CreateBuffer( &desc, nullptr, buffer.GetAddress() ) ) )
+    {
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+    ZeroMemory( &viewDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.NumElements = count;
+    return SUCCEEDED( _device->CreateShaderResourceView( buffer.Get(), &viewDesc, view.GetAddress() ) );
+}
+
+// Gets the number of lights binned this frame
+UINT LightManager::GetLightCount()
+{
+    return _lightCount;
+}
+
+// Gets the number of light indices used this frame
+UINT LightManager::GetLightIndexCount()
+{
+    return _indexCount;
+}
+
+// Creates the light and cluster buffers
+bool LightManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+
+    _slices.resize( ClusterCountZ );
+    return CreateStructuredBuffer( sizeof( PointLight ), MaxLights, _lightBuffer, _lightView )
+        && CreateStructuredBuffer( sizeof( UINT ) * 2, ClusterCount, _clusterBuffer, _clusterView )
+        && CreateStructuredBuffer( sizeof( UINT ), MaxLightIndices, _indexBuffer, _indexView );
+}
+
+// Removes a light
+void LightManager::RemoveLight( Light* light )
+{
+    _lights.Remove( light );
+}
+
+// Releases the light and cluster buffers
+void LightManager::Shutdown()
+{
+    _indexView.Reset();
+    _clusterView.Reset();
+    _lightView.Reset();
+    _indexBuffer.Reset();
+    _clusterBuffer.Reset();
+    _lightBuffer.Reset();
+    _slices.clear();
+
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Bins every light into the camera's clusters and uploads them
+void LightManager::Update( const Camera* camera, float width, float height )
+{
+    if ( !_device || !camera )
+    {
+        return;
+    }
+
+    // Gather the enabled lights
+    _pointLights.clear();
+    for ( auto& light : _lights )
+    {
+        if ( light->IsEnabled() && _pointLights.size() < MaxLights )
+        {
+            _pointLights.push_back( light->GetPointLight() );
+        }
+    }
+    _lightCount = static_cast<UINT>( _pointLights.size() );
+
+    // Move the lights into view space, splitting them into arrays the binning kernel can read four at a time
+    size_t paddedCount = ( _pointLights.size() + 3 ) & ~static_cast<size_t>( 3 );
+    _viewX.assign( paddedCount, 0.0f );
+    _viewY.assign( paddedCount, 0.0f );
+    _viewZ.assign( paddedCount, -FLT_MAX );
+    _radius.assign( paddedCount, 0.0f );
+
+    XMFLOAT4X4 view = camera->GetView();
+    XMMATRIX viewMatrix = XMMatrixTranspose( XMLoadFloat4x4( &view ) );
+    for ( size_t index = 0; index < _pointLights.size(); ++index )
+    {
+        XMFLOAT3 position;
+        XMStoreFloat3( &position, XMVector3TransformCoord( XMLoadFloat3( &_pointLights[ index ].Position ), viewMatrix ) );
+        _viewX[ index ] = position.x;
+        _viewY[ index ] = position.y;
+        _viewZ[ index ] = position.z;
+        _radius[ index ] = _pointLights[ index ].Range;
+    }
+
+    // The depth slices are spaced exponentially from the near plane to the far plane, so
+    // slice = log( depth ) * scale + bias
+    float nearClip = camera->GetNearClip();
+    float farClip = camera->GetFarClip();
+    float depthScale = ClusterCountZ / logf( farClip / nearClip );
+    _clusterScale = XMFLOAT4( ClusterCountX / width, ClusterCountY / height, depthScale, -logf( nearClip ) * depthScale );
+
+    // Every slice only writes its own bins, so they can all be binned at once
+    XMFLOAT4X4 projection = camera->GetProjection();
+    float projectionX = projection._11;
+    float projectionY = projection._22;
+    ThreadPool::ParallelFor( ClusterCountZ, 2, [ = ]( size_t begin, size_t end )
+    {
+        for ( size_t slice = begin; slice < end; ++slice )
+        {
+            float sliceNear = nearClip * powf( farClip / nearClip, static_cast<float>( slice ) / ClusterCountZ );
+            float sliceFar = nearClip * powf( farClip / nearClip, static_cast<float>( slice + 1 ) / ClusterCountZ );
+            BinSlice( static_cast<UINT>( slice ), sliceNear, sliceFar, projectionX, projectionY );
+        }
+    } );
+
+    Upload();
+}
+
+// Uploads the lights and the binned clusters
+void LightManager::Upload()
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if ( !_pointLights.empty() && SUCCEEDED( _deviceContext->Map( _lightBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped ) ) )
+    {
+        memcpy( mapped.pData, &_pointLights[ 0 ], sizeof( PointLight ) * _pointLights.size() );
+        _deviceContext->Unmap( _lightBuffer.Get(), 0 );
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedClusters;
+    D3D11_MAPPED_SUBRESOURCE mappedIndices;
+    if ( FAILED( _deviceContext->Map( _clusterBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedClusters ) ) )
+    {
+        return;
+    }
+    if ( FAILED( _deviceContext->Map( _indexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedIndices ) ) )
+    {
+        _deviceContext->Unmap( _clusterBuffer.Get(), 0 );
+        return;
+    }
+
+    // Put the slices' lists one after the other. Once the index buffer is full, the remaining clusters
+    // lose their lights rather than reading past the end
+    UINT* clusters = static_cast<UINT*>( mappedClusters.pData );
+    UINT* indices = static_cast<UINT*>( mappedIndices.pData );
+    _indexCount = 0;
+    for ( UINT slice = 0; slice < ClusterCountZ; ++slice )
+    {
+        const SliceBins& bins = _slices[ slice ];
+        UINT sliceStart = _indexCount;
+        UINT sliceCount = std::min( static_cast<UINT>( bins.Indices.size() ), MaxLightIndices - sliceStart );
+        if ( sliceCount > 0 )
+        {
+            memcpy( indices + sliceStart, &bins.Indices[ 0 ], sliceCount * sizeof( UINT ) );
+        }
+        _indexCount += sliceCount;
+
+        for ( UINT cluster = 0; cluster < ClustersPerSlice; ++cluster )
+        {
+            UINT offset = std::min( bins.Offsets[ cluster ], sliceCount );
+            UINT* range = clusters + ( slice * ClustersPerSlice + cluster ) * 2;
+            range[ 0 ] = sliceStart + offset;
+            range[ 1 ] = std::min( bins.Counts[ cluster ], sliceCount - offset );
+        }
+    }
+
+    _deviceContext->Unmap( _indexBuffer.Get(), 0 );
+    _deviceContext->Unmap( _clusterBuffer.Get(), 0 );
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Cache.hpp"
+#include "Camera.hpp"
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Light.hpp"
+#include "SimpleShader.h"
+#include <vector>
+
+/// <summary>
+/// Defines the static light manager. Every frame it bins the point lights into clusters, which
+/// split the view frustum into tiles across the screen and exponentially spaced slices of depth,
+/// and uploads each cluster's list of lights. The default pixel shader then only has to light a
+/// pixel with the lights that can actually reach its cluster.
+/// </summary>
+class LightManager
+{
+    ImplementStaticClass( LightManager );
+
+public:
+    static const UINT ClusterCountX = 16;
+    static const UINT ClusterCountY = 9;
+    static const UINT ClusterCountZ = 24;
+    static const UINT MaxLights = 1024;
+    static const UINT MaxLightIndices = 64 * 1024;
+
+private:
+    static const UINT ClustersPerSlice = ClusterCountX * ClusterCountY;
+    static const UINT ClusterCount = ClustersPerSlice * ClusterCountZ;
+
+    /// <summary>
+    /// Defines the lights binned into one depth slice.
+    /// </summary>
+    struct SliceBins
+    {
+        std::vector<UINT> Offsets;
+        std::vector<UINT> Counts;
+        std::vector<UINT> Indices;
+        std::vector<UINT> Rects;
+    };
+
+    static ID3D11Device* _device;
+    static ID3D11DeviceContext* _deviceContext;
+    static Cache<Light*> _lights;
+    static std::vector<PointLight> _pointLights;
+    static std::vector<float> _viewX;
+    static std::vector<float> _viewY;
+    static std::vector<float> _viewZ;
+    static std::vector<float> _radius;
+    static std::vector<SliceBins> _slices;
+    static ComPtr<ID3D11Buffer> _lightBuffer;
+    static ComPtr<ID3D11Buffer> _clusterBuffer;
+    static ComPtr<ID3D11Buffer> _indexBuffer;
+    static ComPtr<ID3D11ShaderResourceView> _lightView;
+    static ComPtr<ID3D11ShaderResourceView> _clusterView;
+    static ComPtr<ID3D11ShaderResourceView> _indexView;
+    static DirectX::XMFLOAT4 _clusterScale;
+    static UINT _lightCount;
+    static UINT _indexCount;
+
+    /// <summary>
+    /// Bins the lights that reach into one depth slice.
+    /// </summary>
+    /// <param name="slice">The index of the slice.</param>
+    /// <param name="nearDepth">The view depth the slice starts at.</param>
+    /// <param name="farDepth">The view depth the slice ends at.</param>
+    /// <param name="projectionX">How much the projection scales x by.</param>
+    /// <param name="projectionY">How much the projection scales y by.</param>
+    static void BinSlice( UINT slice, float nearDepth, float farDepth, float projectionX, float projectionY );
+
+    /// <summary>
+    /// Creates a dynamic structured buffer and its shader resource view.
+    /// </summary>
+    /// <param name="stride">The size of one element.</param>
+    /// <param name="count">The number of elements.</param>
+    /// <param name="buffer">Receives the buffer.</param>
+    /// <param name="view">Receives the view.</param>
+    static bool CreateStructuredBuffer( UINT stride, UINT count, ComPtr<ID3D11Buffer>& buffer, ComPtr<ID3D11ShaderResourceView>& view );
+
+    /// <summary>
+    /// Uploads the lights and the binned clusters.
+    /// </summary>
+    static void Upload();
+
+public:
+    /// <summary>
+    /// Adds a light to be binned every frame.
+    /// </summary>
+    /// <param name="light">The light.</param>
+    static void AddLight( Light* light );
+
+    /// <summary>
+    /// Binds this frame's lights and clusters to a shader.
+    /// </summary>
+    /// <param name="shader">The pixel shader.</param>
+    /// <returns>True if the shader reads the light clusters, false if not.</returns>
+    static bool Apply( ISimpleShader* shader );
+
+    /// <summary>
+    /// Gets the number of lights binned this frame.
+    /// </summary>
+    static UINT GetLightCount();
+
+    /// <summary>
+    /// Gets the number of light indices the clusters used this frame.
+    /// </summary>
+    static UINT GetLightIndexCount();
+
+    /// <summary>
+    /// Attempts to create the light and cluster buffers.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    static bool Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Removes a light.
+    /// </summary>
+    /// <param name="light">The light.</param>
+    static void RemoveLight( Light* light );
+
+    /// <summary>
+    /// Releases the light and cluster buffers.
+    /// </summary>
+    static void Shutdown();
+
+    /// <summary>
+    /// Bins every enabled light into the clusters of the given camera's view, and uploads the result.
+    /// </summary>
+    /// <param name="camera">The camera.</param>
+    /// <param name="width">The width of the screen, in pixels.</param>
+    /// <param name="height">The height of the screen, in pixels.</param>
+    static void Update( const Camera* camera, float width, float height );
+};
@@ -0,0 +1,209 @@
+#include "LineBatcher.hpp"
+#include <algorithm>
+
+using namespace DirectX;
+
+const UINT LineBatcher::InitialVertexCapacity = 8192;
+
+// Attempts to create a new line batcher
+std::shared_ptr<LineBatcher> LineBatcher::Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    std::shared_ptr<LineBatcher> batcher( new ( std::nothrow ) LineBatcher( device, deviceContext ) );
+    if ( !batcher )
+    {
+        return nullptr;
+    }
+
+    // Load the shaders
+    batcher->_vertexShader = std::make_shared<SimpleVertexShader>( device, deviceContext );
+    batcher->_pixelShader  = std::make_shared<SimplePixelShader>( device, deviceContext );
+    if ( !batcher->_vertexShader->LoadShaderFile( L"Shaders\\LineVertexShader.cso" ) ||
+         !batcher->_pixelShader->LoadShaderFile( L"Shaders\\LinePixelShader.cso" ) )
+    {
+        return nullptr;
+    }
+
+    // Create the buffer
+    if ( !batcher->CreateVertexBuffer( InitialVertexCapacity ) )
+    {
+        return nullptr;
+    }
+
+    return batcher;
+}
+
+// Creates a new line batcher
+LineBatcher::LineBatcher( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+    : _device( nullptr )
+    , _deviceContext( nullptr )
+    , _vertexCapacity( 0 )
+    , _ringOffset( 0 )
+    , _worldBaseVertex( 0 )
+    , _screenBaseVertex( 0 )
+    , _isUploaded( false )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+}
+
+// Destroys this line batcher
+LineBatcher::~LineBatcher()
+{
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Adds a world-space line
+void LineBatcher::AddLine( const XMFLOAT3& start, const XMFLOAT3& end, const XMFLOAT4& color )
+{
+    LineVertex vertex;
+    vertex.Color = color;
+
+    vertex.Position = start;
+    _worldVertices.push_back( vertex );
+    vertex.Position = end;
+    _worldVertices.push_back( vertex );
+}
+
+// Adds a screen-space line
+void LineBatcher::AddScreenLine( const XMFLOAT2& start, const XMFLOAT2& end, const XMFLOAT4& color )
+{
+    LineVertex vertex;
+    vertex.Color = color;
+
+    vertex.Position = XMFLOAT3( start.x, start.y, 0.0f );
+    _screenVertices.push_back( vertex );
+    vertex.Position = XMFLOAT3( end.x, end.y, 0.0f );
+    _screenVertices.push_back( vertex );
+}
+
+// Removes every line added this frame
+void LineBatcher::Clear()
+{
+    // Keep the capacity around, since the next frame will likely add about as many lines
+    _worldVertices.clear();
+    _screenVertices.clear();
+    _isUploaded = false;
+}
+
+// Creates the ring vertex buffer
+bool LineBatcher::CreateVertexBuffer( UINT vertexCapacity )
+{
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof( LineVertex ) * vertexCapacity;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    _vertexBuffer.Reset();
+    if ( FAILED( _device->CreateBuffer( &desc, nullptr, _vertexBuffer.GetAddress() ) ) )
+    {
+        _vertexCapacity = 0;
+        return false;
+    }
+
+    // Start "full" so that the first write discards
+    _vertexCapacity = vertexCapacity;
+    _ringOffset = vertexCapacity;
+    return true;
+}
+
+// Draws every screen-space line
+void LineBatcher::DrawScreenLines( StateTracker* stateTracker, const XMFLOAT4X4& projection )
+{
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4( &view, XMMatrixIdentity() );
+    DrawVertices( stateTracker, _screenBaseVertex, static_cast<UINT>( _screenVertices.size() ), view, projection );
+}
+
+// Draws a range of the uploaded vertices
+void LineBatcher::DrawVertices( StateTracker* stateTracker, UINT baseVertex, UINT vertexCount, const XMFLOAT4X4& view, const XMFLOAT4X4& projection )
+{
+    if ( !_isUploaded || vertexCount == 0 )
+    {
+        return;
+    }
+
+    _vertexShader->SetMatrix4x4( "View", view );
+    _vertexShader->SetMatrix4x4( "Projection", projection );
+    _vertexShader->SetShader( true );
+    _pixelShader->SetShader( true );
+
+    stateTracker->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_LINELIST );
+    stateTracker->SetVertexBuffer( _vertexBuffer.Get(), sizeof( LineVertex ) );
+    _deviceContext->Draw( vertexCount, baseVertex );
+}
+
+// Draws every world-space line
+void LineBatcher::DrawWorldLines( StateTracker* stateTracker, const XMFLOAT4X4& view, const XMFLOAT4X4& projection )
+{
+    DrawVertices( stateTracker, _worldBaseVertex, static_cast<UINT>( _worldVertices.size() ), view, projection );
+}
+
+// Gets the number of lines added this frame
+UINT LineBatcher::GetLineCount() const
+{
+    return static_cast<UINT>( ( _worldVertices.size() + _screenVertices.size() ) / 2 );
+}
+
+// Writes every line into the vertex buffer
+bool LineBatcher::Upload()
+{
+    _isUploaded = false;
+
+    UINT worldCount  = static_cast<UINT>( _worldVertices.size() );
+    UINT screenCount = static_cast<UINT>( _screenVertices.size() );
+    UINT vertexCount = worldCount + screenCount;
+    if ( vertexCount == 0 )
+    {
+        return true;
+    }
+
+    // Only grow the ring buffer when a frame genuinely needs more room than it has
+    if ( vertexCount > _vertexCapacity )
+    {
+        UINT capacity = std::max( _vertexCapacity, InitialVertexCapacity );
+        while ( capacity < vertexCount )
+        {
+            capacity *= 2;
+        }
+        if ( !CreateVertexBuffer( capacity ) )
+        {
+            return false;
+        }
+    }
+
+    // Append after last frame's lines if they fit, otherwise orphan the buffer and wrap around
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if ( _ringOffset + vertexCount > _vertexCapacity )
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        _ringOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if ( FAILED( _deviceContext->Map( _vertexBuffer.Get(), 0, mapType, 0, &mapped ) ) )
+    {
+        return false;
+    }
+
+    // World lines go first, with the screen lines right after them
+    LineVertex* dest = reinterpret_cast<LineVertex*>( mapped.pData ) + _ringOffset;
+    if ( worldCount > 0 )
+    {
+        memcpy( dest, &_worldVertices[ 0 ], sizeof( LineVertex ) * worldCount );
+    }
+    if ( screenCount > 0 )
+    {
+        memcpy( dest + worldCount, &_screenVertices[ 0 ], sizeof( LineVertex ) * screenCount );
+    }
+
+    _deviceContext->Unmap( _vertexBuffer.Get(), 0 );
+
+    _worldBaseVertex = _ringOffset;
+    _screenBaseVertex = _ringOffset + worldCount;
+    _ringOffset += vertexCount;
+    _isUploaded = true;
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "SimpleShader.h"
+#include "StateTracker.hpp"
+#include "Vertex.hpp"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Defines an immediate-mode line batcher. Lines are added from anywhere during a frame (line
+/// renderers, gameplay, physics debug drawing), written into a single growable dynamic ring
+/// buffer once, and drawn with one draw for world-space lines and one for screen-space lines.
+/// </summary>
+class LineBatcher
+{
+    ImplementNonCopyableClass( LineBatcher );
+    ImplementNonMovableClass( LineBatcher );
+
+    static const UINT InitialVertexCapacity;
+
+    ID3D11Device* _device;
+    ID3D11DeviceContext* _deviceContext;
+    ComPtr<ID3D11Buffer> _vertexBuffer;
+    std::shared_ptr<SimpleVertexShader> _vertexShader;
+    std::shared_ptr<SimplePixelShader> _pixelShader;
+    std::vector<LineVertex> _worldVertices;
+    std::vector<LineVertex> _screenVertices;
+    UINT _vertexCapacity;
+    UINT _ringOffset;
+    UINT _worldBaseVertex;
+    UINT _screenBaseVertex;
+    bool _isUploaded;
+
+    /// <summary>
+    /// Creates a new line batcher.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    LineBatcher( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Creates the ring vertex buffer with room for the given number of vertices.
+    /// </summary>
+    /// <param name="vertexCapacity">The number of vertices.</param>
+    bool CreateVertexBuffer( UINT vertexCapacity );
+
+    /// <summary>
+    /// Draws a range of the uploaded vertices as a line list.
+    /// </summary>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    /// <param name="baseVertex">The first vertex.</param>
+    /// <param name="vertexCount">The number of vertices.</param>
+    /// <param name="view">The (transposed) view matrix.</param>
+    /// <param name="projection">The (transposed) projection matrix.</param>
+    void DrawVertices( StateTracker* stateTracker, UINT baseVertex, UINT vertexCount, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection );
+
+public:
+    /// <summary>
+    /// Attempts to create a new line batcher.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    static std::shared_ptr<LineBatcher> Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Destroys this line batcher.
+    /// </summary>
+    ~LineBatcher();
+
+    /// <summary>
+    /// Adds a world-space line to be drawn this frame.
+    /// </summary>
+    /// <param name="start">The starting point.</param>
+    /// <param name="end">The ending point.</param>
+    /// <param name="color">The line's color.</param>
+    void AddLine( const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& end, const DirectX::XMFLOAT4& color );
+
+    /// <summary>
+    /// Adds a screen-space line (in pixels) to be drawn this frame.
+    /// </summary>
+    /// <param name="start">The starting point.</param>
+    /// <param name="end">The ending point.</param>
+    /// <param name="color">The line's color.</param>
+    void AddScreenLine( const DirectX::XMFLOAT2& start, const DirectX::XMFLOAT2& end, const DirectX::XMFLOAT4& color );
+
+    /// <summary>
+    /// Removes every line added this frame.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Draws every screen-space line with one draw. Upload must have been called first.
+    /// </summary>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    /// <param name="projection">The (transposed) screen projection matrix.</param>
+    void DrawScreenLines( StateTracker* stateTracker, const DirectX::XMFLOAT4X4& projection );
+
+    /// <summary>
+    /// Draws every world-space line with one draw. Upload must have been called first.
+    /// </summary>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    /// <param name="view">The (transposed) camera view matrix.</param>
+    /// <param name="projection">The (transposed) camera projection matrix.</param>
+    void DrawWorldLines( StateTracker* stateTracker, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection );
+
+    /// <summary>
+    /// Gets the number of lines added this frame.
+    /// </summary>
+    UINT GetLineCount() const;
+
+    /// <summary>
+    /// Writes every line added this frame into the vertex buffer with a single map, growing it if needed.
+    /// </summary>
+    bool Upload();
+};
@@ -8,9 +8,7 @@ LineMaterial::LineMaterial( GameObject* gameObject )
     : Material( gameObject )
     , _lineColor( 0, 0, 0, 0 )
 {
-    // Load the default vertex and pixel shaders
-    assert( _vertexShader->LoadShaderFile( L"Shaders\\LineVertexShader.cso" ) );
-    assert( _pixelShader->LoadShaderFile( L"Shaders\\LinePixelShader.cso" ) );
+    // The line batcher owns the line shaders and reads our color when it submits lines
 }
 
 // Destroys this line material
@@ -29,13 +27,3 @@ void LineMaterial::SetLineColor( const XMFLOAT4& color )
 {
     _lineColor = color;
 }
-
-// Sends this material's information to the shaders
-void LineMaterial::UpdateShaderData()
-{
-    // Send our variables
-    assert( _pixelShader->SetFloat4( "LineColor", _lineColor ) );
-
-    // Let the base class do its thing
-    Material::UpdateShaderData();
-}
@@ -32,9 +32,4 @@ public:
     /// </summary>
     /// <param name="color">The new color.</param>
     void SetLineColor( const DirectX::XMFLOAT4& color );
-
-    /// <summary>
-    /// Sends this material's information to the shaders.
-    /// </summary>
-    void UpdateShaderData() override;
 };
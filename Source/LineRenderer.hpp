@@ -2,22 +2,16 @@
 
 #include "Config.hpp"
 #include "Component.hpp"
-#include "ComPtr.hpp"
 #include "DirectX.hpp"
-#include "Vertex.hpp"
 
 /// <summary>
-/// Defines a line renderer.
+/// Defines a line renderer. Its line is drawn in screen space, along with every other line, by the render manager's line batcher.
 /// </summary>
 class LineRenderer : public Component
 {
-    friend class RenderManager;
-
 private:
-    LineVertex _points[ 2 ];
-    ComPtr<ID3D11Buffer> _vertexBuffer;
-    ComPtr<ID3D11Buffer> _indexBuffer;
-    bool _isMeshDirty;
+    DirectX::XMFLOAT2 _startPoint;
+    DirectX::XMFLOAT2 _endPoint;
 
 public:
     /// <summary>
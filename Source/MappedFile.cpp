@@ -0,0 +1,106 @@
+#include "MappedFile.hpp"
+
+static const UINT64 FnvOffsetBasis = 0xCBF29CE484222325ULL;
+static const UINT64 FnvPrime       = 0x00000100000001B3ULL;
+
+// Creates a new mapped file
+MappedFile::MappedFile()
+    : _file( INVALID_HANDLE_VALUE )
+    , _mapping( nullptr )
+    , _data( nullptr )
+    , _size( 0 )
+{
+}
+
+// Destroys this mapped file
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+// Unmaps and closes this file
+void MappedFile::Close()
+{
+    if ( _data )
+    {
+        UnmapViewOfFile( _data );
+        _data = nullptr;
+    }
+    if ( _mapping )
+    {
+        CloseHandle( _mapping );
+        _mapping = nullptr;
+    }
+    if ( _file != INVALID_HANDLE_VALUE )
+    {
+        CloseHandle( _file );
+        _file = INVALID_HANDLE_VALUE;
+    }
+    _size = 0;
+}
+
+// Gets this file's contents
+const unsigned char* MappedFile::GetData() const
+{
+    return _data;
+}
+
+// Gets this file's size
+size_t MappedFile::GetSize() const
+{
+    return _size;
+}
+
+// Hashes this file's contents
+UINT64 MappedFile::Hash() const
+{
+    UINT64 hash = FnvOffsetBasis;
+    for ( size_t index = 0; index < _size; ++index )
+    {
+        hash ^= _data[ index ];
+        hash *= FnvPrime;
+    }
+    return hash;
+}
+
+// Checks to see if this file is open
+bool MappedFile::IsOpen() const
+{
+    return _data != nullptr;
+}
+
+// Attempts to open and map a file
+bool MappedFile::Open( const std::string& fname )
+{
+    Close();
+
+    _file = CreateFileA( fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( _file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx( _file, &size ) || size.QuadPart == 0 || static_cast<ULONGLONG>( size.QuadPart ) > static_cast<size_t>( -1 ) )
+    {
+        Close();
+        return false;
+    }
+
+    _mapping = CreateFileMappingA( _file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( !_mapping )
+    {
+        Close();
+        return false;
+    }
+
+    _data = static_cast<const unsigned char*>( MapViewOfFile( _mapping, FILE_MAP_READ, 0, 0, 0 ) );
+    if ( !_data )
+    {
+        Close();
+        return false;
+    }
+
+    _size = static_cast<size_t>( size.QuadPart );
+    return true;
+}
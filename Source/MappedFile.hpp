@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include <string>
+
+/// <summary>
+/// Defines a read-only, memory-mapped file. The file's contents are paged in by the OS as they are
+/// touched rather than being read into a buffer up front.
+/// </summary>
+class MappedFile
+{
+    ImplementNonCopyableClass( MappedFile );
+    ImplementNonMovableClass( MappedFile );
+
+    HANDLE _file;
+    HANDLE _mapping;
+    const unsigned char* _data;
+    size_t _size;
+
+public:
+    /// <summary>
+    /// Creates a new, closed mapped file.
+    /// </summary>
+    MappedFile();
+
+    /// <summary>
+    /// Destroys this mapped file, unmapping it if it is open.
+    /// </summary>
+    ~MappedFile();
+
+    /// <summary>
+    /// Unmaps and closes this file.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Gets this file's contents.
+    /// </summary>
+    const unsigned char* GetData() const;
+
+    /// <summary>
+    /// Gets the size of this file, in bytes.
+    /// </summary>
+    size_t GetSize() const;
+
+    /// <summary>
+    /// Hashes this file's contents with 64-bit FNV-1a.
+    /// </summary>
+    UINT64 Hash() const;
+
+    /// <summary>
+    /// Checks to see if this file is open.
+    /// </summary>
+    bool IsOpen() const;
+
+    /// <summary>
+    /// Attempts to open and map the given file. Empty files cannot be mapped.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    bool Open( const std::string& fname );
+};
@@ -4,7 +4,8 @@
 #include <DirectXTK/WICTextureLoader.h>
 #include <assert.h>
 
-Material* Material::ActiveMaterial = nullptr;
+Material*           Material::ActiveMaterial = nullptr;
+const PipelineState Material::DefaultPipelineState;
 
 // Create a new material
 Material::Material( GameObject* gameObject )
@@ -16,10 +17,6 @@ Material::Material( GameObject* gameObject )
     UpdateD3DResource( _device, gameObject->GetDevice() );
     UpdateD3DResource( _deviceContext, gameObject->GetDeviceContext() );
     assert( _device != nullptr && _deviceContext != nullptr && "Materials must have a valid device and device context!" );
-
-    // Create the vertex and pixel shaders
-    _vertexShader = std::make_shared<SimpleVertexShader>( gameObject->GetDevice(), gameObject->GetDeviceContext() );
-    _pixelShader  = std::make_shared<SimplePixelShader>( gameObject->GetDevice(), gameObject->GetDeviceContext() );
 }
 
 // Destroy this material
@@ -29,36 +26,23 @@ Material::~Material()
     ReleaseMacro( _device );
 }
 
-// Create the sampler state
-void Material::CreateSamplerState( ID3D11SamplerState** samplerState, D3D11_FILTER filter, D3D11_TEXTURE_ADDRESS_MODE addressMode, UINT anisotropy, float minLod, float maxLod )
-{
-    ReleaseMacro( ( *samplerState ) );
-
-    // Create the sampler state description
-    D3D11_SAMPLER_DESC samplerDesc;
-    ZeroMemory( &samplerDesc, sizeof( D3D11_SAMPLER_DESC ) );
-    samplerDesc.Filter = filter;
-    samplerDesc.AddressU = addressMode;
-    samplerDesc.AddressV = addressMode;
-    samplerDesc.AddressW = addressMode;
-    samplerDesc.MaxAnisotropy = anisotropy;
-    samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-    samplerDesc.MinLOD = minLod;
-    samplerDesc.MaxLOD = maxLod;
-
-    // Create the sampler state
-    HR( _device->CreateSamplerState( &samplerDesc, samplerState ) );
-}
-
 // Attempt to load the pixel shader
 bool Material::LoadPixelShader( const wchar_t* fname )
 {
+    if ( !_pixelShader )
+    {
+        _pixelShader = std::make_shared<SimplePixelShader>( _device, _deviceContext );
+    }
     return _pixelShader->LoadShaderFile( fname );
 }
 
 // Attempt to load the vertex shader
 bool Material::LoadVertexShader( const wchar_t* fname )
 {
+    if ( !_vertexShader )
+    {
+        _vertexShader = std::make_shared<SimpleVertexShader>( _device, _deviceContext );
+    }
     return _vertexShader->LoadShaderFile( fname );
 }
 
@@ -101,6 +85,28 @@ SimplePixelShader* Material::GetPixelShader()
     return _pixelShader.get();
 }
 
+// Gets the pipeline state this material draws with
+const PipelineState& Material::GetPipelineState() const
+{
+    return DefaultPipelineState;
+}
+
+// Gets the key to sort this material's draws by
+UINT64 Material::GetSortKey()
+{
+    return 0;
+}
+
+// Tells this material how large it was drawn
+void Material::RequestTextureResolution( float screenSize )
+{
+}
+
+// Switches to the vertex shader for a mesh
+void Material::SelectVertexShader( const Mesh& mesh )
+{
+}
+
 // Updates this material
 void Material::Update()
 {
@@ -2,11 +2,13 @@
 
 #include "DirectX.hpp"
 #include "SimpleShader.h"
+#include "StateCache.hpp"
 #include "Component.hpp"
 #include "Texture2D.hpp"
 #include <memory> // for std::shared_ptr
 
 class Camera; // forward declaration
+class Mesh;
 
 /// <summary>
 /// Defines a material.
@@ -15,23 +17,13 @@ class Material : public Component
 {
 protected:
     static Material* ActiveMaterial;
+    static const PipelineState DefaultPipelineState;
 
     std::shared_ptr<SimpleVertexShader> _vertexShader;
     std::shared_ptr<SimplePixelShader> _pixelShader;
     ID3D11Device* _device;
     ID3D11DeviceContext* _deviceContext;
 
-    /// <summary>
-    /// Creates a sampler state.
-    /// </summary>
-    /// <param name="samplerState">The sampler state.</param>
-    /// <param name="filter">The filter mode.</param>
-    /// <param name="addressMode">The address mode.</param>
-    /// <param name="anisotropy">The max anisotropy level allowed.</param>
-    /// <param name="minLod">The minimum LOD.</param>
-    /// <param name="maxLod">The maximum LOD.</param>
-    void CreateSamplerState( ID3D11SamplerState** samplerState, D3D11_FILTER filter, D3D11_TEXTURE_ADDRESS_MODE addressMode, UINT anisotropy, float minLod, float maxLod );
-
     /// <summary>
     /// Attempts to load the given pixel shader.
     /// </summary>
@@ -82,6 +74,29 @@ public:
     /// </summary>
     SimplePixelShader* GetPixelShader();    // Remove in favor of "set" methods
 
+    /// <summary>
+    /// Gets the pipeline state this material draws with. By default, a material uses its pass's states.
+    /// </summary>
+    virtual const PipelineState& GetPipelineState() const;
+
+    /// <summary>
+    /// Gets the key the render queue sorts this material's draws by. Draws with the same key share
+    /// their shaders and parameters, so drawing them together saves the state changes between them.
+    /// </summary>
+    virtual UINT64 GetSortKey();
+
+    /// <summary>
+    /// Tells this material how large its surface was drawn this frame, so its textures can be streamed at the right resolution.
+    /// </summary>
+    /// <param name="screenSize">The size of the surface on screen, in pixels.</param>
+    virtual void RequestTextureResolution( float screenSize );
+
+    /// <summary>
+    /// Switches this material to the vertex shader that reads the given mesh's vertex format.
+    /// </summary>
+    /// <param name="mesh">The mesh about to be drawn.</param>
+    virtual void SelectVertexShader( const Mesh& mesh );
+
     /// <summary>
     /// Updates this material.
     /// </summary>
@@ -0,0 +1,75 @@
+#include "MaterialParameterBlock.hpp"
+
+// Creates a new material parameter block
+MaterialParameterBlock::MaterialParameterBlock( ID3D11Device* device, unsigned int id, UINT64 hash, const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures )
+    : _parameters( parameters )
+    , _textures( textures )
+    , _hash( hash )
+    , _id( id )
+{
+    if ( _parameters.empty() )
+    {
+        return;
+    }
+
+    // The parameters never change, so the buffer can live wherever the GPU likes it best
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.ByteWidth = static_cast<UINT>( ( _parameters.size() + 15 ) & ~static_cast<size_t>( 15 ) );
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    std::vector<unsigned char> contents( _parameters );
+    contents.resize( desc.ByteWidth, 0 );
+    D3D11_SUBRESOURCE_DATA data;
+    ZeroMemory( &data, sizeof( D3D11_SUBRESOURCE_DATA ) );
+    data.pSysMem = &contents[ 0 ];
+
+    HR( device->CreateBuffer( &desc, &data, _buffer.GetAddress() ) );
+}
+
+// Computes the hash of a set of parameters and textures
+UINT64 MaterialParameterBlock::ComputeHash( const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures )
+{
+    // FNV-1a over the parameter bytes, then over the texture pointers
+    UINT64 hash = 14695981039346656037ULL;
+    for ( unsigned char byte : parameters )
+    {
+        hash = ( hash ^ byte ) * 1099511628211ULL;
+    }
+    for ( auto& texture : textures )
+    {
+        hash = ( hash ^ reinterpret_cast<UINT64>( texture.get() ) ) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Gets this block's constant buffer
+ID3D11Buffer* MaterialParameterBlock::GetBuffer()
+{
+    return _buffer.Get();
+}
+
+// Gets the hash of this block's contents
+UINT64 MaterialParameterBlock::GetHash() const
+{
+    return _hash;
+}
+
+// Gets this block's ID
+unsigned int MaterialParameterBlock::GetId() const
+{
+    return _id;
+}
+
+// Gets this block's textures
+const std::vector<std::shared_ptr<Texture2D>>& MaterialParameterBlock::GetTextures() const
+{
+    return _textures;
+}
+
+// Checks to see if this block holds the given parameters and textures
+bool MaterialParameterBlock::Matches( const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures ) const
+{
+    return ( _parameters == parameters ) && ( _textures == textures );
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Texture2D.hpp"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Defines a material parameter that an instance sets instead of using its template's default.
+/// </summary>
+struct MaterialParameter
+{
+    unsigned int Offset;
+    std::vector<unsigned char> Data;
+};
+
+/// <summary>
+/// Defines a block of material parameters on the GPU. Blocks never change once they're created,
+/// and every material instance with the same parameters and textures shares the same block.
+/// </summary>
+class MaterialParameterBlock
+{
+    ImplementNonCopyableClass( MaterialParameterBlock );
+    ImplementNonMovableClass( MaterialParameterBlock );
+
+    ComPtr<ID3D11Buffer> _buffer;
+    std::vector<unsigned char> _parameters;
+    std::vector<std::shared_ptr<Texture2D>> _textures;
+    UINT64 _hash;
+    unsigned int _id;
+
+public:
+    /// <summary>
+    /// Creates a new material parameter block.
+    /// </summary>
+    /// <param name="device">The device to create the constant buffer with.</param>
+    /// <param name="id">The block's ID, unique within its template.</param>
+    /// <param name="hash">The hash of the parameters and textures.</param>
+    /// <param name="parameters">The contents of the constant buffer.</param>
+    /// <param name="textures">The textures, one for each of the template's texture slots.</param>
+    MaterialParameterBlock( ID3D11Device* device, unsigned int id, UINT64 hash, const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures );
+
+    /// <summary>
+    /// Destroys this material parameter block.
+    /// </summary>
+    ~MaterialParameterBlock() = default;
+
+    /// <summary>
+    /// Computes the hash of a set of parameters and textures.
+    /// </summary>
+    /// <param name="parameters">The contents of the constant buffer.</param>
+    /// <param name="textures">The textures.</param>
+    static UINT64 ComputeHash( const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures );
+
+    /// <summary>
+    /// Gets this block's constant buffer.
+    /// </summary>
+    ID3D11Buffer* GetBuffer();
+
+    /// <summary>
+    /// Gets the hash of this block's parameters and textures.
+    /// </summary>
+    UINT64 GetHash() const;
+
+    /// <summary>
+    /// Gets this block's ID.
+    /// </summary>
+    unsigned int GetId() const;
+
+    /// <summary>
+    /// Gets this block's textures.
+    /// </summary>
+    const std::vector<std::shared_ptr<Texture2D>>& GetTextures() const;
+
+    /// <summary>
+    /// Checks to see if this block holds exactly the given parameters and textures.
+    /// </summary>
+    /// <param name="parameters">The contents of the constant buffer.</param>
+    /// <param name="textures">The textures.</param>
+    bool Matches( const std::vector<unsigned char>& parameters, const std::vector<std::shared_ptr<Texture2D>>& textures ) const;
+};
@@ -0,0 +1,208 @@
+#include "MaterialTemplate.hpp"
+#include <algorithm>
+#include <string.h>
+
+const std::string   MaterialTemplate::ParameterBufferName = "PerMaterial";
+unsigned int        MaterialTemplate::_nextId = 1;
+
+// Creates a new material template
+MaterialTemplate::MaterialTemplate( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+    : _device( nullptr )
+    , _deviceContext( nullptr )
+    , _id( _nextId++ )
+    , _nextBlockId( 1 )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+}
+
+// Destroys this material template
+MaterialTemplate::~MaterialTemplate()
+{
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Adds a texture slot
+size_t MaterialTemplate::AddTextureSlot( const std::string& name )
+{
+    _textureNames.push_back( name );
+    return _textureNames.size() - 1;
+}
+
+// Adds a sampler state for every instance to use
+bool MaterialTemplate::AddSamplerState( const std::string& name, D3D11_FILTER filter, D3D11_TEXTURE_ADDRESS_MODE addressMode, UINT anisotropy, float minLod, float maxLod )
+{
+    // Create the sampler state description
+    D3D11_SAMPLER_DESC samplerDesc;
+    ZeroMemory( &samplerDesc, sizeof( D3D11_SAMPLER_DESC ) );
+    samplerDesc.Filter = filter;
+    samplerDesc.AddressU = addressMode;
+    samplerDesc.AddressV = addressMode;
+    samplerDesc.AddressW = addressMode;
+    samplerDesc.MaxAnisotropy = anisotropy;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+    samplerDesc.MinLOD = minLod;
+    samplerDesc.MaxLOD = maxLod;
+
+    // Every template asking for the same sampler gets the same one
+    ID3D11SamplerState* samplerState = StateCache::GetSamplerState( _device, samplerDesc );
+    if ( !samplerState )
+    {
+        return false;
+    }
+
+    _samplers.push_back( std::make_pair( name, samplerState ) );
+    return true;
+}
+
+// Binds this template's resources and a parameter block
+void MaterialTemplate::Apply( MaterialParameterBlock& block )
+{
+    for ( auto& sampler : _samplers )
+    {
+        _pixelShader->SetSamplerState( sampler.first, sampler.second );
+    }
+
+    // The views are looked up every time, because streamed textures swap theirs out
+    const std::vector<std::shared_ptr<Texture2D>>& textures = block.GetTextures();
+    for ( size_t index = 0; index < _textureNames.size() && index < textures.size(); ++index )
+    {
+        if ( textures[ index ] )
+        {
+            _pixelShader->SetShaderResourceView( _textureNames[ index ], textures[ index ]->GetShaderResourceView() );
+        }
+    }
+
+    _pixelShader->SetConstantBuffer( ParameterBufferName, block.GetBuffer() );
+}
+
+// Finds where a parameter lives
+bool MaterialTemplate::FindParameter( const std::string& name, unsigned int& offset, unsigned int& size )
+{
+    return _pixelShader && _pixelShader->GetVariableLayout( ParameterBufferName, name, offset, size );
+}
+
+// Gets the number of parameter blocks still in use
+size_t MaterialTemplate::GetBlockCount() const
+{
+    size_t count = 0;
+    for ( auto& block : _blocks )
+    {
+        if ( !block.second.expired() )
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Gets this template's ID
+unsigned int MaterialTemplate::GetId() const
+{
+    return _id;
+}
+
+// Gets the parameter block for a set of overrides and textures
+std::shared_ptr<MaterialParameterBlock> MaterialTemplate::GetParameterBlock( const std::vector<MaterialParameter>& overrides, const std::vector<std::shared_ptr<Texture2D>>& textures )
+{
+    // Lay the overrides over the defaults
+    std::vector<unsigned char> parameters( _defaultParameters );
+    for ( auto& parameter : overrides )
+    {
+        if ( !parameter.Data.empty() && parameter.Offset + parameter.Data.size() <= parameters.size() )
+        {
+            memcpy( &parameters[ parameter.Offset ], &parameter.Data[ 0 ], parameter.Data.size() );
+        }
+    }
+
+    // Share the block of any instance with the same parameters
+    UINT64 hash = MaterialParameterBlock::ComputeHash( parameters, textures );
+    auto search = _blocks.find( hash );
+    if ( search != _blocks.end() )
+    {
+        std::shared_ptr<MaterialParameterBlock> block = search->second.lock();
+        if ( block && block->Matches( parameters, textures ) )
+        {
+            return block;
+        }
+    }
+
+    // Forget blocks nobody uses any more before adding another
+    for ( auto block = _blocks.begin(); block != _blocks.end(); )
+    {
+        if ( block->second.expired() )
+        {
+            block = _blocks.erase( block );
+        }
+        else
+        {
+            ++block;
+        }
+    }
+
+    // A hash collision only costs the other block its sharing, so the newer one simply takes the slot
+    std::shared_ptr<MaterialParameterBlock> block = std::make_shared<MaterialParameterBlock>( _device, _nextBlockId++, hash, parameters, textures );
+    _blocks[ hash ] = block;
+    return block;
+}
+
+// Gets the pipeline state instances draw with
+const PipelineState& MaterialTemplate::GetPipelineState() const
+{
+    return _pipelineState;
+}
+
+// Gets this template's pixel shader
+std::shared_ptr<SimplePixelShader> MaterialTemplate::GetPixelShader()
+{
+    return _pixelShader;
+}
+
+// Gets the number of texture slots
+size_t MaterialTemplate::GetTextureSlotCount() const
+{
+    return _textureNames.size();
+}
+
+// Gets the vertex shader for a vertex format
+std::shared_ptr<SimpleVertexShader> MaterialTemplate::GetVertexShader( VertexFormat format )
+{
+    return ( format == VertexFormat::Compact ) ? _compactVertexShader : _standardVertexShader;
+}
+
+// Loads this template's shaders
+bool MaterialTemplate::LoadShaders( const wchar_t* vertexShader, const wchar_t* compactVertexShader, const wchar_t* pixelShader )
+{
+    _standardVertexShader = std::make_shared<SimpleVertexShader>( _device, _deviceContext );
+    _compactVertexShader = std::make_shared<SimpleVertexShader>( _device, _deviceContext );
+    _pixelShader = std::make_shared<SimplePixelShader>( _device, _deviceContext );
+
+    bool isLoaded = _standardVertexShader->LoadShaderFile( vertexShader );
+    isLoaded = _compactVertexShader->LoadShaderFile( compactVertexShader ) && isLoaded;
+    isLoaded = _pixelShader->LoadShaderFile( pixelShader ) && isLoaded;
+
+    // Every parameter starts out zeroed until the template gives it a default
+    _defaultParameters.assign( _pixelShader->GetConstantBufferSize( ParameterBufferName ), 0 );
+    return isLoaded;
+}
+
+// Sets the pipeline state instances draw with
+void MaterialTemplate::SetPipelineState( const PipelineState& state )
+{
+    _pipelineState = state;
+}
+
+// Sets a parameter's default value
+bool MaterialTemplate::SetDefaultParameter( const std::string& name, const void* data, unsigned int size )
+{
+    unsigned int offset = 0;
+    unsigned int parameterSize = 0;
+    if ( !FindParameter( name, offset, parameterSize ) )
+    {
+        return false;
+    }
+
+    memcpy( &_defaultParameters[ offset ], data, std::min( size, parameterSize ) );
+    return true;
+}
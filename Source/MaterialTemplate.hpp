@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "MaterialParameterBlock.hpp"
+#include "Mesh.hpp"
+#include "SimpleShader.h"
+#include "StateCache.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Defines a material template. A template owns everything that material instances of the same
+/// kind have in common: the shaders, the sampler and pipeline states, the layout and default
+/// values of the parameters, and the names of the texture slots. Instances only keep the
+/// parameters they change, and get a parameter block for them from their template.
+/// </summary>
+class MaterialTemplate
+{
+    ImplementNonCopyableClass( MaterialTemplate );
+    ImplementNonMovableClass( MaterialTemplate );
+
+    static const std::string ParameterBufferName;
+    static unsigned int _nextId;
+
+    std::unordered_map<UINT64, std::weak_ptr<MaterialParameterBlock>> _blocks;
+    std::vector<unsigned char> _defaultParameters;
+    std::vector<std::pair<std::string, ID3D11SamplerState*>> _samplers;
+    std::vector<std::string> _textureNames;
+    std::shared_ptr<SimpleVertexShader> _standardVertexShader;
+    std::shared_ptr<SimpleVertexShader> _compactVertexShader;
+    std::shared_ptr<SimplePixelShader> _pixelShader;
+    PipelineState _pipelineState;
+    ID3D11Device* _device;
+    ID3D11DeviceContext* _deviceContext;
+    unsigned int _id;
+    unsigned int _nextBlockId;
+
+public:
+    /// <summary>
+    /// Creates a new material template.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    MaterialTemplate( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Destroys this material template.
+    /// </summary>
+    ~MaterialTemplate();
+
+    /// <summary>
+    /// Adds a texture slot that instances can fill in.
+    /// </summary>
+    /// <param name="name">The name of the texture in the pixel shader.</param>
+    /// <returns>The index of the slot.</returns>
+    size_t AddTextureSlot( const std::string& name );
+
+    /// <summary>
+    /// Adds a sampler state that every instance of this template uses.
+    /// </summary>
+    /// <param name="name">The name of the sampler in the pixel shader.</param>
+    /// <param name="filter">The filter mode.</param>
+    /// <param name="addressMode">The address mode.</param>
+    /// <param name="anisotropy">The max anisotropy level allowed.</param>
+    /// <param name="minLod">The minimum LOD.</param>
+    /// <param name="maxLod">The maximum LOD.</param>
+    /// <returns>True if the sampler state could be created, false if not.</returns>
+    bool AddSamplerState( const std::string& name, D3D11_FILTER filter, D3D11_TEXTURE_ADDRESS_MODE addressMode, UINT anisotropy, float minLod, float maxLod );
+
+    /// <summary>
+    /// Binds this template's shader resources and the given parameter block to its shaders.
+    /// </summary>
+    /// <param name="block">The parameter block.</param>
+    void Apply( MaterialParameterBlock& block );
+
+    /// <summary>
+    /// Finds where a parameter lives in the parameter buffer.
+    /// </summary>
+    /// <param name="name">The name of the parameter.</param>
+    /// <param name="offset">Receives the parameter's offset.</param>
+    /// <param name="size">Receives the parameter's size.</param>
+    /// <returns>True if the parameter exists, false if not.</returns>
+    bool FindParameter( const std::string& name, unsigned int& offset, unsigned int& size );
+
+    /// <summary>
+    /// Gets the number of parameter blocks that are still in use.
+    /// </summary>
+    size_t GetBlockCount() const;
+
+    /// <summary>
+    /// Gets this template's ID.
+    /// </summary>
+    unsigned int GetId() const;
+
+    /// <summary>
+    /// Gets the parameter block holding the given overrides and textures, creating it if no
+    /// instance with the same parameters has one yet.
+    /// </summary>
+    /// <param name="overrides">The parameters to use instead of the defaults.</param>
+    /// <param name="textures">The textures, one for each texture slot.</param>
+    std::shared_ptr<MaterialParameterBlock> GetParameterBlock( const std::vector<MaterialParameter>& overrides, const std::vector<std::shared_ptr<Texture2D>>& textures );
+
+    /// <summary>
+    /// Gets the pipeline state every instance of this template draws with.
+    /// </summary>
+    const PipelineState& GetPipelineState() const;
+
+    /// <summary>
+    /// Gets this template's pixel shader.
+    /// </summary>
+    std::shared_ptr<SimplePixelShader> GetPixelShader();
+
+    /// <summary>
+    /// Gets the number of texture slots.
+    /// </summary>
+    size_t GetTextureSlotCount() const;
+
+    /// <summary>
+    /// Gets the vertex shader that reads the given vertex format.
+    /// </summary>
+    /// <param name="format">The vertex format.</param>
+    std::shared_ptr<SimpleVertexShader> GetVertexShader( VertexFormat format );
+
+    /// <summary>
+    /// Loads this template's shaders. The pixel shader's parameter buffer decides the parameters' layout.
+    /// </summary>
+    /// <param name="vertexShader">The vertex shader for standard vertices.</param>
+    /// <param name="compactVertexShader">The vertex shader for compact vertices.</param>
+    /// <param name="pixelShader">The pixel shader.</param>
+    /// <returns>True if every shader was loaded, false if not.</returns>
+    bool LoadShaders( const wchar_t* vertexShader, const wchar_t* compactVertexShader, const wchar_t* pixelShader );
+
+    /// <summary>
+    /// Sets the pipeline state every instance of this template draws with. The states should come from the state cache.
+    /// </summary>
+    /// <param name="state">The pipeline state.</param>
+    void SetPipelineState( const PipelineState& state );
+
+    /// <summary>
+    /// Sets a parameter's default value.
+    /// </summary>
+    /// <param name="name">The name of the parameter.</param>
+    /// <param name="data">The value.</param>
+    /// <param name="size">The size of the value.</param>
+    /// <returns>True if the parameter exists, false if not.</returns>
+    bool SetDefaultParameter( const std::string& name, const void* data, unsigned int size );
+};
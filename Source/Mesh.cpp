@@ -1,4 +1,43 @@
 #include "Mesh.hpp"
+#include "MeshFile.hpp"
+#include <algorithm>
+#include <limits.h>
+
+using namespace DirectX;
+
+static const float LodPixelError = 1.0f;
+static const float LodHysteresis = 0.75f;
+static const size_t MaxOccluderTriangles = 2048;
+static const float MaxOccluderError = 0.001f; // Relative to the bounding radius
+
+// Create a new mesh out of compact vertices
+Mesh::Mesh( ID3D11Device* device, const std::vector<CompactVertex>& vertices, const std::vector<UINT>& indices, const DirectX::XMFLOAT3& positionOffset, const DirectX::XMFLOAT3& positionScale )
+    : Mesh( device, vertices, indices )
+{
+    _vertexFormat = VertexFormat::Compact;
+    _positionOffset = positionOffset;
+    _positionScale = positionScale;
+}
+
+// Create a new mesh from a cooked mesh file
+Mesh::Mesh( ID3D11Device* device, const MeshFile& file )
+    : _indexCount( file.GetHeader().IndexCount )
+    , _vertexCount( file.GetHeader().VertexCount )
+    , _vertexStride( file.GetHeader().VertexStride )
+    , _indexFormat( static_cast<DXGI_FORMAT>( file.GetHeader().IndexFormat ) )
+    , _vertexFormat( static_cast<VertexFormat>( file.GetHeader().VertexFormat ) )
+    , _positionOffset( file.GetHeader().PositionOffset )
+    , _positionScale( file.GetHeader().PositionScale )
+    , _boundsCenter( 0.0f, 0.0f, 0.0f )
+    , _boundsSize( file.GetHeader().BoundsSize )
+    , _boundsRadius( file.GetHeader().BoundsRadius )
+    , _submeshes( file.GetSubmeshes(), file.GetSubmeshes() + file.GetHeader().SubmeshCount )
+    , _lods( file.GetLods(), file.GetLods() + file.GetHeader().LodCount )
+{
+    // The file's buffers go straight to the GPU without being copied anywhere first
+    CreateBuffers( device, file.GetVertexData(), file.GetVertexDataSize(), file.GetIndexData(), file.GetIndexDataSize() );
+    CreateOccluder( file.GetVertexData(), file.GetIndexData() );
+}
 
 // Destroy this mesh
 Mesh::~Mesh()
@@ -6,12 +45,142 @@ Mesh::~Mesh()
     _indexCount = 0;
 }
 
+// Create the vertex and index buffers
+void Mesh::CreateBuffers( ID3D11Device* device, const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes )
+{
+    // Create the vertex buffer description
+    D3D11_BUFFER_DESC bufferDesc;
+    ZeroMemory( &bufferDesc, sizeof( D3D11_BUFFER_DESC ) );
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+
+    // Create the sub-resource data object
+    D3D11_SUBRESOURCE_DATA resourceData = { nullptr, 0, 0 };
+
+    // Create the vertex buffer
+    if ( vertexBytes > 0 )
+    {
+        bufferDesc.ByteWidth = static_cast<UINT>( vertexBytes );
+        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+        // Set the resource data pointer
+        resourceData.pSysMem = vertexData;
+
+        // Send the vertex data to DirectX
+        HR( device->CreateBuffer( &bufferDesc, &resourceData, _vertexBuffer.GetAddress() ) );
+    }
+
+
+    // Reuse the buffer description for the index buffer
+    if ( indexBytes > 0 )
+    {
+        bufferDesc.ByteWidth = static_cast<UINT>( indexBytes );
+        bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+        // Set the resource data pointer
+        resourceData.pSysMem = indexData;
+
+        // Send the index data to DirectX
+        HR( device->CreateBuffer( &bufferDesc, &resourceData, _indexBuffer.GetAddress() ) );
+    }
+}
+
+// Decode the bounds' center and the occluder triangles
+void Mesh::CreateOccluder( const void* vertexData, const void* indexData )
+{
+    if ( !vertexData || _vertexCount == 0 )
+    {
+        return;
+    }
+
+    // Compact positions are quantized within the bounds, so they only need to be scaled back out
+    std::vector<XMFLOAT3> positions( _vertexCount );
+    const unsigned char* vertex = static_cast<const unsigned char*>( vertexData );
+    for ( size_t index = 0; index < _vertexCount; ++index, vertex += _vertexStride )
+    {
+        if ( _vertexFormat == VertexFormat::Compact )
+        {
+            const CompactVertex* compact = reinterpret_cast<const CompactVertex*>( vertex );
+            positions[ index ] = XMFLOAT3( _positionOffset.x + _positionScale.x * ( compact->PositionXY & 0xFFFF ) / 65535.0f,
+                                           _positionOffset.y + _positionScale.y * ( compact->PositionXY >> 16 ) / 65535.0f,
+                                           _positionOffset.z + _positionScale.z * ( compact->PositionZ & 0xFFFF ) / 65535.0f );
+        }
+        else
+        {
+            positions[ index ] = reinterpret_cast<const Vertex*>( vertex )->Position;
+        }
+    }
+
+    XMVECTOR min = XMLoadFloat3( &positions[ 0 ] );
+    XMVECTOR max = min;
+    for ( auto& position : positions )
+    {
+        min = XMVectorMin( min, XMLoadFloat3( &position ) );
+        max = XMVectorMax( max, XMLoadFloat3( &position ) );
+    }
+    XMStoreFloat3( &_boundsCenter, XMVectorScale( XMVectorAdd( min, max ), 0.5f ) );
+
+    // Simplified levels of detail can bulge out past the real surface and hide things that should
+    // be seen, so only a level whose error is a tiny fraction of the mesh's size occludes. While the
+    // mesh fits in the occlusion culler's 256 texel wide depth buffer, that is well under a texel
+    if ( !indexData || _lods.empty() )
+    {
+        return;
+    }
+    const MeshLod* occluderLod = nullptr;
+    for ( auto lod = _lods.rbegin(); lod != _lods.rend() && !occluderLod; ++lod )
+    {
+        if ( lod->Error <= MaxOccluderError * _boundsRadius && lod->IndexCount <= MaxOccluderTriangles * 3 )
+        {
+            occluderLod = &*lod;
+        }
+    }
+    if ( !occluderLod )
+    {
+        return;
+    }
+
+    // Keep just the vertices that level uses
+    const MeshLod& lod = *occluderLod;
+    std::vector<UINT> remap( _vertexCount, UINT_MAX );
+    _occluderIndices.resize( lod.IndexCount );
+    for ( UINT index = 0; index < lod.IndexCount; ++index )
+    {
+        UINT source = ( _indexFormat == DXGI_FORMAT_R16_UINT )
+            ? static_cast<const USHORT*>( indexData )[ lod.IndexStart + index ]
+            : static_cast<const UINT*>( indexData )[ lod.IndexStart + index ];
+        if ( remap[ source ] == UINT_MAX )
+        {
+            remap[ source ] = static_cast<UINT>( _occluderVertices.size() );
+            _occluderVertices.push_back( positions[ source ] );
+        }
+        _occluderIndices[ index ] = remap[ source ];
+    }
+}
+
 // Get vertex buffer
 ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer() const
 {
     return _vertexBuffer;
 }
 
+// Get the bounding radius
+float Mesh::GetBoundsRadius() const
+{
+    return _boundsRadius;
+}
+
+// Get the bounding center
+DirectX::XMFLOAT3 Mesh::GetBoundsCenter() const
+{
+    return _boundsCenter;
+}
+
+// Get the bounding size
+DirectX::XMFLOAT3 Mesh::GetBoundsSize() const
+{
+    return _boundsSize;
+}
+
 // Get index buffer
 ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer() const
 {
@@ -24,12 +193,88 @@ size_t Mesh::GetIndexCount() const
     return _indexCount;
 }
 
+// Get index format
+DXGI_FORMAT Mesh::GetIndexFormat() const
+{
+    return _indexFormat;
+}
+
+// Get the levels of detail
+const std::vector<MeshLod>& Mesh::GetLods() const
+{
+    return _lods;
+}
+
+// Get the number of bytes the buffers use
+size_t Mesh::GetMemorySize() const
+{
+    const size_t indexSize = ( _indexFormat == DXGI_FORMAT_R16_UINT ) ? sizeof( USHORT ) : sizeof( UINT );
+    return _vertexCount * _vertexStride + _indexCount * indexSize
+         + _occluderVertices.size() * sizeof( DirectX::XMFLOAT3 ) + _occluderIndices.size() * sizeof( UINT );
+}
+
+// Get the occluder indices
+const std::vector<UINT>& Mesh::GetOccluderIndices() const
+{
+    return _occluderIndices;
+}
+
+// Get the occluder vertices
+const std::vector<DirectX::XMFLOAT3>& Mesh::GetOccluderVertices() const
+{
+    return _occluderVertices;
+}
+
+// Get the compact position offset
+DirectX::XMFLOAT3 Mesh::GetPositionOffset() const
+{
+    return _positionOffset;
+}
+
+// Get the compact position scale
+DirectX::XMFLOAT3 Mesh::GetPositionScale() const
+{
+    return _positionScale;
+}
+
+// Get the submeshes
+const std::vector<Submesh>& Mesh::GetSubmeshes() const
+{
+    return _submeshes;
+}
+
+// Picks a level of detail for the given screen coverage
+size_t Mesh::SelectLod( float pixelsPerUnit, size_t currentLod ) const
+{
+    size_t lod = std::min( currentLod, _lods.size() - 1 );
+
+    // Go finer straight away as soon as the current level looks wrong...
+    while ( lod > 0 && _lods[ lod ].Error * pixelsPerUnit > LodPixelError )
+    {
+        --lod;
+    }
+
+    // ...but only go coarser once the next level is well under the limit
+    while ( lod + 1 < _lods.size() && _lods[ lod + 1 ].Error * pixelsPerUnit <= LodPixelError * LodHysteresis )
+    {
+        ++lod;
+    }
+
+    return lod;
+}
+
 // Get the vertex count
 size_t Mesh::GetVertexCount() const
 {
     return _vertexCount;
 }
 
+// Get the vertex format
+VertexFormat Mesh::GetVertexFormat() const
+{
+    return _vertexFormat;
+}
+
 // Get the size of a vertex
 size_t Mesh::GetVertexStride() const
 {
@@ -6,6 +6,28 @@
 #include <vector>
 #include "Vertex.hpp"
 
+class MeshFile;
+
+/// <summary>
+/// Defines a range of a mesh's indices that came from one of its source meshes.
+/// </summary>
+struct Submesh
+{
+    UINT IndexStart;
+    UINT IndexCount;
+    UINT MaterialIndex;
+};
+
+/// <summary>
+/// Defines a range of a mesh's indices that draws the whole mesh at one level of detail.
+/// </summary>
+struct MeshLod
+{
+    UINT IndexStart;
+    UINT IndexCount;
+    float Error;
+};
+
 /// <summary>
 /// Defines a mesh.
 /// </summary>
@@ -20,6 +42,36 @@ private:
     size_t _indexCount;
     size_t _vertexCount;
     size_t _vertexStride;
+    DXGI_FORMAT _indexFormat;
+    VertexFormat _vertexFormat;
+    DirectX::XMFLOAT3 _positionOffset;
+    DirectX::XMFLOAT3 _positionScale;
+    DirectX::XMFLOAT3 _boundsCenter;
+    DirectX::XMFLOAT3 _boundsSize;
+    float _boundsRadius;
+    std::vector<Submesh> _submeshes;
+    std::vector<MeshLod> _lods;
+    std::vector<DirectX::XMFLOAT3> _occluderVertices;
+    std::vector<UINT> _occluderIndices;
+
+    /// <summary>
+    /// Decodes the vertex positions to find the center of this mesh's bounds, and keeps a copy of
+    /// the triangles of the coarsest level of detail that stays on the original surface for the
+    /// occlusion culler to rasterize.
+    /// </summary>
+    /// <param name="vertexData">The vertex data, in this mesh's vertex format.</param>
+    /// <param name="indexData">The index data, in this mesh's index format.</param>
+    void CreateOccluder( const void* vertexData, const void* indexData );
+
+    /// <summary>
+    /// Creates this mesh's immutable vertex and index buffers.
+    /// </summary>
+    /// <param name="device">The graphics device to create the buffers on.</param>
+    /// <param name="vertexData">The vertex data.</param>
+    /// <param name="vertexBytes">The number of bytes of vertex data.</param>
+    /// <param name="indexData">The index data.</param>
+    /// <param name="indexBytes">The number of bytes of index data.</param>
+    void CreateBuffers( ID3D11Device* device, const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes );
 
 public:
     /// <summary>
@@ -31,26 +83,113 @@ public:
     /// <param name="indices">The indices to use.</param>
     template<typename TVertex> Mesh( ID3D11Device* device, const std::vector<TVertex>& vertices, const std::vector<UINT>& indices );
 
+    /// <summary>
+    /// Creates a new mesh out of compact vertices.
+    /// </summary>
+    /// <param name="device">The graphics device context to create our buffers on.</param>
+    /// <param name="vertices">The vertices to use.</param>
+    /// <param name="indices">The indices to use.</param>
+    /// <param name="positionOffset">The minimum corner of the bounds the vertex positions were quantized in.</param>
+    /// <param name="positionScale">The size of the bounds the vertex positions were quantized in.</param>
+    Mesh( ID3D11Device* device, const std::vector<CompactVertex>& vertices, const std::vector<UINT>& indices, const DirectX::XMFLOAT3& positionOffset, const DirectX::XMFLOAT3& positionScale );
+
+    /// <summary>
+    /// Creates a new mesh straight from a cooked mesh file's buffers.
+    /// </summary>
+    /// <param name="device">The graphics device to create our buffers on.</param>
+    /// <param name="file">The cooked mesh file.</param>
+    Mesh( ID3D11Device* device, const MeshFile& file );
+
     /// <summary>
     /// Destroys this mesh.
     /// </summary>
     ~Mesh();
 
+    /// <summary>
+    /// Gets the radius of the sphere around the center of this mesh's bounds that holds every vertex.
+    /// </summary>
+    float GetBoundsRadius() const;
+
+    /// <summary>
+    /// Gets the center of this mesh's bounds, in model space.
+    /// </summary>
+    DirectX::XMFLOAT3 GetBoundsCenter() const;
+
+    /// <summary>
+    /// Gets the size of this mesh's bounds.
+    /// </summary>
+    DirectX::XMFLOAT3 GetBoundsSize() const;
+
     /// <summary>
     /// Gets this mesh's index buffer.
     /// </summary>
     ComPtr<ID3D11Buffer> GetIndexBuffer() const;
 
     /// <summary>
-    /// Gets the number of indices in this mesh.
+    /// Gets the number of indices in this mesh, across every level of detail.
     /// </summary>
     size_t GetIndexCount() const;
 
+    /// <summary>
+    /// Gets the format of this mesh's indices (16-bit if the vertex count allows, 32-bit otherwise).
+    /// </summary>
+    DXGI_FORMAT GetIndexFormat() const;
+
+    /// <summary>
+    /// Gets this mesh's levels of detail, from full detail to coarsest. Every mesh has at least one.
+    /// </summary>
+    const std::vector<MeshLod>& GetLods() const;
+
+    /// <summary>
+    /// Gets the number of bytes this mesh's vertex and index buffers and occluder triangles use.
+    /// </summary>
+    size_t GetMemorySize() const;
+
+    /// <summary>
+    /// Gets the indices of the triangles this mesh occludes with. Meshes built by hand, and meshes
+    /// with no level of detail that is both faithful to the surface and cheap to rasterize, have none.
+    /// </summary>
+    const std::vector<UINT>& GetOccluderIndices() const;
+
+    /// <summary>
+    /// Gets the model space positions of the vertices this mesh occludes with.
+    /// </summary>
+    const std::vector<DirectX::XMFLOAT3>& GetOccluderVertices() const;
+
+    /// <summary>
+    /// Gets the offset that compact vertex positions are decoded with.
+    /// </summary>
+    DirectX::XMFLOAT3 GetPositionOffset() const;
+
+    /// <summary>
+    /// Gets the scale that compact vertex positions are decoded with.
+    /// </summary>
+    DirectX::XMFLOAT3 GetPositionScale() const;
+
+    /// <summary>
+    /// Gets the ranges of this mesh's indices that came from each of its source meshes.
+    /// </summary>
+    const std::vector<Submesh>& GetSubmeshes() const;
+
+    /// <summary>
+    /// Picks the coarsest level of detail whose error would stay under a pixel on screen. A level
+    /// is only dropped to once its error is comfortably small, so objects near the boundary don't
+    /// keep swapping back and forth.
+    /// </summary>
+    /// <param name="pixelsPerUnit">How many pixels one object space unit covers where the mesh is drawn.</param>
+    /// <param name="currentLod">The level of detail the mesh was drawn with last time.</param>
+    size_t SelectLod( float pixelsPerUnit, size_t currentLod ) const;
+
     /// <summary>
     /// Gets this mesh's vertex buffer.
     /// </summary>
     ComPtr<ID3D11Buffer> GetVertexBuffer() const;
 
+    /// <summary>
+    /// Gets the format of this mesh's vertices.
+    /// </summary>
+    VertexFormat GetVertexFormat() const;
+
     /// <summary>
     /// Gets the number of vertices in this mesh.
     /// </summary>
@@ -5,39 +5,36 @@ template<typename TVertex> Mesh::Mesh( ID3D11Device* device, const std::vector<T
     : _indexCount( indices.size() )
     , _vertexCount( vertices.size() )
     , _vertexStride( sizeof( TVertex ) )
+    , _indexFormat( DXGI_FORMAT_R32_UINT )
+    , _vertexFormat( VertexFormat::Standard )
+    , _positionOffset( 0.0f, 0.0f, 0.0f )
+    , _positionScale( 1.0f, 1.0f, 1.0f )
+    , _boundsCenter( 0.0f, 0.0f, 0.0f )
+    , _boundsSize( 0.0f, 0.0f, 0.0f )
+    , _boundsRadius( 0.0f )
 {
-    // Create the vertex buffer description
-    D3D11_BUFFER_DESC bufferDesc;
-    ZeroMemory( &bufferDesc, sizeof( D3D11_BUFFER_DESC ) );
-    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    const void* vertexData = vertices.empty() ? nullptr : &( vertices[ 0 ] );
+    const void* indexData = indices.empty() ? nullptr : &( indices[ 0 ] );
+    size_t indexSize = sizeof( UINT );
 
-    // Create the sub-resource data object
-    D3D11_SUBRESOURCE_DATA resourceData = { nullptr, 0, 0 };
-
-    // Create the vertex buffer
-    if ( vertices.size() > 0 )
+    // Most meshes have few enough vertices for 16-bit indices, which halves the index buffer
+    std::vector<USHORT> shortIndices;
+    if ( !indices.empty() && vertices.size() <= 0xFFFF )
     {
-        bufferDesc.ByteWidth = sizeof( TVertex ) * vertices.size();
-        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-
-        // Set the resource data pointer
-        resourceData.pSysMem = &( vertices[ 0 ] );
-
-        // Send the vertex data to DirectX
-        HR( device->CreateBuffer( &bufferDesc, &resourceData, _vertexBuffer.GetAddress() ) );
+        shortIndices.resize( indices.size() );
+        for ( size_t index = 0; index < indices.size(); ++index )
+        {
+            shortIndices[ index ] = static_cast<USHORT>( indices[ index ] );
+        }
+
+        _indexFormat = DXGI_FORMAT_R16_UINT;
+        indexData = &( shortIndices[ 0 ] );
+        indexSize = sizeof( USHORT );
     }
 
+    CreateBuffers( device, vertexData, sizeof( TVertex ) * vertices.size(), indexData, indexSize * indices.size() );
 
-    // Reuse the buffer description for the index buffer
-    if ( indices.size() > 0 )
-    {
-        bufferDesc.ByteWidth = sizeof( UINT ) * indices.size();
-        bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-
-        // Set the resource data pointer
-        resourceData.pSysMem = &( indices[ 0 ] );
-
-        // Send the index data to DirectX
-        HR( device->CreateBuffer( &bufferDesc, &resourceData, _indexBuffer.GetAddress() ) );
-    }
+    // Meshes built by hand only have the one level of detail
+    MeshLod lod = { 0, static_cast<UINT>( indices.size() ), 0.0f };
+    _lods.push_back( lod );
 }
@@ -0,0 +1,247 @@
+#include "MeshFile.hpp"
+#include <fstream>
+#include <string.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+const UINT MeshFile::Magic   = 0x4853454D; // "MESH"
+const UINT MeshFile::Version = 2;
+
+// Creates a new mesh file
+MeshFile::MeshFile()
+    : _contents( nullptr )
+    , _size( 0 )
+{
+}
+
+// Destroys this mesh file
+MeshFile::~MeshFile()
+{
+    _contents = nullptr;
+    _size = 0;
+}
+
+// Builds this file in memory
+bool MeshFile::Create( const MeshFileHeader& header, const void* vertices, const std::vector<UINT>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods )
+{
+    _mapping.Close();
+    _data.clear();
+    _contents = nullptr;
+    _size = 0;
+
+    MeshFileHeader fileHeader = header;
+    fileHeader.Magic = Magic;
+    fileHeader.Version = Version;
+    fileHeader.IndexFormat = ( header.VertexCount <= 0xFFFF ) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    fileHeader.IndexCount = static_cast<UINT>( indices.size() );
+    fileHeader.SubmeshCount = static_cast<UINT>( submeshes.size() );
+    fileHeader.LodCount = static_cast<UINT>( lods.size() );
+
+    const size_t submeshBytes = sizeof( Submesh ) * submeshes.size();
+    const size_t lodBytes = sizeof( MeshLod ) * lods.size();
+    const size_t vertexBytes = static_cast<size_t>( header.VertexStride ) * header.VertexCount;
+    const size_t indexSize = ( fileHeader.IndexFormat == DXGI_FORMAT_R16_UINT ) ? sizeof( USHORT ) : sizeof( UINT );
+    _data.resize( sizeof( MeshFileHeader ) + submeshBytes + lodBytes + vertexBytes + indexSize * indices.size() );
+
+    unsigned char* write = &_data[ 0 ];
+    memcpy( write, &fileHeader, sizeof( MeshFileHeader ) );
+    write += sizeof( MeshFileHeader );
+    if ( submeshBytes > 0 )
+    {
+        memcpy( write, &submeshes[ 0 ], submeshBytes );
+        write += submeshBytes;
+    }
+    if ( lodBytes > 0 )
+    {
+        memcpy( write, &lods[ 0 ], lodBytes );
+        write += lodBytes;
+    }
+    if ( vertexBytes > 0 )
+    {
+        memcpy( write, vertices, vertexBytes );
+        write += vertexBytes;
+    }
+    for ( UINT index : indices )
+    {
+        if ( indexSize == sizeof( USHORT ) )
+        {
+            USHORT shortIndex = static_cast<USHORT>( index );
+            memcpy( write, &shortIndex, sizeof( USHORT ) );
+        }
+        else
+        {
+            memcpy( write, &index, sizeof( UINT ) );
+        }
+        write += indexSize;
+    }
+
+    _contents = &_data[ 0 ];
+    _size = _data.size();
+    return true;
+}
+
+// Gets the cooked file name for a source mesh file
+std::string MeshFile::GetCookedFileName( const std::string& fname )
+{
+    size_t extension = fname.find_last_of( '.' );
+    size_t directory = fname.find_last_of( "\\/" );
+    if ( extension == std::string::npos || ( directory != std::string::npos && extension < directory ) )
+    {
+        return fname + ".meshbin";
+    }
+    return fname.substr( 0, extension ) + ".meshbin";
+}
+
+// Gets the header
+const MeshFileHeader& MeshFile::GetHeader() const
+{
+    return *reinterpret_cast<const MeshFileHeader*>( _contents );
+}
+
+// Gets the index buffer data
+const void* MeshFile::GetIndexData() const
+{
+    return static_cast<const unsigned char*>( GetVertexData() ) + GetVertexDataSize();
+}
+
+// Gets the size of the index buffer data
+size_t MeshFile::GetIndexDataSize() const
+{
+    return GetIndexSize() * GetHeader().IndexCount;
+}
+
+// Gets the size of one index
+size_t MeshFile::GetIndexSize() const
+{
+    return ( GetHeader().IndexFormat == DXGI_FORMAT_R16_UINT ) ? sizeof( USHORT ) : sizeof( UINT );
+}
+
+// Gets the level of detail table
+const MeshLod* MeshFile::GetLods() const
+{
+    return reinterpret_cast<const MeshLod*>( GetSubmeshes() + GetHeader().SubmeshCount );
+}
+
+// Gets the submesh table
+const Submesh* MeshFile::GetSubmeshes() const
+{
+    return reinterpret_cast<const Submesh*>( _contents + sizeof( MeshFileHeader ) );
+}
+
+// Gets the vertex buffer data
+const void* MeshFile::GetVertexData() const
+{
+    return reinterpret_cast<const unsigned char*>( GetLods() + GetHeader().LodCount );
+}
+
+// Gets the size of the vertex buffer data
+size_t MeshFile::GetVertexDataSize() const
+{
+    return static_cast<size_t>( GetHeader().VertexStride ) * GetHeader().VertexCount;
+}
+
+// Hashes a file's contents
+bool MeshFile::HashFile( const std::string& fname, UINT64& hash )
+{
+    MappedFile file;
+    if ( !file.Open( fname ) )
+    {
+        return false;
+    }
+
+    hash = file.Hash();
+    return true;
+}
+
+// Attempts to map a cooked mesh file
+bool MeshFile::LoadFromFile( const std::string& fname )
+{
+    _data.clear();
+    _contents = nullptr;
+    _size = 0;
+
+    if ( !_mapping.Open( fname ) )
+    {
+        return false;
+    }
+
+    // Make sure the file is one of ours and that every buffer the header describes is actually there
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>( _mapping.GetData() );
+    if ( _mapping.GetSize() < sizeof( MeshFileHeader ) || header->Magic != Magic || header->Version != Version
+      || ( header->IndexFormat != DXGI_FORMAT_R16_UINT && header->IndexFormat != DXGI_FORMAT_R32_UINT ) )
+    {
+        _mapping.Close();
+        return false;
+    }
+
+    // The sizes come from the file, so they're added up in 64 bits where a corrupt header can't wrap them
+    _contents = _mapping.GetData();
+    _size = _mapping.GetSize();
+    UINT64 expectedSize = sizeof( MeshFileHeader ) + static_cast<UINT64>( sizeof( Submesh ) ) * header->SubmeshCount
+                        + static_cast<UINT64>( sizeof( MeshLod ) ) * header->LodCount
+                        + static_cast<UINT64>( header->VertexStride ) * header->VertexCount
+                        + static_cast<UINT64>( GetIndexSize() ) * header->IndexCount;
+    bool areRangesValid = header->LodCount > 0;
+    for ( UINT lod = 0; lod < header->LodCount && areRangesValid && _size == expectedSize; ++lod )
+    {
+        areRangesValid = static_cast<UINT64>( GetLods()[ lod ].IndexStart ) + GetLods()[ lod ].IndexCount <= header->IndexCount;
+    }
+    for ( UINT submesh = 0; submesh < header->SubmeshCount && areRangesValid && _size == expectedSize; ++submesh )
+    {
+        areRangesValid = static_cast<UINT64>( GetSubmeshes()[ submesh ].IndexStart ) + GetSubmeshes()[ submesh ].IndexCount <= header->IndexCount;
+    }
+
+    // Every index has to point at a vertex that's actually in the file
+    for ( UINT index = 0; index < header->IndexCount && areRangesValid && _size == expectedSize; ++index )
+    {
+        UINT vertex = 0;
+        if ( header->IndexFormat == DXGI_FORMAT_R16_UINT )
+        {
+            vertex = static_cast<const USHORT*>( GetIndexData() )[ index ];
+        }
+        else
+        {
+            vertex = static_cast<const UINT*>( GetIndexData() )[ index ];
+        }
+        areRangesValid = vertex < header->VertexCount;
+    }
+
+    if ( _size != expectedSize || !areRangesValid )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        if ( _size != expectedSize )
+        {
+            std::cout << "'" << fname << "' is " << _size << " bytes, but should be " << expectedSize << " bytes." << std::endl;
+        }
+        else
+        {
+            std::cout << "'" << fname << "' has submeshes or indices outside of its buffers." << std::endl;
+        }
+#endif
+        _mapping.Close();
+        _contents = nullptr;
+        _size = 0;
+        return false;
+    }
+
+    return true;
+}
+
+// Attempts to save this file
+bool MeshFile::Save( const std::string& fname ) const
+{
+    if ( !_contents )
+    {
+        return false;
+    }
+
+    std::ofstream file( fname, std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !file.is_open() )
+    {
+        return false;
+    }
+
+    file.write( reinterpret_cast<const char*>( _contents ), _size );
+    return static_cast<bool>( file );
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines the header at the start of a cooked mesh file. It is followed by the submesh table, the
+/// level of detail table, the vertex buffer and then the index buffer, all in the exact layout the
+/// GPU expects.
+/// </summary>
+struct MeshFileHeader
+{
+    UINT Magic;
+    UINT Version;
+    UINT64 SourceHash;
+    UINT VertexFormat;
+    UINT VertexStride;
+    UINT VertexCount;
+    UINT IndexFormat;
+    UINT IndexCount;
+    UINT SubmeshCount;
+    UINT LodCount;
+    DirectX::XMFLOAT3 BoundsSize;
+    float BoundsRadius;
+    DirectX::XMFLOAT3 PositionOffset;
+    DirectX::XMFLOAT3 PositionScale;
+};
+
+/// <summary>
+/// Defines a cooked mesh file (.meshbin). Cooked files are memory mapped when loaded, so their
+/// buffers can be handed straight to the GPU without being read or parsed first.
+/// </summary>
+class MeshFile
+{
+    ImplementNonCopyableClass( MeshFile );
+    ImplementNonMovableClass( MeshFile );
+
+    static const UINT Magic;
+    static const UINT Version;
+
+    MappedFile _mapping;
+    std::vector<unsigned char> _data;
+    const unsigned char* _contents;
+    size_t _size;
+
+    /// <summary>
+    /// Gets the number of bytes in each of this file's indices.
+    /// </summary>
+    size_t GetIndexSize() const;
+
+public:
+    /// <summary>
+    /// Creates a new, empty mesh file.
+    /// </summary>
+    MeshFile();
+
+    /// <summary>
+    /// Destroys this mesh file.
+    /// </summary>
+    ~MeshFile();
+
+    /// <summary>
+    /// Builds this file in memory. Indices are stored as 16-bit values if the vertex count allows.
+    /// </summary>
+    /// <param name="header">The header. The magic, version, index, submesh and level of detail fields are filled in here.</param>
+    /// <param name="vertices">The vertex data, which must hold the header's vertex count of vertices.</param>
+    /// <param name="indices">The triangle list indices of every level of detail.</param>
+    /// <param name="submeshes">The submesh table.</param>
+    /// <param name="lods">The level of detail table.</param>
+    bool Create( const MeshFileHeader& header, const void* vertices, const std::vector<UINT>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods );
+
+    /// <summary>
+    /// Gets the name of the cooked file for the given source mesh file.
+    /// </summary>
+    /// <param name="fname">The source mesh file.</param>
+    static std::string GetCookedFileName( const std::string& fname );
+
+    /// <summary>
+    /// Gets this file's header.
+    /// </summary>
+    const MeshFileHeader& GetHeader() const;
+
+    /// <summary>
+    /// Gets this file's index buffer data.
+    /// </summary>
+    const void* GetIndexData() const;
+
+    /// <summary>
+    /// Gets the number of bytes of index buffer data.
+    /// </summary>
+    size_t GetIndexDataSize() const;
+
+    /// <summary>
+    /// Gets this file's level of detail table.
+    /// </summary>
+    const MeshLod* GetLods() const;
+
+    /// <summary>
+    /// Gets this file's submesh table.
+    /// </summary>
+    const Submesh* GetSubmeshes() const;
+
+    /// <summary>
+    /// Gets this file's vertex buffer data.
+    /// </summary>
+    const void* GetVertexData() const;
+
+    /// <summary>
+    /// Gets the number of bytes of vertex buffer data.
+    /// </summary>
+    size_t GetVertexDataSize() const;
+
+    /// <summary>
+    /// Hashes the contents of the given file with 64-bit FNV-1a.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    /// <param name="hash">Receives the hash.</param>
+    static bool HashFile( const std::string& fname, UINT64& hash );
+
+    /// <summary>
+    /// Attempts to memory map the given cooked mesh file and check that it is complete.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    bool LoadFromFile( const std::string& fname );
+
+    /// <summary>
+    /// Attempts to save this file.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    bool Save( const std::string& fname ) const;
+};
@@ -1,10 +1,20 @@
 #include "MeshLoader.hpp"
 #include "BoxCollider.hpp"
+#include "MeshFile.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "ResourceManager.hpp"
 #include "SphereCollider.hpp"
+#include "ThreadPool.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <algorithm>
+#include <DirectXPackedVector.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include "Timer.hpp"
+#   include <iostream>
+#endif
 
 using namespace DirectX;
 
@@ -19,47 +29,195 @@ inline float fmul( float a, float b ) { return a * b; }
 #define Float3_Sub(a, b) Float3_Cmp( a, b, fsub )
 #define Float3_Mul(a, b) Float3_Cmp( a, b, fmul )
 
-std::unordered_map<std::string, MeshLoader::MeshCacheData> MeshLoader::_meshCache;
+/// <summary>
+/// Defines one mesh of a batch being loaded.
+/// </summary>
+struct BatchJob
+{
+    std::string FileName;
+    MeshFile File;
+    bool IsLoaded;
+    bool IsCooked;
+};
+
+VertexFormat MeshLoader::_vertexFormat = VertexFormat::Compact;
+
+// Packs a value in [0, 1] into 16-bit fixed point
+static UINT PackUnorm16( float value )
+{
+    return static_cast<UINT>( std::min( std::max( value, 0.0f ), 1.0f ) * 65535.0f + 0.5f );
+}
+
+// Packs a value in [-1, 1] into a 16-bit signed normalized value
+static UINT PackSnorm16( float value )
+{
+    float scaled = std::min( std::max( value, -1.0f ), 1.0f ) * 32767.0f;
+    SHORT rounded = static_cast<SHORT>( ( scaled >= 0.0f ) ? scaled + 0.5f : scaled - 0.5f );
+    return static_cast<USHORT>( rounded );
+}
 
-// Applies mesh cache data to a collider
-void MeshLoader::ApplyDataToCollider( MeshCacheData& data, Collider* collider )
+// Encodes a unit vector as a point on an octahedron, packed into two 16-bit signed normalized values
+static UINT EncodeOctahedral( const XMFLOAT3& vector )
+{
+    float length = fabsf( vector.x ) + fabsf( vector.y ) + fabsf( vector.z );
+    if ( length <= 0.0f )
+    {
+        return 0;
+    }
+
+    // Project onto the octahedron, then fold the lower half over the upper half
+    float x = vector.x / length;
+    float y = vector.y / length;
+    if ( vector.z < 0.0f )
+    {
+        float foldedX = ( 1.0f - fabsf( y ) ) * ( ( x >= 0.0f ) ? 1.0f : -1.0f );
+        float foldedY = ( 1.0f - fabsf( x ) ) * ( ( y >= 0.0f ) ? 1.0f : -1.0f );
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return PackSnorm16( x ) | ( PackSnorm16( y ) << 16 );
+}
+
+// Fits a collider to a mesh's bounds
+void MeshLoader::ApplyBoundsToCollider( const Mesh& mesh, Collider* collider )
 {
     if ( collider )
     {
         if ( collider->GetType() == ColliderType::Box )
         {
             BoxCollider* bc = static_cast<BoxCollider*>( collider );
-            bc->SetSize( data.Size );
+            bc->SetSize( mesh.GetBoundsSize() );
         }
         else if ( collider->GetType() == ColliderType::Sphere )
         {
             SphereCollider* sc = static_cast<SphereCollider*>( collider );
-            sc->SetRadius( data.Radius );
+            sc->SetRadius( mesh.GetBoundsRadius() );
         }
     }
 }
 
+// Packs standard vertices into compact vertices
+void MeshLoader::CompactVertices( const std::vector<Vertex>& vertices, std::vector<CompactVertex>& compactVertices, XMFLOAT3& positionOffset, XMFLOAT3& positionScale )
+{
+    // Positions are quantized within the mesh's bounds, so find those first
+    XMFLOAT3 min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    XMFLOAT3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for ( const Vertex& vertex : vertices )
+    {
+        min = Float3_Min( min, vertex.Position );
+        max = Float3_Max( max, vertex.Position );
+    }
+    if ( vertices.empty() )
+    {
+        min = max = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    }
+
+    positionOffset = min;
+    positionScale = Float3_Sub( max, min );
+
+    // Flat meshes have no size along some axis, so don't divide by it
+    XMFLOAT3 invScale( ( positionScale.x > 0.0f ) ? 1.0f / positionScale.x : 0.0f,
+                       ( positionScale.y > 0.0f ) ? 1.0f / positionScale.y : 0.0f,
+                       ( positionScale.z > 0.0f ) ? 1.0f / positionScale.z : 0.0f );
+
+    compactVertices.resize( vertices.size() );
+    for ( size_t index = 0; index < vertices.size(); ++index )
+    {
+        const Vertex& vertex = vertices[ index ];
+        CompactVertex& compact = compactVertices[ index ];
+
+        XMFLOAT3 position = Float3_Mul( Float3_Sub( vertex.Position, min ), invScale );
+        compact.PositionXY = PackUnorm16( position.x ) | ( PackUnorm16( position.y ) << 16 );
+        compact.PositionZ = PackUnorm16( position.z );
+
+        compact.UV = static_cast<UINT>( PackedVector::XMConvertFloatToHalf( vertex.UV.x ) )
+                   | ( static_cast<UINT>( PackedVector::XMConvertFloatToHalf( vertex.UV.y ) ) << 16 );
+
+        compact.Normal = EncodeOctahedral( vertex.Normal );
+        compact.Tangent = EncodeOctahedral( vertex.Tangent );
+    }
+}
+
+// Cooks a source mesh file
+bool MeshLoader::Cook( Assimp::Importer& importer, const std::string& fname, UINT64 sourceHash, MeshFile& file )
+{
+    std::vector<Vertex> vertices;
+    std::vector<UINT> indices;
+    std::vector<Submesh> submeshes;
+    if ( !Import( importer, fname, vertices, indices, submeshes ) )
+    {
+        return false;
+    }
+
+    // Build the coarser levels of detail out of the same vertices, then reorder everything for the
+    // vertex cache, overdraw and vertex fetch before it goes to the GPU
+    std::vector<MeshLod> lods;
+    MeshSimplifier::GenerateLods( vertices, indices, lods );
+    MeshOptimizer::Optimize( vertices, indices, submeshes, lods );
+
+    MeshFileHeader header;
+    ZeroMemory( &header, sizeof( MeshFileHeader ) );
+    header.SourceHash = sourceHash;
+    header.VertexFormat = static_cast<UINT>( _vertexFormat );
+    header.VertexCount = static_cast<UINT>( vertices.size() );
+    ProcessVertices( vertices, header.BoundsSize, header.BoundsRadius );
+    header.PositionScale = XMFLOAT3( 1.0f, 1.0f, 1.0f );
+
+    // Pack the vertices down first if we're using compact vertices
+    bool isCreated = false;
+    if ( _vertexFormat == VertexFormat::Compact )
+    {
+        std::vector<CompactVertex> compactVertices;
+        CompactVertices( vertices, compactVertices, header.PositionOffset, header.PositionScale );
+        header.VertexStride = sizeof( CompactVertex );
+        isCreated = file.Create( header, compactVertices.empty() ? nullptr : &compactVertices[ 0 ], indices, submeshes, lods );
+    }
+    else
+    {
+        header.VertexStride = sizeof( Vertex );
+        isCreated = file.Create( header, vertices.empty() ? nullptr : &vertices[ 0 ], indices, submeshes, lods );
+    }
+
+    // Failing to save only means the mesh gets cooked again next time
+    std::string cookedName = MeshFile::GetCookedFileName( fname );
+    if ( isCreated && !file.Save( cookedName ) )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Failed to save '" << cookedName << "'" << std::endl;
+#endif
+    }
+    return isCreated;
+}
+
+// Gets the format loaded meshes store their vertices in
+VertexFormat MeshLoader::GetVertexFormat()
+{
+    return _vertexFormat;
+}
+
 // Processes an Assimp node
-void MeshLoader::ProcessNode( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const aiScene* scene, aiNode* node )
+void MeshLoader::ProcessNode( std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes, const aiScene* scene, aiNode* node )
 {
     // Process sub-meshes
     for ( UINT i = 0; i < node->mNumMeshes; ++i )
     {
         aiMesh* mesh = scene->mMeshes[ node->mMeshes[ i ] ];
-        ProcessMesh( vertices, indices, scene, mesh );
+        ProcessMesh( vertices, indices, submeshes, scene, mesh );
     }
 
     // Process nodes
     for ( UINT i = 0; i < node->mNumChildren; ++i )
     {
-        ProcessNode( vertices, indices, scene, node->mChildren[ i ] );
+        ProcessNode( vertices, indices, submeshes, scene, node->mChildren[ i ] );
     }
 }
 
 // Processes an Assimp mesh
-void MeshLoader::ProcessMesh( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const aiScene* scene, aiMesh* mesh )
+void MeshLoader::ProcessMesh( std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes, const aiScene* scene, aiMesh* mesh )
 {
-    // Get the vertices
+    // Get the vertices, remembering where they start so the indices can be offset to match
+    const UINT baseVertex = static_cast<UINT>( vertices.size() );
     Vertex v;
     for ( UINT i = 0; i < mesh->mNumVertices; ++i )
     {
@@ -85,19 +243,24 @@ void MeshLoader::ProcessMesh( std::vector<Vertex>& vertices, std::vector<UINT>&
         vertices.push_back( v );
     }
 
-    // Get the face indices
+    // Get the face indices, recording which of them belong to this mesh
+    Submesh submesh;
+    submesh.IndexStart = static_cast<UINT>( indices.size() );
+    submesh.IndexCount = mesh->mNumFaces * 3;
+    submesh.MaterialIndex = mesh->mMaterialIndex;
+    submeshes.push_back( submesh );
     for ( UINT i = 0; i < mesh->mNumFaces; ++i )
     {
         // We triangulate the models, so we're guaranteed 3 indices
         aiFace face = mesh->mFaces[ i ];
-        indices.push_back( face.mIndices[ 0 ] );
-        indices.push_back( face.mIndices[ 1 ] );
-        indices.push_back( face.mIndices[ 2 ] );
+        indices.push_back( baseVertex + face.mIndices[ 0 ] );
+        indices.push_back( baseVertex + face.mIndices[ 1 ] );
+        indices.push_back( baseVertex + face.mIndices[ 2 ] );
     }
 }
 
-// Processes vertices for mesh cache data
-void MeshLoader::ProcessVertices( const std::vector<Vertex>& vertices, MeshCacheData& data )
+// Works out the bounds of a mesh's vertices
+void MeshLoader::ProcessVertices( const std::vector<Vertex>& vertices, XMFLOAT3& size, float& radius )
 {
     // Get the min and max vertex
     XMFLOAT3 min = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
@@ -105,12 +268,12 @@ void MeshLoader::ProcessVertices( const std::vector<Vertex>& vertices, MeshCache
     for ( const Vertex& vertex : vertices )
     {
         min = Float3_Min( min, vertex.Position );
-        max = Float3_Min( max, vertex.Position );
+        max = Float3_Max( max, vertex.Position );
     }
 
     // Set the size and get the center
-    data.Size = Float3_Sub( max, min );
-    XMFLOAT3 center = Float3_Add( min, Float3_Mul( data.Size, XMFLOAT3( 0.5f, 0.5f, 0.5f ) ) );
+    size = Float3_Sub( max, min );
+    XMFLOAT3 center = Float3_Add( min, Float3_Mul( size, XMFLOAT3( 0.5f, 0.5f, 0.5f ) ) );
 
     // Get the maximum distance squared to a vertex
     float maxDistSq = -FLT_MAX;
@@ -124,28 +287,19 @@ void MeshLoader::ProcessVertices( const std::vector<Vertex>& vertices, MeshCache
     }
 
     // Set the radius
-    data.Radius = std::sqrt( maxDistSq );
+    radius = std::sqrt( maxDistSq );
 }
 
-// Loads a mesh from a file
-std::shared_ptr<Mesh> MeshLoader::Load( const std::string& fname, ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+// Imports a mesh's vertices, indices and submeshes from a file
+bool MeshLoader::Import( const std::string& fname, std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes )
 {
-    return Load( fname, device, deviceContext, nullptr );
+    Assimp::Importer importer;
+    return Import( importer, fname, vertices, indices, submeshes );
 }
 
-// Loads a mesh from a file
-std::shared_ptr<Mesh> MeshLoader::Load( const std::string& fname, ID3D11Device* device, ID3D11DeviceContext* deviceContext, Collider* collider )
+// Imports a mesh's vertices, indices and submeshes from a file with the given importer
+bool MeshLoader::Import( Assimp::Importer& importer, const std::string& fname, std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes )
 {
-    // If the mesh has been loaded before, we don't need to re-load it
-    auto search = _meshCache.find( fname );
-    if ( search != _meshCache.end() )
-    {
-        ApplyDataToCollider( search->second, collider );
-        return search->second.Mesh;
-    }
-
-    // Load the mesh's information
-    Assimp::Importer importer;
     UINT importFlags = aiProcess_CalcTangentSpace
         | aiProcess_GenSmoothNormals
         | aiProcess_JoinIdenticalVertices
@@ -153,26 +307,151 @@ std::shared_ptr<Mesh> MeshLoader::Load( const std::string& fname, ID3D11Device*
     const aiScene* scene = importer.ReadFile( fname, importFlags );
 
     // If we failed to load the mesh, then we have nothing to return
-    std::shared_ptr<Mesh> mesh;
-    if ( scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode )
+    if ( !scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode )
     {
-        return mesh;
+        return false;
     }
 
     // Now process the root node
-    std::vector<Vertex> vertices;
-    std::vector<UINT> indices;
-    ProcessNode( vertices, indices, scene, scene->mRootNode );
+    vertices.clear();
+    indices.clear();
+    submeshes.clear();
+    ProcessNode( vertices, indices, submeshes, scene, scene->mRootNode );
+    importer.FreeScene();
+    return true;
+}
 
-    // Now create the mesh
-    mesh = std::make_shared<Mesh>( device, vertices, indices );
-    if ( mesh )
+// Loads a mesh from a file
+std::shared_ptr<Mesh> MeshLoader::Load( const std::string& fname, ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    return Load( fname, device, deviceContext, nullptr );
+}
+
+// Loads a mesh from a file
+std::shared_ptr<Mesh> MeshLoader::Load( const std::string& fname, ID3D11Device* device, ID3D11DeviceContext* deviceContext, Collider* collider )
+{
+    // If the mesh hasn't been loaded before, load it as a batch of one
+    std::shared_ptr<Mesh> mesh = ResourceManager::GetMeshes().Find( fname );
+    if ( !mesh )
     {
-        MeshCacheData data;
-        data.Mesh = mesh;
-        ProcessVertices( vertices, data );
-        ApplyDataToCollider( data, collider );
-        _meshCache[ fname ] = data;
+        LoadBatch( std::vector<std::string>( 1, fname ), device, deviceContext );
+        mesh = ResourceManager::GetMeshes().Find( fname );
+        if ( !mesh )
+        {
+            return nullptr;
+        }
     }
+
+    ApplyBoundsToCollider( *mesh, collider );
     return mesh;
 }
+
+// Loads a batch of meshes in parallel
+void MeshLoader::LoadBatch( const std::vector<std::string>& fnames, ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+#if defined( _DEBUG ) || defined( DEBUG )
+    Timer timer;
+    timer.Start();
+#endif
+
+    // Skip the meshes that have already been loaded, and only load each of the rest once
+    ResourceCache<Mesh>& cache = ResourceManager::GetMeshes();
+    std::vector<std::string> jobNames;
+    for ( auto& fname : fnames )
+    {
+        if ( !cache.Find( fname ) && std::find( jobNames.begin(), jobNames.end(), fname ) == jobNames.end() )
+        {
+            jobNames.push_back( fname );
+        }
+    }
+    if ( jobNames.empty() )
+    {
+        return;
+    }
+
+    const size_t jobCount = jobNames.size();
+    std::unique_ptr<BatchJob[]> jobs( new BatchJob[ jobCount ] );
+    for ( size_t job = 0; job < jobCount; ++job )
+    {
+        jobs[ job ].FileName = jobNames[ job ];
+        jobs[ job ].IsLoaded = false;
+        jobs[ job ].IsCooked = false;
+    }
+
+    // Each task loads one mesh, creating its own importer only if it has to cook. Cooking never uses the thread
+    // pool itself, so the tasks can't end up nesting ParallelFor calls
+    ThreadPool::ParallelFor( jobCount, 1, [ &jobs ]( size_t begin, size_t end )
+    {
+        for ( size_t job = begin; job < end; ++job )
+        {
+            std::unique_ptr<Assimp::Importer> importer;
+            jobs[ job ].IsLoaded = LoadFile( importer, jobs[ job ].FileName, jobs[ job ].File, jobs[ job ].IsCooked );
+        }
+    } );
+
+    // Creating the buffers is quick, so every mesh goes into the cache at once from this thread
+    for ( size_t job = 0; job < jobCount; ++job )
+    {
+        if ( !jobs[ job ].IsLoaded )
+        {
+#if defined( _DEBUG ) || defined( DEBUG )
+            std::cout << "Failed to load '" << jobs[ job ].FileName << "'" << std::endl;
+#endif
+            continue;
+        }
+
+        // Copies of the same model under different names only get one set of buffers
+        const MeshFile& file = jobs[ job ].File;
+        UINT64 contentHash = file.GetHeader().SourceHash ^ ( static_cast<UINT64>( file.GetHeader().VertexFormat ) << 56 );
+        if ( cache.FindContent( jobs[ job ].FileName, contentHash ) )
+        {
+            continue;
+        }
+
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>( device, file );
+        cache.Add( jobs[ job ].FileName, contentHash, mesh );
+
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Loaded '" << jobs[ job ].FileName << "' with " << mesh->GetVertexCount() << " vertices ("
+                  << ( mesh->GetVertexCount() * mesh->GetVertexStride() ) << " bytes) and "
+                  << mesh->GetLods().size() << " levels of detail"
+                  << ( jobs[ job ].IsCooked ? "" : ", cooked it first" ) << std::endl;
+#endif
+    }
+
+#if defined( _DEBUG ) || defined( DEBUG )
+    timer.Stop();
+    std::cout << "Loaded " << jobCount << " meshes on " << ThreadPool::GetThreadCount() << " threads in " << timer.GetElapsedTime() << " seconds." << std::endl;
+#endif
+}
+
+// Maps a mesh's cooked file, cooking it first if needed
+bool MeshLoader::LoadFile( std::unique_ptr<Assimp::Importer>& importer, const std::string& fname, MeshFile& file, bool& isCooked )
+{
+    // Use the cooked file if it was cooked from the current source, otherwise cook it again
+    UINT64 sourceHash = 0;
+    bool hasSource = MeshFile::HashFile( fname, sourceHash );
+    isCooked = file.LoadFromFile( MeshFile::GetCookedFileName( fname ) )
+            && ( !hasSource || file.GetHeader().SourceHash == sourceHash )
+            && file.GetHeader().VertexFormat == static_cast<UINT>( _vertexFormat );
+    if ( isCooked )
+    {
+        return true;
+    }
+    if ( !hasSource )
+    {
+        return false;
+    }
+
+    if ( !importer )
+    {
+        importer.reset( new Assimp::Importer() );
+    }
+    return Cook( *importer, fname, sourceHash, file );
+}
+
+// Sets the format loaded meshes store their vertices in
+void MeshLoader::SetVertexFormat( VertexFormat format )
+{
+    _vertexFormat = format;
+}
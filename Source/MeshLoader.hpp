@@ -3,14 +3,20 @@
 #include "Config.hpp"
 #include "Mesh.hpp"
 #include <memory>
-#include <unordered_map>
 #include <string>
+#include <vector>
 
 struct aiNode;
 struct aiMesh;
 struct aiScene;
 
+namespace Assimp
+{
+    class Importer;
+}
+
 class Collider;
+class MeshFile;
 
 /// <summary>
 /// Defines a static mesh loader.
@@ -19,42 +25,90 @@ class MeshLoader
 {
     ImplementStaticClass( MeshLoader );
 
-    struct MeshCacheData
-    {
-        DirectX::XMFLOAT3 Size;
-        std::shared_ptr<Mesh> Mesh;
-        float Radius;
-    };
-
-    static std::unordered_map<std::string, MeshCacheData> _meshCache;
+    static VertexFormat _vertexFormat;
 
     /// <summary>
-    /// Applies mesh cache data to a collider.
+    /// Fits a collider to a mesh's bounds.
     /// </summary>
-    /// <param name="data">The data.</param>
+    /// <param name="mesh">The mesh.</param>
     /// <param name="collider">The collider.</param>
-    static void ApplyDataToCollider( MeshCacheData& data, Collider* collider );
+    static void ApplyBoundsToCollider( const Mesh& mesh, Collider* collider );
+
+    /// <summary>
+    /// Imports, optimizes and packs a source mesh file, then saves it as a cooked mesh file.
+    /// </summary>
+    /// <param name="importer">The importer to read the source mesh file with.</param>
+    /// <param name="fname">The source mesh file.</param>
+    /// <param name="sourceHash">The hash of the source mesh file.</param>
+    /// <param name="file">Receives the cooked mesh file.</param>
+    static bool Cook( Assimp::Importer& importer, const std::string& fname, UINT64 sourceHash, MeshFile& file );
+
+    /// <summary>
+    /// Packs standard vertices into compact vertices.
+    /// </summary>
+    /// <param name="vertices">The standard vertices.</param>
+    /// <param name="compactVertices">Receives the compact vertices.</param>
+    /// <param name="positionOffset">Receives the minimum corner of the vertices' bounds.</param>
+    /// <param name="positionScale">Receives the size of the vertices' bounds.</param>
+    static void CompactVertices( const std::vector<Vertex>& vertices, std::vector<CompactVertex>& compactVertices, DirectX::XMFLOAT3& positionOffset, DirectX::XMFLOAT3& positionScale );
+
+    /// <summary>
+    /// Imports a mesh's vertices, indices and submeshes from a file with the given importer.
+    /// </summary>
+    /// <param name="importer">The importer.</param>
+    /// <param name="fname">The file name.</param>
+    /// <param name="vertices">Receives the vertices.</param>
+    /// <param name="indices">Receives the triangle list indices.</param>
+    /// <param name="submeshes">Receives the range of indices each source mesh uses.</param>
+    static bool Import( Assimp::Importer& importer, const std::string& fname, std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes );
+
+    /// <summary>
+    /// Maps a mesh's cooked file, cooking it first if it is missing or was cooked from a different
+    /// version of the source file. Safe to call from several threads at once.
+    /// </summary>
+    /// <param name="importer">The importer to cook with, which is created the first time it's needed. Importers aren't thread safe, so each task needs its own.</param>
+    /// <param name="fname">The source mesh file.</param>
+    /// <param name="file">Receives the cooked mesh file.</param>
+    /// <param name="isCooked">Receives whether an up to date cooked file was already there.</param>
+    static bool LoadFile( std::unique_ptr<Assimp::Importer>& importer, const std::string& fname, MeshFile& file, bool& isCooked );
 
     /// <summary>
-    /// Processes a mesh's node into the given vertices and indices.
+    /// Processes a mesh's node into the given vertices, indices and submeshes.
     /// </summary>
-    static void ProcessNode( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const aiScene* scene, aiNode* node );
+    static void ProcessNode( std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes, const aiScene* scene, aiNode* node );
 
     /// <summary>
-    /// Processes a mesh into the given vertices and indices.
+    /// Processes a mesh into the given vertices and indices, and adds it to the submesh table.
     /// </summary>
-    static void ProcessMesh( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const aiScene* scene, aiMesh* mesh );
+    static void ProcessMesh( std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes, const aiScene* scene, aiMesh* mesh );
 
     /// <summary>
-    /// Processes vertices for mesh cache data.
+    /// Works out the bounds of a mesh's vertices.
     /// </summary>
     /// <param name="vertices">The vertices.</param>
-    /// <param name="data">The data.</param>
-    static void ProcessVertices( const std::vector<Vertex>& vertices, MeshCacheData& data );
+    /// <param name="size">Receives the size of the vertices' bounds.</param>
+    /// <param name="radius">Receives the radius of the sphere around the center of the bounds that holds every vertex.</param>
+    static void ProcessVertices( const std::vector<Vertex>& vertices, DirectX::XMFLOAT3& size, float& radius );
 
 public:
     /// <summary>
-    /// Loads a mesh.
+    /// Gets the format that loaded meshes store their vertices in.
+    /// </summary>
+    static VertexFormat GetVertexFormat();
+
+    /// <summary>
+    /// Imports a mesh's vertices, indices and submeshes from a file without optimizing them or creating a mesh.
+    /// </summary>
+    /// <param name="fname">The file name.</param>
+    /// <param name="vertices">Receives the vertices.</param>
+    /// <param name="indices">Receives the triangle list indices.</param>
+    /// <param name="submeshes">Receives the range of indices each source mesh uses.</param>
+    static bool Import( const std::string& fname, std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<Submesh>& submeshes );
+
+    /// <summary>
+    /// Loads a mesh. The mesh is loaded from its cooked file, which is cooked first if it is missing
+    /// or was cooked from a different version of the source file. Loaded meshes are kept in the
+    /// resource manager's mesh cache, and are shared with every other path to the same source file.
     /// </summary>
     /// <param name="fname">The file name.</param>
     /// <param name="device">The graphics device to create the mesh on.</param>
@@ -69,4 +123,20 @@ public:
     /// <param name="device">The device context for the mesh to draw on.</param>
     /// <param name="collider.">The collider to modify to fit the model.</param>
     static std::shared_ptr<Mesh> Load( const std::string& fname, ID3D11Device* device, ID3D11DeviceContext* deviceContext, Collider* collider );
+
+    /// <summary>
+    /// Loads every mesh in a list at once, spread across the thread pool, so that a scene's meshes
+    /// don't have to be cooked or mapped one at a time on first use. Meshes that are already loaded
+    /// are skipped, and the rest are added to the resource manager's mesh cache together once they're all ready.
+    /// </summary>
+    /// <param name="fnames">The mesh file names.</param>
+    /// <param name="device">The graphics device to create the meshes on.</param>
+    /// <param name="deviceContext">The device context for the meshes to draw on.</param>
+    static void LoadBatch( const std::vector<std::string>& fnames, ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Sets the format that meshes loaded from now on store their vertices in.
+    /// </summary>
+    /// <param name="format">The vertex format.</param>
+    static void SetVertexFormat( VertexFormat format );
 };
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include "MeshOptimizer.hpp"
+#include "MeshLoader.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <math.h>
+#include <sstream>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+using namespace DirectX;
+
+const unsigned int MeshOptimizer::SimulatedCacheSize = 16;
+const unsigned int MeshOptimizer::ScoringCacheSize   = 32;
+const float        MeshOptimizer::OverdrawThreshold  = 1.05f;
+
+static const float  CacheDecayPower   = 1.5f;
+static const float  LastTriangleScore = 0.75f;
+static const float  ValenceBoostScale = 2.0f;
+static const float  ValenceBoostPower = 0.5f;
+static const size_t NoTriangle        = static_cast<size_t>( -1 );
+static const UINT   NoVertex          = static_cast<UINT>( -1 );
+
+// Scores a vertex by how recently it was used and how many triangles still need it
+static float ScoreVertex( int cachePosition, unsigned int remainingTriangles, unsigned int cacheSize )
+{
+    if ( remainingTriangles == 0 )
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if ( cachePosition >= 0 )
+    {
+        // The last triangle's vertices all get the same score, otherwise long thin strips win out
+        if ( cachePosition < 3 )
+        {
+            score = LastTriangleScore;
+        }
+        else
+        {
+            float scale = 1.0f - static_cast<float>( cachePosition - 3 ) / static_cast<float>( cacheSize - 3 );
+            score = powf( scale, CacheDecayPower );
+        }
+    }
+
+    // Vertices with only a few triangles left get a boost so they're finished off rather than left behind
+    score += ValenceBoostScale * powf( static_cast<float>( remainingTriangles ), -ValenceBoostPower );
+    return score;
+}
+
+// Uses a vertex in a simulated FIFO cache, returning true if it missed
+static bool TouchVertex( std::vector<size_t>& insertTimes, size_t& misses, UINT vertex, unsigned int cacheSize )
+{
+    // A vertex is still cached if fewer than cacheSize others have been inserted since it was
+    if ( insertTimes[ vertex ] != 0 && misses - insertTimes[ vertex ] < cacheSize )
+    {
+        return false;
+    }
+
+    ++misses;
+    insertTimes[ vertex ] = misses;
+    return true;
+}
+
+// Gets the ACMR of a mesh
+float MeshOptimizer::CalculateAcmr( const std::vector<UINT>& indices, size_t vertexCount )
+{
+    if ( indices.size() < 3 )
+    {
+        return 0.0f;
+    }
+
+    std::vector<size_t> insertTimes( vertexCount, 0 );
+    size_t misses = 0;
+    for ( UINT index : indices )
+    {
+        TouchVertex( insertTimes, misses, index, SimulatedCacheSize );
+    }
+
+    return static_cast<float>( misses ) / static_cast<float>( indices.size() / 3 );
+}
+
+// Runs every optimization on a mesh
+void MeshOptimizer::Optimize( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods )
+{
+    // The full detail mesh is split up by submesh, but the coarser levels span every submesh at once
+    std::vector<std::pair<UINT, UINT>> ranges;
+    for ( const Submesh& submesh : submeshes )
+    {
+        ranges.push_back( std::make_pair( submesh.IndexStart, submesh.IndexCount ) );
+    }
+    for ( size_t lod = 1; lod < lods.size(); ++lod )
+    {
+        ranges.push_back( std::make_pair( lods[ lod ].IndexStart, lods[ lod ].IndexCount ) );
+    }
+
+    std::vector<UINT> rangeIndices;
+    for ( auto& range : ranges )
+    {
+        auto begin = indices.begin() + range.first;
+        auto end = begin + range.second;
+        rangeIndices.assign( begin, end );
+
+        OptimizeVertexCache( rangeIndices, vertices.size() );
+        OptimizeOverdraw( rangeIndices, vertices );
+        std::copy( rangeIndices.begin(), rangeIndices.end(), begin );
+    }
+
+    // Vertices are shared by the whole mesh, so they're reordered all at once
+    OptimizeVertexFetch( vertices, indices );
+}
+
+// Reorders triangles for the post-transform vertex cache
+void MeshOptimizer::OptimizeVertexCache( std::vector<UINT>& indices, size_t vertexCount )
+{
+    const size_t triangleCount = indices.size() / 3;
+    if ( triangleCount == 0 )
+    {
+        return;
+    }
+
+    // Build the list of triangles that use each vertex
+    std::vector<unsigned int> remaining( vertexCount, 0 );
+    for ( UINT index : indices )
+    {
+        ++remaining[ index ];
+    }
+
+    std::vector<size_t> firstTriangle( vertexCount + 1, 0 );
+    for ( size_t vertex = 0; vertex < vertexCount; ++vertex )
+    {
+        firstTriangle[ vertex + 1 ] = firstTriangle[ vertex ] + remaining[ vertex ];
+    }
+
+    std::vector<size_t> adjacency( indices.size() );
+    std::vector<size_t> cursors( firstTriangle.begin(), firstTriangle.end() - 1 );
+    for ( size_t index = 0; index < indices.size(); ++index )
+    {
+        adjacency[ cursors[ indices[ index ] ]++ ] = index / 3;
+    }
+
+    // Score every vertex as if the cache were empty
+    std::vector<float> vertexScores( vertexCount );
+    for ( size_t vertex = 0; vertex < vertexCount; ++vertex )
+    {
+        vertexScores[ vertex ] = ScoreVertex( -1, remaining[ vertex ], ScoringCacheSize );
+    }
+
+    std::vector<bool> isEmitted( triangleCount, false );
+    std::vector<UINT> output;
+    std::vector<UINT> cache;
+    std::vector<UINT> newCache;
+    output.reserve( triangleCount * 3 );
+    cache.reserve( ScoringCacheSize + 3 );
+    newCache.reserve( ScoringCacheSize + 3 );
+
+    size_t bestTriangle = NoTriangle;
+    size_t nextUnemitted = 0;
+    for ( size_t emitted = 0; emitted < triangleCount; ++emitted )
+    {
+        // When nothing in the cache leads anywhere, carry on from the next triangle in the original order
+        if ( bestTriangle == NoTriangle )
+        {
+            while ( isEmitted[ nextUnemitted ] )
+            {
+                ++nextUnemitted;
+            }
+            bestTriangle = nextUnemitted;
+        }
+
+        // Emit the triangle and take it out of its vertices' triangle lists
+        isEmitted[ bestTriangle ] = true;
+        const UINT* corners = &indices[ bestTriangle * 3 ];
+        newCache.clear();
+        for ( int corner = 0; corner < 3; ++corner )
+        {
+            UINT vertex = corners[ corner ];
+            output.push_back( vertex );
+
+            size_t* begin = &adjacency[ firstTriangle[ vertex ] ];
+            size_t* end = begin + remaining[ vertex ];
+            *std::find( begin, end, bestTriangle ) = *( end - 1 );
+            --remaining[ vertex ];
+
+            if ( std::find( newCache.begin(), newCache.end(), vertex ) == newCache.end() )
+            {
+                newCache.push_back( vertex );
+            }
+        }
+
+        // The triangle's vertices move to the front of the cache and push everything else back
+        const size_t cornerCount = newCache.size();
+        for ( UINT vertex : cache )
+        {
+            if ( std::find( newCache.begin(), newCache.begin() + cornerCount, vertex ) == newCache.begin() + cornerCount )
+            {
+                newCache.push_back( vertex );
+            }
+        }
+
+        // Rescore everything that was in the cache, including the vertices that just fell out of it
+        for ( size_t position = 0; position < newCache.size(); ++position )
+        {
+            UINT vertex = newCache[ position ];
+            int cachePosition = ( position < ScoringCacheSize ) ? static_cast<int>( position ) : -1;
+            vertexScores[ vertex ] = ScoreVertex( cachePosition, remaining[ vertex ], ScoringCacheSize );
+        }
+        if ( newCache.size() > ScoringCacheSize )
+        {
+            newCache.resize( ScoringCacheSize );
+        }
+
+        // The next triangle is the best scoring one that uses a cached vertex
+        bestTriangle = NoTriangle;
+        float bestScore = -1.0f;
+        for ( UINT vertex : newCache )
+        {
+            for ( size_t adjacent = firstTriangle[ vertex ]; adjacent < firstTriangle[ vertex ] + remaining[ vertex ]; ++adjacent )
+            {
+                const size_t triangle = adjacency[ adjacent ];
+                const UINT* triangleCorners = &indices[ triangle * 3 ];
+                float score = vertexScores[ triangleCorners[ 0 ] ] + vertexScores[ triangleCorners[ 1 ] ] + vertexScores[ triangleCorners[ 2 ] ];
+                if ( score > bestScore )
+                {
+                    bestScore = score;
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        cache.swap( newCache );
+    }
+
+    indices.swap( output );
+}
+
+// Reorders clusters of triangles to reduce overdraw
+void MeshOptimizer::OptimizeOverdraw( std::vector<UINT>& indices, const std::vector<Vertex>& vertices )
+{
+    const size_t triangleCount = indices.size() / 3;
+    if ( triangleCount < 2 )
+    {
+        return;
+    }
+
+    // Split the triangles into clusters wherever the cache optimizer had to start over with all new
+    // vertices; moving those clusters around costs next to nothing in cache misses
+    std::vector<size_t> clusterStarts;
+    std::vector<size_t> insertTimes( vertices.size(), 0 );
+    size_t misses = 0;
+    for ( size_t triangle = 0; triangle < triangleCount; ++triangle )
+    {
+        unsigned int triangleMisses = 0;
+        for ( size_t corner = 0; corner < 3; ++corner )
+        {
+            if ( TouchVertex( insertTimes, misses, indices[ triangle * 3 + corner ], SimulatedCacheSize ) )
+            {
+                ++triangleMisses;
+            }
+        }
+        if ( triangle == 0 || triangleMisses == 3 )
+        {
+            clusterStarts.push_back( triangle );
+        }
+    }
+    if ( clusterStarts.size() < 2 )
+    {
+        return;
+    }
+    clusterStarts.push_back( triangleCount );
+
+    // Find the middle of the mesh
+    XMVECTOR meshCenter = XMVectorZero();
+    for ( const Vertex& vertex : vertices )
+    {
+        meshCenter = XMVectorAdd( meshCenter, XMLoadFloat3( &vertex.Position ) );
+    }
+    meshCenter = XMVectorScale( meshCenter, 1.0f / static_cast<float>( std::max( vertices.size(), static_cast<size_t>( 1 ) ) ) );
+
+    // Clusters that face away from the middle of the mesh are the most likely to occlude the rest
+    const size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<float> sortKeys( clusterCount );
+    for ( size_t cluster = 0; cluster < clusterCount; ++cluster )
+    {
+        XMVECTOR center = XMVectorZero();
+        XMVECTOR normal = XMVectorZero();
+        float area = 0.0f;
+        for ( size_t triangle = clusterStarts[ cluster ]; triangle < clusterStarts[ cluster + 1 ]; ++triangle )
+        {
+            XMVECTOR a = XMLoadFloat3( &vertices[ indices[ triangle * 3 + 0 ] ].Position );
+            XMVECTOR b = XMLoadFloat3( &vertices[ indices[ triangle * 3 + 1 ] ].Position );
+            XMVECTOR c = XMLoadFloat3( &vertices[ indices[ triangle * 3 + 2 ] ].Position );
+
+            // The cross product's length is twice the triangle's area, so it weights everything for us
+            XMVECTOR cross = XMVector3Cross( XMVectorSubtract( b, a ), XMVectorSubtract( c, a ) );
+            float triangleArea = XMVectorGetX( XMVector3Length( cross ) );
+            XMVECTOR triangleCenter = XMVectorScale( XMVectorAdd( XMVectorAdd( a, b ), c ), 1.0f / 3.0f );
+
+            center = XMVectorAdd( center, XMVectorScale( triangleCenter, triangleArea ) );
+            normal = XMVectorAdd( normal, cross );
+            area += triangleArea;
+        }
+
+        if ( area > 0.0f )
+        {
+            center = XMVectorScale( center, 1.0f / area );
+        }
+        XMVECTOR outward = XMVectorSubtract( center, meshCenter );
+        sortKeys[ cluster ] = XMVectorGetX( XMVector3Dot( outward, XMVector3Normalize( normal ) ) );
+    }
+
+    std::vector<size_t> order( clusterCount );
+    for ( size_t cluster = 0; cluster < clusterCount; ++cluster )
+    {
+        order[ cluster ] = cluster;
+    }
+    std::stable_sort( order.begin(), order.end(), [ &sortKeys ]( size_t left, size_t right )
+    {
+        return sortKeys[ left ] > sortKeys[ right ];
+    } );
+
+    std::vector<UINT> sorted;
+    sorted.reserve( indices.size() );
+    for ( size_t cluster : order )
+    {
+        sorted.insert( sorted.end(), indices.begin() + clusterStarts[ cluster ] * 3, indices.begin() + clusterStarts[ cluster + 1 ] * 3 );
+    }
+
+    // Keep the new order only if it didn't cost too much in cache misses
+    if ( CalculateAcmr( sorted, vertices.size() ) <= CalculateAcmr( indices, vertices.size() ) * OverdrawThreshold )
+    {
+        indices.swap( sorted );
+    }
+}
+
+// Reorders vertices for fetch locality
+void MeshOptimizer::OptimizeVertexFetch( std::vector<Vertex>& vertices, std::vector<UINT>& indices )
+{
+    std::vector<UINT> remap( vertices.size(), NoVertex );
+    std::vector<Vertex> fetched;
+    fetched.reserve( vertices.size() );
+
+    for ( UINT& index : indices )
+    {
+        if ( remap[ index ] == NoVertex )
+        {
+            remap[ index ] = static_cast<UINT>( fetched.size() );
+            fetched.push_back( vertices[ index ] );
+        }
+        index = remap[ index ];
+    }
+
+    vertices.swap( fetched );
+}
+
+// Reports the ACMR of every model in a directory
+void MeshOptimizer::ReportDirectory( const std::string& directory )
+{
+    std::ostringstream report;
+    report << "Mesh optimization (ACMR with a " << SimulatedCacheSize << " vertex FIFO cache):" << std::endl
+           << std::fixed << std::setprecision( 3 );
+
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA( ( directory + "\\*" ).c_str(), &findData );
+    if ( find != INVALID_HANDLE_VALUE )
+    {
+        do
+        {
+            if ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+            {
+                continue;
+            }
+
+            std::vector<Vertex> vertices;
+            std::vector<UINT> indices;
+            std::vector<Submesh> submeshes;
+            if ( !MeshLoader::Import( directory + "\\" + findData.cFileName, vertices, indices, submeshes ) )
+            {
+                continue;
+            }
+
+            float before = CalculateAcmr( indices, vertices.size() );
+            Optimize( vertices, indices, submeshes, std::vector<MeshLod>() );
+            float after = CalculateAcmr( indices, vertices.size() );
+
+            report << "  " << findData.cFileName << ": " << ( indices.size() / 3 ) << " triangles, "
+                   << vertices.size() << " vertices, ACMR " << before << " -> " << after << std::endl;
+        }
+        while ( FindNextFileA( find, &findData ) );
+
+        FindClose( find );
+    }
+
+#if defined( _DEBUG ) || defined( DEBUG )
+    std::cout << report.str();
+#endif
+    OutputDebugStringA( report.str().c_str() );
+    MessageBoxA( nullptr, report.str().c_str(), "Mesh Optimization", MB_OK );
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Mesh.hpp"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines the static mesh optimizer. Imported meshes come out in whatever order the modelling
+/// package wrote them, so their triangles are reordered for the post-transform vertex cache and
+/// for less overdraw, and their vertices are reordered to be fetched in order.
+/// </summary>
+class MeshOptimizer
+{
+    ImplementStaticClass( MeshOptimizer );
+
+    static const unsigned int SimulatedCacheSize;
+    static const unsigned int ScoringCacheSize;
+    static const float OverdrawThreshold;
+
+public:
+    /// <summary>
+    /// Gets the average number of vertices transformed per triangle, using a simulated FIFO vertex cache.
+    /// </summary>
+    /// <param name="indices">The triangle list indices.</param>
+    /// <param name="vertexCount">The number of vertices the indices refer to.</param>
+    static float CalculateAcmr( const std::vector<UINT>& indices, size_t vertexCount );
+
+    /// <summary>
+    /// Runs every optimization on a mesh: vertex cache, then overdraw, then vertex fetch. Triangles
+    /// are only reordered within their own submesh or level of detail, so both tables stay valid.
+    /// </summary>
+    /// <param name="vertices">The vertices.</param>
+    /// <param name="indices">The triangle list indices.</param>
+    /// <param name="submeshes">The submesh table, which covers the full detail mesh.</param>
+    /// <param name="lods">The level of detail table. Every level after the first is optimized as a whole.</param>
+    static void Optimize( std::vector<Vertex>& vertices, std::vector<UINT>& indices, const std::vector<Submesh>& submeshes, const std::vector<MeshLod>& lods );
+
+    /// <summary>
+    /// Reorders triangles so that neighbouring triangles share vertices while they're still in the
+    /// post-transform cache, using Tom Forsyth's linear-speed vertex cache optimization.
+    /// </summary>
+    /// <param name="indices">The triangle list indices.</param>
+    /// <param name="vertexCount">The number of vertices the indices refer to.</param>
+    static void OptimizeVertexCache( std::vector<UINT>& indices, size_t vertexCount );
+
+    /// <summary>
+    /// Reorders clusters of cache-optimized triangles so that the ones facing out from the middle
+    /// of the mesh are drawn first, so long as the vertex cache doesn't suffer too much for it.
+    /// </summary>
+    /// <param name="indices">The triangle list indices, already optimized for the vertex cache.</param>
+    /// <param name="vertices">The vertices.</param>
+    static void OptimizeOverdraw( std::vector<UINT>& indices, const std::vector<Vertex>& vertices );
+
+    /// <summary>
+    /// Reorders vertices into the order the indices first use them, and drops unused vertices.
+    /// </summary>
+    /// <param name="vertices">The vertices.</param>
+    /// <param name="indices">The triangle list indices.</param>
+    static void OptimizeVertexFetch( std::vector<Vertex>& vertices, std::vector<UINT>& indices );
+
+    /// <summary>
+    /// Reports the ACMR of every model in the given directory before and after optimization.
+    /// </summary>
+    /// <param name="directory">The directory.</param>
+    static void ReportDirectory( const std::string& directory );
+};
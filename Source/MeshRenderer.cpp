@@ -9,6 +9,8 @@ MeshRenderer::MeshRenderer( GameObject* gameObj )
     : Component( gameObj )
     , _mesh( nullptr )
     , _material( nullptr )
+    , _lodIndex( 0 )
+    , _isOccluder( false )
 {
     RenderManager::AddMeshRenderer( this );
 }
@@ -25,6 +27,7 @@ MeshRenderer::~MeshRenderer()
 void MeshRenderer::SetMesh( std::shared_ptr<Mesh> nMesh )
 {
     _mesh = nMesh;
+    _lodIndex = 0;
 }
 
 // Sets our material
@@ -45,6 +48,30 @@ Material* MeshRenderer::GetMaterial()
     return _material;
 }
 
+// Gets our level of detail
+size_t MeshRenderer::GetLodIndex() const
+{
+    return _lodIndex;
+}
+
+// Checks if we're an occluder
+bool MeshRenderer::IsOccluder() const
+{
+    return _isOccluder;
+}
+
+// Sets whether we're an occluder
+void MeshRenderer::SetOccluder( bool isOccluder )
+{
+    _isOccluder = isOccluder;
+}
+
+// Sets our level of detail
+void MeshRenderer::SetLodIndex( size_t lodIndex )
+{
+    _lodIndex = lodIndex;
+}
+
 // Updates this mesh renderer
 void MeshRenderer::Update()
 {
@@ -14,6 +14,8 @@ class MeshRenderer : public Component
 {
     std::shared_ptr<Mesh> _mesh;
     Material* _material;
+    size_t _lodIndex;
+    bool _isOccluder;
 
 public:
     /// <summary>
@@ -55,6 +57,29 @@ public:
     /// </summary>
     Material* GetMaterial();
 
+    /// <summary>
+    /// Returns the level of detail this renderer last drew its mesh with.
+    /// </summary>
+    size_t GetLodIndex() const;
+
+    /// <summary>
+    /// Checks whether this renderer's mesh hides the objects behind it from the occlusion culler.
+    /// </summary>
+    bool IsOccluder() const;
+
+    /// <summary>
+    /// Sets whether this renderer's mesh hides the objects behind it from the occlusion culler.
+    /// Occluders are always drawn, so only large, solid meshes are worth marking.
+    /// </summary>
+    /// <param name="isOccluder">True to occlude, false not to.</param>
+    void SetOccluder( bool isOccluder );
+
+    /// <summary>
+    /// Sets the level of detail to draw the mesh with.
+    /// </summary>
+    /// <param name="lodIndex">The level of detail.</param>
+    void SetLodIndex( size_t lodIndex );
+
     /// <summary>
     /// Updates the renderer.
     /// </summary>
@@ -0,0 +1,458 @@
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <tuple>
+#include <unordered_map>
+
+using namespace DirectX;
+
+const size_t MeshSimplifier::MaxLodCount       = 5;
+const size_t MeshSimplifier::MinLodTriangles   = 64;
+const float  MeshSimplifier::LodReduction      = 0.5f;
+const float  MeshSimplifier::MinLodImprovement = 0.8f;
+
+static const float  MinFlipCosine = 0.25f;
+static const double BorderWeight  = 10.0;
+static const UINT   NoVertex      = static_cast<UINT>( -1 );
+
+/// <summary>
+/// Defines a symmetric 4x4 error quadric, plus the total area of the planes summed into it.
+/// </summary>
+struct Quadric
+{
+    double XX, XY, XZ, XW;
+    double YY, YZ, YW;
+    double ZZ, ZW;
+    double WW;
+    double Area;
+};
+
+/// <summary>
+/// Defines a candidate edge collapse, which moves every vertex at one position onto another position.
+/// </summary>
+struct Collapse
+{
+    UINT From;
+    UINT To;
+    double Cost;
+};
+
+// Adds one quadric to another
+static void AddQuadric( Quadric& quadric, const Quadric& other )
+{
+    quadric.XX += other.XX; quadric.XY += other.XY; quadric.XZ += other.XZ; quadric.XW += other.XW;
+    quadric.YY += other.YY; quadric.YZ += other.YZ; quadric.YW += other.YW;
+    quadric.ZZ += other.ZZ; quadric.ZW += other.ZW;
+    quadric.WW += other.WW;
+    quadric.Area += other.Area;
+}
+
+// Gets the area weighted sum of squared distances from a point to a quadric's planes
+static double EvaluateQuadric( const Quadric& quadric, const XMFLOAT3& point )
+{
+    const double x = point.x;
+    const double y = point.y;
+    const double z = point.z;
+    return quadric.XX * x * x + 2.0 * quadric.XY * x * y + 2.0 * quadric.XZ * x * z + 2.0 * quadric.XW * x
+         + quadric.YY * y * y + 2.0 * quadric.YZ * y * z + 2.0 * quadric.YW * y
+         + quadric.ZZ * z * z + 2.0 * quadric.ZW * z
+         + quadric.WW;
+}
+
+// Gets the quadric of a triangle's plane, weighted by the triangle's area
+static Quadric GetTriangleQuadric( const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c )
+{
+    Quadric quadric;
+    ZeroMemory( &quadric, sizeof( Quadric ) );
+
+    XMVECTOR pointA = XMLoadFloat3( &a );
+    XMVECTOR cross = XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &b ), pointA ), XMVectorSubtract( XMLoadFloat3( &c ), pointA ) );
+    float length = XMVectorGetX( XMVector3Length( cross ) );
+    if ( length <= 0.0f )
+    {
+        return quadric;
+    }
+
+    XMFLOAT3 normal;
+    XMStoreFloat3( &normal, XMVectorScale( cross, 1.0f / length ) );
+    const double nx = normal.x;
+    const double ny = normal.y;
+    const double nz = normal.z;
+    const double d = -( nx * a.x + ny * a.y + nz * a.z );
+    const double area = length * 0.5;
+
+    quadric.XX = area * nx * nx; quadric.XY = area * nx * ny; quadric.XZ = area * nx * nz; quadric.XW = area * nx * d;
+    quadric.YY = area * ny * ny; quadric.YZ = area * ny * nz; quadric.YW = area * ny * d;
+    quadric.ZZ = area * nz * nz; quadric.ZW = area * nz * d;
+    quadric.WW = area * d * d;
+    quadric.Area = area;
+    return quadric;
+}
+
+// Gets the quadric of the plane that stands up along a border edge, so the border keeps its shape
+static Quadric GetBorderQuadric( const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c )
+{
+    Quadric quadric;
+    ZeroMemory( &quadric, sizeof( Quadric ) );
+
+    XMVECTOR pointA = XMLoadFloat3( &a );
+    XMVECTOR edge = XMVectorSubtract( XMLoadFloat3( &b ), pointA );
+    XMVECTOR faceNormal = XMVector3Cross( edge, XMVectorSubtract( XMLoadFloat3( &c ), pointA ) );
+    XMVECTOR planeNormal = XMVector3Cross( edge, faceNormal );
+    float length = XMVectorGetX( XMVector3Length( planeNormal ) );
+    if ( length <= 0.0f )
+    {
+        return quadric;
+    }
+
+    XMFLOAT3 normal;
+    XMStoreFloat3( &normal, XMVectorScale( planeNormal, 1.0f / length ) );
+    const double nx = normal.x;
+    const double ny = normal.y;
+    const double nz = normal.z;
+    const double d = -( nx * a.x + ny * a.y + nz * a.z );
+    const double weight = XMVectorGetX( XMVector3LengthSq( edge ) ) * BorderWeight;
+
+    quadric.XX = weight * nx * nx; quadric.XY = weight * nx * ny; quadric.XZ = weight * nx * nz; quadric.XW = weight * nx * d;
+    quadric.YY = weight * ny * ny; quadric.YZ = weight * ny * nz; quadric.YW = weight * ny * d;
+    quadric.ZZ = weight * nz * nz; quadric.ZW = weight * nz * d;
+    quadric.WW = weight * d * d;
+    return quadric;
+}
+
+// Gets a triangle's unnormalized normal
+static XMVECTOR GetTriangleNormal( const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c )
+{
+    XMVECTOR pointA = XMLoadFloat3( &a );
+    return XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &b ), pointA ), XMVectorSubtract( XMLoadFloat3( &c ), pointA ) );
+}
+
+// Gets the key of the undirected edge between two vertices
+static UINT64 GetEdgeKey( UINT a, UINT b )
+{
+    return ( static_cast<UINT64>( std::min( a, b ) ) << 32 ) | std::max( a, b );
+}
+
+// Counts how many triangles use each edge, with vertices welded by position
+static void CountEdgeUses( const std::vector<UINT>& indices, const std::vector<UINT>& welded, std::unordered_map<UINT64, unsigned int>& edgeUses )
+{
+    // Double sided meshes repeat every triangle facing the other way, so only count each one once
+    std::vector<std::tuple<UINT, UINT, UINT>> triangles;
+    triangles.reserve( indices.size() / 3 );
+    for ( size_t index = 0; index < indices.size(); index += 3 )
+    {
+        UINT corners[ 3 ] = { welded[ indices[ index + 0 ] ], welded[ indices[ index + 1 ] ], welded[ indices[ index + 2 ] ] };
+        std::sort( corners, corners + 3 );
+        triangles.push_back( std::make_tuple( corners[ 0 ], corners[ 1 ], corners[ 2 ] ) );
+    }
+    std::sort( triangles.begin(), triangles.end() );
+    triangles.erase( std::unique( triangles.begin(), triangles.end() ), triangles.end() );
+
+    edgeUses.clear();
+    for ( auto& triangle : triangles )
+    {
+        ++edgeUses[ GetEdgeKey( std::get<0>( triangle ), std::get<1>( triangle ) ) ];
+        ++edgeUses[ GetEdgeKey( std::get<1>( triangle ), std::get<2>( triangle ) ) ];
+        ++edgeUses[ GetEdgeKey( std::get<2>( triangle ), std::get<0>( triangle ) ) ];
+    }
+}
+
+// Builds a chain of simplified levels of detail
+void MeshSimplifier::GenerateLods( const std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<MeshLod>& lods )
+{
+    const size_t fullIndexCount = indices.size();
+
+    lods.clear();
+    MeshLod fullDetail = { 0, static_cast<UINT>( fullIndexCount ), 0.0f };
+    lods.push_back( fullDetail );
+
+    // Every level is simplified from the full detail mesh, so its error is measured against the original surface
+    const std::vector<UINT> original( indices.begin(), indices.end() );
+    std::vector<UINT> simplified;
+    size_t targetIndexCount = fullIndexCount;
+    while ( lods.size() < MaxLodCount )
+    {
+        targetIndexCount = static_cast<size_t>( targetIndexCount / 3 * LodReduction ) * 3;
+        if ( targetIndexCount / 3 < MinLodTriangles )
+        {
+            break;
+        }
+
+        float error = Simplify( vertices, original, targetIndexCount, simplified );
+
+        // Stop once the seams and borders won't let the mesh get much simpler than the last level
+        if ( simplified.size() > lods.back().IndexCount * MinLodImprovement )
+        {
+            break;
+        }
+
+        MeshLod lod = { static_cast<UINT>( indices.size() ), static_cast<UINT>( simplified.size() ), error };
+        lods.push_back( lod );
+        indices.insert( indices.end(), simplified.begin(), simplified.end() );
+        targetIndexCount = simplified.size();
+    }
+}
+
+// Simplifies a mesh by collapsing its cheapest edges
+float MeshSimplifier::Simplify( const std::vector<Vertex>& vertices, const std::vector<UINT>& indices, size_t targetIndexCount, std::vector<UINT>& simplified )
+{
+    simplified.assign( indices.begin(), indices.end() );
+    const size_t vertexCount = vertices.size();
+
+    // Vertices on texture and normal seams share their position with other vertices; collapses work on
+    // positions, and every vertex at a position follows along so that seams never open up
+    std::map<std::tuple<float, float, float>, UINT> positions;
+    std::vector<UINT> welded( vertexCount );
+    std::vector<UINT> nextWedge( vertexCount );
+    for ( size_t vertex = 0; vertex < vertexCount; ++vertex )
+    {
+        const XMFLOAT3& position = vertices[ vertex ].Position;
+        auto search = positions.insert( std::make_pair( std::make_tuple( position.x, position.y, position.z ), static_cast<UINT>( vertex ) ) );
+        UINT first = search.first->second;
+        welded[ vertex ] = first;
+
+        // Each position's vertices form a ring, so any one of them leads to the rest
+        if ( first == vertex )
+        {
+            nextWedge[ vertex ] = first;
+        }
+        else
+        {
+            nextWedge[ vertex ] = nextWedge[ first ];
+            nextWedge[ first ] = static_cast<UINT>( vertex );
+        }
+    }
+
+    // Each position starts out with the planes of the triangles around it, plus the planes along any border it is on
+    std::unordered_map<UINT64, unsigned int> edgeUses;
+    CountEdgeUses( simplified, welded, edgeUses );
+    std::vector<Quadric> quadrics( vertexCount );
+    if ( vertexCount > 0 )
+    {
+        ZeroMemory( &quadrics[ 0 ], sizeof( Quadric ) * vertexCount );
+    }
+    for ( size_t index = 0; index < simplified.size(); index += 3 )
+    {
+        const UINT* corners = &simplified[ index ];
+        Quadric quadric = GetTriangleQuadric( vertices[ corners[ 0 ] ].Position, vertices[ corners[ 1 ] ].Position, vertices[ corners[ 2 ] ].Position );
+        for ( size_t corner = 0; corner < 3; ++corner )
+        {
+            UINT a = corners[ corner ];
+            UINT b = corners[ ( corner + 1 ) % 3 ];
+            UINT c = corners[ ( corner + 2 ) % 3 ];
+            AddQuadric( quadrics[ welded[ a ] ], quadric );
+
+            if ( edgeUses[ GetEdgeKey( welded[ a ], welded[ b ] ) ] == 1 )
+            {
+                Quadric border = GetBorderQuadric( vertices[ a ].Position, vertices[ b ].Position, vertices[ c ].Position );
+                AddQuadric( quadrics[ welded[ a ] ], border );
+                AddQuadric( quadrics[ welded[ b ] ], border );
+            }
+        }
+    }
+
+    // Collapse edges in passes, cheapest first, never touching the same neighbourhood twice in one pass
+    double maxError = 0.0;
+    std::vector<unsigned int> triangleCounts( vertexCount );
+    std::vector<size_t> firstTriangle( vertexCount + 1, 0 );
+    std::vector<size_t> adjacency;
+    std::vector<size_t> cursors;
+    std::vector<Collapse> collapses;
+    std::vector<UINT> remap( vertexCount );
+    std::vector<UINT> targets;
+    std::vector<bool> isBorder( vertexCount );
+    std::vector<bool> isTouched( vertexCount );
+    while ( simplified.size() > targetIndexCount )
+    {
+        // Build the list of triangles around each vertex
+        std::fill( triangleCounts.begin(), triangleCounts.end(), 0 );
+        for ( UINT index : simplified )
+        {
+            ++triangleCounts[ index ];
+        }
+        for ( size_t vertex = 0; vertex < vertexCount; ++vertex )
+        {
+            firstTriangle[ vertex + 1 ] = firstTriangle[ vertex ] + triangleCounts[ vertex ];
+        }
+        adjacency.resize( simplified.size() );
+        cursors.assign( firstTriangle.begin(), firstTriangle.end() - 1 );
+        for ( size_t index = 0; index < simplified.size(); ++index )
+        {
+            adjacency[ cursors[ simplified[ index ] ]++ ] = index / 3;
+        }
+
+        // Border positions may only slide along the border, so find where it is now
+        CountEdgeUses( simplified, welded, edgeUses );
+        std::fill( isBorder.begin(), isBorder.end(), false );
+        for ( auto& edge : edgeUses )
+        {
+            if ( edge.second == 1 )
+            {
+                isBorder[ static_cast<UINT>( edge.first >> 32 ) ] = true;
+                isBorder[ static_cast<UINT>( edge.first & 0xFFFFFFFF ) ] = true;
+            }
+        }
+
+        // Cost both directions of every edge; the surviving position keeps its own vertices' attributes
+        collapses.clear();
+        for ( size_t index = 0; index < simplified.size(); index += 3 )
+        {
+            for ( size_t corner = 0; corner < 3; ++corner )
+            {
+                UINT from = welded[ simplified[ index + corner ] ];
+                UINT to = welded[ simplified[ index + ( corner + 1 ) % 3 ] ];
+                for ( int direction = 0; direction < 2; ++direction )
+                {
+                    if ( !isBorder[ from ] || edgeUses[ GetEdgeKey( from, to ) ] == 1 )
+                    {
+                        Quadric quadric = quadrics[ from ];
+                        AddQuadric( quadric, quadrics[ to ] );
+                        Collapse collapse = { from, to, EvaluateQuadric( quadric, vertices[ to ].Position ) };
+                        collapses.push_back( collapse );
+                    }
+                    std::swap( from, to );
+                }
+            }
+        }
+        std::sort( collapses.begin(), collapses.end(), []( const Collapse& left, const Collapse& right )
+        {
+            return left.Cost < right.Cost;
+        } );
+
+        const size_t wantedTriangles = ( simplified.size() - targetIndexCount ) / 3;
+        size_t removedTriangles = 0;
+        size_t collapseCount = 0;
+        for ( size_t vertex = 0; vertex < vertexCount; ++vertex )
+        {
+            remap[ vertex ] = static_cast<UINT>( vertex );
+        }
+        std::fill( isTouched.begin(), isTouched.end(), false );
+
+        for ( const Collapse& collapse : collapses )
+        {
+            if ( isTouched[ collapse.From ] || isTouched[ collapse.To ] )
+            {
+                continue;
+            }
+
+            // Every vertex at the collapsing position has to move onto the one vertex at the target position
+            // it shares triangles with; if it touches none or several, its attributes would come out wrong
+            bool isValid = true;
+            size_t squashedTriangles = 0;
+            targets.clear();
+            UINT wedge = collapse.From;
+            do
+            {
+                UINT target = NoVertex;
+                for ( size_t adjacent = firstTriangle[ wedge ]; adjacent < firstTriangle[ wedge + 1 ] && isValid; ++adjacent )
+                {
+                    const UINT* corners = &simplified[ adjacency[ adjacent ] * 3 ];
+                    for ( size_t corner = 0; corner < 3; ++corner )
+                    {
+                        if ( welded[ corners[ corner ] ] == collapse.To )
+                        {
+                            isValid = ( target == NoVertex || target == corners[ corner ] );
+                            target = corners[ corner ];
+                            ++squashedTriangles;
+                        }
+                    }
+                }
+                isValid = isValid && ( target != NoVertex || firstTriangle[ wedge ] == firstTriangle[ wedge + 1 ] );
+                targets.push_back( target );
+                wedge = nextWedge[ wedge ];
+            }
+            while ( isValid && wedge != collapse.From );
+
+            // Don't let any triangle that survives the collapse turn over
+            const XMFLOAT3& destination = vertices[ collapse.To ].Position;
+            wedge = collapse.From;
+            do
+            {
+                for ( size_t adjacent = firstTriangle[ wedge ]; adjacent < firstTriangle[ wedge + 1 ] && isValid; ++adjacent )
+                {
+                    const UINT* corners = &simplified[ adjacency[ adjacent ] * 3 ];
+                    UINT a = welded[ corners[ 0 ] ];
+                    UINT b = welded[ corners[ 1 ] ];
+                    UINT c = welded[ corners[ 2 ] ];
+                    if ( a == collapse.To || b == collapse.To || c == collapse.To )
+                    {
+                        continue;
+                    }
+
+                    XMVECTOR before = GetTriangleNormal( vertices[ a ].Position, vertices[ b ].Position, vertices[ c ].Position );
+                    XMVECTOR after = GetTriangleNormal( ( a == collapse.From ) ? destination : vertices[ a ].Position,
+                                                        ( b == collapse.From ) ? destination : vertices[ b ].Position,
+                                                        ( c == collapse.From ) ? destination : vertices[ c ].Position );
+                    float lengths = XMVectorGetX( XMVector3Length( before ) ) * XMVectorGetX( XMVector3Length( after ) );
+                    isValid = XMVectorGetX( XMVector3Dot( before, after ) ) > MinFlipCosine * lengths;
+                }
+                wedge = nextWedge[ wedge ];
+            }
+            while ( isValid && wedge != collapse.From );
+
+            if ( !isValid )
+            {
+                continue;
+            }
+
+            // Everything around the collapsed position has changed, so leave it alone until the next pass
+            size_t targetIndex = 0;
+            wedge = collapse.From;
+            do
+            {
+                if ( targets[ targetIndex ] != NoVertex )
+                {
+                    remap[ wedge ] = targets[ targetIndex ];
+                }
+                ++targetIndex;
+
+                for ( size_t adjacent = firstTriangle[ wedge ]; adjacent < firstTriangle[ wedge + 1 ]; ++adjacent )
+                {
+                    const UINT* corners = &simplified[ adjacency[ adjacent ] * 3 ];
+                    isTouched[ welded[ corners[ 0 ] ] ] = true;
+                    isTouched[ welded[ corners[ 1 ] ] ] = true;
+                    isTouched[ welded[ corners[ 2 ] ] ] = true;
+                }
+                wedge = nextWedge[ wedge ];
+            }
+            while ( wedge != collapse.From );
+
+            AddQuadric( quadrics[ collapse.To ], quadrics[ collapse.From ] );
+            if ( quadrics[ collapse.To ].Area > 0.0 )
+            {
+                maxError = std::max( maxError, collapse.Cost / quadrics[ collapse.To ].Area );
+            }
+
+            ++collapseCount;
+            removedTriangles += squashedTriangles;
+            if ( removedTriangles >= wantedTriangles )
+            {
+                break;
+            }
+        }
+        if ( collapseCount == 0 )
+        {
+            break;
+        }
+
+        // Move the collapsed vertices and drop the triangles that were squashed flat
+        size_t writeIndex = 0;
+        for ( size_t index = 0; index < simplified.size(); index += 3 )
+        {
+            UINT a = remap[ simplified[ index + 0 ] ];
+            UINT b = remap[ simplified[ index + 1 ] ];
+            UINT c = remap[ simplified[ index + 2 ] ];
+            if ( welded[ a ] != welded[ b ] && welded[ b ] != welded[ c ] && welded[ c ] != welded[ a ] )
+            {
+                simplified[ writeIndex++ ] = a;
+                simplified[ writeIndex++ ] = b;
+                simplified[ writeIndex++ ] = c;
+            }
+        }
+        simplified.resize( writeIndex );
+    }
+
+    // The quadrics are area weighted, so dividing by the area leaves the mean squared distance to the planes
+    return static_cast<float>( sqrt( maxError ) );
+}
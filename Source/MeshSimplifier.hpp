@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Mesh.hpp"
+#include <vector>
+
+/// <summary>
+/// Defines the static mesh simplifier. Meshes are simplified by collapsing edges in order of their
+/// quadric error, so that each mesh can carry a chain of coarser levels of detail for when it is
+/// drawn small on screen. Borders and texture seams are only ever shortened along their own
+/// length, so simplified meshes don't open up cracks.
+/// </summary>
+class MeshSimplifier
+{
+    ImplementStaticClass( MeshSimplifier );
+
+    static const size_t MaxLodCount;
+    static const size_t MinLodTriangles;
+    static const float LodReduction;
+    static const float MinLodImprovement;
+
+public:
+    /// <summary>
+    /// Appends a chain of progressively simplified copies of a mesh's indices after its own. The
+    /// vertices are shared by every level of detail, so only the indices grow.
+    /// </summary>
+    /// <param name="vertices">The vertices.</param>
+    /// <param name="indices">The full detail triangle list indices, which receive each coarser level of detail after them.</param>
+    /// <param name="lods">Receives the range of indices and the error of each level of detail, starting with the full detail mesh.</param>
+    static void GenerateLods( const std::vector<Vertex>& vertices, std::vector<UINT>& indices, std::vector<MeshLod>& lods );
+
+    /// <summary>
+    /// Simplifies a mesh down to roughly the given number of indices, or as close as it can get
+    /// without pulling borders and seams out of shape or flipping triangles.
+    /// </summary>
+    /// <param name="vertices">The vertices.</param>
+    /// <param name="indices">The triangle list indices.</param>
+    /// <param name="targetIndexCount">The number of indices to aim for.</param>
+    /// <param name="simplified">Receives the simplified triangle list indices.</param>
+    /// <returns>An estimate of how far, in object space, the simplified surface strays from the original.</returns>
+    static float Simplify( const std::vector<Vertex>& vertices, const std::vector<UINT>& indices, size_t targetIndexCount, std::vector<UINT>& simplified );
+};
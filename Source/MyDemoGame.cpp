@@ -22,11 +22,19 @@
 // ----------------------------------------------------------------------------
 
 #include "MyDemoGame.hpp"
+#include "CommandLine.hpp"
 #include "Input.hpp"
 #include "Time.hpp"
 #include "Vertex.hpp"
 #include "MeshLoader.hpp"
+#include "MeshOptimizer.hpp"
+#include "OcclusionCuller.hpp"
+#include "ParticleSimulator.hpp"
+#include "Physics.hpp"
 #include "RenderManager.hpp"
+#include "ResourceManager.hpp"
+#include "TextureCompressor.hpp"
+#include "ThreadPool.hpp"
 #include "GameObject.hpp"
 #include "Components.hpp"
 
@@ -60,6 +68,42 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, i
         _CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
     #endif
 
+    // Run the particle benchmark instead of the game if asked to
+    CommandLine::Initialize( cmdLine );
+    if ( CommandLine::HasFlag( "-benchmark-particles" ) )
+    {
+        ThreadPool::Initialize();
+        ParticleSimulator::RunBenchmark( 1000000, 300 );
+        ThreadPool::Shutdown();
+        return 0;
+    }
+
+    // Cook the textures instead of running the game if asked to
+    if ( CommandLine::HasFlag( "-cook-textures" ) )
+    {
+        ThreadPool::Initialize();
+        unsigned int cooked = TextureCompressor::CookDirectory( "Textures" );
+        ThreadPool::Shutdown();
+
+        std::ostringstream report;
+        report << "Cooked " << cooked << " texture(s)." << std::endl;
+        OutputDebugStringA( report.str().c_str() );
+        return 0;
+    }
+
+    // Report how well the mesh optimizer does on every model instead of running the game if asked to
+    if ( CommandLine::HasFlag( "-report-meshes" ) )
+    {
+        MeshOptimizer::ReportDirectory( "Models" );
+        return 0;
+    }
+
+    // Keep meshes in the full 44-byte vertex format if asked to, for comparing against compact vertices
+    if ( CommandLine::HasFlag( "-full-vertices" ) )
+    {
+        MeshLoader::SetVertexFormat( VertexFormat::Standard );
+    }
+
     // Create the game object.
     MyDemoGame* game = MyDemoGame::CreateInstance( hInstance );
 
@@ -168,6 +212,28 @@ void MyDemoGame::UpdateScene()
         Quit();
         return;
     }
+
+    // Toggle drawing the physics world
+    if ( Input::WasKeyPressed( Key::F1 ) )
+    {
+        Physics::SetDebugDrawEnabled( !Physics::IsDebugDrawEnabled() );
+    }
+
+    // Report what's loaded and how much memory it uses
+    if ( Input::WasKeyPressed( Key::F2 ) )
+    {
+        std::string report = ResourceManager::GetReport();
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << report;
+#endif
+        OutputDebugStringA( report.c_str() );
+    }
+
+    // Toggle occlusion culling, to compare against drawing everything
+    if ( Input::WasKeyPressed( Key::F3 ) )
+    {
+        OcclusionCuller::SetEnabled( !OcclusionCuller::IsEnabled() );
+    }
     
     Scene::GetInstance()->Update();
 }
@@ -0,0 +1,336 @@
+#include "OcclusionCuller.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <xmmintrin.h>
+
+using namespace DirectX;
+
+std::vector<float>                      OcclusionCuller::_depth( OcclusionCuller::Width * OcclusionCuller::Height, 1.0f );
+std::vector<float>                      OcclusionCuller::_blockDepth( OcclusionCuller::BlockCountX * OcclusionCuller::BlockCountY, 1.0f );
+std::vector<OcclusionCuller::Triangle>  OcclusionCuller::_triangles;
+std::vector<std::vector<UINT>>          OcclusionCuller::_tileBins( OcclusionCuller::TileCountX * OcclusionCuller::TileCountY );
+std::vector<XMFLOAT4>                   OcclusionCuller::_clipVertices;
+XMFLOAT4X4                              OcclusionCuller::_viewProjection;
+size_t                                  OcclusionCuller::_testedCount = 0;
+size_t                                  OcclusionCuller::_culledCount = 0;
+bool                                    OcclusionCuller::_hasOccluders = false;
+bool                                    OcclusionCuller::_isEnabled = true;
+
+// Projects a point in clip space onto the depth buffer
+static XMFLOAT3 ToScreen( const XMFLOAT4& clip )
+{
+    float invW = 1.0f / clip.w;
+    return XMFLOAT3( ( clip.x * invW * 0.5f + 0.5f ) * OcclusionCuller::Width,
+                     ( 0.5f - clip.y * invW * 0.5f ) * OcclusionCuller::Height,
+                     clip.z * invW );
+}
+
+// Adds an occluder to rasterize
+void OcclusionCuller::AddOccluder( const Mesh& mesh, const XMFLOAT4X4& world )
+{
+    const std::vector<XMFLOAT3>& vertices = mesh.GetOccluderVertices();
+    const std::vector<UINT>& indices = mesh.GetOccluderIndices();
+    if ( !_isEnabled || indices.empty() )
+    {
+        return;
+    }
+
+    XMMATRIX worldViewProjection = XMMatrixMultiply( XMLoadFloat4x4( &world ), XMLoadFloat4x4( &_viewProjection ) );
+    _clipVertices.resize( vertices.size() );
+    for ( size_t index = 0; index < vertices.size(); ++index )
+    {
+        XMStoreFloat4( &_clipVertices[ index ], XMVector3Transform( XMLoadFloat3( &vertices[ index ] ), worldViewProjection ) );
+    }
+
+    for ( size_t index = 0; index + 2 < indices.size(); index += 3 )
+    {
+        // Clipping against the near plane is skipped by dropping any triangle that crosses it,
+        // which can only make the occluder smaller
+        const XMFLOAT4* clip[ 3 ] = { &_clipVertices[ indices[ index ] ], &_clipVertices[ indices[ index + 1 ] ], &_clipVertices[ indices[ index + 2 ] ] };
+        if ( clip[ 0 ]->z < 0.0f || clip[ 1 ]->z < 0.0f || clip[ 2 ]->z < 0.0f )
+        {
+            continue;
+        }
+
+        Triangle triangle;
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            XMFLOAT3 screen = ToScreen( *clip[ vertex ] );
+            triangle.X[ vertex ] = screen.x;
+            triangle.Y[ vertex ] = screen.y;
+            triangle.Z[ vertex ] = screen.z;
+            minX = std::min( minX, screen.x );
+            minY = std::min( minY, screen.y );
+            maxX = std::max( maxX, screen.x );
+            maxY = std::max( maxY, screen.y );
+        }
+        if ( maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height )
+        {
+            continue;
+        }
+
+        // Bin the triangle into every tile its bounds touch
+        UINT triangleIndex = static_cast<UINT>( _triangles.size() );
+        _triangles.push_back( triangle );
+        UINT firstTileX = static_cast<UINT>( std::max( minX, 0.0f ) ) / TileWidth;
+        UINT firstTileY = static_cast<UINT>( std::max( minY, 0.0f ) ) / TileHeight;
+        UINT lastTileX = std::min( static_cast<UINT>( maxX ) / TileWidth, TileCountX - 1 );
+        UINT lastTileY = std::min( static_cast<UINT>( maxY ) / TileHeight, TileCountY - 1 );
+        for ( UINT tileY = firstTileY; tileY <= lastTileY; ++tileY )
+        {
+            for ( UINT tileX = firstTileX; tileX <= lastTileX; ++tileX )
+            {
+                _tileBins[ tileY * TileCountX + tileX ].push_back( triangleIndex );
+            }
+        }
+    }
+
+    _hasOccluders = true;
+}
+
+// Starts a new frame
+void OcclusionCuller::BeginFrame( const Camera* camera )
+{
+    _triangles.clear();
+    for ( auto& bin : _tileBins )
+    {
+        bin.clear();
+    }
+    _hasOccluders = false;
+    _testedCount = 0;
+    _culledCount = 0;
+
+    // The camera keeps its matrices transposed for the shaders
+    XMFLOAT4X4 view = camera->GetView();
+    XMFLOAT4X4 projection = camera->GetProjection();
+    XMMATRIX viewProjection = XMMatrixMultiply( XMMatrixTranspose( XMLoadFloat4x4( &view ) ), XMMatrixTranspose( XMLoadFloat4x4( &projection ) ) );
+    XMStoreFloat4x4( &_viewProjection, viewProjection );
+}
+
+// Gets the number of bounding boxes found hidden
+size_t OcclusionCuller::GetCulledCount()
+{
+    return _culledCount;
+}
+
+// Gets the number of bounding boxes tested
+size_t OcclusionCuller::GetTestedCount()
+{
+    return _testedCount;
+}
+
+// Checks if occlusion culling is enabled
+bool OcclusionCuller::IsEnabled()
+{
+    return _isEnabled;
+}
+
+// Checks if any of a mesh's bounding box can be seen
+bool OcclusionCuller::IsVisible( const Mesh& mesh, const XMFLOAT4X4& world )
+{
+    if ( !_isEnabled || !_hasOccluders )
+    {
+        return true;
+    }
+    ++_testedCount;
+
+    // Project the box's corners, giving up on boxes that cross the near plane
+    XMMATRIX worldViewProjection = XMMatrixMultiply( XMLoadFloat4x4( &world ), XMLoadFloat4x4( &_viewProjection ) );
+    XMFLOAT3 center = mesh.GetBoundsCenter();
+    XMFLOAT3 size = mesh.GetBoundsSize();
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for ( int corner = 0; corner < 8; ++corner )
+    {
+        XMFLOAT3 position( center.x + ( ( corner & 1 ) ? 0.5f : -0.5f ) * size.x,
+                           center.y + ( ( corner & 2 ) ? 0.5f : -0.5f ) * size.y,
+                           center.z + ( ( corner & 4 ) ? 0.5f : -0.5f ) * size.z );
+        XMFLOAT4 clip;
+        XMStoreFloat4( &clip, XMVector3Transform( XMLoadFloat3( &position ), worldViewProjection ) );
+        if ( clip.z < 0.0f )
+        {
+            return true;
+        }
+
+        XMFLOAT3 screen = ToScreen( clip );
+        minX = std::min( minX, screen.x );
+        minY = std::min( minY, screen.y );
+        minZ = std::min( minZ, screen.z );
+        maxX = std::max( maxX, screen.x );
+        maxY = std::max( maxY, screen.y );
+    }
+
+    // Leave anything off screen to the rest of the pipeline
+    if ( maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height )
+    {
+        return true;
+    }
+    int firstX = static_cast<int>( std::max( minX, 0.0f ) );
+    int firstY = static_cast<int>( std::max( minY, 0.0f ) );
+    int lastX = std::min( static_cast<int>( maxX ), static_cast<int>( Width ) - 1 );
+    int lastY = std::min( static_cast<int>( maxY ), static_cast<int>( Height ) - 1 );
+
+    // Only look at the pixels of blocks whose farthest depth is behind the box's nearest point
+    const int blockSize = static_cast<int>( BlockSize );
+    const __m128 lanes = _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f );
+    const __m128 boxFirstX = _mm_set1_ps( static_cast<float>( firstX ) );
+    const __m128 boxLastX = _mm_set1_ps( static_cast<float>( lastX ) );
+    const __m128 boxDepth = _mm_set1_ps( minZ );
+    for ( int blockY = firstY / blockSize; blockY <= lastY / blockSize; ++blockY )
+    {
+        for ( int blockX = firstX / blockSize; blockX <= lastX / blockSize; ++blockX )
+        {
+            if ( minZ > _blockDepth[ blockY * BlockCountX + blockX ] )
+            {
+                continue;
+            }
+
+            int rowStart = std::max( firstY, blockY * blockSize );
+            int rowEnd = std::min( lastY, ( blockY + 1 ) * blockSize - 1 );
+            for ( int y = rowStart; y <= rowEnd; ++y )
+            {
+                for ( int x = blockX * blockSize; x < ( blockX + 1 ) * blockSize; x += 4 )
+                {
+                    __m128 pixelX = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), lanes );
+                    __m128 isInBox = _mm_and_ps( _mm_cmpge_ps( pixelX, boxFirstX ), _mm_cmple_ps( pixelX, boxLastX ) );
+                    __m128 isInFront = _mm_cmple_ps( boxDepth, _mm_loadu_ps( &_depth[ y * Width + x ] ) );
+                    if ( _mm_movemask_ps( _mm_and_ps( isInBox, isInFront ) ) )
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    ++_culledCount;
+    return false;
+}
+
+// Rasterizes this frame's occluders
+void OcclusionCuller::Rasterize()
+{
+    if ( !_isEnabled || !_hasOccluders )
+    {
+        return;
+    }
+
+    // Every tile only writes its own pixels and blocks
+    ThreadPool::ParallelFor( TileCountX * TileCountY, 1, []( size_t begin, size_t end )
+    {
+        for ( size_t tile = begin; tile < end; ++tile )
+        {
+            RasterizeTile( static_cast<UINT>( tile ) );
+        }
+    } );
+}
+
+// Rasterizes one tile of the depth buffer
+void OcclusionCuller::RasterizeTile( UINT tile )
+{
+    const int tileX = static_cast<int>( ( tile % TileCountX ) * TileWidth );
+    const int tileY = static_cast<int>( ( tile / TileCountX ) * TileHeight );
+    for ( int y = tileY; y < tileY + static_cast<int>( TileHeight ); ++y )
+    {
+        std::fill( _depth.begin() + y * Width + tileX, _depth.begin() + y * Width + tileX + TileWidth, 1.0f );
+    }
+
+    const __m128 lanes = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+    const __m128 zero = _mm_setzero_ps();
+    for ( UINT triangleIndex : _tileBins[ tile ] )
+    {
+        // Wind the triangle so that all three edge functions are positive inside it
+        Triangle triangle = _triangles[ triangleIndex ];
+        float area = ( triangle.X[ 1 ] - triangle.X[ 0 ] ) * ( triangle.Y[ 2 ] - triangle.Y[ 0 ] )
+                   - ( triangle.Y[ 1 ] - triangle.Y[ 0 ] ) * ( triangle.X[ 2 ] - triangle.X[ 0 ] );
+        if ( area == 0.0f )
+        {
+            continue;
+        }
+        if ( area < 0.0f )
+        {
+            std::swap( triangle.X[ 1 ], triangle.X[ 2 ] );
+            std::swap( triangle.Y[ 1 ], triangle.Y[ 2 ] );
+            std::swap( triangle.Z[ 1 ], triangle.Z[ 2 ] );
+            area = -area;
+        }
+
+        // Each vertex's edge function is the one for the edge across from it, so dividing them by the
+        // area gives that vertex's barycentric weight, and the depth plane falls out of the weights
+        float edgeA[ 3 ], edgeB[ 3 ], edgeC[ 3 ];
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            int from = ( vertex + 1 ) % 3;
+            int to = ( vertex + 2 ) % 3;
+            edgeA[ vertex ] = triangle.Y[ from ] - triangle.Y[ to ];
+            edgeB[ vertex ] = triangle.X[ to ] - triangle.X[ from ];
+            edgeC[ vertex ] = -( edgeA[ vertex ] * triangle.X[ from ] + edgeB[ vertex ] * triangle.Y[ from ] );
+        }
+        float invArea = 1.0f / area;
+        float depthA = ( edgeA[ 0 ] * triangle.Z[ 0 ] + edgeA[ 1 ] * triangle.Z[ 1 ] + edgeA[ 2 ] * triangle.Z[ 2 ] ) * invArea;
+        float depthB = ( edgeB[ 0 ] * triangle.Z[ 0 ] + edgeB[ 1 ] * triangle.Z[ 1 ] + edgeB[ 2 ] * triangle.Z[ 2 ] ) * invArea;
+        float depthC = ( edgeC[ 0 ] * triangle.Z[ 0 ] + edgeC[ 1 ] * triangle.Z[ 1 ] + edgeC[ 2 ] * triangle.Z[ 2 ] ) * invArea;
+
+        // Only walk the part of the tile the triangle's bounds cover, four pixels at a time
+        float minX = std::min( triangle.X[ 0 ], std::min( triangle.X[ 1 ], triangle.X[ 2 ] ) );
+        float maxX = std::max( triangle.X[ 0 ], std::max( triangle.X[ 1 ], triangle.X[ 2 ] ) );
+        float minY = std::min( triangle.Y[ 0 ], std::min( triangle.Y[ 1 ], triangle.Y[ 2 ] ) );
+        float maxY = std::max( triangle.Y[ 0 ], std::max( triangle.Y[ 1 ], triangle.Y[ 2 ] ) );
+        int firstX = std::max( tileX, static_cast<int>( floorf( minX ) ) ) & ~3;
+        int lastX = std::min( tileX + static_cast<int>( TileWidth ) - 1, static_cast<int>( floorf( maxX ) ) );
+        int firstY = std::max( tileY, static_cast<int>( floorf( minY ) ) );
+        int lastY = std::min( tileY + static_cast<int>( TileHeight ) - 1, static_cast<int>( floorf( maxY ) ) );
+
+        const __m128 a0 = _mm_set1_ps( edgeA[ 0 ] ), a1 = _mm_set1_ps( edgeA[ 1 ] ), a2 = _mm_set1_ps( edgeA[ 2 ] );
+        const __m128 za = _mm_set1_ps( depthA );
+        for ( int y = firstY; y <= lastY; ++y )
+        {
+            float pixelY = y + 0.5f;
+            __m128 b0 = _mm_set1_ps( edgeB[ 0 ] * pixelY + edgeC[ 0 ] );
+            __m128 b1 = _mm_set1_ps( edgeB[ 1 ] * pixelY + edgeC[ 1 ] );
+            __m128 b2 = _mm_set1_ps( edgeB[ 2 ] * pixelY + edgeC[ 2 ] );
+            __m128 zb = _mm_set1_ps( depthB * pixelY + depthC );
+            float* row = &_depth[ y * Width ];
+            for ( int x = firstX; x <= lastX; x += 4 )
+            {
+                __m128 pixelX = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), lanes );
+                __m128 isInside = _mm_and_ps( _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a0, pixelX ), b0 ), zero ),
+                                  _mm_and_ps( _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a1, pixelX ), b1 ), zero ),
+                                              _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a2, pixelX ), b2 ), zero ) ) );
+                if ( !_mm_movemask_ps( isInside ) )
+                {
+                    continue;
+                }
+
+                __m128 current = _mm_loadu_ps( row + x );
+                __m128 nearest = _mm_min_ps( current, _mm_add_ps( _mm_mul_ps( za, pixelX ), zb ) );
+                _mm_storeu_ps( row + x, _mm_or_ps( _mm_and_ps( isInside, nearest ), _mm_andnot_ps( isInside, current ) ) );
+            }
+        }
+    }
+
+    // Find the farthest depth in each of the tile's blocks, so tests can skip blocks that can't hide anything
+    for ( int blockY = tileY; blockY < tileY + static_cast<int>( TileHeight ); blockY += BlockSize )
+    {
+        for ( int blockX = tileX; blockX < tileX + static_cast<int>( TileWidth ); blockX += BlockSize )
+        {
+            __m128 farthest = zero;
+            for ( int y = blockY; y < blockY + static_cast<int>( BlockSize ); ++y )
+            {
+                farthest = _mm_max_ps( farthest, _mm_loadu_ps( &_depth[ y * Width + blockX ] ) );
+                farthest = _mm_max_ps( farthest, _mm_loadu_ps( &_depth[ y * Width + blockX + 4 ] ) );
+            }
+            farthest = _mm_max_ps( farthest, _mm_shuffle_ps( farthest, farthest, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+            farthest = _mm_max_ps( farthest, _mm_shuffle_ps( farthest, farthest, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+            _mm_store_ss( &_blockDepth[ ( blockY / BlockSize ) * BlockCountX + blockX / BlockSize ], farthest );
+        }
+    }
+}
+
+// Sets whether occlusion culling is enabled
+void OcclusionCuller::SetEnabled( bool isEnabled )
+{
+    _isEnabled = isEnabled;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "Mesh.hpp"
+#include <vector>
+
+/// <summary>
+/// Defines the static occlusion culler. Every frame the designated occluders are rasterized on the
+/// CPU into a small depth buffer, along with the farthest depth of every block of it, and everything
+/// else tests its bounding box against that before it's queued to draw. Nothing is read back from
+/// the GPU, so the culler works without a device.
+/// </summary>
+class OcclusionCuller
+{
+    ImplementStaticClass( OcclusionCuller );
+
+public:
+    static const UINT Width = 256;
+    static const UINT Height = 144;
+
+private:
+    static const UINT TileWidth = 64;
+    static const UINT TileHeight = 16;
+    static const UINT TileCountX = Width / TileWidth;
+    static const UINT TileCountY = Height / TileHeight;
+    static const UINT BlockSize = 8;
+    static const UINT BlockCountX = Width / BlockSize;
+    static const UINT BlockCountY = Height / BlockSize;
+
+    /// <summary>
+    /// Defines an occluder triangle in screen space. Depth is the projected depth, from 0 at the
+    /// near plane to 1 at the far plane.
+    /// </summary>
+    struct Triangle
+    {
+        float X[ 3 ];
+        float Y[ 3 ];
+        float Z[ 3 ];
+    };
+
+    static std::vector<float> _depth;
+    static std::vector<float> _blockDepth;
+    static std::vector<Triangle> _triangles;
+    static std::vector<std::vector<UINT>> _tileBins;
+    static std::vector<DirectX::XMFLOAT4> _clipVertices;
+    static DirectX::XMFLOAT4X4 _viewProjection;
+    static size_t _testedCount;
+    static size_t _culledCount;
+    static bool _hasOccluders;
+    static bool _isEnabled;
+
+    /// <summary>
+    /// Clears one tile of the depth buffer, rasterizes the triangles that touch it, then finds the
+    /// farthest depth of each of its blocks.
+    /// </summary>
+    /// <param name="tile">The index of the tile.</param>
+    static void RasterizeTile( UINT tile );
+
+public:
+    /// <summary>
+    /// Adds an occluder to be rasterized this frame.
+    /// </summary>
+    /// <param name="mesh">The occluder's mesh.</param>
+    /// <param name="world">The occluder's world matrix.</param>
+    static void AddOccluder( const Mesh& mesh, const DirectX::XMFLOAT4X4& world );
+
+    /// <summary>
+    /// Starts a new frame, forgetting last frame's occluders.
+    /// </summary>
+    /// <param name="camera">The camera to cull for.</param>
+    static void BeginFrame( const Camera* camera );
+
+    /// <summary>
+    /// Gets the number of bounding boxes found to be hidden this frame.
+    /// </summary>
+    static size_t GetCulledCount();
+
+    /// <summary>
+    /// Gets the number of bounding boxes tested this frame.
+    /// </summary>
+    static size_t GetTestedCount();
+
+    /// <summary>
+    /// Checks whether occlusion culling is enabled.
+    /// </summary>
+    static bool IsEnabled();
+
+    /// <summary>
+    /// Checks whether any part of a mesh's bounding box could be seen past this frame's occluders.
+    /// </summary>
+    /// <param name="mesh">The mesh.</param>
+    /// <param name="world">The mesh's world matrix.</param>
+    /// <returns>False if the occluders hide the whole box, true if not.</returns>
+    static bool IsVisible( const Mesh& mesh, const DirectX::XMFLOAT4X4& world );
+
+    /// <summary>
+    /// Rasterizes this frame's occluders, one tile of the depth buffer per task.
+    /// </summary>
+    static void Rasterize();
+
+    /// <summary>
+    /// Sets whether occlusion culling is enabled. While disabled, everything is visible.
+    /// </summary>
+    /// <param name="isEnabled">True to enable, false to disable.</param>
+    static void SetEnabled( bool isEnabled );
+};
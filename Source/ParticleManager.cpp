@@ -0,0 +1,619 @@
+#include "ParticleManager.hpp"
+#include "StateCache.hpp"
+#include "Vertex.hpp"
+#include <algorithm>
+#include <math.h>
+#include <time.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+using namespace DirectX;
+
+const UINT ParticleManager::MaxSpawnsPerSecond      = 240;              // The spawn shader emits at most one particle per frame
+const UINT ParticleManager::MinimumBufferCapacity   = 256;
+const UINT ParticleManager::MaximumBufferBytes      = 16 * 1024 * 1024;
+const UINT ParticleManager::RandomTextureWidth      = 1024;
+const UINT ParticleManager::SeedCapacity            = 64;
+
+ID3D11Device*                                       ParticleManager::_device = nullptr;
+ID3D11DeviceContext*                                ParticleManager::_deviceContext = nullptr;
+std::shared_ptr<SimpleVertexShader>                 ParticleManager::_spawnVertexShader;
+std::shared_ptr<SimpleGeometryShader>               ParticleManager::_spawnGeometryShader;
+std::shared_ptr<SimpleVertexShader>                 ParticleManager::_particleVertexShader;
+std::shared_ptr<SimpleGeometryShader>               ParticleManager::_particleGeometryShader;
+std::shared_ptr<SimplePixelShader>                  ParticleManager::_particlePixelShader;
+ID3D11SamplerState*                                 ParticleManager::_sampler = nullptr;
+ID3D11BlendState*                                   ParticleManager::_blendState = nullptr;
+ID3D11DepthStencilState*                            ParticleManager::_depthStencilState = nullptr;
+ComPtr<ID3D11ShaderResourceView>                    ParticleManager::_randomTexture;
+ComPtr<ID3D11Buffer>                                ParticleManager::_seedBuffer;
+UINT                                                ParticleManager::_seedOffset = 0;
+UINT                                                ParticleManager::_bufferBytes = 0;
+std::vector<std::shared_ptr<ParticleSystem>>        ParticleManager::_systems;
+std::vector<std::shared_ptr<ParticleStreamBuffers>> ParticleManager::_freeBuffers;
+ParticleBackend                                     ParticleManager::_backend = ParticleBackend::Gpu;
+std::shared_ptr<ParticleSimulator>                  ParticleManager::_simulator;
+std::vector<ParticleInstance>                       ParticleManager::_instances;
+ComPtr<ID3D11Buffer>                                ParticleManager::_instanceBuffer;
+UINT                                                ParticleManager::_instanceCapacity = 0;
+
+// Gets a pair of stream-out buffers with room for the given number of particles
+std::shared_ptr<ParticleStreamBuffers> ParticleManager::AcquireBuffers( UINT capacity )
+{
+    // Round the capacity up to a power of two, so that buffers can be reused between systems
+    UINT roundedCapacity = MinimumBufferCapacity;
+    while ( roundedCapacity < capacity )
+    {
+        roundedCapacity *= 2;
+    }
+
+    // Reuse the smallest free pair that's big enough
+    auto best = _freeBuffers.end();
+    for ( auto it = _freeBuffers.begin(); it != _freeBuffers.end(); ++it )
+    {
+        if ( ( *it )->Capacity >= roundedCapacity && ( best == _freeBuffers.end() || ( *it )->Capacity < ( *best )->Capacity ) )
+        {
+            best = it;
+        }
+    }
+    if ( best != _freeBuffers.end() )
+    {
+        std::shared_ptr<ParticleStreamBuffers> buffers = *best;
+        _freeBuffers.erase( best );
+        return buffers;
+    }
+
+    // Otherwise make room for a new pair by dropping free pairs (largest first) if we need to
+    const UINT pairBytes = 2 * roundedCapacity * sizeof( ParticleVertex );
+    std::sort( _freeBuffers.begin(), _freeBuffers.end(), []( const std::shared_ptr<ParticleStreamBuffers>& a, const std::shared_ptr<ParticleStreamBuffers>& b )
+    {
+        return a->Capacity < b->Capacity;
+    } );
+    while ( _bufferBytes + pairBytes > MaximumBufferBytes && !_freeBuffers.empty() )
+    {
+        _bufferBytes -= 2 * _freeBuffers.back()->Capacity * sizeof( ParticleVertex );
+        _freeBuffers.pop_back();
+    }
+    if ( _bufferBytes + pairBytes > MaximumBufferBytes )
+    {
+        return nullptr;
+    }
+
+    // Create the new pair
+    std::shared_ptr<ParticleStreamBuffers> buffers = std::make_shared<ParticleStreamBuffers>();
+    buffers->Capacity = roundedCapacity;
+    if ( !_spawnGeometryShader->CreateCompatibleStreamOutBuffer( buffers->Read.GetAddress(), roundedCapacity ) ||
+         !_spawnGeometryShader->CreateCompatibleStreamOutBuffer( buffers->Write.GetAddress(), roundedCapacity ) )
+    {
+        return nullptr;
+    }
+
+    _bufferBytes += pairBytes;
+    return buffers;
+}
+
+// Binds the shaders and states every particle draw shares
+void ParticleManager::ApplyDrawStates( Camera* camera, StateTracker* stateTracker )
+{
+    // Everything but the acceleration, lifetime and texture is shared by every system
+    XMFLOAT4X4 world;
+    XMStoreFloat4x4( &world, XMMatrixIdentity() );
+    _particleGeometryShader->SetMatrix4x4( "world", world );
+    _particleGeometryShader->SetMatrix4x4( "view", camera->GetView() );
+    _particleGeometryShader->SetMatrix4x4( "projection", camera->GetProjection() );
+    _particleGeometryShader->SetShader( true );
+    _particlePixelShader->SetShader( true );
+    _particlePixelShader->SetSamplerState( "trilinear", _sampler );
+
+    stateTracker->SetBlendState( _blendState );
+    stateTracker->SetDepthStencilState( _depthStencilState );
+    stateTracker->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_POINTLIST );
+}
+
+// Creates the random texture
+bool ParticleManager::CreateRandomTexture()
+{
+    // Random values in [-1, 1] for every channel of every texel
+    srand( static_cast<unsigned int>( time( 0 ) ) );
+    std::vector<float> data( RandomTextureWidth * 4 );
+    for ( size_t index = 0; index < data.size(); ++index )
+    {
+        data[ index ] = rand() / static_cast<float>( RAND_MAX ) * 2.0f - 1.0f;
+    }
+
+    D3D11_TEXTURE1D_DESC textureDesc;
+    ZeroMemory( &textureDesc, sizeof( D3D11_TEXTURE1D_DESC ) );
+    textureDesc.ArraySize = 1;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    textureDesc.MipLevels = 1;
+    textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    textureDesc.Width = RandomTextureWidth;
+
+    D3D11_SUBRESOURCE_DATA initData;
+    ZeroMemory( &initData, sizeof( D3D11_SUBRESOURCE_DATA ) );
+    initData.pSysMem = &data[ 0 ];
+    initData.SysMemPitch = RandomTextureWidth * sizeof( float ) * 4;
+
+    ComPtr<ID3D11Texture1D> texture;
+    if ( FAILED( _device->CreateTexture1D( &textureDesc, &initData, texture.GetAddress() ) ) )
+    {
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    ZeroMemory( &srvDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    srvDesc.Format = textureDesc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1D;
+    srvDesc.Texture1D.MipLevels = 1;
+    return SUCCEEDED( _device->CreateShaderResourceView( texture.Get(), &srvDesc, _randomTexture.GetAddress() ) );
+}
+
+// Creates the sampler, blend and depth/stencil states
+bool ParticleManager::CreateStates()
+{
+    // Wrap, so that the random texture can be indexed by time forever
+    D3D11_SAMPLER_DESC samplerDesc;
+    ZeroMemory( &samplerDesc, sizeof( D3D11_SAMPLER_DESC ) );
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    _sampler = StateCache::GetSamplerState( _device, samplerDesc );
+    if ( !_sampler )
+    {
+        return false;
+    }
+
+    // Additive blending
+    D3D11_BLEND_DESC blendDesc;
+    ZeroMemory( &blendDesc, sizeof( D3D11_BLEND_DESC ) );
+    blendDesc.RenderTarget[ 0 ].BlendEnable = true;
+    blendDesc.RenderTarget[ 0 ].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[ 0 ].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[ 0 ].DestBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[ 0 ].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[ 0 ].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[ 0 ].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[ 0 ].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    _blendState = StateCache::GetBlendState( _device, blendDesc );
+    if ( !_blendState )
+    {
+        return false;
+    }
+
+    // Test against the scene, but don't write depth
+    D3D11_DEPTH_STENCIL_DESC depthDesc;
+    ZeroMemory( &depthDesc, sizeof( D3D11_DEPTH_STENCIL_DESC ) );
+    depthDesc.DepthEnable = true;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    _depthStencilState = StateCache::GetDepthStencilState( _device, depthDesc );
+    return _depthStencilState != nullptr;
+}
+
+// Simulates and draws every particle system
+void ParticleManager::Draw( float elapsedTime, float totalTime, Camera* camera, StateTracker* stateTracker )
+{
+    // The CPU backend simulates on the thread pool and only uses the GPU to draw
+    if ( _backend == ParticleBackend::Cpu )
+    {
+        if ( _simulator->GetEmitterCount() > 0 )
+        {
+            _simulator->Update( elapsedTime );
+            if ( camera )
+            {
+                DrawSimulatedParticles( camera, stateTracker );
+            }
+        }
+        return;
+    }
+
+    if ( _systems.empty() )
+    {
+        return;
+    }
+
+    DrawSpawn( elapsedTime, totalTime, stateTracker );
+    if ( camera )
+    {
+        DrawParticles( camera, stateTracker );
+    }
+    RetireFinishedSystems();
+}
+
+// Draws every particle system's particles
+void ParticleManager::DrawParticles( Camera* camera, StateTracker* stateTracker )
+{
+    ApplyDrawStates( camera, stateTracker );
+
+    for ( auto& system : _systems )
+    {
+        const ParticleSystemDescription& description = system->_description;
+        _particleVertexShader->SetFloat3( "acceleration", description.Acceleration );
+        _particleVertexShader->SetFloat( "maxLifetime", description.MaxLifetime );
+        _particleVertexShader->SetShader( true );
+        if ( description.Texture )
+        {
+            _particlePixelShader->SetShaderResourceView( "particleTexture", description.Texture->GetShaderResourceView() );
+        }
+
+        // Draw however many particles the last spawn pass streamed out
+        stateTracker->SetVertexBuffer( system->_buffers->Read.Get(), sizeof( ParticleVertex ) );
+        _deviceContext->DrawAuto();
+    }
+
+    stateTracker->SetGeometryShader( nullptr );
+}
+
+// Uploads and draws the CPU simulator's particles
+void ParticleManager::DrawSimulatedParticles( Camera* camera, StateTracker* stateTracker )
+{
+    UINT count = UploadInstances( static_cast<UINT>( _simulator->WriteInstances( _instances ) ) );
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    // The instances are already where they belong and already colored and sized, so the vertex
+    // shader has nothing left to integrate or interpolate
+    ApplyDrawStates( camera, stateTracker );
+    _particleVertexShader->SetFloat3( "acceleration", XMFLOAT3( 0.0f, 0.0f, 0.0f ) );
+    _particleVertexShader->SetFloat( "maxLifetime", 1.0f );
+    _particleVertexShader->SetShader( true );
+    stateTracker->SetVertexBuffer( _instanceBuffer.Get(), sizeof( ParticleVertex ) );
+
+    // Every emitter's particles follow the previous emitter's, so each one is a single draw
+    UINT first = 0;
+    for ( size_t emitter = 0; emitter < _simulator->GetEmitterCount() && first < count; ++emitter )
+    {
+        UINT emitterCount = std::min( static_cast<UINT>( _simulator->GetEmitterParticleCount( emitter ) ), count - first );
+        const ParticleSystemDescription& description = _simulator->GetEmitterDescription( emitter );
+        if ( description.Texture )
+        {
+            _particlePixelShader->SetShaderResourceView( "particleTexture", description.Texture->GetShaderResourceView() );
+        }
+
+        _deviceContext->Draw( emitterCount, first );
+        first += emitterCount;
+    }
+
+    stateTracker->SetGeometryShader( nullptr );
+}
+
+// Runs every particle system's spawn pass
+void ParticleManager::DrawSpawn( float elapsedTime, float totalTime, StateTracker* stateTracker )
+{
+    _spawnGeometryShader->SetFloat( "dt", elapsedTime );
+    _spawnGeometryShader->SetFloat( "totalTime", totalTime );
+    _spawnGeometryShader->SetShaderResourceView( "randomTexture", _randomTexture.Get() );
+    _spawnGeometryShader->SetSamplerState( "randomSampler", _sampler );
+    _spawnVertexShader->SetShader( true );
+
+    stateTracker->SetPixelShader( nullptr );
+    stateTracker->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_POINTLIST );
+
+    for ( auto& system : _systems )
+    {
+        const ParticleSystemDescription& description = system->_description;
+        _spawnGeometryShader->SetFloat( "ageToSpawn", description.SpawnInterval );
+        _spawnGeometryShader->SetFloat( "maxLifetime", description.MaxLifetime );
+        _spawnGeometryShader->SetFloat( "isEmitting", system->IsEmitting() ? 1.0f : 0.0f );
+        _spawnGeometryShader->SetShader( true );
+
+        ParticleStreamBuffers& buffers = *system->_buffers;
+        stateTracker->SetStreamOutTarget( buffers.Write.Get() );
+        if ( system->_isSeeded )
+        {
+            // Run last frame's particles through the spawn shader
+            stateTracker->SetVertexBuffer( buffers.Read.Get(), sizeof( ParticleVertex ) );
+            _deviceContext->DrawAuto();
+        }
+        else
+        {
+            // The first frame starts from just the root particle
+            UINT seedVertex = 0;
+            if ( WriteSeed( *system, seedVertex ) )
+            {
+                stateTracker->SetVertexBuffer( _seedBuffer.Get(), sizeof( ParticleVertex ) );
+                _deviceContext->Draw( 1, seedVertex );
+                system->_isSeeded = true;
+            }
+        }
+
+        buffers.Swap();
+        system->_age += elapsedTime;
+    }
+
+    stateTracker->SetStreamOutTarget( nullptr );
+    stateTracker->SetGeometryShader( nullptr );
+}
+
+// Starts a new particle system
+bool ParticleManager::Emit( const ParticleSystemDescription& description )
+{
+    if ( !_device )
+    {
+        return false;
+    }
+
+    if ( _backend == ParticleBackend::Cpu )
+    {
+        _simulator->AddEmitter( description );
+        return true;
+    }
+
+    std::shared_ptr<ParticleStreamBuffers> buffers = AcquireBuffers( GetRequiredCapacity( description ) );
+    if ( !buffers )
+    {
+#if defined( _DEBUG ) || defined( DEBUG )
+        std::cout << "Not enough particle memory left to emit a particle system." << std::endl;
+#endif
+        return false;
+    }
+
+    std::shared_ptr<ParticleSystem> system( new ( std::nothrow ) ParticleSystem( description, buffers ) );
+    if ( !system )
+    {
+        ReleaseBuffers( buffers );
+        return false;
+    }
+
+    _systems.push_back( system );
+    return true;
+}
+
+// Gets the backend particles are simulated with
+ParticleBackend ParticleManager::GetBackend()
+{
+    return _backend;
+}
+
+// Gets the number of bytes of particle buffers allocated
+UINT ParticleManager::GetBufferBytes()
+{
+    return _bufferBytes;
+}
+
+// Gets the most particles a system can have alive at once
+UINT ParticleManager::GetRequiredCapacity( const ParticleSystemDescription& description )
+{
+    float spawnRate = static_cast<float>( MaxSpawnsPerSecond );
+    if ( description.SpawnInterval > 0.0f )
+    {
+        spawnRate = std::min( spawnRate, 1.0f / description.SpawnInterval );
+    }
+
+    float aliveTime = std::min( description.EmitDuration, description.MaxLifetime );
+    return static_cast<UINT>( ceilf( aliveTime * spawnRate ) ) + 1;
+}
+
+// Gets the number of live particle systems
+UINT ParticleManager::GetSystemCount()
+{
+    if ( _backend == ParticleBackend::Cpu )
+    {
+        return static_cast<UINT>( _simulator->GetEmitterCount() );
+    }
+    return static_cast<UINT>( _systems.size() );
+}
+
+// Attempts to initialize the particle manager
+bool ParticleManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+
+    // Load the shaders (the spawn geometry shader streams its output back out)
+    _spawnVertexShader      = std::make_shared<SimpleVertexShader>( device, deviceContext );
+    _spawnGeometryShader    = std::make_shared<SimpleGeometryShader>( device, deviceContext, true, false );
+    _particleVertexShader   = std::make_shared<SimpleVertexShader>( device, deviceContext );
+    _particleGeometryShader = std::make_shared<SimpleGeometryShader>( device, deviceContext );
+    _particlePixelShader    = std::make_shared<SimplePixelShader>( device, deviceContext );
+    if ( !_spawnVertexShader->LoadShaderFile( L"Shaders\\SpawnVertexShader.cso" ) ||
+         !_spawnGeometryShader->LoadShaderFile( L"Shaders\\SpawnGeometryShader.cso" ) ||
+         !_particleVertexShader->LoadShaderFile( L"Shaders\\ParticleVertexShader.cso" ) ||
+         !_particleGeometryShader->LoadShaderFile( L"Shaders\\ParticleGeometryShader.cso" ) ||
+         !_particlePixelShader->LoadShaderFile( L"Shaders\\ParticlePixelShader.cso" ) )
+    {
+        return false;
+    }
+
+    if ( !CreateStates() || !CreateRandomTexture() )
+    {
+        return false;
+    }
+
+    // Create the buffer new systems' root particles are written into
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof( ParticleVertex ) * SeedCapacity;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if ( FAILED( _device->CreateBuffer( &desc, nullptr, _seedBuffer.GetAddress() ) ) )
+    {
+        return false;
+    }
+    _seedOffset = SeedCapacity;
+
+    _simulator = std::make_shared<ParticleSimulator>( static_cast<unsigned int>( time( 0 ) ) );
+    return true;
+}
+
+// Returns a pair of stream-out buffers to the pool
+void ParticleManager::ReleaseBuffers( std::shared_ptr<ParticleStreamBuffers> buffers )
+{
+    _freeBuffers.push_back( buffers );
+}
+
+// Removes every particle system whose particles have died
+void ParticleManager::RetireFinishedSystems()
+{
+    auto end = std::remove_if( _systems.begin(), _systems.end(), []( const std::shared_ptr<ParticleSystem>& system )
+    {
+        if ( system->IsFinished() )
+        {
+            ReleaseBuffers( system->_buffers );
+            return true;
+        }
+        return false;
+    } );
+    _systems.erase( end, _systems.end() );
+}
+
+// Sets the backend particles are simulated with
+void ParticleManager::SetBackend( ParticleBackend backend )
+{
+    if ( backend == _backend )
+    {
+        return;
+    }
+
+    // The backends can't hand particles to each other, so start over and give the other backend the whole budget
+    _systems.clear();
+    _freeBuffers.clear();
+    _instanceBuffer.Reset();
+    _instanceCapacity = 0;
+    _bufferBytes = 0;
+    if ( _simulator )
+    {
+        _simulator = std::make_shared<ParticleSimulator>( static_cast<unsigned int>( time( 0 ) ) );
+    }
+
+    _backend = backend;
+}
+
+// Releases every particle system and shared resource
+void ParticleManager::Shutdown()
+{
+    _systems.clear();
+    _freeBuffers.clear();
+    _simulator.reset();
+    _instances.clear();
+    _instanceBuffer.Reset();
+    _instanceCapacity = 0;
+    _bufferBytes = 0;
+
+    _seedBuffer.Reset();
+    _randomTexture.Reset();
+    _depthStencilState = nullptr;
+    _blendState = nullptr;
+    _sampler = nullptr;
+    _particlePixelShader.reset();
+    _particleGeometryShader.reset();
+    _particleVertexShader.reset();
+    _spawnGeometryShader.reset();
+    _spawnVertexShader.reset();
+
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Writes the CPU simulator's particles into the instance buffer
+UINT ParticleManager::UploadInstances( UINT count )
+{
+    if ( count == 0 )
+    {
+        return 0;
+    }
+
+    // Grow the buffer to the next power of two, as far as the memory budget allows
+    if ( count > _instanceCapacity )
+    {
+        const UINT maximumCapacity = ( MaximumBufferBytes - ( _bufferBytes - _instanceCapacity * sizeof( ParticleVertex ) ) ) / sizeof( ParticleVertex );
+        UINT capacity = std::max( _instanceCapacity, MinimumBufferCapacity );
+        while ( capacity < count && capacity * 2 <= maximumCapacity )
+        {
+            capacity *= 2;
+        }
+
+        if ( capacity != _instanceCapacity )
+        {
+            D3D11_BUFFER_DESC desc;
+            ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+            desc.Usage = D3D11_USAGE_DYNAMIC;
+            desc.ByteWidth = sizeof( ParticleVertex ) * capacity;
+            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+            ComPtr<ID3D11Buffer> buffer;
+            if ( SUCCEEDED( _device->CreateBuffer( &desc, nullptr, buffer.GetAddress() ) ) )
+            {
+                _bufferBytes = _bufferBytes - _instanceCapacity * sizeof( ParticleVertex ) + capacity * sizeof( ParticleVertex );
+                _instanceBuffer = buffer;
+                _instanceCapacity = capacity;
+            }
+        }
+
+#if defined( _DEBUG ) || defined( DEBUG )
+        if ( count > _instanceCapacity )
+        {
+            std::cout << "Not enough particle memory left to draw " << ( count - _instanceCapacity ) << " CPU particles." << std::endl;
+        }
+#endif
+        count = std::min( count, _instanceCapacity );
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if ( count == 0 || FAILED( _deviceContext->Map( _instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped ) ) )
+    {
+        return 0;
+    }
+
+    // A particle that is zero seconds old with the same start, middle and end values is drawn
+    // exactly where and how the simulator left it
+    ParticleVertex* vertices = reinterpret_cast<ParticleVertex*>( mapped.pData );
+    for ( UINT index = 0; index < count; ++index )
+    {
+        const ParticleInstance& instance = _instances[ index ];
+        ParticleVertex& vertex = vertices[ index ];
+        vertex.Type = 1;
+        vertex.Age = 0.0f;
+        vertex.StartPosition = instance.Position;
+        vertex.StartVelocity = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+        vertex.StartColor = instance.Color;
+        vertex.MidColor = instance.Color;
+        vertex.EndColor = instance.Color;
+        vertex.StartMidEndSize = XMFLOAT3( instance.Size, instance.Size, instance.Size );
+    }
+
+    _deviceContext->Unmap( _instanceBuffer.Get(), 0 );
+    return count;
+}
+
+// Writes a particle system's root particle into the seed buffer
+bool ParticleManager::WriteSeed( const ParticleSystem& system, UINT& seedVertex )
+{
+    // Append after the last seed if there's room, otherwise orphan the buffer and wrap around
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if ( _seedOffset >= SeedCapacity )
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        _seedOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if ( FAILED( _deviceContext->Map( _seedBuffer.Get(), 0, mapType, 0, &mapped ) ) )
+    {
+        return false;
+    }
+
+    const ParticleSystemDescription& description = system._description;
+    ParticleVertex& seed = reinterpret_cast<ParticleVertex*>( mapped.pData )[ _seedOffset ];
+    seed.Type = 0;
+    seed.Age = 0.0f;
+    seed.StartPosition = description.StartPosition;
+    seed.StartVelocity = description.StartVelocity;
+    seed.StartColor = description.StartColor;
+    seed.MidColor = description.MidColor;
+    seed.EndColor = description.EndColor;
+    seed.StartMidEndSize = description.StartMidEndSize;
+
+    _deviceContext->Unmap( _seedBuffer.Get(), 0 );
+
+    seedVertex = _seedOffset++;
+    return true;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "ParticleSimulator.hpp"
+#include "ParticleSystem.h"
+#include "SimpleShader.h"
+#include "StateTracker.hpp"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// An enumeration of the ways particles can be simulated.
+/// </summary>
+enum class ParticleBackend
+{
+    Gpu,
+    Cpu
+};
+
+/// <summary>
+/// Defines the static particle manager. It owns the shaders, states and random texture that every
+/// particle system shares, hands out stream-out buffers from a pool sized to what each system
+/// actually needs (up to a fixed memory budget), and retires systems once their particles die.
+/// With the CPU backend, particles are simulated by a particle simulator instead and uploaded to a
+/// dynamic vertex buffer every frame, then drawn with the same shaders.
+/// </summary>
+class ParticleManager
+{
+    ImplementStaticClass( ParticleManager );
+
+    static const UINT MaxSpawnsPerSecond;
+    static const UINT MinimumBufferCapacity;
+    static const UINT MaximumBufferBytes;
+    static const UINT RandomTextureWidth;
+    static const UINT SeedCapacity;
+
+    static ID3D11Device* _device;
+    static ID3D11DeviceContext* _deviceContext;
+    static std::shared_ptr<SimpleVertexShader> _spawnVertexShader;
+    static std::shared_ptr<SimpleGeometryShader> _spawnGeometryShader;
+    static std::shared_ptr<SimpleVertexShader> _particleVertexShader;
+    static std::shared_ptr<SimpleGeometryShader> _particleGeometryShader;
+    static std::shared_ptr<SimplePixelShader> _particlePixelShader;
+    static ID3D11SamplerState* _sampler;
+    static ID3D11BlendState* _blendState;
+    static ID3D11DepthStencilState* _depthStencilState;
+    static ComPtr<ID3D11ShaderResourceView> _randomTexture;
+    static ComPtr<ID3D11Buffer> _seedBuffer;
+    static UINT _seedOffset;
+    static UINT _bufferBytes;
+    static std::vector<std::shared_ptr<ParticleSystem>> _systems;
+    static std::vector<std::shared_ptr<ParticleStreamBuffers>> _freeBuffers;
+    static ParticleBackend _backend;
+    static std::shared_ptr<ParticleSimulator> _simulator;
+    static std::vector<ParticleInstance> _instances;
+    static ComPtr<ID3D11Buffer> _instanceBuffer;
+    static UINT _instanceCapacity;
+
+    /// <summary>
+    /// Gets a pair of stream-out buffers with room for at least the given number of particles.
+    /// </summary>
+    /// <param name="capacity">The number of particles.</param>
+    /// <returns>The buffers, or null if they would go over the memory budget.</returns>
+    static std::shared_ptr<ParticleStreamBuffers> AcquireBuffers( UINT capacity );
+
+    /// <summary>
+    /// Binds the shaders and states every particle draw shares.
+    /// </summary>
+    /// <param name="camera">The camera to draw with.</param>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    static void ApplyDrawStates( Camera* camera, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Creates the texture of random values the spawn shader reads from.
+    /// </summary>
+    static bool CreateRandomTexture();
+
+    /// <summary>
+    /// Creates the sampler, blend and depth/stencil states.
+    /// </summary>
+    static bool CreateStates();
+
+    /// <summary>
+    /// Draws every particle system's particles.
+    /// </summary>
+    /// <param name="camera">The camera to draw with.</param>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    static void DrawParticles( Camera* camera, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Uploads and draws the CPU simulator's particles.
+    /// </summary>
+    /// <param name="camera">The camera to draw with.</param>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    static void DrawSimulatedParticles( Camera* camera, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Runs every particle system's spawn and simulation pass.
+    /// </summary>
+    /// <param name="elapsedTime">The time since the last frame.</param>
+    /// <param name="totalTime">The total time.</param>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    static void DrawSpawn( float elapsedTime, float totalTime, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Gets the most particles (including the root) a system with the given settings can have alive at once.
+    /// </summary>
+    /// <param name="description">The particle system's settings.</param>
+    static UINT GetRequiredCapacity( const ParticleSystemDescription& description );
+
+    /// <summary>
+    /// Returns a pair of stream-out buffers to the pool.
+    /// </summary>
+    /// <param name="buffers">The buffers.</param>
+    static void ReleaseBuffers( std::shared_ptr<ParticleStreamBuffers> buffers );
+
+    /// <summary>
+    /// Removes every particle system whose particles have all died.
+    /// </summary>
+    static void RetireFinishedSystems();
+
+    /// <summary>
+    /// Writes the CPU simulator's particles into the instance buffer, growing it if it has to.
+    /// </summary>
+    /// <param name="count">The number of particles to write.</param>
+    /// <returns>The number of particles written, which is less than asked for if the buffer would go over the memory budget.</returns>
+    static UINT UploadInstances( UINT count );
+
+    /// <summary>
+    /// Writes the given particle system's root particle into the seed buffer.
+    /// </summary>
+    /// <param name="system">The particle system.</param>
+    /// <param name="seedVertex">Receives the index of the written vertex.</param>
+    static bool WriteSeed( const ParticleSystem& system, UINT& seedVertex );
+
+public:
+    /// <summary>
+    /// Simulates and draws every particle system, then retires the ones that have finished.
+    /// </summary>
+    /// <param name="elapsedTime">The time since the last frame.</param>
+    /// <param name="totalTime">The total time.</param>
+    /// <param name="camera">The camera to draw with.</param>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    static void Draw( float elapsedTime, float totalTime, Camera* camera, StateTracker* stateTracker );
+
+    /// <summary>
+    /// Starts a new particle system.
+    /// </summary>
+    /// <param name="description">The particle system's settings.</param>
+    /// <returns>True if the system was started, false if there wasn't enough room for its particles.</returns>
+    static bool Emit( const ParticleSystemDescription& description );
+
+    /// <summary>
+    /// Gets the backend particles are simulated with.
+    /// </summary>
+    static ParticleBackend GetBackend();
+
+    /// <summary>
+    /// Gets the number of bytes of particle buffers currently allocated.
+    /// </summary>
+    static UINT GetBufferBytes();
+
+    /// <summary>
+    /// Gets the number of live particle systems.
+    /// </summary>
+    static UINT GetSystemCount();
+
+    /// <summary>
+    /// Attempts to initialize the particle manager.
+    /// </summary>
+    /// <param name="device">The device to create resources on.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    static bool Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Sets the backend particles are simulated with. Live particle systems are dropped when the backend changes.
+    /// </summary>
+    /// <param name="backend">The backend.</param>
+    static void SetBackend( ParticleBackend backend );
+
+    /// <summary>
+    /// Releases every particle system and shared resource.
+    /// </summary>
+    static void Shutdown();
+};
@@ -0,0 +1,392 @@
+#include "ParticleSimulator.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+#include <algorithm>
+#include <sstream>
+#include <xmmintrin.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+using namespace DirectX;
+
+// The most particles a single thread integrates at once
+const size_t ParticleSimulator::ChunkSize = 16384;
+
+// Evaluates the same curve as the particle vertex shader, so CPU and GPU particles fade identically
+static inline float BezierCurve( float p0, float p1, float p2, float t )
+{
+    float oneMinusT = 1.0f - t;
+    return oneMinusT * oneMinusT * p0 + 2.0f * oneMinusT * t * p1 + t * p2;
+}
+
+// Creates a new particle simulator
+ParticleSimulator::ParticleSimulator( unsigned int seed )
+    : _randomState( seed ? seed : 1 )
+{
+}
+
+// Destroys this particle simulator
+ParticleSimulator::~ParticleSimulator()
+{
+}
+
+// Adds an emitter
+size_t ParticleSimulator::AddEmitter( const ParticleSystemDescription& description )
+{
+    Emitter emitter;
+    emitter.Description = description;
+    emitter.Age = 0.0f;
+    emitter.RootAge = 0.0f;
+    emitter.First = 0;
+
+    _emitters.push_back( emitter );
+    return _emitters.size() - 1;
+}
+
+// Splits every emitter's live particles into chunks
+size_t ParticleSimulator::BuildChunks() const
+{
+    _chunks.clear();
+
+    size_t output = 0;
+    for ( auto& emitter : _emitters )
+    {
+        size_t count = emitter.ParticleAge.size();
+        for ( size_t begin = emitter.First; begin < count; begin += ChunkSize )
+        {
+            Chunk chunk;
+            chunk.Source = const_cast<Emitter*>( &emitter );
+            chunk.Begin = begin;
+            chunk.End = std::min( begin + ChunkSize, count );
+            chunk.Output = output;
+            _chunks.push_back( chunk );
+
+            output += chunk.End - chunk.Begin;
+        }
+    }
+
+    return output;
+}
+
+// Spawns a number of particles from an emitter at once
+void ParticleSimulator::Burst( size_t emitter, size_t count )
+{
+    if ( emitter >= _emitters.size() )
+    {
+        return;
+    }
+
+    Emitter& target = _emitters[ emitter ];
+    size_t capacity = target.ParticleAge.size() + count;
+    target.PositionX.reserve( capacity );
+    target.PositionY.reserve( capacity );
+    target.PositionZ.reserve( capacity );
+    target.VelocityX.reserve( capacity );
+    target.VelocityY.reserve( capacity );
+    target.VelocityZ.reserve( capacity );
+    target.ParticleAge.reserve( capacity );
+
+    for ( size_t index = 0; index < count; ++index )
+    {
+        SpawnParticle( target );
+    }
+}
+
+// Gets the number of emitters
+size_t ParticleSimulator::GetEmitterCount() const
+{
+    return _emitters.size();
+}
+
+// Gets the settings an emitter was added with
+const ParticleSystemDescription& ParticleSimulator::GetEmitterDescription( size_t emitter ) const
+{
+    return _emitters[ emitter ].Description;
+}
+
+// Gets the number of an emitter's live particles
+size_t ParticleSimulator::GetEmitterParticleCount( size_t emitter ) const
+{
+    return _emitters[ emitter ].ParticleAge.size() - _emitters[ emitter ].First;
+}
+
+// Gets the number of live particles
+size_t ParticleSimulator::GetParticleCount() const
+{
+    size_t count = 0;
+    for ( auto& emitter : _emitters )
+    {
+        count += emitter.ParticleAge.size() - emitter.First;
+    }
+    return count;
+}
+
+// Integrates the given range of an emitter's particles
+void ParticleSimulator::Integrate( Emitter& emitter, size_t begin, size_t end, float elapsedTime )
+{
+    const XMFLOAT3& acceleration = emitter.Description.Acceleration;
+    const float halfStepSquared = 0.5f * elapsedTime * elapsedTime;
+
+    float* positionX = emitter.PositionX.data();
+    float* positionY = emitter.PositionY.data();
+    float* positionZ = emitter.PositionZ.data();
+    float* velocityX = emitter.VelocityX.data();
+    float* velocityY = emitter.VelocityY.data();
+    float* velocityZ = emitter.VelocityZ.data();
+    float* age = emitter.ParticleAge.data();
+
+    // Acceleration is constant, so p += v*dt + a*dt^2/2 and v += a*dt is exact and matches the
+    // closed form the particle vertex shader evaluates
+    const __m128 step = _mm_set1_ps( elapsedTime );
+    const __m128 offsetX = _mm_set1_ps( acceleration.x * halfStepSquared );
+    const __m128 offsetY = _mm_set1_ps( acceleration.y * halfStepSquared );
+    const __m128 offsetZ = _mm_set1_ps( acceleration.z * halfStepSquared );
+    const __m128 deltaX = _mm_set1_ps( acceleration.x * elapsedTime );
+    const __m128 deltaY = _mm_set1_ps( acceleration.y * elapsedTime );
+    const __m128 deltaZ = _mm_set1_ps( acceleration.z * elapsedTime );
+
+    size_t index = begin;
+    for ( ; index + 4 <= end; index += 4 )
+    {
+        __m128 vx = _mm_loadu_ps( velocityX + index );
+        __m128 vy = _mm_loadu_ps( velocityY + index );
+        __m128 vz = _mm_loadu_ps( velocityZ + index );
+
+        __m128 px = _mm_loadu_ps( positionX + index );
+        __m128 py = _mm_loadu_ps( positionY + index );
+        __m128 pz = _mm_loadu_ps( positionZ + index );
+        px = _mm_add_ps( px, _mm_add_ps( _mm_mul_ps( vx, step ), offsetX ) );
+        py = _mm_add_ps( py, _mm_add_ps( _mm_mul_ps( vy, step ), offsetY ) );
+        pz = _mm_add_ps( pz, _mm_add_ps( _mm_mul_ps( vz, step ), offsetZ ) );
+        _mm_storeu_ps( positionX + index, px );
+        _mm_storeu_ps( positionY + index, py );
+        _mm_storeu_ps( positionZ + index, pz );
+
+        _mm_storeu_ps( velocityX + index, _mm_add_ps( vx, deltaX ) );
+        _mm_storeu_ps( velocityY + index, _mm_add_ps( vy, deltaY ) );
+        _mm_storeu_ps( velocityZ + index, _mm_add_ps( vz, deltaZ ) );
+
+        _mm_storeu_ps( age + index, _mm_add_ps( _mm_loadu_ps( age + index ), step ) );
+    }
+
+    // Finish off the particles that don't fill a whole register
+    for ( ; index < end; ++index )
+    {
+        positionX[ index ] += velocityX[ index ] * elapsedTime + acceleration.x * halfStepSquared;
+        positionY[ index ] += velocityY[ index ] * elapsedTime + acceleration.y * halfStepSquared;
+        positionZ[ index ] += velocityZ[ index ] * elapsedTime + acceleration.z * halfStepSquared;
+        velocityX[ index ] += acceleration.x * elapsedTime;
+        velocityY[ index ] += acceleration.y * elapsedTime;
+        velocityZ[ index ] += acceleration.z * elapsedTime;
+        age[ index ] += elapsedTime;
+    }
+}
+
+// Gets the next random value in [-1, 1]
+float ParticleSimulator::NextRandom()
+{
+    // xorshift32, so a given seed always produces the same particles
+    _randomState ^= _randomState << 13;
+    _randomState ^= _randomState >> 17;
+    _randomState ^= _randomState << 5;
+
+    return static_cast<float>( _randomState >> 8 ) * ( 2.0f / 16777215.0f ) - 1.0f;
+}
+
+// Drops an emitter's particles that have outlived their lifetime
+void ParticleSimulator::RetireDeadParticles( Emitter& emitter )
+{
+    // Every particle shares the emitter's lifetime and they are stored oldest first, so the
+    // dead ones are always at the front
+    size_t count = emitter.ParticleAge.size();
+    const float maxLifetime = emitter.Description.MaxLifetime;
+    while ( emitter.First < count && emitter.ParticleAge[ emitter.First ] >= maxLifetime )
+    {
+        ++emitter.First;
+    }
+
+    // Only move memory once the dead particles make up at least half of the arrays
+    if ( emitter.First == 0 || emitter.First * 2 < count )
+    {
+        return;
+    }
+
+    std::vector<float>* arrays[] =
+    {
+        &emitter.PositionX, &emitter.PositionY, &emitter.PositionZ,
+        &emitter.VelocityX, &emitter.VelocityY, &emitter.VelocityZ,
+        &emitter.ParticleAge
+    };
+    for ( auto array : arrays )
+    {
+        array->erase( array->begin(), array->begin() + emitter.First );
+    }
+    emitter.First = 0;
+}
+
+// Runs the simulation benchmark
+void ParticleSimulator::RunBenchmark( size_t particleCount, unsigned int frameCount )
+{
+    const size_t emitterCount = 64;
+    const float elapsedTime = 1.0f / 60.0f;
+
+    ParticleSystemDescription description;
+    description.StartVelocity = XMFLOAT3( 0.0f, 4.0f, 0.0f );
+    description.Acceleration = XMFLOAT3( 0.0f, -9.8f, 0.0f );
+    description.StartMidEndSize = XMFLOAT3( 5.0f, 10.0f, 3.0f );
+    description.SpawnInterval = elapsedTime;
+    description.MaxLifetime = frameCount * elapsedTime + 1.0f;
+    description.EmitDuration = description.MaxLifetime;
+
+    // Spread the particles over a grid of emitters
+    ParticleSimulator simulator( 1 );
+    for ( size_t index = 0; index < emitterCount; ++index )
+    {
+        description.StartPosition = XMFLOAT3( static_cast<float>( index % 8 ) * 4.0f, 0.0f, static_cast<float>( index / 8 ) * 4.0f );
+
+        size_t emitter = simulator.AddEmitter( description );
+        simulator.Burst( emitter, particleCount / emitterCount + ( index < particleCount % emitterCount ? 1 : 0 ) );
+    }
+
+    // Time the simulation and the instance writing separately
+    std::vector<ParticleInstance> instances;
+    Timer timer;
+    double updateTime = 0.0;
+    double writeTime = 0.0;
+    for ( unsigned int frame = 0; frame < frameCount; ++frame )
+    {
+        timer.Start();
+        simulator.Update( elapsedTime );
+        timer.Stop();
+        updateTime += timer.GetElapsedTime();
+
+        timer.Start();
+        simulator.WriteInstances( instances );
+        timer.Stop();
+        writeTime += timer.GetElapsedTime();
+    }
+
+    // Report the results
+    double frames = static_cast<double>( std::max( frameCount, 1U ) );
+    double particles = static_cast<double>( std::max( simulator.GetParticleCount(), static_cast<size_t>( 1 ) ) );
+    std::ostringstream report;
+    report << "Particle benchmark: " << simulator.GetParticleCount() << " particles, "
+           << frameCount << " frames, " << ThreadPool::GetThreadCount() << " threads" << std::endl
+           << "  Update:         " << ( updateTime * 1000.0 / frames ) << " ms/frame, "
+           << ( updateTime * 1.0e9 / ( frames * particles ) ) << " ns/particle" << std::endl
+           << "  WriteInstances: " << ( writeTime * 1000.0 / frames ) << " ms/frame, "
+           << ( writeTime * 1.0e9 / ( frames * particles ) ) << " ns/particle" << std::endl;
+
+#if defined( _DEBUG ) || defined( DEBUG )
+    std::cout << report.str();
+#endif
+    OutputDebugStringA( report.str().c_str() );
+    MessageBoxA( nullptr, report.str().c_str(), "Particle Benchmark", MB_OK );
+}
+
+// Spawns one particle from the given emitter
+void ParticleSimulator::SpawnParticle( Emitter& emitter )
+{
+    const ParticleSystemDescription& description = emitter.Description;
+
+    // Offset the particle the same way the spawn geometry shader does
+    float randomX = NextRandom();
+    float randomY = NextRandom();
+    float randomZ = NextRandom();
+    float randomW = NextRandom();
+
+    emitter.PositionX.push_back( description.StartPosition.x + randomX * 0.5f );
+    emitter.PositionY.push_back( description.StartPosition.y + randomY * 0.5f );
+    emitter.PositionZ.push_back( description.StartPosition.z + randomZ * 0.5f );
+    emitter.VelocityX.push_back( randomW * 0.3f );
+    emitter.VelocityY.push_back( description.StartVelocity.y );
+    emitter.VelocityZ.push_back( randomX * 0.3f );
+    emitter.ParticleAge.push_back( 0.0f );
+}
+
+// Ages, moves, spawns and retires every particle
+void ParticleSimulator::Update( float elapsedTime )
+{
+    // Integrate every live particle, spread across the thread pool
+    if ( BuildChunks() > 0 )
+    {
+        ThreadPool::ParallelFor( _chunks.size(), 1, [ this, elapsedTime ]( size_t begin, size_t end )
+        {
+            for ( size_t index = begin; index < end; ++index )
+            {
+                const Chunk& chunk = _chunks[ index ];
+                Integrate( *chunk.Source, chunk.Begin, chunk.End, elapsedTime );
+            }
+        } );
+    }
+
+    // Retire dead particles and spawn new ones the same way the spawn pass handles the root particle
+    for ( auto& emitter : _emitters )
+    {
+        RetireDeadParticles( emitter );
+
+        if ( emitter.Age < emitter.Description.EmitDuration )
+        {
+            emitter.RootAge += elapsedTime;
+            if ( emitter.RootAge >= emitter.Description.SpawnInterval )
+            {
+                emitter.RootAge = 0.0f;
+                SpawnParticle( emitter );
+            }
+        }
+
+        emitter.Age += elapsedTime;
+    }
+
+    // Remove the emitters that have stopped emitting and have no particles left
+    auto finished = std::remove_if( _emitters.begin(), _emitters.end(), []( const Emitter& emitter )
+    {
+        return emitter.Age >= emitter.Description.EmitDuration && emitter.First == emitter.ParticleAge.size();
+    } );
+    _emitters.erase( finished, _emitters.end() );
+}
+
+// Writes the instance data for the given range of an emitter's particles
+void ParticleSimulator::WriteInstances( const Emitter& emitter, size_t begin, size_t end, ParticleInstance* output )
+{
+    const ParticleSystemDescription& description = emitter.Description;
+    const float inverseLifetime = 1.0f / description.MaxLifetime;
+
+    for ( size_t index = begin; index < end; ++index, ++output )
+    {
+        float t = emitter.ParticleAge[ index ] * inverseLifetime;
+
+        output->Position.x = emitter.PositionX[ index ];
+        output->Position.y = emitter.PositionY[ index ];
+        output->Position.z = emitter.PositionZ[ index ];
+        output->Size = BezierCurve( description.StartMidEndSize.x, description.StartMidEndSize.y, description.StartMidEndSize.z, t );
+        output->Color.x = BezierCurve( description.StartColor.x, description.MidColor.x, description.EndColor.x, t );
+        output->Color.y = BezierCurve( description.StartColor.y, description.MidColor.y, description.EndColor.y, t );
+        output->Color.z = BezierCurve( description.StartColor.z, description.MidColor.z, description.EndColor.z, t );
+        output->Color.w = BezierCurve( description.StartColor.w, description.MidColor.w, description.EndColor.w, t );
+    }
+}
+
+// Writes the instance data for every live particle
+size_t ParticleSimulator::WriteInstances( std::vector<ParticleInstance>& instances ) const
+{
+    size_t count = BuildChunks();
+    instances.resize( count );
+    if ( count == 0 )
+    {
+        return 0;
+    }
+
+    ParticleInstance* output = instances.data();
+    ThreadPool::ParallelFor( _chunks.size(), 1, [ this, output ]( size_t begin, size_t end )
+    {
+        for ( size_t index = begin; index < end; ++index )
+        {
+            const Chunk& chunk = _chunks[ index ];
+            WriteInstances( *chunk.Source, chunk.Begin, chunk.End, output + chunk.Output );
+        }
+    } );
+
+    return count;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Config.hpp"
+#include "ParticleSystem.h"
+#include <DirectXMath.h>
+#include <vector>
+
+/// <summary>
+/// Defines the data a CPU-simulated particle is drawn with.
+/// </summary>
+struct ParticleInstance
+{
+    DirectX::XMFLOAT3 Position;
+    float Size;
+    DirectX::XMFLOAT4 Color;
+};
+
+/// <summary>
+/// Defines a CPU particle simulator. Particles are stored as structure-of-arrays per emitter and
+/// integrated four at a time with SSE, and large emitter sets are split across the thread pool.
+/// Spawning and integration follow the same rules as the GPU stream-out path.
+/// </summary>
+class ParticleSimulator
+{
+    ImplementNonCopyableClass( ParticleSimulator );
+    ImplementNonMovableClass( ParticleSimulator );
+
+    /// <summary>
+    /// Defines an emitter and its live particles.
+    /// </summary>
+    struct Emitter
+    {
+        ParticleSystemDescription Description;
+        float Age;
+        float RootAge;
+        size_t First;
+        std::vector<float> PositionX;
+        std::vector<float> PositionY;
+        std::vector<float> PositionZ;
+        std::vector<float> VelocityX;
+        std::vector<float> VelocityY;
+        std::vector<float> VelocityZ;
+        std::vector<float> ParticleAge;
+    };
+
+    /// <summary>
+    /// Defines a range of one emitter's particles that one thread works on.
+    /// </summary>
+    struct Chunk
+    {
+        Emitter* Source;
+        size_t Begin;
+        size_t End;
+        size_t Output;
+    };
+
+    static const size_t ChunkSize;
+
+    std::vector<Emitter> _emitters;
+    mutable std::vector<Chunk> _chunks;
+    unsigned int _randomState;
+
+    /// <summary>
+    /// Splits every emitter's live particles into chunks.
+    /// </summary>
+    /// <returns>The total number of live particles.</returns>
+    size_t BuildChunks() const;
+
+    /// <summary>
+    /// Integrates the given range of an emitter's particles.
+    /// </summary>
+    /// <param name="emitter">The emitter.</param>
+    /// <param name="begin">The first particle.</param>
+    /// <param name="end">One past the last particle.</param>
+    /// <param name="elapsedTime">The time step.</param>
+    static void Integrate( Emitter& emitter, size_t begin, size_t end, float elapsedTime );
+
+    /// <summary>
+    /// Gets the next random value in [-1, 1].
+    /// </summary>
+    float NextRandom();
+
+    /// <summary>
+    /// Drops an emitter's particles that have outlived their lifetime.
+    /// </summary>
+    /// <param name="emitter">The emitter.</param>
+    static void RetireDeadParticles( Emitter& emitter );
+
+    /// <summary>
+    /// Spawns one particle from the given emitter.
+    /// </summary>
+    /// <param name="emitter">The emitter.</param>
+    void SpawnParticle( Emitter& emitter );
+
+    /// <summary>
+    /// Writes the instance data for the given range of an emitter's particles.
+    /// </summary>
+    /// <param name="emitter">The emitter.</param>
+    /// <param name="begin">The first particle.</param>
+    /// <param name="end">One past the last particle.</param>
+    /// <param name="output">The first instance to write to.</param>
+    static void WriteInstances( const Emitter& emitter, size_t begin, size_t end, ParticleInstance* output );
+
+public:
+    /// <summary>
+    /// Creates a new particle simulator.
+    /// </summary>
+    /// <param name="seed">The seed for the random number generator.</param>
+    ParticleSimulator( unsigned int seed = 1 );
+
+    /// <summary>
+    /// Destroys this particle simulator.
+    /// </summary>
+    ~ParticleSimulator();
+
+    /// <summary>
+    /// Adds an emitter.
+    /// </summary>
+    /// <param name="description">The emitter's settings.</param>
+    /// <returns>The emitter's index, which stays valid until the next update.</returns>
+    size_t AddEmitter( const ParticleSystemDescription& description );
+
+    /// <summary>
+    /// Spawns a number of particles from an emitter at once.
+    /// </summary>
+    /// <param name="emitter">The emitter's index.</param>
+    /// <param name="count">The number of particles.</param>
+    void Burst( size_t emitter, size_t count );
+
+    /// <summary>
+    /// Gets the number of emitters.
+    /// </summary>
+    size_t GetEmitterCount() const;
+
+    /// <summary>
+    /// Gets the settings an emitter was added with.
+    /// </summary>
+    /// <param name="emitter">The emitter's index.</param>
+    const ParticleSystemDescription& GetEmitterDescription( size_t emitter ) const;
+
+    /// <summary>
+    /// Gets the number of an emitter's live particles. Emitters write their instances in order, so
+    /// an emitter's first instance comes right after every earlier emitter's particles.
+    /// </summary>
+    /// <param name="emitter">The emitter's index.</param>
+    size_t GetEmitterParticleCount( size_t emitter ) const;
+
+    /// <summary>
+    /// Gets the number of live particles.
+    /// </summary>
+    size_t GetParticleCount() const;
+
+    /// <summary>
+    /// Runs the simulation benchmark and reports the timings.
+    /// </summary>
+    /// <param name="particleCount">The number of particles to simulate.</param>
+    /// <param name="frameCount">The number of frames to simulate.</param>
+    static void RunBenchmark( size_t particleCount, unsigned int frameCount );
+
+    /// <summary>
+    /// Ages, moves, spawns and retires every particle, then removes emitters that have finished.
+    /// </summary>
+    /// <param name="elapsedTime">The time step.</param>
+    void Update( float elapsedTime );
+
+    /// <summary>
+    /// Writes the instance data for every live particle.
+    /// </summary>
+    /// <param name="instances">Receives the instances.</param>
+    /// <returns>The number of instances written.</returns>
+    size_t WriteInstances( std::vector<ParticleInstance>& instances ) const;
+};
@@ -1,61 +1,96 @@
 #pragma once
-#include <DirectXMath.h>
-#include "DirectXGameCore.h"
-#include <d3d11.h>
-#include "SimpleShader.h"
-#include "Vertex.hpp"
-#include <time.h>
-#include "Camera.hpp"
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
 #include "Texture2D.hpp"
+#include <DirectXMath.h>
+#include <memory>
+
+/// <summary>
+/// Defines the settings a particle system is emitted with.
+/// </summary>
+struct ParticleSystemDescription
+{
+    DirectX::XMFLOAT3 StartPosition;
+    DirectX::XMFLOAT3 StartVelocity;
+    DirectX::XMFLOAT4 StartColor;
+    DirectX::XMFLOAT4 MidColor;
+    DirectX::XMFLOAT4 EndColor;
+    DirectX::XMFLOAT3 StartMidEndSize;
+    DirectX::XMFLOAT3 Acceleration;
+    float SpawnInterval;
+    float MaxLifetime;
+    float EmitDuration;
+    std::shared_ptr<Texture2D> Texture;
+
+    /// <summary>
+    /// Creates a new particle system description.
+    /// </summary>
+    ParticleSystemDescription();
+};
+
+/// <summary>
+/// Defines a pair of stream-out buffers that a particle system's particles ping-pong between.
+/// </summary>
+struct ParticleStreamBuffers
+{
+    ComPtr<ID3D11Buffer> Read;
+    ComPtr<ID3D11Buffer> Write;
+    UINT Capacity;
 
-using namespace DirectX;
+    /// <summary>
+    /// Swaps the read and write buffers.
+    /// </summary>
+    void Swap();
+};
 
+/// <summary>
+/// Defines a particle system. Particle systems are simulated on the GPU with stream output, and
+/// are created and retired by the particle manager.
+/// </summary>
 class ParticleSystem
 {
+    friend class ParticleManager;
+
+    ImplementNonCopyableClass( ParticleSystem );
+    ImplementNonMovableClass( ParticleSystem );
+
+    ParticleSystemDescription _description;
+    std::shared_ptr<ParticleStreamBuffers> _buffers;
+    float _age;
+    bool _isSeeded;
+
+    /// <summary>
+    /// Creates a new particle system.
+    /// </summary>
+    /// <param name="description">The particle system's settings.</param>
+    /// <param name="buffers">The stream-out buffers to simulate the particles in.</param>
+    ParticleSystem( const ParticleSystemDescription& description, std::shared_ptr<ParticleStreamBuffers> buffers );
+
 public:
-	ParticleSystem();
-	ParticleSystem(XMFLOAT3, XMFLOAT3, XMFLOAT4, XMFLOAT4, XMFLOAT4, float, float, float, float, float, XMFLOAT3, std::shared_ptr<Texture2D>);
-	~ParticleSystem();
-
-	void DrawSpawn(float dt, float totalTime, ID3D11Device*, ID3D11DeviceContext*);
-	void DrawParticles(Camera*, ID3D11Device*, ID3D11DeviceContext*);
-	void SwapSOBuffers();
-	void CreateGeometry(ID3D11Device*);
-	void LoadShaders(ID3D11Device*, ID3D11DeviceContext*);
-	
-private:
-	std::shared_ptr<Texture2D> texture;
-	ID3D11SamplerState* sampler;
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* soBufferRead;
-	ID3D11Buffer* soBufferWrite;
-	bool spawnFlip;
-	int frameCount;
-
-	SimpleVertexShader* particleVertShader;
-	SimplePixelShader* particlePixShader;
-	SimpleGeometryShader* particleGeoShader;
-
-	SimpleVertexShader* spawnVertShader;
-	SimpleGeometryShader* spawnGeoShader;
-
-	ID3D11Texture1D* randomTexture;
-	ID3D11ShaderResourceView* randomSRV;
-	ID3D11BlendState* particleBlendState;
-	ID3D11DepthStencilState* particleDepthState;
-
-	XMFLOAT3 startPos;
-	XMFLOAT3 startVel;
-	XMFLOAT4 startColor;
-	XMFLOAT4 midColor;
-	XMFLOAT4 endColor;
-	float startSize;
-	float midSize;
-	float endSize;
-
-	float ageToSpawn;
-	float maxLifetime;
-	XMFLOAT3 accel;
+    /// <summary>
+    /// Destroys this particle system.
+    /// </summary>
+    ~ParticleSystem();
 
-};
+    /// <summary>
+    /// Gets how long this particle system has been alive.
+    /// </summary>
+    float GetAge() const;
+
+    /// <summary>
+    /// Gets the settings this particle system was emitted with.
+    /// </summary>
+    const ParticleSystemDescription& GetDescription() const;
 
+    /// <summary>
+    /// Checks to see if this particle system is still spawning new particles.
+    /// </summary>
+    bool IsEmitting() const;
+
+    /// <summary>
+    /// Checks to see if every one of this particle system's particles has died.
+    /// </summary>
+    bool IsFinished() const;
+};
@@ -8,6 +8,7 @@ std::shared_ptr<btConstraintSolver>       Physics::_constraintSolver;
 std::shared_ptr<btCollisionConfiguration> Physics::_collisionConfig;
 std::shared_ptr<btDynamicsWorld>          Physics::_world;
 std::set<Rigidbody*>                      Physics::_rigidbodies;
+std::shared_ptr<PhysicsDebugDrawer>       Physics::_debugDrawer;
 
 // Initializes the physics system
 bool Physics::Initialize()
@@ -55,6 +56,10 @@ bool Physics::Initialize()
     // Configure the world
     _world->setGravity( btVector3( 0.0f, -9.81f, 0.0f ) );
 
+    // Create the debug drawer (it stays off until it's asked for)
+    _debugDrawer = std::make_shared<PhysicsDebugDrawer>();
+    _world->setDebugDrawer( _debugDrawer.get() );
+
     return true;
 }
 
@@ -71,6 +76,12 @@ void Physics::AddRigidbody( Rigidbody* rigidbody )
     }
 }
 
+// Checks if the physics world is drawn as debug lines
+bool Physics::IsDebugDrawEnabled()
+{
+    return _debugDrawer && _debugDrawer->getDebugMode() != btIDebugDraw::DBG_NoDebug;
+}
+
 // Removes a rigidbody component from the physics system
 void Physics::RemoveRigidbody( Rigidbody* rigidbody )
 {
@@ -80,6 +91,15 @@ void Physics::RemoveRigidbody( Rigidbody* rigidbody )
     _rigidbodies.erase( rigidbody );
 }
 
+// Sets whether the physics world is drawn as debug lines
+void Physics::SetDebugDrawEnabled( bool value )
+{
+    if ( _debugDrawer )
+    {
+        _debugDrawer->setDebugMode( value ? ( btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawContactPoints ) : btIDebugDraw::DBG_NoDebug );
+    }
+}
+
 // Updates the physics system
 void Physics::Update()
 {
@@ -104,4 +124,10 @@ void Physics::Update()
             rb->CopyTransformFromBullet();
         }
     }
+
+    // Add the world's wireframes to this frame's lines
+    if ( IsDebugDrawEnabled() )
+    {
+        _world->debugDrawWorld();
+    }
 }
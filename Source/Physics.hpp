@@ -1,5 +1,6 @@
 #pragma once
 
+#include "PhysicsDebugDrawer.hpp"
 #include <btBulletCollisionCommon.h>
 #include <btBulletDynamicsCommon.h>
 #include <memory>
@@ -18,6 +19,7 @@ class Physics
     static std::shared_ptr<btCollisionConfiguration> _collisionConfig;
     static std::shared_ptr<btDynamicsWorld>          _world;
     static std::set<Rigidbody*>                      _rigidbodies;
+    static std::shared_ptr<PhysicsDebugDrawer>       _debugDrawer;
 
     // Hide instance methods
     Physics() = delete;
@@ -39,12 +41,23 @@ public:
     /// <param name="rigidbody">The rigidbody.</param>
     static void AddRigidbody( Rigidbody* rigidbody );
 
+    /// <summary>
+    /// Checks to see if the physics world is drawn as debug lines.
+    /// </summary>
+    static bool IsDebugDrawEnabled();
+
     /// <summary>
     /// Removes a rigidbody from the physics system.
     /// </summary>
     /// <param name="rigidbody">The rigidbody.</param>
     static void RemoveRigidbody( Rigidbody* rigidbody );
 
+    /// <summary>
+    /// Sets whether the physics world is drawn as debug lines.
+    /// </summary>
+    /// <param name="value">True to draw every collision shape's wireframe and contact point.</param>
+    static void SetDebugDrawEnabled( bool value );
+
     /// <summary>
     /// Updates the physics system.
     /// </summary>
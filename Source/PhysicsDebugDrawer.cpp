@@ -0,0 +1,65 @@
+#include "PhysicsDebugDrawer.hpp"
+#include "RenderManager.hpp"
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+using namespace DirectX;
+
+// How long contact point lines are, in world units
+static const btScalar ContactLineLength = 0.25f;
+
+// Creates a new physics debug drawer
+PhysicsDebugDrawer::PhysicsDebugDrawer()
+    : _debugMode( DBG_NoDebug )
+{
+}
+
+// Destroys this physics debug drawer
+PhysicsDebugDrawer::~PhysicsDebugDrawer()
+{
+}
+
+// Draws text in the world
+void PhysicsDebugDrawer::draw3dText( const btVector3& location, const char* text )
+{
+    // We don't have world-space text, so just ignore it
+}
+
+// Draws a contact point
+void PhysicsDebugDrawer::drawContactPoint( const btVector3& pointOnB, const btVector3& normalOnB, btScalar distance, int lifeTime, const btVector3& color )
+{
+    drawLine( pointOnB, pointOnB + normalOnB * ContactLineLength, color );
+}
+
+// Draws a line
+void PhysicsDebugDrawer::drawLine( const btVector3& from, const btVector3& to, const btVector3& color )
+{
+    LineBatcher* batcher = RenderManager::GetLineBatcher();
+    if ( batcher )
+    {
+        batcher->AddLine( XMFLOAT3( from.x(), from.y(), from.z() ),
+                          XMFLOAT3( to.x(), to.y(), to.z() ),
+                          XMFLOAT4( color.x(), color.y(), color.z(), 1.0f ) );
+    }
+}
+
+// Gets the current debug mode flags
+int PhysicsDebugDrawer::getDebugMode() const
+{
+    return _debugMode;
+}
+
+// Reports a warning from Bullet
+void PhysicsDebugDrawer::reportErrorWarning( const char* warning )
+{
+#if defined( _DEBUG ) || defined( DEBUG )
+    std::cout << "Bullet: " << warning << std::endl;
+#endif
+}
+
+// Sets the current debug mode flags
+void PhysicsDebugDrawer::setDebugMode( int debugMode )
+{
+    _debugMode = debugMode;
+}
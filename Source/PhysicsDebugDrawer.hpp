@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Config.hpp"
+#include <btBulletCollisionCommon.h>
+
+/// <summary>
+/// Defines Bullet's debug drawer, which adds the physics world's wireframes and contact
+/// points to the render manager's line batcher.
+/// </summary>
+class PhysicsDebugDrawer : public btIDebugDraw
+{
+    ImplementNonCopyableClass( PhysicsDebugDrawer );
+    ImplementNonMovableClass( PhysicsDebugDrawer );
+
+    int _debugMode;
+
+public:
+    /// <summary>
+    /// Creates a new physics debug drawer.
+    /// </summary>
+    PhysicsDebugDrawer();
+
+    /// <summary>
+    /// Destroys this physics debug drawer.
+    /// </summary>
+    ~PhysicsDebugDrawer();
+
+    /// <summary>
+    /// Draws text in the world. This is not supported.
+    /// </summary>
+    /// <param name="location">The location of the text.</param>
+    /// <param name="text">The text.</param>
+    void draw3dText( const btVector3& location, const char* text ) override;
+
+    /// <summary>
+    /// Draws a contact point as a short line along its normal.
+    /// </summary>
+    /// <param name="pointOnB">The contact point.</param>
+    /// <param name="normalOnB">The contact normal.</param>
+    /// <param name="distance">The penetration distance.</param>
+    /// <param name="lifeTime">The contact's lifetime.</param>
+    /// <param name="color">The color to draw with.</param>
+    void drawContactPoint( const btVector3& pointOnB, const btVector3& normalOnB, btScalar distance, int lifeTime, const btVector3& color ) override;
+
+    /// <summary>
+    /// Draws a line.
+    /// </summary>
+    /// <param name="from">The starting point.</param>
+    /// <param name="to">The ending point.</param>
+    /// <param name="color">The color to draw with.</param>
+    void drawLine( const btVector3& from, const btVector3& to, const btVector3& color ) override;
+
+    /// <summary>
+    /// Gets the current debug mode flags.
+    /// </summary>
+    int getDebugMode() const override;
+
+    /// <summary>
+    /// Reports a warning from Bullet.
+    /// </summary>
+    /// <param name="warning">The warning.</param>
+    void reportErrorWarning( const char* warning ) override;
+
+    /// <summary>
+    /// Sets the current debug mode flags.
+    /// </summary>
+    /// <param name="debugMode">The new debug mode flags.</param>
+    void setDebugMode( int debugMode ) override;
+};
@@ -1,28 +1,39 @@
 #include "RenderManager.hpp"
 #include "Components.hpp"
+#include "LightManager.hpp"
 #include "MyDemoGame.hpp"
+#include "OcclusionCuller.hpp"
+#include "ResourceManager.hpp"
+#include "StateCache.hpp"
 #include "Time.hpp"
+#include <algorithm>
 #include <iostream>
 
 using namespace DirectX;
 
 const int                           RenderManager::ShadowMapSize = 4096;
 Cache<LineRenderer*>                RenderManager::_lineRenderers;
+std::shared_ptr<LineBatcher>        RenderManager::_lineBatcher;
 Cache<MeshRenderer*>                RenderManager::_meshRenderers;
 Cache<TextRenderer*>                RenderManager::_textRenderers;
-Cache<ParticleSystem*>              RenderManager::_particleSystems;
 const float                         RenderManager::_textBlendFactor[ 4 ] = { 1.0f, 1.0f, 1.0f, 1.0f };
-std::shared_ptr<DeviceState>        RenderManager::_deviceState;
-ComPtr<ID3D11BlendState>            RenderManager::_textBlendState;
-ComPtr<ID3D11SamplerState>          RenderManager::_textSamplerState;
-ComPtr<ID3D11DepthStencilState>     RenderManager::_textDepthStencilState;
-ComPtr<ID3D11RasterizerState>       RenderManager::_textRasterizerState;
+std::shared_ptr<StateTracker>       RenderManager::_stateTracker;
+std::shared_ptr<TextBatcher>        RenderManager::_textBatcher;
+ID3D11BlendState*                   RenderManager::_textBlendState;
+ID3D11SamplerState*                 RenderManager::_textSamplerState;
+ID3D11DepthStencilState*            RenderManager::_textDepthStencilState;
+ID3D11RasterizerState*              RenderManager::_textRasterizerState;
+std::vector<RenderManager::QueuedDraw> RenderManager::_drawQueue;
 ID3D11DeviceContext*                RenderManager::_deviceContext;
+RenderPassState                     RenderManager::_mainPassState;
 std::shared_ptr<SimpleVertexShader> RenderManager::_shadowVS;
-ComPtr<ID3D11DepthStencilView>      RenderManager::_shadowDSV;
-ComPtr<ID3D11ShaderResourceView>    RenderManager::_shadowSRV;
-ComPtr<ID3D11SamplerState>          RenderManager::_shadowSampler;
-ComPtr<ID3D11RasterizerState>       RenderManager::_shadowRS;
+std::shared_ptr<SimpleVertexShader> RenderManager::_compactShadowVS;
+std::shared_ptr<FrameGraph>         RenderManager::_frameGraph;
+FrameResource                       RenderManager::_backBuffer = FrameGraph::InvalidResource;
+FrameResource                       RenderManager::_sceneDepth = FrameGraph::InvalidResource;
+FrameResource                       RenderManager::_shadowMap = FrameGraph::InvalidResource;
+ID3D11SamplerState*                 RenderManager::_shadowSampler;
+ID3D11RasterizerState*              RenderManager::_shadowRS;
 DirectX::XMFLOAT4X4                 RenderManager::_shadowView;
 DirectX::XMFLOAT4X4                 RenderManager::_shadowProj;
 
@@ -47,34 +58,70 @@ void RenderManager::AddTextRenderer( TextRenderer* renderer )
 // Draws all of the renderers
 void RenderManager::Draw()
 {
-    DrawShadowMap();
-    DrawMeshRenderers();
-    DrawParticleSystems();
-    DrawTextAndLineRenderers();
+    _stateTracker->BeginFrame();
+
+    // Swap in any streamed textures and pick their resolutions based on last frame's draws
+    TextureStreamer::Update();
+
+    // Let go of the meshes and textures nothing has used in a while if either is over its budget
+    ResourceManager::Update();
+
+    // Every pass but the shadow pass renders into the back buffer, which is recreated when the window resizes
+    MyDemoGame* game = MyDemoGame::GetInstance();
+    _mainPassState.RenderTarget = game->GetRenderTargetView();
+    _mainPassState.DepthStencil = game->GetDepthStencilView();
+    _mainPassState.Viewport = game->GetViewport();
+    _frameGraph->SetImportedViews( _backBuffer, _mainPassState.RenderTarget, nullptr, nullptr );
+    _frameGraph->SetImportedViews( _sceneDepth, nullptr, _mainPassState.DepthStencil, nullptr );
+
+    // Gather every line renderer's line, then upload all of this frame's lines at once
+    for ( auto& renderer : _lineRenderers )
+    {
+        if ( !renderer->IsEnabled() )
+        {
+            continue;
+        }
+
+        LineMaterial* material = renderer->GetGameObject()->GetComponent<LineMaterial>();
+        if ( !material )
+        {
+#if defined( _DEBUG ) || defined( DEBUG )
+            std::cout << renderer->GetGameObject()->GetName() << " has a LineRenderer, but not a LineMaterial" << std::endl;
+#endif
+            continue;
+        }
+
+        _lineBatcher->AddScreenLine( renderer->GetStartPoint(), renderer->GetEndPoint(), material->GetLineColor() );
+    }
+    _lineBatcher->Upload();
+
+    // Bin this frame's point lights into the active camera's clusters
+    LightManager::Update( Camera::GetActiveCamera(), _mainPassState.Viewport.Width, _mainPassState.Viewport.Height );
+
+    // The frame graph works out which passes run and in what order
+    _frameGraph->Execute();
+
+    // Lines are immediate mode, so they need to be added again next frame
+    _lineBatcher->Clear();
 }
 
 // Draws the given mesh
-void RenderManager::DrawMesh( std::shared_ptr<Mesh> mesh, D3D11_PRIMITIVE_TOPOLOGY topology )
+void RenderManager::DrawMesh( std::shared_ptr<Mesh> mesh, D3D11_PRIMITIVE_TOPOLOGY topology, size_t lodIndex )
 {
-    _deviceContext->IASetPrimitiveTopology( topology );
-
-    const UINT    stride = mesh->GetVertexStride();
-    const UINT    offset = 0;
-    ID3D11Buffer* vertexBuffer = mesh->GetVertexBuffer().Get();
+    _stateTracker->SetPrimitiveTopology( topology );
+    _stateTracker->SetVertexBuffer( mesh->GetVertexBuffer().Get(), mesh->GetVertexStride() );
 
     // If the mesh has an index buffer, then we need to draw it using that
     if ( mesh->GetIndexCount() > 0 )
     {
-        ID3D11Buffer* indexBuffer = mesh->GetIndexBuffer().Get();
-
-        _deviceContext->IASetIndexBuffer( indexBuffer, DXGI_FORMAT_R32_UINT, 0 );
-        _deviceContext->IASetVertexBuffers( 0, 1, &vertexBuffer, &stride, &offset );
-        _deviceContext->DrawIndexed( mesh->GetIndexCount(), 0, 0 );
+        // Every level of detail shares the index buffer, so just draw the chosen level's range of it
+        const MeshLod& lod = mesh->GetLods()[ std::min( lodIndex, mesh->GetLods().size() - 1 ) ];
+        _stateTracker->SetIndexBuffer( mesh->GetIndexBuffer().Get(), mesh->GetIndexFormat() );
+        _deviceContext->DrawIndexed( lod.IndexCount, lod.IndexStart, 0 );
     }
     else
     {
-        _deviceContext->IASetIndexBuffer( nullptr, DXGI_FORMAT_UNKNOWN, 0 );
-        _deviceContext->IASetVertexBuffers( 0, 1, &vertexBuffer, &stride, &offset );
+        _stateTracker->SetIndexBuffer( nullptr, DXGI_FORMAT_UNKNOWN );
         _deviceContext->Draw( mesh->GetVertexCount(), 0 );
     }
 }
@@ -84,8 +131,29 @@ void RenderManager::DrawMeshRenderers()
 {
     std::shared_ptr<Mesh> mesh;
     Material* material;
-    XMFLOAT4X4 world;
 
+    // Work out how many pixels one world unit covers at a distance of one, for texture streaming and levels of detail
+    Camera* camera = Camera::GetActiveCamera();
+    XMFLOAT3 cameraPosition = camera->GetPosition();
+    float pixelsPerUnit = camera->GetProjection()._22 * _mainPassState.Viewport.Height * 0.5f;
+
+    // Meshes use the default device states
+    _stateTracker->ApplyPassState( _mainPassState );
+    _stateTracker->SetGeometryShader( nullptr );
+
+    // Rasterize the occluders first, so everything else can be tested against them before it's queued
+    OcclusionCuller::BeginFrame( camera );
+    for ( auto& renderer : _meshRenderers )
+    {
+        if ( renderer->IsEnabled() && renderer->IsOccluder() && renderer->GetMesh() )
+        {
+            OcclusionCuller::AddOccluder( *renderer->GetMesh(), renderer->GetGameObject()->GetTransform()->GetWorldMatrix() );
+        }
+    }
+    OcclusionCuller::Rasterize();
+
+    // Queue up everything there is to draw
+    _drawQueue.clear();
     for ( auto& renderer : _meshRenderers )
     {
         // Get the mesh and material
@@ -96,8 +164,6 @@ void RenderManager::DrawMeshRenderers()
         mesh = renderer->GetMesh();
         material = renderer->GetMaterial();
 
-
-
         // Ensure that the mesh and material exist
         if ( !mesh || !material )
         {
@@ -114,63 +180,113 @@ void RenderManager::DrawMeshRenderers()
             continue;
         }
 
+        // Skip anything hidden behind the occluders
+        if ( !renderer->IsOccluder() && !OcclusionCuller::IsVisible( *mesh, renderer->GetGameObject()->GetTransform()->GetWorldMatrix() ) )
+        {
+            continue;
+        }
+
+        QueuedDraw draw;
+        draw.PipelineKey = StateCache::GetPipelineKey( material->GetPipelineState() );
+        draw.SortKey = material->GetSortKey();
+        draw.DrawnMesh = mesh.get();
+        draw.Renderer = renderer;
+        _drawQueue.push_back( draw );
+    }
+
+    // Draws with the same pipeline state, material parameters and mesh end up next to each other, so the state
+    // tracker can skip rebinding the fixed-function states, shaders, textures, parameter buffer and vertex buffers
+    std::sort( _drawQueue.begin(), _drawQueue.end(), []( const QueuedDraw& left, const QueuedDraw& right )
+    {
+        if ( left.PipelineKey != right.PipelineKey )
+        {
+            return left.PipelineKey < right.PipelineKey;
+        }
+        if ( left.SortKey != right.SortKey )
+        {
+            return left.SortKey < right.SortKey;
+        }
+        return left.DrawnMesh < right.DrawnMesh;
+    } );
+
+    for ( auto& draw : _drawQueue )
+    {
+        MeshRenderer* renderer = draw.Renderer;
+        mesh = renderer->GetMesh();
+        material = renderer->GetMaterial();
 
+        // Anything the material doesn't ask for comes from the pass
+        const PipelineState& pipelineState = material->GetPipelineState();
+        _stateTracker->SetBlendState( pipelineState.BlendState ? pipelineState.BlendState : _mainPassState.BlendState,
+                                      _mainPassState.BlendFactor, _mainPassState.BlendMask );
+        _stateTracker->SetDepthStencilState( pipelineState.DepthStencilState ? pipelineState.DepthStencilState : _mainPassState.DepthStencilState,
+                                             _mainPassState.StencilRef );
+        _stateTracker->SetRasterizerState( pipelineState.RasterizerState ? pipelineState.RasterizerState : _mainPassState.RasterizerState );
 
         // Get and set the world matrix, then activate the shader
+        material->SelectVertexShader( *mesh );
         XMFLOAT4X4 world = renderer->GetGameObject()->GetTransform()->GetWorldMatrix();
         XMStoreFloat4x4( &world, XMMatrixTranspose( XMLoadFloat4x4( &world ) ) );
-        assert( material->GetVertexShader()->SetMatrix4x4( "World", world ) );
-        assert( material->GetVertexShader()->SetMatrix4x4( "ShadowView", _shadowView ) );
-        assert( material->GetVertexShader()->SetMatrix4x4( "ShadowProjection", _shadowProj ) );
-        assert( material->GetPixelShader()->SetShaderResourceView( "ShadowMap", _shadowSRV.Get() ) );
-        assert( material->GetPixelShader()->SetSamplerState( "ShadowSampler", _shadowSampler.Get() ) );
+        bool isSet = material->GetVertexShader()->SetMatrix4x4( "World", world );
+        isSet = material->GetVertexShader()->SetMatrix4x4( "ShadowView", _shadowView ) && isSet;
+        isSet = material->GetVertexShader()->SetMatrix4x4( "ShadowProjection", _shadowProj ) && isSet;
+        isSet = material->GetPixelShader()->SetShaderResourceView( "ShadowMap", _frameGraph->GetShaderResourceView( _shadowMap ) ) && isSet;
+        isSet = material->GetPixelShader()->SetSamplerState( "ShadowSampler", _shadowSampler ) && isSet;
+        assert( isSet && "Failed to set the mesh's shadow parameters!" );
+        LightManager::Apply( material->GetPixelShader() );
         material->Activate();
 
+        // Let the material know roughly how large the object is on screen
+        Transform* transform = renderer->GetGameObject()->GetTransform();
+        XMFLOAT3 position = transform->GetPosition();
+        XMFLOAT3 scale = transform->GetScale();
+        float distance = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &position ), XMLoadFloat3( &cameraPosition ) ) ) );
+        float maxScale = std::max( scale.x, std::max( scale.y, scale.z ) );
+        float objectPixelsPerUnit = maxScale * pixelsPerUnit / std::max( distance, 0.01f );
+        material->RequestTextureResolution( 2.0f * objectPixelsPerUnit );
 
+        // Draw as few triangles as the object's size on screen allows
+        renderer->SetLodIndex( mesh->SelectLod( objectPixelsPerUnit, renderer->GetLodIndex() ) );
 
         // Draw the mesh
-        DrawMesh( mesh, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+        DrawMesh( mesh, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, renderer->GetLodIndex() );
     }
 }
 
+// Draws all of the particle systems
 void RenderManager::DrawParticleSystems()
 {
-    _deviceState->Cache();
-
-    auto device = _deviceState->GetDevice();
-    auto dc = _deviceState->GetDeviceContext();
-    for ( auto& ps : _particleSystems )
-    {
-        ps->DrawSpawn( Time::GetElapsedTime(), Time::GetTotalTime(), device, dc );
-        ps->DrawParticles( Camera::GetActiveCamera(), device, dc );
-    }
-
-    _deviceState->Restore();
+    // The particle manager sets its own blend and depth states on top of the main pass
+    _stateTracker->ApplyPassState( _mainPassState );
+    ParticleManager::Draw( Time::GetElapsedTime(), Time::GetTotalTime(), Camera::GetActiveCamera(), _stateTracker.get() );
 }
 
 // Draws to the shadow map
 void RenderManager::DrawShadowMap()
 {
-    _deviceState->Cache();
-
-    // Initial setup
-    _deviceContext->OMSetRenderTargets( 0, 0, _shadowDSV.Get() );
-    _deviceContext->ClearDepthStencilView( _shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0 );
-    _deviceContext->RSSetState( _shadowRS.Get() );
-
-    // We need a viewport!  This defines how much of the render target to render into
-    D3D11_VIEWPORT viewport = MyDemoGame::GetInstance()->GetViewport();
-    D3D11_VIEWPORT shadowVP = viewport;
-    shadowVP.MaxDepth = 1.0f;
-    shadowVP.Width = static_cast<float>( ShadowMapSize );
-    shadowVP.Height = static_cast<float>( ShadowMapSize );
-    _deviceContext->RSSetViewports( 1, &shadowVP );
+    // Describe the shadow pass: depth only, biased, into the whole shadow map
+    RenderPassState shadowPass;
+    shadowPass.DepthStencil = _frameGraph->GetDepthStencilView( _shadowMap );
+    shadowPass.RasterizerState = _shadowRS;
+    shadowPass.Viewport = _mainPassState.Viewport;
+    shadowPass.Viewport.MaxDepth = 1.0f;
+    shadowPass.Viewport.Width = static_cast<float>( ShadowMapSize );
+    shadowPass.Viewport.Height = static_cast<float>( ShadowMapSize );
+    _stateTracker->ApplyPassState( shadowPass );
 
     // Turn on the correct shaders
-    _shadowVS->SetShader( false ); // Don't copy any data yet
-    assert( _shadowVS->SetMatrix4x4( "View", _shadowView ) );
-    assert( _shadowVS->SetMatrix4x4( "Projection", _shadowProj ) );
-    _deviceContext->PSSetShader( 0, 0, 0 ); // Turn off the pixel shader
+    SimpleVertexShader* activeVS = _shadowVS.get();
+    activeVS->SetShader( false ); // Don't copy any data yet
+    bool isSet = _shadowVS->SetMatrix4x4( "View", _shadowView );
+    isSet = _shadowVS->SetMatrix4x4( "Projection", _shadowProj ) && isSet;
+    isSet = _compactShadowVS->SetMatrix4x4( "View", _shadowView ) && isSet;
+    isSet = _compactShadowVS->SetMatrix4x4( "Projection", _shadowProj ) && isSet;
+    assert( isSet && "Failed to set the shadow matrices!" );
+    _stateTracker->SetGeometryShader( nullptr );
+    _stateTracker->SetPixelShader( nullptr ); // Turn off the pixel shader
+
+    // The shadow projection is orthographic, so a world unit covers the same number of shadow map texels everywhere
+    const float shadowTexelsPerUnit = _shadowProj._11 * ShadowMapSize * 0.5f;
 
     // Now render everything :D
     for ( auto& renderer : _meshRenderers )
@@ -182,43 +298,55 @@ void RenderManager::DrawShadowMap()
         }
         auto mesh = renderer->GetMesh();
 
-
-
         // Ensure that the mesh and material exist
         if ( !mesh )
         {
             continue;
         }
 
-
+        // Compact meshes need the shadow shader that unpacks their vertices
+        SimpleVertexShader* meshVS = _shadowVS.get();
+        if ( mesh->GetVertexFormat() == VertexFormat::Compact )
+        {
+            meshVS = _compactShadowVS.get();
+            meshVS->SetFloat3( "PositionOffset", mesh->GetPositionOffset() );
+            meshVS->SetFloat3( "PositionScale", mesh->GetPositionScale() );
+        }
+        if ( meshVS != activeVS )
+        {
+            activeVS = meshVS;
+            activeVS->SetShader( false );
+        }
 
         // Get and set the world matrix, then activate the shader
         XMFLOAT4X4 world = renderer->GetGameObject()->GetTransform()->GetWorldMatrix();
         XMStoreFloat4x4( &world, XMMatrixTranspose( XMLoadFloat4x4( &world ) ) );
-        _shadowVS->SetMatrix4x4( "World", world );
-        _shadowVS->CopyAllBufferData();
+        activeVS->SetMatrix4x4( "World", world );
+        activeVS->CopyAllBufferData();
 
+        // Shadow map texels are much larger than pixels, and a shadow never needs more detail than its caster
+        XMFLOAT3 scale = renderer->GetGameObject()->GetTransform()->GetScale();
+        float maxScale = std::max( scale.x, std::max( scale.y, scale.z ) );
+        size_t shadowLod = mesh->SelectLod( maxScale * shadowTexelsPerUnit, mesh->GetLods().size() - 1 );
+        shadowLod = std::max( shadowLod, renderer->GetLodIndex() );
 
         // Draw the mesh
-        DrawMesh( mesh, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+        DrawMesh( mesh, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, shadowLod );
     }
-
-    // Revert to original DX state
-    auto rtv = MyDemoGame::GetInstance()->GetRenderTargetView();
-    auto dsv = MyDemoGame::GetInstance()->GetDepthStencilView();
-    _deviceContext->OMSetRenderTargets( 1, &rtv, dsv );
-    _deviceContext->RSSetViewports( 1, &viewport );
-    _deviceState->Restore();
 }
 
 // Draw all text and line renderer
 void RenderManager::DrawTextAndLineRenderers()
 {
-    // Cache the current states and set our states
-    _deviceState->Cache();
-    _deviceContext->OMSetBlendState( _textBlendState.Get(), _textBlendFactor, 0xFFFFFFFF );
-    _deviceContext->OMSetDepthStencilState( _textDepthStencilState.Get(), 0xFFFFFFFF );
-    _deviceContext->RSSetState( _textRasterizerState.Get() );
+    // Describe the overlay pass: alpha blended, no depth, into the back buffer
+    RenderPassState overlayPass = _mainPassState;
+    overlayPass.BlendState = _textBlendState;
+    memcpy( overlayPass.BlendFactor, _textBlendFactor, sizeof( overlayPass.BlendFactor ) );
+    overlayPass.DepthStencilState = _textDepthStencilState;
+    overlayPass.StencilRef = 0xFFFFFFFF;
+    overlayPass.RasterizerState = _textRasterizerState;
+    _stateTracker->ApplyPassState( overlayPass );
+    _stateTracker->SetGeometryShader( nullptr );
 
 
 
@@ -232,99 +360,90 @@ void RenderManager::DrawTextAndLineRenderers()
 
 
 
-    // Now iterate over all of the text renderers
-    for ( auto& renderer : _textRenderers )
+    // Bring every text renderer's glyph quads up to date before anything is submitted, since loading
+    // a glyph can repack a font atlas and move glyphs that other text renderers already laid out
+    for ( int attempt = 0; attempt < 2; ++attempt )
     {
-        // Ensure we can render the text
-        if ( !renderer->IsEnabled() || !renderer->IsValid() )
+        bool hasRebuilt = false;
+        for ( auto& renderer : _textRenderers )
         {
-            continue;
-        }
-
-        // Get the text material and mesh
-        std::shared_ptr<Mesh> mesh = renderer->GetMesh();
-        if ( !mesh )
-        {
-            continue;
-        }
-        TextMaterial* material = renderer->GetGameObject()->GetComponent<TextMaterial>();
-        if ( !material )
-        {
-#if defined( _DEBUG ) || defined( DEBUG )
-            std::cout << renderer->GetGameObject()->GetName() << " has a TextRenderer, but not a TextMaterial" << std::endl;
-#endif
-            continue;
+            if ( renderer->IsEnabled() && renderer->IsValid() && renderer->NeedsRebuild() )
+            {
+                renderer->RebuildQuads();
+                hasRebuilt = true;
+            }
         }
-
-        // Get the world matrix
-        XMFLOAT4X4 world = material->GetGameObject()->GetTransform()->GetWorldMatrix();
-        XMStoreFloat4x4( &world, XMMatrixTranspose( XMLoadFloat4x4( &world ) ) );
-
-        // Get the font texture, send data to the shaders, and activate the material
-        std::shared_ptr<Texture2D> texture = renderer->GetFont()->GetTexture( renderer->GetFontSize() );
-        if ( texture )
+        if ( !hasRebuilt )
         {
-            assert( material->GetVertexShader()->SetMatrix4x4( "World", world ) );
-            assert( material->GetVertexShader()->SetMatrix4x4( "Projection", projection ) );
-            assert( material->GetPixelShader()->SetSamplerState( "TextSampler", _textSamplerState.Get() ) );
-            assert( material->GetPixelShader()->SetShaderResourceView( "TextTexture", texture->GetShaderResourceView() ) );
-            material->Activate();
-
-            // Draw the mesh
-            DrawMesh( mesh, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+            break;
         }
     }
 
-
-
-    // Now we need to draw the line renderers!
-    _deviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_LINELIST );
-    for ( auto& renderer : _lineRenderers )
+    // Now submit all of the text renderers to the batcher
+    _textBatcher->Begin();
+    for ( auto& renderer : _textRenderers )
     {
-        // Get the line renderer
-        if ( !renderer->IsEnabled() )
+        // Ensure we can render the text
+        if ( !renderer->IsEnabled() || !renderer->IsValid() )
         {
             continue;
         }
 
-        // Get the buffers and the material
-        ComPtr<ID3D11Buffer>& vertexBuffer = renderer->_vertexBuffer;
-        ComPtr<ID3D11Buffer>& indexBuffer  = renderer->_indexBuffer;
-        LineMaterial* material = renderer->GetGameObject()->GetComponent<LineMaterial>();
-
-        // Ensure we have a material
+        // Get the text material
+        TextMaterial* material = renderer->GetGameObject()->GetComponent<TextMaterial>();
         if ( !material )
         {
 #if defined( _DEBUG ) || defined( DEBUG )
-            std::cout << renderer->GetGameObject()->GetName() << " has a LineRenderer, but not a LineMaterial" << std::endl;
+            std::cout << renderer->GetGameObject()->GetName() << " has a TextRenderer, but not a TextMaterial" << std::endl;
 #endif
             continue;
         }
 
-        // Get the world matrix
-        XMFLOAT4X4 world;
-        XMStoreFloat4x4( &world, XMMatrixIdentity() );
+        // Queue the text's glyphs against its font atlas
+        std::shared_ptr<Texture2D> texture = renderer->GetFont()->GetTexture( renderer->GetFontSize() );
+        _textBatcher->Submit( renderer, texture.get(), material->GetTextColor(), renderer->GetFont()->IsDistanceField() );
+    }
 
-        // Set the world and projection matrices
-        assert( material->GetVertexShader()->SetMatrix4x4( "World", world ) );
-        assert( material->GetVertexShader()->SetMatrix4x4( "Projection", projection ) );
-        material->Activate();
+    // Draw all of the text with one draw per font atlas
+    _textBatcher->End( _stateTracker.get(), projection, _textSamplerState );
 
 
 
-        // Draw the buffers
-        const UINT stride = sizeof( LineVertex );
-        const UINT offset = 0;
+    // Now draw every screen-space line in one go
+    _lineBatcher->DrawScreenLines( _stateTracker.get(), projection );
+}
 
-        _deviceContext->IASetIndexBuffer( indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0 );
-        _deviceContext->IASetVertexBuffers( 0, 1, vertexBuffer.GetAddress(), &stride, &offset );
-        _deviceContext->DrawIndexed( 2, 0, 0 );
+// Draws all of this frame's world-space lines
+void RenderManager::DrawWorldLines()
+{
+    Camera* camera = Camera::GetActiveCamera();
+    if ( !camera )
+    {
+        return;
     }
 
+    // World lines are depth tested against the scene like everything else
+    _stateTracker->ApplyPassState( _mainPassState );
+    _stateTracker->SetGeometryShader( nullptr );
+    _lineBatcher->DrawWorldLines( _stateTracker.get(), camera->GetView(), camera->GetProjection() );
+}
 
+// Gets the frame graph
+FrameGraph* RenderManager::GetFrameGraph()
+{
+    return _frameGraph.get();
+}
 
-    // Restore the device's state
-    _deviceState->Restore();
+// Gets the line batcher
+LineBatcher* RenderManager::GetLineBatcher()
+{
+    return _lineBatcher.get();
+}
+
+// Gets the state tracker all rendering goes through
+StateTracker* RenderManager::GetStateTracker()
+{
+    return _stateTracker.get();
 }
 
 // Attempts to initialize the render manager
@@ -332,12 +451,13 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
 {
     _deviceContext = deviceContext;
 
-    // Try to create the device state
-    _deviceState = std::make_shared<DeviceState>( device, deviceContext );
+    // Try to create the state tracker, and have all shaders bind through it
+    _stateTracker = std::make_shared<StateTracker>( deviceContext );
     if ( !_deviceContext )
     {
         return false;
     }
+    ISimpleShader::SetStateTracker( _stateTracker.get() );
 
     /////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -355,7 +475,8 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     blendDesc.RenderTarget[ 0 ].SrcBlend = D3D11_BLEND_SRC_ALPHA;
     blendDesc.RenderTarget[ 0 ].SrcBlendAlpha = D3D11_BLEND_SRC_ALPHA;
 
-    if ( FAILED( device->CreateBlendState( &blendDesc, _textBlendState.GetAddress() ) ) )
+    _textBlendState = StateCache::GetBlendState( device, blendDesc );
+    if ( !_textBlendState )
     {
         return false;
     }
@@ -372,7 +493,8 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
     samplerDesc.MaxAnisotropy = 4;
 
-    if ( FAILED( device->CreateSamplerState( &samplerDesc, _textSamplerState.GetAddress() ) ) )
+    _textSamplerState = StateCache::GetSamplerState( device, samplerDesc );
+    if ( !_textSamplerState )
     {
         return false;
     }
@@ -397,7 +519,8 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     dsDesc.StencilReadMask = 0xFF;
     dsDesc.StencilWriteMask = 0xFF;
 
-    if ( FAILED( device->CreateDepthStencilState( &dsDesc, _textDepthStencilState.GetAddress() ) ) )
+    _textDepthStencilState = StateCache::GetDepthStencilState( device, dsDesc );
+    if ( !_textDepthStencilState )
     {
         return false;
     }
@@ -412,60 +535,31 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     rasterDesc.FillMode = D3D11_FILL_SOLID;
     rasterDesc.MultisampleEnable = true;
 
-    if ( FAILED( device->CreateRasterizerState( &rasterDesc, _textRasterizerState.GetAddress() ) ) )
+    _textRasterizerState = StateCache::GetRasterizerState( device, rasterDesc );
+    if ( !_textRasterizerState )
     {
         return false;
     }
 
-    #pragma endregion
-
-    /////////////////////////////////////////////////////////////////////////////////////////////////
-
-    #pragma region Shadow Initialization
-
-    D3D11_TEXTURE2D_DESC shadowMapDesc;
-    shadowMapDesc.Width = ShadowMapSize;
-    shadowMapDesc.Height = ShadowMapSize;
-    shadowMapDesc.ArraySize = 1;
-    shadowMapDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
-    shadowMapDesc.CPUAccessFlags = 0;
-    shadowMapDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-    shadowMapDesc.MipLevels = 1;
-    shadowMapDesc.MiscFlags = 0;
-    shadowMapDesc.SampleDesc.Count = 1;
-    shadowMapDesc.SampleDesc.Quality = 0;
-    shadowMapDesc.Usage = D3D11_USAGE_DEFAULT;
-    ID3D11Texture2D* shadowTexture;
-    if ( FAILED( device->CreateTexture2D( &shadowMapDesc, 0, &shadowTexture ) ) )
+    // Finally, create the text batcher
+    _textBatcher = TextBatcher::Create( device, deviceContext );
+    if ( !_textBatcher )
     {
         return false;
     }
 
-    // Create the depth/stencil view for the shadow map
-    D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
-    dsvDesc.Flags = 0;
-    dsvDesc.Format = DXGI_FORMAT_D32_FLOAT; // Gotta give it the D
-    dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-    dsvDesc.Texture2D.MipSlice = 0;
-    if ( FAILED( device->CreateDepthStencilView( shadowTexture, &dsvDesc, _shadowDSV.GetAddress() ) ) )
+    // The line batcher draws through the same overlay states
+    _lineBatcher = LineBatcher::Create( device, deviceContext );
+    if ( !_lineBatcher )
     {
         return false;
     }
 
-    // Create the SRV for the shadow map
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    if ( FAILED( device->CreateShaderResourceView( shadowTexture, &srvDesc, _shadowSRV.GetAddress() ) ) )
-    {
-        return false;
-    }
+    #pragma endregion
 
-    // Done with this texture ref
-    shadowTexture->Release();
-    shadowTexture = nullptr;
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+
+    #pragma region Shadow Initialization
 
     // Create a better sampler specifically for the shadow map
     D3D11_SAMPLER_DESC sampDesc = {};
@@ -478,7 +572,8 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     sampDesc.BorderColor[ 1 ] = 1.0f;
     sampDesc.BorderColor[ 2 ] = 1.0f;
     sampDesc.BorderColor[ 3 ] = 1.0f;
-    if ( FAILED( device->CreateSamplerState( &sampDesc, _shadowSampler.GetAddress() ) ) )
+    _shadowSampler = StateCache::GetSamplerState( device, sampDesc );
+    if ( !_shadowSampler )
     {
         return false;
     }
@@ -492,7 +587,8 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     shRastDesc.DepthBias = 1000; // Not world units - this gets multiplied by the "smallest possible value > 0 in depth buffer"
     shRastDesc.DepthBiasClamp = 0.0f;
     shRastDesc.SlopeScaledDepthBias = 1.0f;
-    if ( FAILED( device->CreateRasterizerState( &shRastDesc, _shadowRS.GetAddress() ) ) )
+    _shadowRS = StateCache::GetRasterizerState( device, shRastDesc );
+    if ( !_shadowRS )
     {
         return false;
     }
@@ -503,6 +599,11 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
     {
         return false;
     }
+    _compactShadowVS = std::make_shared<SimpleVertexShader>( device, deviceContext );
+    if ( !_compactShadowVS || !_compactShadowVS->LoadShaderFile( L"Shaders\\ShadowCompactVertexShader.cso" ) )
+    {
+        return false;
+    }
 
     // Create the shadow projection matrix
     XMMATRIX shProj = XMMatrixOrthographicLH(
@@ -516,6 +617,38 @@ bool RenderManager::Initialize( ID3D11Device* device, ID3D11DeviceContext* devic
 
     /////////////////////////////////////////////////////////////////////////////////////////////////
 
+    #pragma region Frame Graph Initialization
+
+    _frameGraph = FrameGraph::Create( device, deviceContext, _stateTracker.get() );
+    if ( !_frameGraph )
+    {
+        return false;
+    }
+
+    // The back buffer and its depth buffer belong to the game, and the back buffer is what every frame is for
+    _backBuffer = _frameGraph->ImportTexture( "BackBuffer", nullptr, nullptr, nullptr );
+    _sceneDepth = _frameGraph->ImportTexture( "SceneDepth", nullptr, nullptr, nullptr );
+    _frameGraph->SetOutput( _backBuffer, true );
+
+    // The shadow map only has to live from the shadow pass to the mesh pass
+    FrameTextureDesc shadowMapDesc;
+    shadowMapDesc.Width = static_cast<UINT>( ShadowMapSize );
+    shadowMapDesc.Height = static_cast<UINT>( ShadowMapSize );
+    shadowMapDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    _shadowMap = _frameGraph->CreateTexture( "ShadowMap", shadowMapDesc );
+
+    // The mesh pass is added before the shadow pass it reads from on purpose; the graph still runs the shadow pass first
+    std::vector<FrameResource> none;
+    _frameGraph->AddPass( "Meshes", { _shadowMap }, { _backBuffer, _sceneDepth }, []( FrameGraph& ) { DrawMeshRenderers(); } );
+    _frameGraph->AddPass( "Shadows", none, { _shadowMap }, []( FrameGraph& ) { DrawShadowMap(); } );
+    _frameGraph->AddPass( "Particles", { _sceneDepth }, { _backBuffer }, []( FrameGraph& ) { DrawParticleSystems(); } );
+    _frameGraph->AddPass( "WorldLines", { _sceneDepth }, { _backBuffer }, []( FrameGraph& ) { DrawWorldLines(); } );
+    _frameGraph->AddPass( "Overlay", none, { _backBuffer }, []( FrameGraph& ) { DrawTextAndLineRenderers(); } );
+
+    #pragma endregion
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+
     return true;
 }
 
@@ -3,11 +3,15 @@
 #include "Cache.hpp"
 #include "ComPtr.hpp"
 #include "DirectX.hpp"
-#include "DeviceState.hpp"
+#include "FrameGraph.hpp"
+#include "LineBatcher.hpp"
 #include "LineRenderer.hpp"
 #include "MeshRenderer.hpp"
+#include "ParticleManager.hpp"
+#include "TextureStreamer.hpp"
 #include "TextRenderer.hpp"
-#include "ParticleSystem.h"
+#include "StateTracker.hpp"
+#include "TextBatcher.hpp"
 #include <unordered_map>
 #include <vector>
 
@@ -19,39 +23,60 @@ class RenderManager
     ImplementStaticClass( RenderManager );
 
 private:
+    /// <summary>
+    /// Defines a mesh renderer waiting in the render queue.
+    /// </summary>
+    struct QueuedDraw
+    {
+        UINT64 PipelineKey;
+        UINT64 SortKey;
+        const Mesh* DrawnMesh;
+        MeshRenderer* Renderer;
+    };
+
     static const int ShadowMapSize;
 
     static DirectX::XMFLOAT4X4              _shadowView;
     static DirectX::XMFLOAT4X4              _shadowProj;
     static Cache<LineRenderer*>             _lineRenderers;
+    static std::shared_ptr<LineBatcher>     _lineBatcher;
     static Cache<MeshRenderer*>             _meshRenderers;
     static Cache<TextRenderer*>             _textRenderers;
-    static Cache<ParticleSystem*>            _particleSystems;
     static std::shared_ptr<SimpleVertexShader> _shadowVS;
-    static ComPtr<ID3D11DepthStencilView>   _shadowDSV;
-    static ComPtr<ID3D11ShaderResourceView> _shadowSRV;
-    static ComPtr<ID3D11SamplerState>       _shadowSampler;
-    static ComPtr<ID3D11RasterizerState>    _shadowRS;
+    static std::shared_ptr<SimpleVertexShader> _compactShadowVS;
+    static std::shared_ptr<FrameGraph>      _frameGraph;
+    static FrameResource                    _backBuffer;
+    static FrameResource                    _sceneDepth;
+    static FrameResource                    _shadowMap;
+    static ID3D11SamplerState*              _shadowSampler;
+    static ID3D11RasterizerState*           _shadowRS;
     static const float                      _textBlendFactor[ 4 ];
-    static std::shared_ptr<DeviceState>     _deviceState;
-    static ComPtr<ID3D11BlendState>         _textBlendState;
-    static ComPtr<ID3D11SamplerState>       _textSamplerState;
-    static ComPtr<ID3D11DepthStencilState>  _textDepthStencilState;
-    static ComPtr<ID3D11RasterizerState>    _textRasterizerState;
+    static std::shared_ptr<StateTracker>    _stateTracker;
+    static std::shared_ptr<TextBatcher>     _textBatcher;
+    static ID3D11BlendState*                _textBlendState;
+    static ID3D11SamplerState*              _textSamplerState;
+    static ID3D11DepthStencilState*         _textDepthStencilState;
+    static ID3D11RasterizerState*           _textRasterizerState;
+    static std::vector<QueuedDraw>          _drawQueue;
     static ID3D11DeviceContext*             _deviceContext;
+    static RenderPassState                  _mainPassState;
 
     /// <summary>
     /// Draws the given mesh.
     /// </summary>
     /// <param name="mesh">The mesh.</param>
     /// <param name="topology">The topology to draw the mesh as.</param>
-    static void DrawMesh( std::shared_ptr<Mesh> mesh, D3D11_PRIMITIVE_TOPOLOGY topology );
+    /// <param name="lodIndex">The level of detail to draw.</param>
+    static void DrawMesh( std::shared_ptr<Mesh> mesh, D3D11_PRIMITIVE_TOPOLOGY topology, size_t lodIndex );
 
     /// <summary>
     /// Draws all of the mesh renderers.
     /// </summary>
     static void DrawMeshRenderers();
 
+    /// <summary>
+    /// Draws all of the particle systems.
+    /// </summary>
     static void DrawParticleSystems();
 
     /// <summary>
@@ -59,6 +84,11 @@ private:
     /// </summary>
     static void DrawShadowMap();
 
+    /// <summary>
+    /// Draws all of this frame's world-space lines.
+    /// </summary>
+    static void DrawWorldLines();
+
     /// <summary>
     /// Draws all of the text and line renderers.
     /// </summary>
@@ -83,13 +113,27 @@ public:
     /// <param name="renderer">The text renderer.</param>
     static void AddTextRenderer( TextRenderer* renderer );
 
-    static void AddParticleSystem( ParticleSystem* ps ) { _particleSystems.Add( ps ); }
-
     /// <summary>
-    /// Draws all of the renderers.
+    /// Draws all of the renderers by executing the frame graph.
     /// </summary>
     static void Draw();
 
+    /// <summary>
+    /// Gets the frame graph every pass is scheduled through. Passes can be added to it or disabled at
+    /// any time, and can find the built-in textures by name: "BackBuffer", "SceneDepth" and "ShadowMap".
+    /// </summary>
+    static FrameGraph* GetFrameGraph();
+
+    /// <summary>
+    /// Gets the line batcher, which anything can add lines to during a frame.
+    /// </summary>
+    static LineBatcher* GetLineBatcher();
+
+    /// <summary>
+    /// Gets the state tracker all rendering goes through.
+    /// </summary>
+    static StateTracker* GetStateTracker();
+
     /// <summary>
     /// Attempts to initialize the render manager.
     /// </summary>
@@ -115,8 +159,6 @@ public:
     /// <param name="renderer">The text renderer.</param>
     static void RemoveTextRenderer( TextRenderer* renderer );
 
-    static void RemoveParticleSystem( ParticleSystem* ps ) { _particleSystems.Remove( ps ); }
-
     /// <summary>
     /// Sets the directional light's direction.
     /// </summary>
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Defines a cache of loaded resources of one type. Resources are keyed by a hash of their
+/// contents, so the same file loaded through different paths is only ever resident once. Once
+/// the cache is over its memory budget, the resources nothing else holds on to are evicted,
+/// least recently used first. The resource type must have a GetMemorySize() method.
+/// </summary>
+template<typename T> class ResourceCache
+{
+    ImplementNonCopyableClass( ResourceCache );
+    ImplementNonMovableClass( ResourceCache );
+
+    /// <summary>
+    /// Defines a cached resource.
+    /// </summary>
+    struct Entry
+    {
+        std::shared_ptr<T> Resource;
+        unsigned int LastUsedFrame;
+    };
+
+    std::unordered_map<std::string, UINT64> _paths;
+    std::unordered_map<UINT64, Entry> _entries;
+    size_t _budget;
+    size_t _evictedCount;
+    unsigned int _frame;
+
+    /// <summary>
+    /// Evicts a resource and forgets every path that led to it.
+    /// </summary>
+    /// <param name="hash">The hash of the resource's contents.</param>
+    void Evict( UINT64 hash );
+
+public:
+    /// <summary>
+    /// Creates a new resource cache.
+    /// </summary>
+    /// <param name="budget">The memory budget, in bytes.</param>
+    ResourceCache( size_t budget );
+
+    /// <summary>
+    /// Destroys this resource cache.
+    /// </summary>
+    ~ResourceCache() = default;
+
+    /// <summary>
+    /// Adds a newly loaded resource to this cache. If a resource with the same contents was
+    /// added in the meantime, that one is kept and returned instead.
+    /// </summary>
+    /// <param name="path">The path the resource was loaded from.</param>
+    /// <param name="hash">The hash of the resource's contents.</param>
+    /// <param name="resource">The resource.</param>
+    std::shared_ptr<T> Add( const std::string& path, UINT64 hash, std::shared_ptr<T> resource );
+
+    /// <summary>
+    /// Forgets every resource in this cache.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Finds the resource loaded from the given path.
+    /// </summary>
+    /// <param name="path">The path.</param>
+    /// <returns>The resource, or null if it hasn't been loaded.</returns>
+    std::shared_ptr<T> Find( const std::string& path );
+
+    /// <summary>
+    /// Finds a resource by its contents, and remembers the given path as another way to reach it.
+    /// </summary>
+    /// <param name="path">The path the resource is being loaded from.</param>
+    /// <param name="hash">The hash of the resource's contents.</param>
+    /// <returns>The resource, or null if nothing with the same contents has been loaded.</returns>
+    std::shared_ptr<T> FindContent( const std::string& path, UINT64 hash );
+
+    /// <summary>
+    /// Gets the memory budget, in bytes.
+    /// </summary>
+    size_t GetBudget() const;
+
+    /// <summary>
+    /// Gets the number of bytes the cached resources use.
+    /// </summary>
+    size_t GetBytes() const;
+
+    /// <summary>
+    /// Gets the number of cached resources.
+    /// </summary>
+    size_t GetCount() const;
+
+    /// <summary>
+    /// Gets the number of resources that have been evicted so far.
+    /// </summary>
+    size_t GetEvictedCount() const;
+
+    /// <summary>
+    /// Gets the number of paths that lead to the cached resources.
+    /// </summary>
+    size_t GetPathCount() const;
+
+    /// <summary>
+    /// Gets the number of cached resources that something other than the cache holds on to.
+    /// </summary>
+    size_t GetReferencedCount() const;
+
+    /// <summary>
+    /// Sets the memory budget.
+    /// </summary>
+    /// <param name="bytes">The budget, in bytes.</param>
+    void SetBudget( size_t bytes );
+
+    /// <summary>
+    /// Marks every resource that is still held on to as used this frame, then evicts unused
+    /// resources, least recently used first, until the cache is back under its budget.
+    /// </summary>
+    void Update();
+};
+
+#include "ResourceCache.inl"
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+
+// Creates a new resource cache
+template<typename T> ResourceCache<T>::ResourceCache( size_t budget )
+    : _budget( budget )
+    , _evictedCount( 0 )
+    , _frame( 0 )
+{
+}
+
+// Adds a newly loaded resource to this cache
+template<typename T> std::shared_ptr<T> ResourceCache<T>::Add( const std::string& path, UINT64 hash, std::shared_ptr<T> resource )
+{
+    _paths[ path ] = hash;
+
+    auto search = _entries.find( hash );
+    if ( search != _entries.end() )
+    {
+        search->second.LastUsedFrame = _frame;
+        return search->second.Resource;
+    }
+
+    Entry entry;
+    entry.Resource = resource;
+    entry.LastUsedFrame = _frame;
+    _entries[ hash ] = entry;
+    return resource;
+}
+
+// Forgets every resource in this cache
+template<typename T> void ResourceCache<T>::Clear()
+{
+    _paths.clear();
+    _entries.clear();
+}
+
+// Evicts a resource and forgets every path that led to it
+template<typename T> void ResourceCache<T>::Evict( UINT64 hash )
+{
+    for ( auto path = _paths.begin(); path != _paths.end(); )
+    {
+        if ( path->second == hash )
+        {
+            path = _paths.erase( path );
+        }
+        else
+        {
+            ++path;
+        }
+    }
+
+    _entries.erase( hash );
+    ++_evictedCount;
+}
+
+// Finds the resource loaded from the given path
+template<typename T> std::shared_ptr<T> ResourceCache<T>::Find( const std::string& path )
+{
+    auto search = _paths.find( path );
+    if ( search == _paths.end() )
+    {
+        return nullptr;
+    }
+
+    Entry& entry = _entries[ search->second ];
+    entry.LastUsedFrame = _frame;
+    return entry.Resource;
+}
+
+// Finds a resource by its contents
+template<typename T> std::shared_ptr<T> ResourceCache<T>::FindContent( const std::string& path, UINT64 hash )
+{
+    auto search = _entries.find( hash );
+    if ( search == _entries.end() )
+    {
+        return nullptr;
+    }
+
+    _paths[ path ] = hash;
+    search->second.LastUsedFrame = _frame;
+    return search->second.Resource;
+}
+
+// Gets the memory budget
+template<typename T> size_t ResourceCache<T>::GetBudget() const
+{
+    return _budget;
+}
+
+// Gets the number of bytes the cached resources use
+template<typename T> size_t ResourceCache<T>::GetBytes() const
+{
+    size_t bytes = 0;
+    for ( auto& entry : _entries )
+    {
+        bytes += entry.second.Resource->GetMemorySize();
+    }
+    return bytes;
+}
+
+// Gets the number of cached resources
+template<typename T> size_t ResourceCache<T>::GetCount() const
+{
+    return _entries.size();
+}
+
+// Gets the number of resources evicted so far
+template<typename T> size_t ResourceCache<T>::GetEvictedCount() const
+{
+    return _evictedCount;
+}
+
+// Gets the number of paths that lead to the cached resources
+template<typename T> size_t ResourceCache<T>::GetPathCount() const
+{
+    return _paths.size();
+}
+
+// Gets the number of cached resources that are held on to elsewhere
+template<typename T> size_t ResourceCache<T>::GetReferencedCount() const
+{
+    size_t count = 0;
+    for ( auto& entry : _entries )
+    {
+        if ( entry.second.Resource.use_count() > 1 )
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Sets the memory budget
+template<typename T> void ResourceCache<T>::SetBudget( size_t bytes )
+{
+    _budget = bytes;
+}
+
+// Evicts unused resources until this cache is under its budget
+template<typename T> void ResourceCache<T>::Update()
+{
+    ++_frame;
+
+    // Anything a renderer, material or collider still holds counts as used, whether or not it was drawn
+    size_t bytes = 0;
+    std::vector<std::pair<unsigned int, UINT64>> unused;
+    for ( auto& entry : _entries )
+    {
+        if ( entry.second.Resource.use_count() > 1 )
+        {
+            entry.second.LastUsedFrame = _frame;
+        }
+        else
+        {
+            unused.push_back( std::make_pair( entry.second.LastUsedFrame, entry.first ) );
+        }
+        bytes += entry.second.Resource->GetMemorySize();
+    }
+    if ( bytes <= _budget || unused.empty() )
+    {
+        return;
+    }
+
+    // Only the cache holds on to these, so dropping them frees them straight away
+    std::sort( unused.begin(), unused.end() );
+    for ( size_t index = 0; index < unused.size() && bytes > _budget; ++index )
+    {
+        bytes -= _entries[ unused[ index ].second ].Resource->GetMemorySize();
+        Evict( unused[ index ].second );
+    }
+}
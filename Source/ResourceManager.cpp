@@ -0,0 +1,92 @@
+#include "ResourceManager.hpp"
+#include "DefaultMaterial.hpp"
+#include "LightManager.hpp"
+#include "OcclusionCuller.hpp"
+#include "RenderManager.hpp"
+#include "ShaderCache.hpp"
+#include "StateCache.hpp"
+#include <iomanip>
+#include <sstream>
+
+const size_t                ResourceManager::DefaultMeshBudget = 128 * 1024 * 1024;
+const size_t                ResourceManager::DefaultTextureBudget = 512 * 1024 * 1024;
+ResourceCache<Mesh>         ResourceManager::_meshes( ResourceManager::DefaultMeshBudget );
+ResourceCache<Texture2D>    ResourceManager::_textures( ResourceManager::DefaultTextureBudget );
+
+// Writes one line of the resource report
+template<typename T> static void ReportCache( std::ostringstream& report, const char* name, const ResourceCache<T>& cache )
+{
+    const double megabyte = 1024.0 * 1024.0;
+    report << "  " << name << ": " << cache.GetCount() << " loaded (" << cache.GetReferencedCount() << " in use, "
+           << cache.GetPathCount() << " paths), " << ( cache.GetBytes() / megabyte ) << " of "
+           << ( cache.GetBudget() / megabyte ) << " MB, " << cache.GetEvictedCount() << " evicted" << std::endl;
+}
+
+// Forgets every cached resource
+void ResourceManager::Clear()
+{
+    _meshes.Clear();
+    _textures.Clear();
+}
+
+// Gets the memory budget for a type of resource
+size_t ResourceManager::GetBudget( ResourceType type )
+{
+    return ( type == ResourceType::Mesh ) ? _meshes.GetBudget() : _textures.GetBudget();
+}
+
+// Gets the mesh cache
+ResourceCache<Mesh>& ResourceManager::GetMeshes()
+{
+    return _meshes;
+}
+
+// Builds a report of the loaded resources
+std::string ResourceManager::GetReport()
+{
+    std::ostringstream report;
+    report << "Resources:" << std::endl << std::fixed << std::setprecision( 2 );
+    ReportCache( report, "Meshes", _meshes );
+    ReportCache( report, "Textures", _textures );
+    report << "  Shaders: " << ShaderCache::GetCount() << " loaded, " << ShaderCache::GetHitCount() << " loads shared" << std::endl;
+    report << "  States: " << StateCache::GetCount() << " created, " << StateCache::GetHitCount() << " requests shared" << std::endl;
+    report << "  Material parameter blocks: " << DefaultMaterial::GetParameterBlockCount() << " in use" << std::endl;
+    report << "  Lights: " << LightManager::GetLightCount() << " binned, " << LightManager::GetLightIndexCount() << " of "
+           << LightManager::MaxLightIndices << " cluster indices used" << std::endl;
+    report << "  Occlusion culling: " << ( OcclusionCuller::IsEnabled() ? "on, " : "off, " ) << OcclusionCuller::GetCulledCount()
+           << " of " << OcclusionCuller::GetTestedCount() << " meshes hidden last frame" << std::endl;
+    FrameGraph* frameGraph = RenderManager::GetFrameGraph();
+    if ( frameGraph )
+    {
+        report << "  Frame graph: " << frameGraph->GetExecutedPassCount() << " of " << frameGraph->GetPassCount() << " passes run, "
+               << frameGraph->GetCulledPassCount() << " culled, " << ( frameGraph->GetTransientMemorySize() / ( 1024.0 * 1024.0 ) )
+               << " MB of transient textures" << std::endl;
+    }
+    return report.str();
+}
+
+// Gets the texture cache
+ResourceCache<Texture2D>& ResourceManager::GetTextures()
+{
+    return _textures;
+}
+
+// Sets the memory budget for a type of resource
+void ResourceManager::SetBudget( ResourceType type, size_t bytes )
+{
+    if ( type == ResourceType::Mesh )
+    {
+        _meshes.SetBudget( bytes );
+    }
+    else
+    {
+        _textures.SetBudget( bytes );
+    }
+}
+
+// Evicts resources that are over budget
+void ResourceManager::Update()
+{
+    _meshes.Update();
+    _textures.Update();
+}
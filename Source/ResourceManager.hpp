@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Config.hpp"
+#include "Mesh.hpp"
+#include "ResourceCache.hpp"
+#include "Texture2D.hpp"
+#include <string>
+
+/// <summary>
+/// An enumeration of the types of resources the resource manager keeps.
+/// </summary>
+enum class ResourceType
+{
+    Mesh,
+    Texture
+};
+
+/// <summary>
+/// Defines the static resource manager. Every mesh and texture loaded from a file is kept in one
+/// of its caches, each with its own memory budget, so that loaded resources can be shared,
+/// accounted for and evicted once nothing uses them any more.
+/// </summary>
+class ResourceManager
+{
+    ImplementStaticClass( ResourceManager );
+
+    static const size_t DefaultMeshBudget;
+    static const size_t DefaultTextureBudget;
+
+    static ResourceCache<Mesh>      _meshes;
+    static ResourceCache<Texture2D> _textures;
+
+public:
+    /// <summary>
+    /// Forgets every cached resource. Resources still in use elsewhere live on until they're released.
+    /// </summary>
+    static void Clear();
+
+    /// <summary>
+    /// Gets the memory budget for a type of resource, in bytes.
+    /// </summary>
+    /// <param name="type">The type of resource.</param>
+    static size_t GetBudget( ResourceType type );
+
+    /// <summary>
+    /// Gets the mesh cache.
+    /// </summary>
+    static ResourceCache<Mesh>& GetMeshes();
+
+    /// <summary>
+    /// Gets the texture cache.
+    /// </summary>
+    static ResourceCache<Texture2D>& GetTextures();
+
+    /// <summary>
+    /// Builds a report of how many resources of each type are loaded and how much memory they use,
+    /// along with how many shaders and pipeline states are loaded and how often they've been shared,
+    /// and how many material parameter blocks the default materials share.
+    /// </summary>
+    static std::string GetReport();
+
+    /// <summary>
+    /// Sets the memory budget for a type of resource.
+    /// </summary>
+    /// <param name="type">The type of resource.</param>
+    /// <param name="bytes">The budget, in bytes.</param>
+    static void SetBudget( ResourceType type, size_t bytes );
+
+    /// <summary>
+    /// Evicts the least recently used resources of any type that's over its budget. Should be called once per frame.
+    /// </summary>
+    static void Update();
+};
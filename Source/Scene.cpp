@@ -1,5 +1,6 @@
 #include "Scene.hpp"
 #include "Components.hpp"
+#include "FontManager.hpp"
 #include "MeshLoader.hpp"
 #include "MeshRenderer.hpp"
 #include "Shaders\DirectionalLight.hpp"
@@ -129,6 +130,9 @@ static DirectionalLight ParseDirectionalLight( json::Object& object )
 static PointLight ParsePointLight( json::Object& object )
 {
     PointLight light;
+    light.DiffuseColor = XMFLOAT4( 1.0f, 1.0f, 1.0f, 1.0f );
+    light.Position = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    light.Range = 10.0f;
     for ( auto iter = object.begin(); iter != object.end(); ++iter )
     {
         if ( "DiffuseColor" == iter->first )
@@ -139,10 +143,28 @@ static PointLight ParsePointLight( json::Object& object )
         {
             light.Position = ParseFloat3( iter->second );
         }
+        else if ( "Range" == iter->first )
+        {
+            light.Range = iter->second.ToFloat();
+        }
     }
     return light;
 }
 
+// Parses a JSON object into a light
+static void ParseLight( Light* value, json::Object& object )
+{
+    if ( !value )
+    {
+        return;
+    }
+
+    // The light's position comes from its transform
+    PointLight light = ParsePointLight( object );
+    value->SetDiffuseColor( light.DiffuseColor );
+    value->SetRange( light.Range );
+}
+
 // Parses a JSON object into a default material
 static void ParseDefaultMaterial( DefaultMaterial* value, json::Object& object )
 {
@@ -183,6 +205,32 @@ static void ParseTextMaterial( TextMaterial* value, json::Object& object )
     }
 }
 
+// Gathers the names of the meshes used by every mesh renderer in a scene root
+static void GatherMeshNames( json::Object& root, std::vector<std::string>& meshNames )
+{
+    for ( auto object = root.begin(); object != root.end(); ++object )
+    {
+        if ( object->second.GetType() != json::ValueType::ObjectVal )
+        {
+            continue;
+        }
+
+        json::Object components = object->second.ToObject();
+        auto renderer = components.find( "MeshRenderer" );
+        if ( renderer == components.end() || renderer->second.GetType() != json::ValueType::ObjectVal )
+        {
+            continue;
+        }
+
+        json::Object properties = renderer->second.ToObject();
+        auto mesh = properties.find( "Mesh" );
+        if ( mesh != properties.end() && mesh->second.GetType() == json::ValueType::StringVal )
+        {
+            meshNames.push_back( mesh->second.ToString() );
+        }
+    }
+}
+
 // Parses a JSON object into a mesh renderer
 static void ParseMeshRenderer( MeshRenderer* value, json::Object& object )
 {
@@ -234,6 +282,10 @@ static void ParseMeshRenderer( MeshRenderer* value, json::Object& object )
                 std::cout << "Unknown material '" << materialName << "' in " << value->GetGameObject()->GetName() << "'s MeshRenderer." << std::endl;
             }
         }
+        else if ( "Occluder" == iter->first )
+        {
+            value->SetOccluder( iter->second.ToBool() );
+        }
         else
         {
             std::cout << "Unknown value '" << iter->first << "' in "
@@ -249,18 +301,12 @@ static void ParseTextRenderer( TextRenderer* value, json::Object& object )
     {
         if ( "Font" == iter->first )
         {
-            // Load the font
-            ID3D11Device* device = value->GetGameObject()->GetDevice();
-            ID3D11DeviceContext* deviceContext = value->GetGameObject()->GetDeviceContext();
-            std::shared_ptr<Font> font = std::make_shared<Font>( device, deviceContext );
-
-            // If we created the font and the specified if a string
-            if ( font && iter->second.GetType() == json::StringVal )
+            // Get the font from the font manager (every text object using the same file shares one font)
+            if ( iter->second.GetType() == json::StringVal )
             {
-                // Only set the font if we can load the file
-                if ( font->LoadFromFile( iter->second.ToString() ) )
+                std::shared_ptr<Font> font = FontManager::GetFont( iter->second.ToString() );
+                if ( font )
                 {
-                    std::cout << "Loaded font " << font->GetFontName() << " at " << font->GetCurrentSize() << "px" << std::endl;
                     value->SetFont( font );
                 }
             }
@@ -512,6 +558,7 @@ bool Scene::ParseComponent( std::shared_ptr<GameObject>& go, const std::string&
     else if ( "TweenPosition"   == name ) ParserTweener( go->AddComponent<TweenPosition>(), object );
     else if ( "TweenScale"      == name ) ParserTweener( go->AddComponent<TweenScale>(), object );
     else if ( "Camera"			== name ) ParseCamera(go->AddComponent<Camera>(), object);
+    else if ( "Light"           == name ) ParseLight( go->AddComponent<Light>(), object );
     else
     {
         std::cout << "Unknown component '" << name << "' in '" << go->GetName() << "'." << std::endl;
@@ -566,6 +613,11 @@ bool Scene::ParseSceneRoot( json::Object& root )
     timer.Start();
 #endif
 
+    // Load every mesh the scene uses up front as one batch, so they're ready by the time their renderers are parsed
+    std::vector<std::string> meshNames;
+    GatherMeshNames( root, meshNames );
+    MeshLoader::LoadBatch( meshNames, _device, _deviceContext );
+
     // Basically we just parse all of the objects in the root as game objects
     for ( auto iter = root.begin(); iter != root.end(); ++iter )
     {
@@ -0,0 +1,42 @@
+#include "ShaderCache.hpp"
+
+std::unordered_map<std::wstring, std::shared_ptr<SimpleShaderProgram>>  ShaderCache::_programs;
+size_t                                                                  ShaderCache::_hitCount = 0;
+
+// Adds a program to the cache
+void ShaderCache::Add( const std::wstring& key, std::shared_ptr<SimpleShaderProgram> program )
+{
+    _programs[ key ] = program;
+}
+
+// Forgets every cached program
+void ShaderCache::Clear()
+{
+    _programs.clear();
+    _hitCount = 0;
+}
+
+// Finds a cached program
+std::shared_ptr<SimpleShaderProgram> ShaderCache::Find( const std::wstring& key )
+{
+    auto search = _programs.find( key );
+    if ( search == _programs.end() )
+    {
+        return nullptr;
+    }
+
+    ++_hitCount;
+    return search->second;
+}
+
+// Gets the number of cached programs
+size_t ShaderCache::GetCount()
+{
+    return _programs.size();
+}
+
+// Gets the number of loads served from the cache
+size_t ShaderCache::GetHitCount()
+{
+    return _hitCount;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Config.hpp"
+#include "SimpleShader.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Defines the static shader cache. Compiled shaders are read, created and reflected once per file
+/// and permutation, and the resulting program is shared by every shader object that loads the same
+/// file afterwards, so creating another material never has to touch the disk.
+/// </summary>
+class ShaderCache
+{
+    ImplementStaticClass( ShaderCache );
+
+    static std::unordered_map<std::wstring, std::shared_ptr<SimpleShaderProgram>> _programs;
+    static size_t _hitCount;
+
+public:
+    /// <summary>
+    /// Adds a newly created program to the cache.
+    /// </summary>
+    /// <param name="key">The shader file and permutation the program was created from.</param>
+    /// <param name="program">The program.</param>
+    static void Add( const std::wstring& key, std::shared_ptr<SimpleShaderProgram> program );
+
+    /// <summary>
+    /// Forgets every cached program. Shaders still using a program keep it alive until they're destroyed.
+    /// </summary>
+    static void Clear();
+
+    /// <summary>
+    /// Finds the program created from the given shader file and permutation.
+    /// </summary>
+    /// <param name="key">The shader file and permutation.</param>
+    /// <returns>The program, or null if it hasn't been created yet.</returns>
+    static std::shared_ptr<SimpleShaderProgram> Find( const std::wstring& key );
+
+    /// <summary>
+    /// Gets the number of cached programs.
+    /// </summary>
+    static size_t GetCount();
+
+    /// <summary>
+    /// Gets the number of shader loads that were served from the cache.
+    /// </summary>
+    static size_t GetHitCount();
+};
@@ -0,0 +1,55 @@
+/// <summary>
+/// Our constant buffer for decoding compact vertex positions.
+/// </summary>
+cbuffer CompactVertexBounds : register( b1 )
+{
+    float3 PositionOffset;
+    float3 PositionScale;
+};
+
+/// <summary>
+/// Defines the information that is passed from the program to the vertex shader for compact vertices.
+/// </summary>
+struct CompactProgramToVertex
+{
+    uint2 Position      : POSITION;
+    uint  UV            : TEXCOORD;
+    uint  Normal        : NORMAL;
+    uint  Tangent       : TANGENT;
+};
+
+/// <summary>
+/// Decodes a position quantized to 16 bits per axis within the mesh's bounds.
+/// </summary>
+/// <param name="position">The packed position.</param>
+float3 DecodePosition( uint2 position )
+{
+    float3 normalized = float3( position.x & 0xFFFF, position.x >> 16, position.y & 0xFFFF ) / 65535.0;
+    return PositionOffset + normalized * PositionScale;
+}
+
+/// <summary>
+/// Decodes a pair of half floats.
+/// </summary>
+/// <param name="value">The packed halves.</param>
+float2 DecodeHalf2( uint value )
+{
+    return float2( f16tof32( value ), f16tof32( value >> 16 ) );
+}
+
+/// <summary>
+/// Decodes a unit vector that was octahedral encoded into two 16-bit signed normalized values.
+/// </summary>
+/// <param name="value">The packed vector.</param>
+float3 DecodeOctahedral( uint value )
+{
+    int2 components = int2( asint( value << 16 ), asint( value ) ) >> 16;
+    float2 encoded = max( components / 32767.0, -1.0 );
+
+    // Unfold the lower half of the octahedron
+    float3 direction = float3( encoded, 1.0 - abs( encoded.x ) - abs( encoded.y ) );
+    float fold = saturate( -direction.z );
+    direction.xy += ( direction.xy >= 0.0 ) ? -fold : fold;
+
+    return normalize( direction );
+}
@@ -0,0 +1,39 @@
+#include "DefaultShaderCommon.hlsli"
+#include "CompactVertexCommon.hlsli"
+
+/// <summary>
+/// The entry point for the compact vertex shader.
+/// </summary>
+/// <param name="input">The compact vertex shader input data from the program.</param>
+VertexToPixel main( CompactProgramToVertex input )
+{
+    // Set up output data
+    VertexToPixel output;
+
+    // Unpack the vertex
+    float3 position = DecodePosition( input.Position );
+    float3 normal = DecodeOctahedral( input.Normal );
+    float3 tangent = DecodeOctahedral( input.Tangent );
+
+    // Calculate the WVP matrix
+    matrix worldViewProj = mul( mul( World, View ), Projection );
+
+    // Transform the world position
+    output.Position = mul( float4( position, 1.0 ), worldViewProj );
+
+    // Calculate the normal and tangent
+    output.Normal = mul( normal, (float3x3)World );
+    output.Tangent = mul( tangent, (float3x3)World );
+
+    // Calculate the world space position of the position
+    output.WorldPosition = mul( float4( position, 1.0 ), World ).xyz;
+
+    // Pass the UV through
+    output.UV = DecodeHalf2( input.UV );
+
+    // Calculate output position in relation to the light
+    matrix shadowWVP = mul( mul( World, ShadowView ), ShadowProjection );
+    output.ShadowPosition = mul( float4( position, 1.0f ), shadowWVP );
+
+    return output;
+}
@@ -6,6 +6,19 @@ Texture2D    ShadowMap      : register( t2 );
 SamplerState TextureSampler : register( s0 );
 SamplerComparisonState ShadowSampler : register( s1 );
 
+StructuredBuffer<PointLight> PointLights   : register( t3 );
+StructuredBuffer<uint2>      LightClusters : register( t4 );   // The start and count of each cluster's light indices
+StructuredBuffer<uint>       LightIndices  : register( t5 );
+
+/// <summary>
+/// Our constant buffer for finding which light cluster a pixel is in.
+/// </summary>
+cbuffer LightClusterInfo : register( b4 )
+{
+    float4 ClusterScale;    // Clusters per pixel across and down, then the depth slice scale and bias
+    uint4  ClusterCount;    // Clusters across, down and deep, then the number of point lights
+};
+
 /// <summary>
 /// Gets the color to be applied from a directional light.
 /// </summary>
@@ -17,6 +30,44 @@ float4 GetDirectionalLightColor( DirectionalLight light, float3 normal )
     return light.DiffuseColor * lightAmount;
 }
 
+/// <summary>
+/// Gets the color to be applied from a point light.
+/// </summary>
+/// <param name="light">The light.</param>
+/// <param name="position">The world position being lit.</param>
+/// <param name="normal">The normal.</param>
+float4 GetPointLightColor( PointLight light, float3 position, float3 normal )
+{
+    float3 toLight     = light.Position - position;
+    float  distance    = length( toLight );
+    float  falloff     = saturate( 1.0 - distance / light.Range );
+    float  lightAmount = saturate( dot( normal, toLight / max( distance, 0.0001 ) ) );
+    return light.DiffuseColor * lightAmount * falloff * falloff;
+}
+
+/// <summary>
+/// Gets the color to be applied from every point light in a pixel's cluster.
+/// </summary>
+/// <param name="screenPosition">The pixel's position on screen, with its view depth in w.</param>
+/// <param name="position">The world position being lit.</param>
+/// <param name="normal">The normal.</param>
+float4 GetClusterLightColor( float4 screenPosition, float3 position, float3 normal )
+{
+    // Depth slices are spaced exponentially, so the slice comes from the log of the view depth
+    uint3 cluster;
+    cluster.xy = uint2( screenPosition.xy * ClusterScale.xy );
+    cluster.z  = uint( max( log( screenPosition.w ) * ClusterScale.z + ClusterScale.w, 0.0 ) );
+    cluster    = min( cluster, ClusterCount.xyz - 1 );
+
+    uint2  lights = LightClusters[ ( cluster.z * ClusterCount.y + cluster.y ) * ClusterCount.x + cluster.x ];
+    float4 color  = float4( 0, 0, 0, 0 );
+    for ( uint index = 0; index < lights.y; ++index )
+    {
+        color += GetPointLightColor( PointLights[ LightIndices[ lights.x + index ] ], position, normal );
+    }
+    return color;
+}
+
 /// <summary>
 /// Gets the normal from the normal map.
 /// </summary>
@@ -25,8 +76,10 @@ float4 GetDirectionalLightColor( DirectionalLight light, float3 normal )
 /// <param name="uv">The UV coordinates.</param>
 float3 GetNormalFromMap( float2 uv, float3 normal, float3 tangent )
 {
-    // Get the normal from the map
-    float3 fromMap = NormalMap.Sample( TextureSampler, uv ).rgb * 2.0 - 1.0;
+    // Get the normal from the map. Cooked normal maps are BC5 and only store X and Y, so Z is rebuilt
+    float3 fromMap;
+    fromMap.xy = NormalMap.Sample( TextureSampler, uv ).rg * 2.0 - 1.0;
+    fromMap.z  = sqrt( saturate( 1.0 - dot( fromMap.xy, fromMap.xy ) ) );
 
     // Calculate the TBN matrix to go from tangent space to world space
     float3 N = normal;
@@ -72,7 +125,10 @@ float4 main( VertexToPixel input ) : SV_TARGET
 
 
 
+    // Only the directional light casts shadows, so the point lights are added on top
+    float4 pointLightColor = GetClusterLightColor( input.Position, input.WorldPosition, input.Normal );
+
     // Return the final lighted and textured color
     float4 litColor = ( dirLightColor + AmbientColor ) * textureColor;
-    return litColor * shadowAdj;
+    return litColor * shadowAdj + pointLightColor * textureColor;
 }
\ No newline at end of file
@@ -2,19 +2,34 @@
 #include "PointLight.hpp"
 
 /// <summary>
-/// Our constant buffer for external data.
+/// Our constant buffer for data that is the same for everything drawn in a frame.
 /// </summary>
-cbuffer __extern__ : register( b0 )
+cbuffer PerFrame : register( b0 )
 {
-    matrix World;
     matrix View;
     matrix Projection;
+    matrix ShadowView;
+    matrix ShadowProjection;
+    float3 CameraPosition;
+};
+
+/// <summary>
+/// Our constant buffer for a material's parameters. It's filled in by the material's parameter
+/// block, which every material with the same parameters shares.
+/// </summary>
+cbuffer PerMaterial : register( b2 )
+{
     DirectionalLight Light;
     float4 AmbientColor;
-    float3 CameraPosition;
     float  UseNormalMap;   // Float, but treated as a bool
-    matrix ShadowView;
-    matrix ShadowProjection;
+};
+
+/// <summary>
+/// Our constant buffer for data that changes with every object drawn.
+/// </summary>
+cbuffer PerObject : register( b3 )
+{
+    matrix World;
 };
 
 /// <summary>
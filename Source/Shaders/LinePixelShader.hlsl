@@ -2,5 +2,5 @@
 
 float4 main( VertexToPixel input ) : SV_TARGET
 {
-    return LineColor;
+    return input.Color;
 }
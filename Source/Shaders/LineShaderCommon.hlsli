@@ -3,9 +3,8 @@
 /// </summary>
 cbuffer __extern__ : register( b0 )
 {
-    matrix World;
+    matrix View;
     matrix Projection;
-    float4 LineColor;
 };
 
 /// <summary>
@@ -13,7 +12,8 @@ cbuffer __extern__ : register( b0 )
 /// </summary>
 struct ProgramToVertex
 {
-    float2 Position : SV_POSITION;
+    float3 Position : SV_POSITION;
+    float4 Color    : COLOR;
 };
 
 /// <summary>
@@ -22,4 +22,5 @@ struct ProgramToVertex
 struct VertexToPixel
 {
     float4 Position : SV_POSITION;
+    float4 Color    : COLOR;
 };
@@ -4,11 +4,12 @@ VertexToPixel main( ProgramToVertex input )
 {
     VertexToPixel output;
 
-    // Get the world-projection matrix
-    matrix worldProjection = mul( World, Projection );
+    // Get the view-projection matrix
+    matrix viewProjection = mul( View, Projection );
+
+    // Get the position and pass the color along
+    output.Position = mul( float4( input.Position, 1.0 ), viewProjection );
+    output.Color = input.Color;
 
-    // Get the position
-    output.Position = mul( float4( input.Position, 0.0, 1.0 ), worldProjection );
-    
     return output;
 }
@@ -5,10 +5,11 @@
 #include "SharedTypes.hpp"
 
 /// <summary>
-/// Defines a point light.
+/// Defines a point light. Its light fades out completely at its range.
 /// </summary>
 struct PointLight
 {
     FLOAT4 DiffuseColor;
     FLOAT3 Position;
+    float  Range;
 };
@@ -0,0 +1,16 @@
+#include "TextShaderCommon.hlsli"
+
+Texture2D    TextTexture : register( t0 );
+SamplerState TextSampler : register( s0 );
+
+float4 main( VertexToPixel input ) : SV_TARGET
+{
+    // The atlas stores the distance to the glyph's outline in alpha, with the outline at 0.5
+    float distance = TextTexture.Sample( TextSampler, input.UV ).a;
+
+    // Smooth over roughly one screen pixel, so the edge stays sharp at any size or scale
+    float smoothing = fwidth( distance ) * 0.7;
+    float alpha = smoothstep( 0.5 - smoothing, 0.5 + smoothing, distance );
+
+    return float4( input.Color.rgb, input.Color.a * alpha );
+}
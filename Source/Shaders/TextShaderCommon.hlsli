@@ -3,9 +3,7 @@
 /// </summary>
 cbuffer __extern__ : register( b0 )
 {
-    matrix World;
     matrix Projection;
-    float4 TextColor;
 };
 
 /// <summary>
@@ -15,6 +13,7 @@ struct ProgramToVertex
 {
     float2 Position : SV_POSITION;
     float2 UV       : TEXCOORD;
+    float4 Color    : COLOR;
 };
 
 /// <summary>
@@ -24,4 +23,5 @@ struct VertexToPixel
 {
     float4 Position : SV_POSITION;
     float2 UV       : TEXCOORD0;
+    float4 Color    : COLOR;
 };
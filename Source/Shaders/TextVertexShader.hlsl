@@ -4,14 +4,12 @@ VertexToPixel main( ProgramToVertex input )
 {
     VertexToPixel output;
 
-    // Get the world-projection matrix
-    matrix worldProjection = mul( World, Projection );
-
-    // Get the position
-    output.Position = mul( float4( input.Position, 0.0, 1.0 ), worldProjection );
+    // Get the position (the batcher has already moved it into world space)
+    output.Position = mul( float4( input.Position, 0.0, 1.0 ), Projection );
     
-    // Pass through the UV coordinates
+    // Pass through the UV coordinates and color
     output.UV = input.UV;
+    output.Color = input.Color;
 
     return output;
 }
@@ -0,0 +1,18 @@
+#include "Shaders/CompactVertexCommon.hlsli"
+
+/// <summary>
+/// Our constant buffer for external data.
+/// </summary>
+cbuffer __extern__ : register( b0 )
+{
+    matrix World;
+    matrix View;
+    matrix Projection;
+};
+
+float4 main( CompactProgramToVertex input ) : SV_POSITION
+{
+    // Calculate output position
+    matrix worldViewProj = mul( mul( World, View ), Projection );
+    return mul( float4( DecodePosition( input.Position ), 1.0f ), worldViewProj );
+}
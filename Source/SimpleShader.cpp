@@ -1,4 +1,41 @@
 #include "SimpleShader.h"
+#include "ShaderCache.hpp"
+#include "StateTracker.hpp"
+
+// The state tracker all shaders bind through (may be null)
+StateTracker* ISimpleShader::stateTracker = nullptr;
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ SHADER PROGRAM ------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// Creates an empty program
+// --------------------------------------------------------
+SimpleShaderProgram::SimpleShaderProgram()
+    : Shader( nullptr )
+    , InputLayout( nullptr )
+    , StreamOutVertexSize( 0 )
+    , ConstantBufferCount( 0 )
+    , ConstantBuffers( nullptr )
+{
+}
+
+// --------------------------------------------------------
+// Releases the shader, input layout and constant buffers
+// --------------------------------------------------------
+SimpleShaderProgram::~SimpleShaderProgram()
+{
+    for (unsigned int i = 0; i < ConstantBufferCount; i++)
+    {
+        if (ConstantBuffers[i].ConstantBuffer) ConstantBuffers[i].ConstantBuffer->Release();
+    }
+    delete[] ConstantBuffers;
+    if (InputLayout) InputLayout->Release();
+    if (Shader) Shader->Release();
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -12,7 +49,7 @@ ISimpleShader::ISimpleShader(ID3D11Device* _device, ID3D11DeviceContext* context
     , device( _device )
     , deviceContext( context )
     , constantBufferCount( 0 )
-    , constantBuffers( nullptr )
+    , constantData( nullptr )
 {
 }
 
@@ -26,53 +63,97 @@ ISimpleShader::~ISimpleShader()
 }
 
 // --------------------------------------------------------
-// Cleans up the variable table and buffers - Some things will
-// be handled by derived classes
+// Cleans up this object's local data buffers and lets go
+// of the shared program
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
-    // Handle constant buffers and local data buffers
     for (unsigned int i = 0; i < constantBufferCount; i++)
     {
-        constantBuffers[i].ConstantBuffer->Release();
-        delete[] constantBuffers[i].LocalDataBuffer;
+        delete[] constantData[i].LocalDataBuffer;
     }
-    delete[] constantBuffers;
+    delete[] constantData;
+    constantData = nullptr;
     constantBufferCount = 0;
 
-    // Clean up tables
-    varTable.clear();
-    cbTable.clear();
-    samplerTable.clear();
-    textureTable.clear();
+    program.reset();
+    shaderValid = false;
 }
 
 // --------------------------------------------------------
-// Loads the specified shader and builds the variable table using shader
-// reflection.  This must be a separate step from the constructor since
-// we can't invoke derived class overrides in the base class constructor.
+// Loads the specified shader. The first object to load a
+// file (with a given permutation) creates the shader and
+// builds the variable table using shader reflection, and
+// every later object shares them through the shader cache.
+// This must be a separate step from the constructor since
+// we can't invoke derived class overrides in the base class
+// constructor.
 //
 // shaderFile - A "wide string" specifying the compiled shader to load
 // 
 // Returns true if shader is loaded properly, false otherwise
 // --------------------------------------------------------
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
+{
+    // Clean up first, in the event this method is
+    // called more than once on the same object
+    CleanUp();
+
+    // Look for the program before going anywhere near the disk
+    std::wstring key = std::wstring(shaderFile) + L"|" + GetPermutation();
+    program = ShaderCache::Find(key);
+    if (!program)
+    {
+        program = CreateProgram(shaderFile);
+        if (!program)
+        {
+            return false;
+        }
+        ShaderCache::Add(key, program);
+    }
+
+    // All this object needs of its own is somewhere to keep its constant buffer contents
+    constantBufferCount = program->ConstantBufferCount;
+    constantData = new SimpleConstantData[constantBufferCount];
+    for (unsigned int b = 0; b < constantBufferCount; b++)
+    {
+        unsigned int size = program->ConstantBuffers[b].Size;
+        constantData[b].LocalDataBuffer = new unsigned char[size];
+        constantData[b].ExternalBuffer = 0;
+        constantData[b].Dirty = true;
+        ZeroMemory(constantData[b].LocalDataBuffer, size);
+    }
+
+    // All set
+    shaderValid = true;
+    return true;
+}
+
+// --------------------------------------------------------
+// Reads a compiled shader, creates the DirectX shader and
+// builds the variable table using shader reflection
+//
+// shaderFile - A "wide string" specifying the compiled shader to load
+// 
+// Returns the new program, or null if it couldn't be created
+// --------------------------------------------------------
+std::shared_ptr<SimpleShaderProgram> ISimpleShader::CreateProgram(LPCWSTR shaderFile)
 {
     // Load the shader to a blob and ensure it worked
     ID3DBlob* shaderBlob = 0;
     HRESULT hr = D3DReadFileToBlob(shaderFile, &shaderBlob);
     if (hr != S_OK)
     {
-        return false;
+        return nullptr;
     }
 
     // Create the shader - Calls an overloaded version of this abstract
     // method in the appropriate child class
-    shaderValid = CreateShader(shaderBlob);
-    if (!shaderValid)
+    std::shared_ptr<SimpleShaderProgram> newProgram = std::make_shared<SimpleShaderProgram>();
+    if (!CreateShader(shaderBlob, newProgram.get()))
     {
         shaderBlob->Release();
-        return false;
+        return nullptr;
     }
 
     // Set up shader reflection to get information about
@@ -88,9 +169,10 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
     D3D11_SHADER_DESC shaderDesc;
     refl->GetDesc(&shaderDesc);
 
-    // Create an array of constant buffers
-    constantBufferCount = shaderDesc.ConstantBuffers;
-    constantBuffers = new SimpleConstantBuffer[constantBufferCount];
+    // Create an array of constant buffers (reflection also lists structured
+    // buffers here, so the count is only known once they're skipped below)
+    newProgram->ConstantBufferCount = 0;
+    newProgram->ConstantBuffers = new SimpleConstantBuffer[shaderDesc.ConstantBuffers];
     
     // Handle bound resources (like shaders and samplers)
     unsigned int resourceCount = shaderDesc.BoundResources;
@@ -104,36 +186,47 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
         switch (resourceDesc.Type)
         {
         case D3D_SIT_TEXTURE: // A texture resource
-            textureTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
+        case D3D_SIT_STRUCTURED: // A structured buffer, bound the same way
+        case D3D_SIT_BYTEADDRESS:
+            newProgram->TextureTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
             break;
 
         case D3D_SIT_SAMPLER: // A sampler resource
-            samplerTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
+            newProgram->SamplerTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
             break;
         }
     }
 
     // Loop through all constant buffers
-    for (unsigned int b = 0; b < constantBufferCount; b++)
+    for (unsigned int r = 0; r < shaderDesc.ConstantBuffers; r++)
     {
         // Get this buffer
         ID3D11ShaderReflectionConstantBuffer* cb =
-            refl->GetConstantBufferByIndex(b);
+            refl->GetConstantBufferByIndex(r);
         
-        // Get the description of this buffer
+        // Get the description of this buffer, skipping the
+        // layouts of structured buffers
         D3D11_SHADER_BUFFER_DESC bufferDesc;
         cb->GetDesc(&bufferDesc);
+        if (bufferDesc.Type != D3D_CT_CBUFFER)
+            continue;
+        unsigned int b = newProgram->ConstantBufferCount++;
 
         // Get the description of the resource binding, so
         // we know exactly how it's bound in the shader
         D3D11_SHADER_INPUT_BIND_DESC bindDesc;
         refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
         
-        // Set up the buffer and put its pointer in the table
-        constantBuffers[b].BindIndex = bindDesc.BindPoint;
-        cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
-
-        // Create this constant buffer
+        // Set up the buffer and put its index in the table
+        SimpleConstantBuffer& constantBuffer = newProgram->ConstantBuffers[b];
+        constantBuffer.BindIndex = bindDesc.BindPoint;
+        constantBuffer.Size = bufferDesc.Size;
+        constantBuffer.ConstantBuffer = 0;
+        constantBuffer.LastUploader = 0;
+        newProgram->CBTable.insert(std::pair<std::string, unsigned int>(bufferDesc.Name, b));
+
+        // Create this constant buffer, which every object using
+        // the program uploads its own contents into before drawing
         D3D11_BUFFER_DESC newBuffDesc;
         newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
         newBuffDesc.ByteWidth = bufferDesc.Size;
@@ -141,11 +234,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
         newBuffDesc.CPUAccessFlags = 0;
         newBuffDesc.MiscFlags = 0;
         newBuffDesc.StructureByteStride = 0;
-        device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
-
-        // Set up the data buffer for this constant buffer
-        constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-        ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+        device->CreateBuffer(&newBuffDesc, 0, &constantBuffer.ConstantBuffer);
 
         // Loop through all variables in this buffer
         for (unsigned int v = 0; v < bufferDesc.Variables; v++)
@@ -168,14 +257,14 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
             std::string varName(varDesc.Name);
 
             // Add this variable to the table
-            varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+            newProgram->VarTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
         }
     }
 
     // All set
     refl->Release();
     shaderBlob->Release();
-    return true;
+    return newProgram;
 }
 
 // --------------------------------------------------------
@@ -184,12 +273,16 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 // --------------------------------------------------------
 SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 {
+    // Nothing can be found before a shader is loaded
+    if (!program)
+        return 0;
+
     // Look for the key
     std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-        varTable.find(name);
+        program->VarTable.find(name);
 
     // Did we find the key?
-    if (result == varTable.end())
+    if (result == program->VarTable.end())
         return 0;
 
     // Grab the result from the iterator
@@ -204,17 +297,21 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 }
 
 // --------------------------------------------------------
-// Helper for looking up a constant buffer by name
+// Helper for looking up a constant buffer's index by name
 // --------------------------------------------------------
-SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
+int ISimpleShader::FindConstantBuffer(std::string name)
 {
+    // Nothing can be found before a shader is loaded
+    if (!program)
+        return -1;
+
     // Look for the key
-    std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
-        cbTable.find(name);
+    std::unordered_map<std::string, unsigned int>::iterator result =
+        program->CBTable.find(name);
 
     // Did we find the key?
-    if (result == cbTable.end())
-        return 0;
+    if (result == program->CBTable.end())
+        return -1;
 
     // Success
     return result->second;
@@ -225,12 +322,16 @@ SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
 // --------------------------------------------------------
 unsigned int ISimpleShader::FindTextureBindIndex(std::string name)
 {
+    // Nothing can be found before a shader is loaded
+    if (!program)
+        return -1;
+
     // Look for the key
     std::unordered_map<std::string, unsigned int>::iterator result =
-        textureTable.find(name);
+        program->TextureTable.find(name);
 
     // Did we find the key?
-    if (result == textureTable.end())
+    if (result == program->TextureTable.end())
         return -1;
 
     // Success
@@ -242,12 +343,16 @@ unsigned int ISimpleShader::FindTextureBindIndex(std::string name)
 // --------------------------------------------------------
 unsigned int ISimpleShader::FindSamplerBindIndex(std::string name)
 {
+    // Nothing can be found before a shader is loaded
+    if (!program)
+        return -1;
+
     // Look for the key
     std::unordered_map<std::string, unsigned int>::iterator result =
-        samplerTable.find(name);
+        program->SamplerTable.find(name);
 
     // Did we find the key?
-    if (result == samplerTable.end())
+    if (result == program->SamplerTable.end())
         return -1;
 
     // Success
@@ -286,13 +391,11 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
     if (!shaderValid) return;
 
     // Check for the buffer
-    SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
-    if (!cb) return;
+    int index = this->FindConstantBuffer(bufferName);
+    if (index < 0) return;
 
     // Copy the data and get out
-    deviceContext->UpdateSubresource(
-        cb->ConstantBuffer, 0, 0, 
-        cb->LocalDataBuffer, 0, 0);
+    UploadConstantBuffer(index);
 }
 
 // --------------------------------------------------------
@@ -308,13 +411,112 @@ void ISimpleShader::CopyAllBufferData()
     // Loop through the constant buffers and copy all data
     for (unsigned int i = 0; i < constantBufferCount; i++)
     {
-        // Copy the entire local data buffer
-        deviceContext->UpdateSubresource(
-            constantBuffers[i].ConstantBuffer, 0, 0,
-            constantBuffers[i].LocalDataBuffer, 0, 0);
+        UploadConstantBuffer(i);
     }
 }
 
+// --------------------------------------------------------
+// Copies one of this object's local data buffers into the
+// shared constant buffer. The copy is skipped if nothing
+// has changed and no other object using the same program
+// has uploaded over it since
+//
+// index - The index of the constant buffer
+// --------------------------------------------------------
+void ISimpleShader::UploadConstantBuffer(unsigned int index)
+{
+    SimpleConstantBuffer& cb = program->ConstantBuffers[index];
+    SimpleConstantData& data = constantData[index];
+    if (data.ExternalBuffer || (!data.Dirty && cb.LastUploader == this))
+        return;
+
+    // Copy the entire local data buffer
+    deviceContext->UpdateSubresource(
+        cb.ConstantBuffer, 0, 0,
+        data.LocalDataBuffer, 0, 0);
+    cb.LastUploader = this;
+    data.Dirty = false;
+}
+
+// --------------------------------------------------------
+// Gets the buffer to bind for a constant buffer: the
+// caller's buffer if one was given, otherwise the shared one
+//
+// index - The index of the constant buffer
+// --------------------------------------------------------
+ID3D11Buffer* ISimpleShader::GetBoundBuffer(unsigned int index)
+{
+    if (constantData[index].ExternalBuffer)
+        return constantData[index].ExternalBuffer;
+    return program->ConstantBuffers[index].ConstantBuffer;
+}
+
+// --------------------------------------------------------
+// Gets the size of a constant buffer
+//
+// bufferName - The name of the constant buffer
+//
+// Returns the size in bytes, or 0 if there is no such buffer
+// --------------------------------------------------------
+unsigned int ISimpleShader::GetConstantBufferSize(std::string bufferName)
+{
+    int index = FindConstantBuffer(bufferName);
+    if (index < 0)
+        return 0;
+
+    return program->ConstantBuffers[index].Size;
+}
+
+// --------------------------------------------------------
+// Looks up where a variable lives in a constant buffer
+//
+// bufferName - The name of the constant buffer
+// name - The name of the variable
+// offset - Receives the variable's offset in the buffer
+// size - Receives the variable's size
+//
+// Returns true if the variable is in the given buffer
+// --------------------------------------------------------
+bool ISimpleShader::GetVariableLayout(std::string bufferName, std::string name, unsigned int& offset, unsigned int& size)
+{
+    int index = FindConstantBuffer(bufferName);
+    if (index < 0)
+        return false;
+
+    // Make sure the variable is in the buffer we were asked about
+    std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
+        program->VarTable.find(name);
+    if (result == program->VarTable.end() || result->second.ConstantBufferIndex != static_cast<unsigned int>(index))
+        return false;
+
+    offset = result->second.ByteOffset;
+    size = result->second.Size;
+    return true;
+}
+
+// --------------------------------------------------------
+// Binds a caller-owned buffer in place of one of the
+// shader's own constant buffers. The caller is responsible
+// for the buffer's contents, so it's never uploaded to
+//
+// bufferName - The name of the constant buffer
+// buffer - The buffer to bind, or null for the shader's own
+//
+// Returns true if the constant buffer exists
+// --------------------------------------------------------
+bool ISimpleShader::SetConstantBuffer(std::string bufferName, ID3D11Buffer* buffer)
+{
+    int index = FindConstantBuffer(bufferName);
+    if (index < 0)
+        return false;
+
+    // Going back to the shared buffer means our contents have to be uploaded again
+    if (constantData[index].ExternalBuffer && !buffer)
+        constantData[index].Dirty = true;
+    constantData[index].ExternalBuffer = buffer;
+    return true;
+}
+
 // --------------------------------------------------------
 // Sets a variable by name with arbitrary data of the specified size
 //
@@ -332,11 +534,15 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
     if (var == 0)
         return false;
 
-    // Set the data in the local data buffer
-    memcpy(
-        constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-        data,
-        size);
+    // Set the data in the local data buffer, flagging the buffer
+    // for the next copy only if the value actually changed
+    SimpleConstantData* cb = &constantData[var->ConstantBufferIndex];
+    unsigned char* dest = cb->LocalDataBuffer + var->ByteOffset;
+    if (memcmp(dest, data, size) != 0)
+    {
+        memcpy(dest, data, size);
+        cb->Dirty = true;
+    }
 
     // Success
     return true;
@@ -433,13 +639,11 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 // --------------------------------------------------------
 SimpleVertexShader::SimpleVertexShader( ID3D11Device* device, ID3D11DeviceContext* context )
     : ISimpleShader( device, context )
-    , inputLayout( nullptr )
-    , shader( nullptr )
 {
 }
 
 // --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
+// Destructor - Let go of the shared program
 // --------------------------------------------------------
 SimpleVertexShader::~SimpleVertexShader()
 {
@@ -447,29 +651,26 @@ SimpleVertexShader::~SimpleVertexShader()
 }
 
 // --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
+// Gets the key that tells vertex shaders apart from other
+// shaders loaded from the same file in the shader cache
 // --------------------------------------------------------
-void SimpleVertexShader::CleanUp()
+std::wstring SimpleVertexShader::GetPermutation()
 {
-    ISimpleShader::CleanUp();
-    if (shader) { shader->Release(); shader = 0; }
-    if (inputLayout) { inputLayout->Release(); inputLayout = 0; }
+    return L"vs";
 }
 
 // --------------------------------------------------------
-// Creates the DirectX vertex shader
+// Creates the DirectX vertex shader and its input layout
 //
 // shaderBlob - The shader's compiled code
+// newProgram - The program to create the shader in
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram)
 {
-    // Clean up first, in the event this method is
-    // called more than once on the same object
-    this->CleanUp();
-
     // Create the shader from the blob
+    ID3D11VertexShader* shader = 0;
     HRESULT result = device->CreateVertexShader(
         shaderBlob->GetBufferPointer(),
         shaderBlob->GetBufferSize(),
@@ -479,6 +680,7 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
     // Did the creation work?
     if (result != S_OK)
         return false;
+    newProgram->Shader = shader;
 
     // Vertex shader was created successfully, so we now use the
     // shader code to re-reflect and create an input layout that 
@@ -549,7 +751,7 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
         inputLayoutDesc.size(), 
         shaderBlob->GetBufferPointer(), 
         shaderBlob->GetBufferSize(),
-        &inputLayout);
+        &newProgram->InputLayout);
 
     // All done, clean up
     refl->Release();
@@ -564,6 +766,21 @@ void SimpleVertexShader::SetShaderAndCB()
 {
     // Is shader valid?
     if (!shaderValid) return;
+    ID3D11VertexShader* shader = static_cast<ID3D11VertexShader*>(program->Shader);
+    SimpleConstantBuffer* constantBuffers = program->ConstantBuffers;
+    ID3D11InputLayout* inputLayout = program->InputLayout;
+
+    // Go through the state tracker if we have one
+    if (stateTracker)
+    {
+        stateTracker->SetInputLayout(inputLayout);
+        stateTracker->SetVertexShader(shader);
+        for (unsigned int i = 0; i < constantBufferCount; i++)
+        {
+            stateTracker->SetConstantBuffer(ShaderStage::Vertex, constantBuffers[i].BindIndex, GetBoundBuffer(i));
+        }
+        return;
+    }
 
     // Set the shader and input layout
     deviceContext->IASetInputLayout(inputLayout);
@@ -572,10 +789,11 @@ void SimpleVertexShader::SetShaderAndCB()
     // Set the constant buffers
     for (unsigned int i = 0; i < constantBufferCount; i++)
     {
+        ID3D11Buffer* buffer = GetBoundBuffer(i);
         deviceContext->VSSetConstantBuffers(
             constantBuffers[i].BindIndex,
             1,
-            &constantBuffers[i].ConstantBuffer);
+            &buffer);
     }
 }
 
@@ -595,7 +813,10 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, ID3D11ShaderRes
         return false;
 
     // Set the shader resource view
-    deviceContext->VSSetShaderResources(bindIndex, 1, &srv);
+    if (stateTracker)
+        stateTracker->SetShaderResource(ShaderStage::Vertex, bindIndex, srv);
+    else
+        deviceContext->VSSetShaderResources(bindIndex, 1, &srv);
 
     // Success
     return true;
@@ -616,8 +837,11 @@ bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* s
     if (bindIndex == -1)
         return false;
 
-    // Set the shader resource view
-    deviceContext->VSSetSamplers(bindIndex, 1, &samplerState);
+    // Set the sampler state
+    if (stateTracker)
+        stateTracker->SetSampler(ShaderStage::Vertex, bindIndex, samplerState);
+    else
+        deviceContext->VSSetSamplers(bindIndex, 1, &samplerState);
 
     // Success
     return true;
@@ -634,12 +858,11 @@ bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* s
 // --------------------------------------------------------
 SimplePixelShader::SimplePixelShader(ID3D11Device* device, ID3D11DeviceContext* context)
     : ISimpleShader(device, context)
-    , shader( nullptr )
 {
 }
 
 // --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
+// Destructor - Let go of the shared program
 // --------------------------------------------------------
 SimplePixelShader::~SimplePixelShader()
 {
@@ -647,28 +870,26 @@ SimplePixelShader::~SimplePixelShader()
 }
 
 // --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
+// Gets the key that tells pixel shaders apart from other
+// shaders loaded from the same file in the shader cache
 // --------------------------------------------------------
-void SimplePixelShader::CleanUp()
+std::wstring SimplePixelShader::GetPermutation()
 {
-    ISimpleShader::CleanUp();
-    if (shader) { shader->Release(); shader = 0; }
+    return L"ps";
 }
 
 // --------------------------------------------------------
 // Creates the DirectX pixel shader
 //
 // shaderBlob - The shader's compiled code
+// newProgram - The program to create the shader in
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram)
 {
-    // Clean up first, in the event this method is
-    // called more than once on the same object
-    this->CleanUp();
-
     // Create the shader from the blob
+    ID3D11PixelShader* shader = 0;
     HRESULT result = device->CreatePixelShader(
         shaderBlob->GetBufferPointer(),
         shaderBlob->GetBufferSize(),
@@ -676,6 +897,7 @@ bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
         &shader);
 
     // Check the result
+    newProgram->Shader = shader;
     return (result == S_OK);
 }
 
@@ -687,6 +909,19 @@ void SimplePixelShader::SetShaderAndCB()
 {
     // Is shader valid?
     if (!shaderValid) return;
+    ID3D11PixelShader* shader = static_cast<ID3D11PixelShader*>(program->Shader);
+    SimpleConstantBuffer* constantBuffers = program->ConstantBuffers;
+
+    // Go through the state tracker if we have one
+    if (stateTracker)
+    {
+        stateTracker->SetPixelShader(shader);
+        for (unsigned int i = 0; i < constantBufferCount; i++)
+        {
+            stateTracker->SetConstantBuffer(ShaderStage::Pixel, constantBuffers[i].BindIndex, GetBoundBuffer(i));
+        }
+        return;
+    }
 
     // Set the shader
     deviceContext->PSSetShader(shader, 0, 0);
@@ -694,10 +929,11 @@ void SimplePixelShader::SetShaderAndCB()
     // Set the constant buffers
     for (unsigned int i = 0; i < constantBufferCount; i++)
     {
+        ID3D11Buffer* buffer = GetBoundBuffer(i);
         deviceContext->PSSetConstantBuffers(
             constantBuffers[i].BindIndex,
             1,
-            &constantBuffers[i].ConstantBuffer);
+            &buffer);
     }
 }
 
@@ -717,7 +953,10 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, ID3D11ShaderReso
         return false;
 
     // Set the shader resource view
-    deviceContext->PSSetShaderResources(bindIndex, 1, &srv);
+    if (stateTracker)
+        stateTracker->SetShaderResource(ShaderStage::Pixel, bindIndex, srv);
+    else
+        deviceContext->PSSetShaderResources(bindIndex, 1, &srv);
 
     // Success
     return true;
@@ -738,8 +977,11 @@ bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* sa
     if (bindIndex == -1)
         return false;
 
-    // Set the shader resource view
-    deviceContext->PSSetSamplers(bindIndex, 1, &samplerState);
+    // Set the sampler state
+    if (stateTracker)
+        stateTracker->SetSampler(ShaderStage::Pixel, bindIndex, samplerState);
+    else
+        deviceContext->PSSetSamplers(bindIndex, 1, &samplerState);
 
     // Success
     return true;
@@ -756,15 +998,13 @@ bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* sa
 // --------------------------------------------------------
 SimpleGeometryShader::SimpleGeometryShader(ID3D11Device* device, ID3D11DeviceContext* context, bool _useStreamOut, bool _allowStreamOutRasterization)
     : ISimpleShader(device, context)
-    , shader( nullptr )
     , useStreamOut( _useStreamOut )
     , allowStreamOutRasterization( _allowStreamOutRasterization )
-    , streamOutVertexSize( 0 )
 {
 }
 
 // --------------------------------------------------------
-// Destructor - Clean up actual shader (base will be called automatically)
+// Destructor - Let go of the shared program
 // --------------------------------------------------------
 SimpleGeometryShader::~SimpleGeometryShader()
 {
@@ -772,32 +1012,33 @@ SimpleGeometryShader::~SimpleGeometryShader()
 }
 
 // --------------------------------------------------------
-// Handles cleaning up shader and base class clean up
+// Gets the key that tells geometry shaders apart from other
+// shaders loaded from the same file in the shader cache.
+// Stream out is baked into the shader, so it's part of the key
 // --------------------------------------------------------
-void SimpleGeometryShader::CleanUp()
+std::wstring SimpleGeometryShader::GetPermutation()
 {
-    ISimpleShader::CleanUp();
-    if (shader) { shader->Release(); shader = 0; }
+    if (!useStreamOut)
+        return L"gs";
+    return allowStreamOutRasterization ? L"gs-so-rasterized" : L"gs-so";
 }
 
 // --------------------------------------------------------
 // Creates the DirectX Geometry shader
 //
 // shaderBlob - The shader's compiled code
+// newProgram - The program to create the shader in
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram)
 {
-    // Clean up first, in the event this method is
-    // called more than once on the same object
-    this->CleanUp();
-
     // Using stream out?
     if (useStreamOut)
-        return this->CreateShaderWithStreamOut(shaderBlob);
+        return this->CreateShaderWithStreamOut(shaderBlob, newProgram);
 
     // Create the shader from the blob
+    ID3D11GeometryShader* shader = 0;
     HRESULT result = device->CreateGeometryShader(
         shaderBlob->GetBufferPointer(),
         shaderBlob->GetBufferSize(),
@@ -805,6 +1046,7 @@ bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
         &shader);
 
     // Check the result
+    newProgram->Shader = shader;
     return (result == S_OK);
 }
 
@@ -813,15 +1055,12 @@ bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
 // stream output, if possible.
 //
 // shaderBlob - The shader's compiled code
+// newProgram - The program to create the shader in
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
+bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram)
 {
-    // Clean up first, in the event this method is
-    // called more than once on the same object
-    this->CleanUp();
-
     // Reflect shader info
     ID3D11ShaderReflection* refl;
     D3DReflect(
@@ -835,7 +1074,7 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
     refl->GetDesc(&shaderDesc);
 
     // Set up the output signature
-    streamOutVertexSize = 0;
+    unsigned int streamOutVertexSize = 0;
     std::vector<D3D11_SO_DECLARATION_ENTRY> soDecl;
     for (unsigned int i = 0; i < shaderDesc.OutputParameters; i++)
     {
@@ -865,6 +1104,7 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
     unsigned int rast = allowStreamOutRasterization ? 0 : D3D11_SO_NO_RASTERIZED_STREAM;
 
     // Create the shader
+    ID3D11GeometryShader* shader = 0;
     HRESULT result = device->CreateGeometryShaderWithStreamOutput(
         shaderBlob->GetBufferPointer(), // Shader blob pointer
         shaderBlob->GetBufferSize(),    // Shader blob size
@@ -875,7 +1115,11 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
         rast,                           // Index of the stream to rasterize (if any)
         NULL,                           // Not using class linkage
         &shader);
-    
+
+    // All done, clean up
+    refl->Release();
+    newProgram->Shader = shader;
+    newProgram->StreamOutVertexSize = streamOutVertexSize;
     return (result == S_OK);
 }
 
@@ -896,13 +1140,13 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(ID3DBlob* shaderBlob)
 bool SimpleGeometryShader::CreateCompatibleStreamOutBuffer(ID3D11Buffer** buffer, int vertexCount)
 {
     // Was stream output actually used?
-    if (!this->useStreamOut || !shaderValid || streamOutVertexSize == 0)
+    if (!this->useStreamOut || !shaderValid || program->StreamOutVertexSize == 0)
         return false;
 
     // Set up the buffer description
     D3D11_BUFFER_DESC desc;
     desc.BindFlags           = D3D11_BIND_STREAM_OUTPUT | D3D11_BIND_VERTEX_BUFFER;
-    desc.ByteWidth           = streamOutVertexSize * vertexCount;
+    desc.ByteWidth           = program->StreamOutVertexSize * vertexCount;
     desc.CPUAccessFlags      = 0;
     desc.MiscFlags           = 0;
     desc.StructureByteStride = 0;
@@ -918,6 +1162,12 @@ bool SimpleGeometryShader::CreateCompatibleStreamOutBuffer(ID3D11Buffer** buffer
 // --------------------------------------------------------
 void SimpleGeometryShader::UnbindStreamOutStage(ID3D11DeviceContext* deviceContext)
 {
+    if (stateTracker)
+    {
+        stateTracker->SetStreamOutTarget(nullptr);
+        return;
+    }
+
     unsigned int offset = 0;
     ID3D11Buffer* unset[1] = { 0 };
     deviceContext->SOSetTargets(1, unset, &offset);
@@ -931,6 +1181,19 @@ void SimpleGeometryShader::SetShaderAndCB()
 {
     // Is shader valid?
     if (!shaderValid) return;
+    ID3D11GeometryShader* shader = static_cast<ID3D11GeometryShader*>(program->Shader);
+    SimpleConstantBuffer* constantBuffers = program->ConstantBuffers;
+
+    // Go through the state tracker if we have one
+    if (stateTracker)
+    {
+        stateTracker->SetGeometryShader(shader);
+        for (unsigned int i = 0; i < constantBufferCount; i++)
+        {
+            stateTracker->SetConstantBuffer(ShaderStage::Geometry, constantBuffers[i].BindIndex, GetBoundBuffer(i));
+        }
+        return;
+    }
 
     // Set the shader
     deviceContext->GSSetShader(shader, 0, 0);
@@ -938,10 +1201,11 @@ void SimpleGeometryShader::SetShaderAndCB()
     // Set the constant buffers
     for (unsigned int i = 0; i < constantBufferCount; i++)
     {
+        ID3D11Buffer* buffer = GetBoundBuffer(i);
         deviceContext->GSSetConstantBuffers(
             constantBuffers[i].BindIndex,
             1,
-            &constantBuffers[i].ConstantBuffer);
+            &buffer);
     }
 }
 
@@ -961,7 +1225,10 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, ID3D11ShaderR
         return false;
 
     // Set the shader resource view
-    deviceContext->GSSetShaderResources(bindIndex, 1, &srv);
+    if (stateTracker)
+        stateTracker->SetShaderResource(ShaderStage::Geometry, bindIndex, srv);
+    else
+        deviceContext->GSSetShaderResources(bindIndex, 1, &srv);
 
     // Success
     return true;
@@ -982,8 +1249,11 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, ID3D11SamplerState*
     if (bindIndex == -1)
         return false;
 
-    // Set the shader resource view
-    deviceContext->GSSetSamplers(bindIndex, 1, &samplerState);
+    // Set the sampler state
+    if (stateTracker)
+        stateTracker->SetSampler(ShaderStage::Geometry, bindIndex, samplerState);
+    else
+        deviceContext->GSSetSamplers(bindIndex, 1, &samplerState);
 
     // Success
     return true;
@@ -5,6 +5,7 @@
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
+#include <memory>
 #include <unordered_map>
 #include <string>
 
@@ -21,16 +22,59 @@ struct SimpleShaderVariable
 
 // --------------------------------------------------------
 // Contains information about a specific
-// constant buffer in a shader, as well as
-// the local data buffer for it
+// constant buffer in a shader, along with the GPU
+// buffer every object using the shader shares
 // --------------------------------------------------------
 struct SimpleConstantBuffer
 {
 	unsigned int BindIndex;
+	unsigned int Size;
 	ID3D11Buffer* ConstantBuffer;
+	const void* LastUploader;
+};
+
+// --------------------------------------------------------
+// One shader object's own copy of a constant
+// buffer's contents
+// --------------------------------------------------------
+struct SimpleConstantData
+{
 	unsigned char* LocalDataBuffer;
+	ID3D11Buffer* ExternalBuffer;
+	bool Dirty;
+};
+
+// --------------------------------------------------------
+// Everything about a compiled shader that doesn't change
+// between the objects using it: the DirectX shader, its
+// input layout, its reflection tables and its constant
+// buffers. Programs are shared through the shader cache,
+// so each file is only read and reflected once
+// --------------------------------------------------------
+struct SimpleShaderProgram
+{
+	SimpleShaderProgram();
+	~SimpleShaderProgram();
+
+	ID3D11DeviceChild* Shader;
+	ID3D11InputLayout* InputLayout;
+	unsigned int StreamOutVertexSize;
+
+	// Constant buffers and the tables for finding things by name
+	unsigned int ConstantBufferCount;
+	SimpleConstantBuffer* ConstantBuffers;
+	std::unordered_map<std::string, unsigned int> CBTable;
+	std::unordered_map<std::string, SimpleShaderVariable> VarTable;
+	std::unordered_map<std::string, unsigned int> TextureTable;
+	std::unordered_map<std::string, unsigned int> SamplerTable;
+
+private:
+	SimpleShaderProgram(const SimpleShaderProgram&) = delete;
+	SimpleShaderProgram& operator=(const SimpleShaderProgram&) = delete;
 };
 
+class StateTracker;
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -41,12 +85,18 @@ public:
 	virtual ~ISimpleShader();
 
 	// Initialization method (since we can't invoke derived class
-	// overrides in the base class constructor)
+	// overrides in the base class constructor). Only the first
+	// load of each file and permutation touches the disk
 	bool LoadShaderFile(LPCWSTR shaderFile);
 
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
+	// Optional state tracker that all shaders bind through, so
+	// redundant shader, buffer and resource binds are dropped
+	static void SetStateTracker(StateTracker* tracker) { stateTracker = tracker; }
+	static StateTracker* GetStateTracker() { return stateTracker; }
+
 	// Activating the shader and copying data
 	void SetShader(bool copyData = true);
 	void CopyAllBufferData();
@@ -66,35 +116,50 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Looks up where a variable lives in one of the shader's
+	// constant buffers, for filling that buffer elsewhere
+	bool GetVariableLayout(std::string bufferName, std::string name, unsigned int& offset, unsigned int& size);
+	unsigned int GetConstantBufferSize(std::string bufferName);
+
+	// Binds a buffer owned by the caller in place of one of the
+	// shader's own constant buffers, or null to go back to it
+	bool SetConstantBuffer(std::string bufferName, ID3D11Buffer* buffer);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
 
 protected:
-	
+	static StateTracker* stateTracker;
+
 	bool shaderValid;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
 
-	// Constant buffers and related data buffers
+	// The shared program, and this object's own constant buffer contents
+	std::shared_ptr<SimpleShaderProgram> program;
 	unsigned int constantBufferCount;
-	
-	// Maps for variables and buffers
-	SimpleConstantBuffer* constantBuffers; // For index-based lookup
-	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
-	std::unordered_map<std::string, unsigned int> textureTable;
-	std::unordered_map<std::string, unsigned int> samplerTable;
+	SimpleConstantData* constantData;
 
 	// Pure virtual functions for dealing with shader types
-	virtual bool CreateShader(ID3DBlob* shaderBlob) = 0;
+	virtual bool CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram) = 0;
+	virtual std::wstring GetPermutation() = 0;
 	virtual void SetShaderAndCB() = 0;
 
 	virtual void CleanUp();
 
+	// Reads, creates and reflects a program from a compiled shader file
+	std::shared_ptr<SimpleShaderProgram> CreateProgram(LPCWSTR shaderFile);
+
+	// Uploads a constant buffer if the GPU copy isn't already this object's
+	void UploadConstantBuffer(unsigned int index);
+
+	// Gets the buffer to bind for a constant buffer
+	ID3D11Buffer* GetBoundBuffer(unsigned int index);
+
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
-	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+	int FindConstantBuffer(std::string name);
 	unsigned int FindTextureBindIndex(std::string name);
 	unsigned int FindSamplerBindIndex(std::string name);
 };
@@ -107,18 +172,16 @@ class SimpleVertexShader : public ISimpleShader
 public:
 	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context);
 	~SimpleVertexShader();
-	ID3D11VertexShader* GetDirectXShader() { return shader; }
-	ID3D11InputLayout* GetInputLayout() { return inputLayout; }
+	ID3D11VertexShader* GetDirectXShader() { return program ? static_cast<ID3D11VertexShader*>(program->Shader) : 0; }
+	ID3D11InputLayout* GetInputLayout() { return program ? program->InputLayout : 0; }
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
 
 protected:
-	ID3D11InputLayout* inputLayout;
-	ID3D11VertexShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram);
+	std::wstring GetPermutation();
 	void SetShaderAndCB();
-	void CleanUp();
 };
 
 
@@ -130,16 +193,15 @@ class SimplePixelShader : public ISimpleShader
 public:
 	SimplePixelShader(ID3D11Device* device, ID3D11DeviceContext* context);
 	~SimplePixelShader();
-	ID3D11PixelShader* GetDirectXShader() { return shader; }
+	ID3D11PixelShader* GetDirectXShader() { return program ? static_cast<ID3D11PixelShader*>(program->Shader) : 0; }
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
 
 protected:
-	ID3D11PixelShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram);
+	std::wstring GetPermutation();
 	void SetShaderAndCB();
-	void CleanUp();
 };
 
 // --------------------------------------------------------
@@ -150,7 +212,7 @@ class SimpleGeometryShader : public ISimpleShader
 public:
 	SimpleGeometryShader(ID3D11Device* device, ID3D11DeviceContext* context, bool useStreamOut = 0, bool allowStreamOutRasterization = 0);
 	~SimpleGeometryShader();
-	ID3D11GeometryShader* GetDirectXShader() { return shader; }
+	ID3D11GeometryShader* GetDirectXShader() { return program ? static_cast<ID3D11GeometryShader*>(program->Shader) : 0; }
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
@@ -160,18 +222,14 @@ public:
 	static void UnbindStreamOutStage(ID3D11DeviceContext* deviceContext);
 
 protected:
-	// Shader itself
-	ID3D11GeometryShader* shader;
-
 	// Stream out related
 	bool useStreamOut;
 	bool allowStreamOutRasterization;
-	unsigned int streamOutVertexSize;
 
-	bool CreateShader(ID3DBlob* shaderBlob);
-	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram);
+	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob, SimpleShaderProgram* newProgram);
+	std::wstring GetPermutation();
 	void SetShaderAndCB();
-	void CleanUp();
 
 	// Helpers
 	unsigned int CalcComponentCount(unsigned int mask);
@@ -5,7 +5,7 @@ struct VStoGS
 {
 	int type			: TEXCOORD0;
 	float age			: TEXCOORD1;
-	float4 startPos		: SV_POSITION;
+	float3 startPos		: POSITION;
 	float3 startVel		: TEXCOORD2;
 	float4 startColor	: COLOR0;
 	float4 midColor		: COLOR1;
@@ -19,6 +19,7 @@ cbuffer externalData : register(b0)
 	float ageToSpawn;
 	float maxLifetime;
 	float totalTime;
+	float isEmitting;
 }
 
 texture1D randomTexture : register(t0);
@@ -31,8 +32,12 @@ void main(point VStoGS input[1], inout PointStream<VStoGS> outStream)
 	input[0].age += dt;
 
 	//Root particle?
-	if (input[0].age == TYPE_ROOT)
+	if (input[0].type == TYPE_ROOT)
 	{
+		//Once the system stops emitting, drop the root so the remaining particles can die off
+		if (isEmitting == 0)
+			return;
+
 		//Create new particle when it's time
 		if (input[0].age >= ageToSpawn)
 		{
@@ -52,7 +57,7 @@ void main(point VStoGS input[1], inout PointStream<VStoGS> outStream)
 
 			//Create some randomness
 			float4 random = randomTexture.SampleLevel(randomSampler, totalTime * 10, 0);
-			emit.startPos.xyz += random.xyz * 0.5f;
+			emit.startPos += random.xyz * 0.5f;
 			emit.startVel.x = random.w * 0.3f;
 			emit.startVel.z = random.x * 0.3f;
 
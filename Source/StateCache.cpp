@@ -0,0 +1,138 @@
+#include "StateCache.hpp"
+#include <string.h>
+
+std::unordered_map<UINT64, std::vector<StateCache::Entry<D3D11_BLEND_DESC, ID3D11BlendState>>>                  StateCache::_blendStates;
+std::unordered_map<UINT64, std::vector<StateCache::Entry<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState>>>   StateCache::_depthStencilStates;
+std::unordered_map<UINT64, std::vector<StateCache::Entry<D3D11_RASTERIZER_DESC, ID3D11RasterizerState>>>        StateCache::_rasterizerStates;
+std::unordered_map<UINT64, std::vector<StateCache::Entry<D3D11_SAMPLER_DESC, ID3D11SamplerState>>>              StateCache::_samplerStates;
+std::unordered_map<const void*, unsigned int>                                                                   StateCache::_stateIds;
+size_t                                                                                                          StateCache::_count = 0;
+size_t                                                                                                          StateCache::_hitCount = 0;
+
+// Hashes a state description
+template<typename TDesc> static UINT64 HashDescription( const TDesc& desc )
+{
+    // FNV-1a over the description's bytes
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>( &desc );
+    UINT64 hash = 14695981039346656037ULL;
+    for ( size_t index = 0; index < sizeof( TDesc ); ++index )
+    {
+        hash = ( hash ^ bytes[ index ] ) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Creates a new pipeline state that leaves everything to the pass
+PipelineState::PipelineState()
+    : BlendState( nullptr )
+    , DepthStencilState( nullptr )
+    , RasterizerState( nullptr )
+{
+}
+
+// Forgets every cached state
+void StateCache::Clear()
+{
+    _blendStates.clear();
+    _depthStencilStates.clear();
+    _rasterizerStates.clear();
+    _samplerStates.clear();
+    _stateIds.clear();
+    _count = 0;
+    _hitCount = 0;
+}
+
+// Finds or creates the state for a description
+template<typename TDesc, typename TState, typename TCreate>
+TState* StateCache::FindOrCreate( std::unordered_map<UINT64, std::vector<Entry<TDesc, TState>>>& table, const TDesc& desc, TCreate create )
+{
+    // Descriptions that hash the same are told apart by their bytes
+    std::vector<Entry<TDesc, TState>>& bucket = table[ HashDescription( desc ) ];
+    for ( auto& entry : bucket )
+    {
+        if ( memcmp( &entry.Description, &desc, sizeof( TDesc ) ) == 0 )
+        {
+            ++_hitCount;
+            return entry.State.Get();
+        }
+    }
+
+    Entry<TDesc, TState> entry;
+    entry.Description = desc;
+    if ( FAILED( create( desc, entry.State.GetAddress() ) ) )
+    {
+        return nullptr;
+    }
+
+    // The device hands back the same object for identical descriptions, so only count new ones
+    TState* state = entry.State.Get();
+    if ( _stateIds.find( state ) == _stateIds.end() )
+    {
+        _stateIds[ state ] = static_cast<unsigned int>( ++_count );
+    }
+    bucket.push_back( entry );
+    return state;
+}
+
+// Gets the blend state for a description
+ID3D11BlendState* StateCache::GetBlendState( ID3D11Device* device, const D3D11_BLEND_DESC& desc )
+{
+    return FindOrCreate( _blendStates, desc, [ device ]( const D3D11_BLEND_DESC& desc, ID3D11BlendState** state )
+    {
+        return device->CreateBlendState( &desc, state );
+    } );
+}
+
+// Gets the number of cached states
+size_t StateCache::GetCount()
+{
+    return _count;
+}
+
+// Gets the depth/stencil state for a description
+ID3D11DepthStencilState* StateCache::GetDepthStencilState( ID3D11Device* device, const D3D11_DEPTH_STENCIL_DESC& desc )
+{
+    return FindOrCreate( _depthStencilStates, desc, [ device ]( const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** state )
+    {
+        return device->CreateDepthStencilState( &desc, state );
+    } );
+}
+
+// Gets the number of requests served from the cache
+size_t StateCache::GetHitCount()
+{
+    return _hitCount;
+}
+
+// Gets a sortable key for a pipeline state
+UINT64 StateCache::GetPipelineKey( const PipelineState& state )
+{
+    // Sixteen bits per state is plenty, since the cache only ever holds a handful
+    UINT64 key = 0;
+    const void* states[] = { state.BlendState, state.DepthStencilState, state.RasterizerState };
+    for ( const void* object : states )
+    {
+        auto search = _stateIds.find( object );
+        UINT64 id = ( search == _stateIds.end() ) ? 0 : search->second;
+        key = ( key << 16 ) | ( id & 0xFFFF );
+    }
+    return key;
+}
+
+// Gets the rasterizer state for a description
+ID3D11RasterizerState* StateCache::GetRasterizerState( ID3D11Device* device, const D3D11_RASTERIZER_DESC& desc )
+{
+    return FindOrCreate( _rasterizerStates, desc, [ device ]( const D3D11_RASTERIZER_DESC& desc, ID3D11RasterizerState** state )
+    {
+        return device->CreateRasterizerState( &desc, state );
+    } );
+}
+
+// Gets the sampler state for a description
+ID3D11SamplerState* StateCache::GetSamplerState( ID3D11Device* device, const D3D11_SAMPLER_DESC& desc )
+{
+    return FindOrCreate( _samplerStates, desc, [ device ]( const D3D11_SAMPLER_DESC& desc, ID3D11SamplerState** state )
+    {
+        return device->CreateSamplerState( &desc, state );
+    } );
+}
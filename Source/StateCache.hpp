@@ -0,0 +1,119 @@
+#pragma once
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Describes the fixed-function states a draw needs on top of its pass. A null state means the
+/// draw uses whatever state its pass set.
+/// </summary>
+struct PipelineState
+{
+    ID3D11BlendState* BlendState;
+    ID3D11DepthStencilState* DepthStencilState;
+    ID3D11RasterizerState* RasterizerState;
+
+    /// <summary>
+    /// Creates a new pipeline state that leaves everything to the pass.
+    /// </summary>
+    PipelineState();
+};
+
+/// <summary>
+/// Defines the static state cache. Sampler, blend, depth/stencil and rasterizer states are keyed by
+/// a hash of their descriptions, so asking for the same description twice hands back the same
+/// immutable state object. The cache owns every state it creates; callers only borrow them.
+/// </summary>
+/// <remarks>
+/// Descriptions are compared byte for byte, so they must be zeroed before they're filled in.
+/// </remarks>
+class StateCache
+{
+    ImplementStaticClass( StateCache );
+
+public:
+    /// <summary>
+    /// Defines a cached state and the description it was created from.
+    /// </summary>
+    template<typename TDesc, typename TState> struct Entry
+    {
+        TDesc Description;
+        ComPtr<TState> State;
+    };
+
+private:
+    static std::unordered_map<UINT64, std::vector<Entry<D3D11_BLEND_DESC, ID3D11BlendState>>>                 _blendStates;
+    static std::unordered_map<UINT64, std::vector<Entry<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState>>>  _depthStencilStates;
+    static std::unordered_map<UINT64, std::vector<Entry<D3D11_RASTERIZER_DESC, ID3D11RasterizerState>>>       _rasterizerStates;
+    static std::unordered_map<UINT64, std::vector<Entry<D3D11_SAMPLER_DESC, ID3D11SamplerState>>>             _samplerStates;
+    static std::unordered_map<const void*, unsigned int> _stateIds;
+    static size_t _count;
+    static size_t _hitCount;
+
+    /// <summary>
+    /// Finds the state created from a description in one of the tables, creating it if needed.
+    /// </summary>
+    /// <param name="table">The table of states of the description's type.</param>
+    /// <param name="desc">The description.</param>
+    /// <param name="create">Creates a state from a description.</param>
+    template<typename TDesc, typename TState, typename TCreate>
+    static TState* FindOrCreate( std::unordered_map<UINT64, std::vector<Entry<TDesc, TState>>>& table, const TDesc& desc, TCreate create );
+
+public:
+    /// <summary>
+    /// Forgets every cached state, releasing the ones nothing else holds on to. Must be called before the device is released.
+    /// </summary>
+    static void Clear();
+
+    /// <summary>
+    /// Gets the blend state for a description, creating it if needed.
+    /// </summary>
+    /// <param name="device">The device to create the state with.</param>
+    /// <param name="desc">The zero-initialized description.</param>
+    /// <returns>The state, or null if it couldn't be created.</returns>
+    static ID3D11BlendState* GetBlendState( ID3D11Device* device, const D3D11_BLEND_DESC& desc );
+
+    /// <summary>
+    /// Gets the number of cached states.
+    /// </summary>
+    static size_t GetCount();
+
+    /// <summary>
+    /// Gets the depth/stencil state for a description, creating it if needed.
+    /// </summary>
+    /// <param name="device">The device to create the state with.</param>
+    /// <param name="desc">The zero-initialized description.</param>
+    /// <returns>The state, or null if it couldn't be created.</returns>
+    static ID3D11DepthStencilState* GetDepthStencilState( ID3D11Device* device, const D3D11_DEPTH_STENCIL_DESC& desc );
+
+    /// <summary>
+    /// Gets the number of requests that were served from the cache.
+    /// </summary>
+    static size_t GetHitCount();
+
+    /// <summary>
+    /// Gets a key for a pipeline state that render queues can sort on. Draws with the same key need no
+    /// fixed-function state changes between them, and the default pipeline state's key is zero.
+    /// </summary>
+    /// <param name="state">The pipeline state.</param>
+    static UINT64 GetPipelineKey( const PipelineState& state );
+
+    /// <summary>
+    /// Gets the rasterizer state for a description, creating it if needed.
+    /// </summary>
+    /// <param name="device">The device to create the state with.</param>
+    /// <param name="desc">The zero-initialized description.</param>
+    /// <returns>The state, or null if it couldn't be created.</returns>
+    static ID3D11RasterizerState* GetRasterizerState( ID3D11Device* device, const D3D11_RASTERIZER_DESC& desc );
+
+    /// <summary>
+    /// Gets the sampler state for a description, creating it if needed.
+    /// </summary>
+    /// <param name="device">The device to create the state with.</param>
+    /// <param name="desc">The zero-initialized description.</param>
+    /// <returns>The state, or null if it couldn't be created.</returns>
+    static ID3D11SamplerState* GetSamplerState( ID3D11Device* device, const D3D11_SAMPLER_DESC& desc );
+};
@@ -0,0 +1,408 @@
+#include "StateTracker.hpp"
+#include <assert.h>
+
+static const float DefaultBlendFactor[ 4 ] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+/// <summary>
+/// Gets a pointer value that no bound object can have, used to mark state as unknown.
+/// </summary>
+template<typename T> static T* UnknownState()
+{
+    return reinterpret_cast<T*>( ~static_cast<UINT_PTR>( 0 ) );
+}
+
+// Creates a new pass state describing the default device state
+RenderPassState::RenderPassState()
+    : BlendState( nullptr )
+    , BlendMask( 0xFFFFFFFF )
+    , DepthStencilState( nullptr )
+    , StencilRef( 0 )
+    , RasterizerState( nullptr )
+    , RenderTarget( nullptr )
+    , DepthStencil( nullptr )
+{
+    memcpy( BlendFactor, DefaultBlendFactor, sizeof( BlendFactor ) );
+    ZeroMemory( &Viewport, sizeof( D3D11_VIEWPORT ) );
+}
+
+// Creates a new state tracker
+StateTracker::StateTracker( ID3D11DeviceContext* deviceContext )
+    : _deviceContext( nullptr )
+    , _callsIssued( 0 )
+    , _callsAvoided( 0 )
+    , _lastFrameCallsIssued( 0 )
+    , _lastFrameCallsAvoided( 0 )
+{
+    UpdateD3DResource( _deviceContext, deviceContext );
+
+    Invalidate();
+}
+
+// Destroys this state tracker
+StateTracker::~StateTracker()
+{
+    ReleaseMacro( _deviceContext );
+}
+
+// Applies the state described by a render pass
+void StateTracker::ApplyPassState( const RenderPassState& state )
+{
+    SetRenderTargets( state.RenderTarget, state.DepthStencil );
+    SetViewport( state.Viewport );
+    SetBlendState( state.BlendState, state.BlendFactor, state.BlendMask );
+    SetDepthStencilState( state.DepthStencilState, state.StencilRef );
+    SetRasterizerState( state.RasterizerState );
+}
+
+// Marks the start of a new frame
+void StateTracker::BeginFrame()
+{
+    _lastFrameCallsIssued = _callsIssued;
+    _lastFrameCallsAvoided = _callsAvoided;
+    _callsIssued = 0;
+    _callsAvoided = 0;
+
+    // The swap chain and resize logic bind their views without going through us
+    InvalidateOutputMerger();
+}
+
+// Gets the number of state calls sent to the device last frame
+UINT StateTracker::GetCallsIssued() const
+{
+    return _lastFrameCallsIssued;
+}
+
+// Gets the number of redundant state calls dropped last frame
+UINT StateTracker::GetCallsAvoided() const
+{
+    return _lastFrameCallsAvoided;
+}
+
+// Gets the device context being tracked
+ID3D11DeviceContext* StateTracker::GetDeviceContext()
+{
+    return _deviceContext;
+}
+
+// Forgets all shadowed state
+void StateTracker::Invalidate()
+{
+    _blendState = UnknownState<ID3D11BlendState>();
+    _blendMask = 0;
+    _depthStencilState = UnknownState<ID3D11DepthStencilState>();
+    _stencilRef = 0;
+    _rasterizerState = UnknownState<ID3D11RasterizerState>();
+    memcpy( _blendFactor, DefaultBlendFactor, sizeof( _blendFactor ) );
+
+    _inputLayout = UnknownState<ID3D11InputLayout>();
+    _topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    _vertexBuffer = UnknownState<ID3D11Buffer>();
+    _vertexStride = 0;
+    _vertexOffset = 0;
+    _indexBuffer = UnknownState<ID3D11Buffer>();
+    _indexFormat = DXGI_FORMAT_UNKNOWN;
+    _indexOffset = 0;
+    _streamOutTarget = UnknownState<ID3D11Buffer>();
+
+    _vertexShader = UnknownState<ID3D11VertexShader>();
+    _geometryShader = UnknownState<ID3D11GeometryShader>();
+    _pixelShader = UnknownState<ID3D11PixelShader>();
+
+    for ( UINT stage = 0; stage < StageCount; ++stage )
+    {
+        for ( UINT slot = 0; slot < MaxConstantBufferSlots; ++slot )
+        {
+            _constantBuffers[ stage ][ slot ] = UnknownState<ID3D11Buffer>();
+        }
+        for ( UINT slot = 0; slot < MaxResourceSlots; ++slot )
+        {
+            _shaderResources[ stage ][ slot ] = UnknownState<ID3D11ShaderResourceView>();
+            _samplers[ stage ][ slot ] = UnknownState<ID3D11SamplerState>();
+        }
+    }
+
+    InvalidateOutputMerger();
+}
+
+// Forgets the shadowed render targets and viewport
+void StateTracker::InvalidateOutputMerger()
+{
+    _renderTarget = UnknownState<ID3D11RenderTargetView>();
+    _depthStencil = UnknownState<ID3D11DepthStencilView>();
+    _isViewportKnown = false;
+}
+
+// Records whether or not a state change was sent to the device
+bool StateTracker::Record( bool issued )
+{
+    if ( issued )
+    {
+        ++_callsIssued;
+    }
+    else
+    {
+        ++_callsAvoided;
+    }
+    return issued;
+}
+
+// Sets the blend state
+void StateTracker::SetBlendState( ID3D11BlendState* state, const float* factor, UINT mask )
+{
+    if ( !factor )
+    {
+        factor = DefaultBlendFactor;
+    }
+
+    bool changed = ( _blendState != state )
+                || ( _blendMask != mask )
+                || ( memcmp( _blendFactor, factor, sizeof( _blendFactor ) ) != 0 );
+    if ( Record( changed ) )
+    {
+        _blendState = state;
+        _blendMask = mask;
+        memcpy( _blendFactor, factor, sizeof( _blendFactor ) );
+        _deviceContext->OMSetBlendState( state, factor, mask );
+    }
+}
+
+// Sets a constant buffer
+void StateTracker::SetConstantBuffer( ShaderStage stage, UINT slot, ID3D11Buffer* buffer )
+{
+    assert( slot < MaxConstantBufferSlots );
+    ID3D11Buffer*& current = _constantBuffers[ static_cast<UINT>( stage ) ][ slot ];
+    if ( !Record( current != buffer ) )
+    {
+        return;
+    }
+
+    current = buffer;
+    switch ( stage )
+    {
+        case ShaderStage::Vertex:   _deviceContext->VSSetConstantBuffers( slot, 1, &buffer ); break;
+        case ShaderStage::Geometry: _deviceContext->GSSetConstantBuffers( slot, 1, &buffer ); break;
+        case ShaderStage::Pixel:    _deviceContext->PSSetConstantBuffers( slot, 1, &buffer ); break;
+    }
+}
+
+// Sets the depth/stencil state
+void StateTracker::SetDepthStencilState( ID3D11DepthStencilState* state, UINT stencilRef )
+{
+    if ( Record( _depthStencilState != state || _stencilRef != stencilRef ) )
+    {
+        _depthStencilState = state;
+        _stencilRef = stencilRef;
+        _deviceContext->OMSetDepthStencilState( state, stencilRef );
+    }
+}
+
+// Sets the geometry shader
+void StateTracker::SetGeometryShader( ID3D11GeometryShader* shader )
+{
+    if ( Record( _geometryShader != shader ) )
+    {
+        _geometryShader = shader;
+        _deviceContext->GSSetShader( shader, nullptr, 0 );
+    }
+}
+
+// Sets the index buffer
+void StateTracker::SetIndexBuffer( ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset )
+{
+    if ( Record( _indexBuffer != buffer || _indexFormat != format || _indexOffset != offset ) )
+    {
+        _indexBuffer = buffer;
+        _indexFormat = format;
+        _indexOffset = offset;
+        _deviceContext->IASetIndexBuffer( buffer, format, offset );
+    }
+}
+
+// Sets the input layout
+void StateTracker::SetInputLayout( ID3D11InputLayout* layout )
+{
+    if ( Record( _inputLayout != layout ) )
+    {
+        _inputLayout = layout;
+        _deviceContext->IASetInputLayout( layout );
+    }
+}
+
+// Sets the pixel shader
+void StateTracker::SetPixelShader( ID3D11PixelShader* shader )
+{
+    if ( Record( _pixelShader != shader ) )
+    {
+        _pixelShader = shader;
+        _deviceContext->PSSetShader( shader, nullptr, 0 );
+    }
+}
+
+// Sets the primitive topology
+void StateTracker::SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY topology )
+{
+    if ( Record( _topology != topology ) )
+    {
+        _topology = topology;
+        _deviceContext->IASetPrimitiveTopology( topology );
+    }
+}
+
+// Sets the rasterizer state
+void StateTracker::SetRasterizerState( ID3D11RasterizerState* state )
+{
+    if ( Record( _rasterizerState != state ) )
+    {
+        _rasterizerState = state;
+        _deviceContext->RSSetState( state );
+    }
+}
+
+// Sets the render target and depth/stencil views
+void StateTracker::SetRenderTargets( ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil )
+{
+    if ( !Record( _renderTarget != renderTarget || _depthStencil != depthStencil ) )
+    {
+        return;
+    }
+
+    // The device silently unbinds inputs that alias outputs, so we have to mirror that
+    UnbindResourceHazards( renderTarget );
+    UnbindResourceHazards( depthStencil );
+
+    _renderTarget = renderTarget;
+    _depthStencil = depthStencil;
+    _deviceContext->OMSetRenderTargets( renderTarget ? 1 : 0, renderTarget ? &renderTarget : nullptr, depthStencil );
+}
+
+// Sets a sampler state
+void StateTracker::SetSampler( ShaderStage stage, UINT slot, ID3D11SamplerState* sampler )
+{
+    assert( slot < MaxResourceSlots );
+    ID3D11SamplerState*& current = _samplers[ static_cast<UINT>( stage ) ][ slot ];
+    if ( !Record( current != sampler ) )
+    {
+        return;
+    }
+
+    current = sampler;
+    switch ( stage )
+    {
+        case ShaderStage::Vertex:   _deviceContext->VSSetSamplers( slot, 1, &sampler ); break;
+        case ShaderStage::Geometry: _deviceContext->GSSetSamplers( slot, 1, &sampler ); break;
+        case ShaderStage::Pixel:    _deviceContext->PSSetSamplers( slot, 1, &sampler ); break;
+    }
+}
+
+// Sets a shader resource
+void StateTracker::SetShaderResource( ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view )
+{
+    assert( slot < MaxResourceSlots );
+    ID3D11ShaderResourceView*& current = _shaderResources[ static_cast<UINT>( stage ) ][ slot ];
+    if ( !Record( current != view ) )
+    {
+        return;
+    }
+
+    current = view;
+    switch ( stage )
+    {
+        case ShaderStage::Vertex:   _deviceContext->VSSetShaderResources( slot, 1, &view ); break;
+        case ShaderStage::Geometry: _deviceContext->GSSetShaderResources( slot, 1, &view ); break;
+        case ShaderStage::Pixel:    _deviceContext->PSSetShaderResources( slot, 1, &view ); break;
+    }
+}
+
+// Sets the stream output target
+void StateTracker::SetStreamOutTarget( ID3D11Buffer* buffer )
+{
+    if ( !Record( _streamOutTarget != buffer ) )
+    {
+        return;
+    }
+
+    // A buffer can't be read by the input assembler while it's being streamed into
+    if ( buffer && buffer == _vertexBuffer )
+    {
+        SetVertexBuffer( nullptr, 0, 0 );
+    }
+
+    UINT offset = 0;
+    _streamOutTarget = buffer;
+    _deviceContext->SOSetTargets( 1, &buffer, &offset );
+}
+
+// Sets the vertex buffer
+void StateTracker::SetVertexBuffer( ID3D11Buffer* buffer, UINT stride, UINT offset )
+{
+    if ( !Record( _vertexBuffer != buffer || _vertexStride != stride || _vertexOffset != offset ) )
+    {
+        return;
+    }
+
+    // Same as above, but the other way around
+    if ( buffer && buffer == _streamOutTarget )
+    {
+        SetStreamOutTarget( nullptr );
+    }
+
+    _vertexBuffer = buffer;
+    _vertexStride = stride;
+    _vertexOffset = offset;
+    _deviceContext->IASetVertexBuffers( 0, 1, &buffer, &stride, &offset );
+}
+
+// Sets the vertex shader
+void StateTracker::SetVertexShader( ID3D11VertexShader* shader )
+{
+    if ( Record( _vertexShader != shader ) )
+    {
+        _vertexShader = shader;
+        _deviceContext->VSSetShader( shader, nullptr, 0 );
+    }
+}
+
+// Sets the viewport
+void StateTracker::SetViewport( const D3D11_VIEWPORT& viewport )
+{
+    if ( Record( !_isViewportKnown || memcmp( &_viewport, &viewport, sizeof( D3D11_VIEWPORT ) ) != 0 ) )
+    {
+        _viewport = viewport;
+        _isViewportKnown = true;
+        _deviceContext->RSSetViewports( 1, &viewport );
+    }
+}
+
+// Unbinds any shader resource that views the same resource as the given view
+void StateTracker::UnbindResourceHazards( ID3D11View* view )
+{
+    if ( !view )
+    {
+        return;
+    }
+
+    ID3D11Resource* target = nullptr;
+    view->GetResource( &target );
+
+    for ( UINT stage = 0; stage < StageCount; ++stage )
+    {
+        for ( UINT slot = 0; slot < MaxResourceSlots; ++slot )
+        {
+            ID3D11ShaderResourceView* srv = _shaderResources[ stage ][ slot ];
+            if ( !srv || srv == UnknownState<ID3D11ShaderResourceView>() )
+            {
+                continue;
+            }
+
+            ID3D11Resource* resource = nullptr;
+            srv->GetResource( &resource );
+            if ( resource == target )
+            {
+                SetShaderResource( static_cast<ShaderStage>( stage ), slot, nullptr );
+            }
+            ReleaseMacro( resource );
+        }
+    }
+
+    ReleaseMacro( target );
+}
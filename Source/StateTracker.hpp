@@ -0,0 +1,264 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DirectX.hpp"
+
+/// <summary>
+/// An enumeration of the shader stages whose bindings are tracked.
+/// </summary>
+enum class ShaderStage
+{
+    Vertex,
+    Geometry,
+    Pixel,
+    Count
+};
+
+/// <summary>
+/// Describes the fixed-function and output state a render pass needs.
+/// </summary>
+struct RenderPassState
+{
+    ID3D11BlendState* BlendState;
+    float BlendFactor[ 4 ];
+    UINT BlendMask;
+    ID3D11DepthStencilState* DepthStencilState;
+    UINT StencilRef;
+    ID3D11RasterizerState* RasterizerState;
+    ID3D11RenderTargetView* RenderTarget;
+    ID3D11DepthStencilView* DepthStencil;
+    D3D11_VIEWPORT Viewport;
+
+    /// <summary>
+    /// Creates a new pass state describing the default device state.
+    /// </summary>
+    RenderPassState();
+};
+
+/// <summary>
+/// Defines a layer over a device context that shadows the currently bound
+/// pipeline state and drops any redundant state changes.
+/// </summary>
+class StateTracker
+{
+    ImplementNonCopyableClass( StateTracker );
+    ImplementNonMovableClass( StateTracker );
+
+public:
+    static const UINT MaxResourceSlots = 16;
+    static const UINT MaxConstantBufferSlots = 8;
+
+private:
+    static const UINT StageCount = static_cast<UINT>( ShaderStage::Count );
+
+    ID3D11DeviceContext* _deviceContext;
+
+    // Output merger and rasterizer state
+    ID3D11BlendState* _blendState;
+    float _blendFactor[ 4 ];
+    UINT _blendMask;
+    ID3D11DepthStencilState* _depthStencilState;
+    UINT _stencilRef;
+    ID3D11RasterizerState* _rasterizerState;
+    ID3D11RenderTargetView* _renderTarget;
+    ID3D11DepthStencilView* _depthStencil;
+    D3D11_VIEWPORT _viewport;
+
+    // Input assembler state
+    ID3D11InputLayout* _inputLayout;
+    D3D11_PRIMITIVE_TOPOLOGY _topology;
+    ID3D11Buffer* _vertexBuffer;
+    UINT _vertexStride;
+    UINT _vertexOffset;
+    ID3D11Buffer* _indexBuffer;
+    DXGI_FORMAT _indexFormat;
+    UINT _indexOffset;
+    ID3D11Buffer* _streamOutTarget;
+
+    // Shader stage state
+    ID3D11VertexShader* _vertexShader;
+    ID3D11GeometryShader* _geometryShader;
+    ID3D11PixelShader* _pixelShader;
+    ID3D11Buffer* _constantBuffers[ StageCount ][ MaxConstantBufferSlots ];
+    ID3D11ShaderResourceView* _shaderResources[ StageCount ][ MaxResourceSlots ];
+    ID3D11SamplerState* _samplers[ StageCount ][ MaxResourceSlots ];
+
+    bool _isViewportKnown;
+
+    UINT _callsIssued;
+    UINT _callsAvoided;
+    UINT _lastFrameCallsIssued;
+    UINT _lastFrameCallsAvoided;
+
+    /// <summary>
+    /// Records whether or not a state change was sent to the device.
+    /// </summary>
+    /// <param name="issued">True if the call was issued, false if it was redundant.</param>
+    /// <returns>The value of <paramref name="issued"/>.</returns>
+    bool Record( bool issued );
+
+    /// <summary>
+    /// Unbinds any shader resource that views the same resource as the given view.
+    /// </summary>
+    /// <param name="view">The view that is about to be bound for output.</param>
+    void UnbindResourceHazards( ID3D11View* view );
+
+public:
+    /// <summary>
+    /// Creates a new state tracker.
+    /// </summary>
+    /// <param name="deviceContext">The device context to track.</param>
+    StateTracker( ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Destroys this state tracker.
+    /// </summary>
+    ~StateTracker();
+
+    /// <summary>
+    /// Marks the start of a new frame, resetting the per-frame call counters.
+    /// </summary>
+    void BeginFrame();
+
+    /// <summary>
+    /// Gets the number of state calls sent to the device last frame.
+    /// </summary>
+    UINT GetCallsIssued() const;
+
+    /// <summary>
+    /// Gets the number of redundant state calls dropped last frame.
+    /// </summary>
+    UINT GetCallsAvoided() const;
+
+    /// <summary>
+    /// Gets the device context being tracked.
+    /// </summary>
+    ID3D11DeviceContext* GetDeviceContext();
+
+    /// <summary>
+    /// Forgets all shadowed state, forcing the next set of everything to reach the device.
+    /// </summary>
+    void Invalidate();
+
+    /// <summary>
+    /// Forgets the shadowed render targets and viewport. Call this when something
+    /// outside of the tracker binds them (i.e. on resize).
+    /// </summary>
+    void InvalidateOutputMerger();
+
+    /// <summary>
+    /// Applies the state described by a render pass.
+    /// </summary>
+    /// <param name="state">The pass state.</param>
+    void ApplyPassState( const RenderPassState& state );
+
+    /// <summary>
+    /// Sets the blend state.
+    /// </summary>
+    /// <param name="state">The blend state.</param>
+    /// <param name="factor">The blend factor, or null for all ones.</param>
+    /// <param name="mask">The sample mask.</param>
+    void SetBlendState( ID3D11BlendState* state, const float* factor = nullptr, UINT mask = 0xFFFFFFFF );
+
+    /// <summary>
+    /// Sets the constant buffer in the given shader stage slot.
+    /// </summary>
+    /// <param name="stage">The shader stage.</param>
+    /// <param name="slot">The slot.</param>
+    /// <param name="buffer">The constant buffer.</param>
+    void SetConstantBuffer( ShaderStage stage, UINT slot, ID3D11Buffer* buffer );
+
+    /// <summary>
+    /// Sets the depth/stencil state.
+    /// </summary>
+    /// <param name="state">The depth/stencil state.</param>
+    /// <param name="stencilRef">The stencil reference value.</param>
+    void SetDepthStencilState( ID3D11DepthStencilState* state, UINT stencilRef = 0 );
+
+    /// <summary>
+    /// Sets the geometry shader.
+    /// </summary>
+    /// <param name="shader">The geometry shader.</param>
+    void SetGeometryShader( ID3D11GeometryShader* shader );
+
+    /// <summary>
+    /// Sets the index buffer.
+    /// </summary>
+    /// <param name="buffer">The index buffer.</param>
+    /// <param name="format">The index format.</param>
+    /// <param name="offset">The offset, in bytes, of the first index.</param>
+    void SetIndexBuffer( ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset = 0 );
+
+    /// <summary>
+    /// Sets the input layout.
+    /// </summary>
+    /// <param name="layout">The input layout.</param>
+    void SetInputLayout( ID3D11InputLayout* layout );
+
+    /// <summary>
+    /// Sets the pixel shader.
+    /// </summary>
+    /// <param name="shader">The pixel shader.</param>
+    void SetPixelShader( ID3D11PixelShader* shader );
+
+    /// <summary>
+    /// Sets the primitive topology.
+    /// </summary>
+    /// <param name="topology">The primitive topology.</param>
+    void SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY topology );
+
+    /// <summary>
+    /// Sets the rasterizer state.
+    /// </summary>
+    /// <param name="state">The rasterizer state.</param>
+    void SetRasterizerState( ID3D11RasterizerState* state );
+
+    /// <summary>
+    /// Sets the render target and depth/stencil views.
+    /// </summary>
+    /// <param name="renderTarget">The render target, or null for none.</param>
+    /// <param name="depthStencil">The depth/stencil view, or null for none.</param>
+    void SetRenderTargets( ID3D11RenderTargetView* renderTarget, ID3D11DepthStencilView* depthStencil );
+
+    /// <summary>
+    /// Sets the sampler state in the given shader stage slot.
+    /// </summary>
+    /// <param name="stage">The shader stage.</param>
+    /// <param name="slot">The slot.</param>
+    /// <param name="sampler">The sampler state.</param>
+    void SetSampler( ShaderStage stage, UINT slot, ID3D11SamplerState* sampler );
+
+    /// <summary>
+    /// Sets the shader resource in the given shader stage slot.
+    /// </summary>
+    /// <param name="stage">The shader stage.</param>
+    /// <param name="slot">The slot.</param>
+    /// <param name="view">The shader resource view.</param>
+    void SetShaderResource( ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view );
+
+    /// <summary>
+    /// Sets the stream output target.
+    /// </summary>
+    /// <param name="buffer">The target buffer, or null to unbind the stream output stage.</param>
+    void SetStreamOutTarget( ID3D11Buffer* buffer );
+
+    /// <summary>
+    /// Sets the vertex buffer in the first input slot.
+    /// </summary>
+    /// <param name="buffer">The vertex buffer.</param>
+    /// <param name="stride">The vertex stride.</param>
+    /// <param name="offset">The offset, in bytes, of the first vertex.</param>
+    void SetVertexBuffer( ID3D11Buffer* buffer, UINT stride, UINT offset = 0 );
+
+    /// <summary>
+    /// Sets the vertex shader.
+    /// </summary>
+    /// <param name="shader">The vertex shader.</param>
+    void SetVertexShader( ID3D11VertexShader* shader );
+
+    /// <summary>
+    /// Sets the viewport.
+    /// </summary>
+    /// <param name="viewport">The viewport.</param>
+    void SetViewport( const D3D11_VIEWPORT& viewport );
+};
@@ -0,0 +1,258 @@
+#include "TextBatcher.hpp"
+#include "GameObject.hpp"
+#include "TextRenderer.hpp"
+#include "Transform.hpp"
+#include <algorithm>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+using namespace DirectX;
+
+const UINT TextBatcher::InitialGlyphCapacity = 4096;
+const UINT TextBatcher::MaxGlyphsPerDraw     = 4096; // 4096 * 4 vertices still fits in 16-bit indices
+
+// Attempts to create a new text batcher
+std::shared_ptr<TextBatcher> TextBatcher::Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    std::shared_ptr<TextBatcher> batcher( new ( std::nothrow ) TextBatcher( device, deviceContext ) );
+    if ( !batcher )
+    {
+        return nullptr;
+    }
+
+    // Load the shaders
+    batcher->_vertexShader = std::make_shared<SimpleVertexShader>( device, deviceContext );
+    batcher->_pixelShader  = std::make_shared<SimplePixelShader>( device, deviceContext );
+    batcher->_distanceFieldPixelShader = std::make_shared<SimplePixelShader>( device, deviceContext );
+    if ( !batcher->_vertexShader->LoadShaderFile( L"Shaders\\TextVertexShader.cso" ) ||
+         !batcher->_pixelShader->LoadShaderFile( L"Shaders\\TextPixelShader.cso" ) ||
+         !batcher->_distanceFieldPixelShader->LoadShaderFile( L"Shaders\\TextDistanceFieldPixelShader.cso" ) )
+    {
+        return nullptr;
+    }
+
+    // Create the buffers
+    if ( !batcher->CreateIndexBuffer() || !batcher->CreateVertexBuffer( InitialGlyphCapacity ) )
+    {
+        return nullptr;
+    }
+
+    return batcher;
+}
+
+// Creates a new text batcher
+TextBatcher::TextBatcher( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+    : _device( nullptr )
+    , _deviceContext( nullptr )
+    , _glyphCapacity( 0 )
+    , _ringOffset( 0 )
+{
+    UpdateD3DResource( _device, device );
+    UpdateD3DResource( _deviceContext, deviceContext );
+}
+
+// Destroys this text batcher
+TextBatcher::~TextBatcher()
+{
+    ReleaseMacro( _deviceContext );
+    ReleaseMacro( _device );
+}
+
+// Begins collecting text for a new frame
+void TextBatcher::Begin()
+{
+    _items.clear();
+    _batches.clear();
+}
+
+// Creates the index buffer shared by every glyph quad
+bool TextBatcher::CreateIndexBuffer()
+{
+    // Every quad is two triangles over its four vertices
+    std::vector<unsigned short> indices( MaxGlyphsPerDraw * 6 );
+    for ( UINT glyph = 0; glyph < MaxGlyphsPerDraw; ++glyph )
+    {
+        unsigned short vertex = static_cast<unsigned short>( glyph * TextRenderer::VerticesPerGlyph );
+        unsigned short* quad = &indices[ glyph * 6 ];
+        quad[ 0 ] = vertex + 0;
+        quad[ 1 ] = vertex + 1;
+        quad[ 2 ] = vertex + 2;
+        quad[ 3 ] = vertex + 2;
+        quad[ 4 ] = vertex + 1;
+        quad[ 5 ] = vertex + 3;
+    }
+
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth = static_cast<UINT>( sizeof( unsigned short ) * indices.size() );
+    desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+    D3D11_SUBRESOURCE_DATA data;
+    ZeroMemory( &data, sizeof( D3D11_SUBRESOURCE_DATA ) );
+    data.pSysMem = &indices[ 0 ];
+
+    _indexBuffer.Reset();
+    return SUCCEEDED( _device->CreateBuffer( &desc, &data, _indexBuffer.GetAddress() ) );
+}
+
+// Creates the ring vertex buffer
+bool TextBatcher::CreateVertexBuffer( UINT glyphCapacity )
+{
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_BUFFER_DESC ) );
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = sizeof( TextVertex ) * TextRenderer::VerticesPerGlyph * glyphCapacity;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    _vertexBuffer.Reset();
+    if ( FAILED( _device->CreateBuffer( &desc, nullptr, _vertexBuffer.GetAddress() ) ) )
+    {
+        _glyphCapacity = 0;
+        return false;
+    }
+
+    // Start "full" so that the first write discards
+    _glyphCapacity = glyphCapacity;
+    _ringOffset = glyphCapacity;
+    return true;
+}
+
+// Draws all of the text submitted since the last call to Begin
+void TextBatcher::End( StateTracker* stateTracker, const XMFLOAT4X4& projection, ID3D11SamplerState* sampler )
+{
+    if ( _items.empty() )
+    {
+        return;
+    }
+
+    // Count the glyphs and build one batch per run of items sharing an atlas. The text is alpha
+    // blended, so it's drawn in submission order to keep later text over anything it overlaps
+    UINT glyphCount = 0;
+    for ( auto& item : _items )
+    {
+        UINT itemGlyphs = item.Renderer->GetGlyphCount();
+        if ( _batches.empty() || _batches.back().Texture != item.Texture )
+        {
+            Batch batch = { item.Texture, glyphCount, 0, item.IsDistanceField };
+            _batches.push_back( batch );
+        }
+        _batches.back().GlyphCount += itemGlyphs;
+        glyphCount += itemGlyphs;
+    }
+
+    // Only grow the ring buffer when a frame genuinely needs more room than it has
+    if ( glyphCount > _glyphCapacity )
+    {
+        UINT capacity = std::max( _glyphCapacity, InitialGlyphCapacity );
+        while ( capacity < glyphCount )
+        {
+            capacity *= 2;
+        }
+        if ( !CreateVertexBuffer( capacity ) )
+        {
+            return;
+        }
+    }
+
+    // Write the glyphs
+    UINT baseGlyph = 0;
+    if ( !WriteGlyphs( glyphCount, baseGlyph ) )
+    {
+        return;
+    }
+
+    // Bind everything shared by all of the batches
+    _vertexShader->SetMatrix4x4( "Projection", projection );
+    _vertexShader->SetShader( true );
+    stateTracker->SetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+    stateTracker->SetVertexBuffer( _vertexBuffer.Get(), sizeof( TextVertex ) );
+    stateTracker->SetIndexBuffer( _indexBuffer.Get(), DXGI_FORMAT_R16_UINT );
+
+    // Now issue one draw per atlas
+    SimplePixelShader* activeShader = nullptr;
+    for ( auto& batch : _batches )
+    {
+        // Switch pixel shaders when moving between bitmap and distance field atlases
+        SimplePixelShader* pixelShader = batch.IsDistanceField ? _distanceFieldPixelShader.get() : _pixelShader.get();
+        if ( pixelShader != activeShader )
+        {
+            pixelShader->SetShader( true );
+            pixelShader->SetSamplerState( "TextSampler", sampler );
+            activeShader = pixelShader;
+        }
+        pixelShader->SetShaderResourceView( "TextTexture", batch.Texture->GetShaderResourceView() );
+
+        UINT drawn = 0;
+        while ( drawn < batch.GlyphCount )
+        {
+            UINT count = std::min( batch.GlyphCount - drawn, MaxGlyphsPerDraw );
+            INT  baseVertex = static_cast<INT>( ( baseGlyph + batch.FirstGlyph + drawn ) * TextRenderer::VerticesPerGlyph );
+            _deviceContext->DrawIndexed( count * 6, 0, baseVertex );
+            drawn += count;
+        }
+    }
+}
+
+// Submits a text renderer to be drawn this frame
+void TextBatcher::Submit( const TextRenderer* renderer, Texture2D* texture, const XMFLOAT4& color, bool isDistanceField )
+{
+    if ( !renderer || !texture || renderer->GetGlyphCount() == 0 )
+    {
+        return;
+    }
+
+    Item item;
+    item.Renderer = renderer;
+    item.Texture = texture;
+    item.World = renderer->GetGameObject()->GetTransform()->GetWorldMatrix();
+    item.Color = color;
+    item.IsDistanceField = isDistanceField;
+    _items.push_back( item );
+}
+
+// Writes the glyph quads of every submitted item into the ring buffer
+bool TextBatcher::WriteGlyphs( UINT glyphCount, UINT& baseGlyph )
+{
+    // Append after last frame's glyphs if they fit, otherwise orphan the buffer and wrap around
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if ( _ringOffset + glyphCount > _glyphCapacity )
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        _ringOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if ( FAILED( _deviceContext->Map( _vertexBuffer.Get(), 0, mapType, 0, &mapped ) ) )
+    {
+        return false;
+    }
+
+    TextVertex* dest = reinterpret_cast<TextVertex*>( mapped.pData ) + _ringOffset * TextRenderer::VerticesPerGlyph;
+    for ( auto& item : _items )
+    {
+        XMMATRIX world  = XMLoadFloat4x4( &item.World );
+        XMVECTOR color  = XMLoadFloat4( &item.Color );
+        float    uScale = 1.0f / item.Texture->GetWidth();
+        float    vScale = 1.0f / item.Texture->GetHeight();
+
+        // Transform each vertex into screen space and normalize its texture coordinates
+        for ( const TextVertex& source : item.Renderer->GetGlyphQuads() )
+        {
+            XMVECTOR position = XMVector2Transform( XMLoadFloat2( &source.Position ), world );
+            XMStoreFloat2( &dest->Position, position );
+            dest->UV.x = source.UV.x * uScale;
+            dest->UV.y = source.UV.y * vScale;
+            XMStoreFloat4( &dest->Color, XMVectorMultiply( XMLoadFloat4( &source.Color ), color ) );
+            ++dest;
+        }
+    }
+
+    _deviceContext->Unmap( _vertexBuffer.Get(), 0 );
+
+    baseGlyph = _ringOffset;
+    _ringOffset += glyphCount;
+    return true;
+}
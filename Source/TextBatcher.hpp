@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ComPtr.hpp"
+#include "Config.hpp"
+#include "DirectX.hpp"
+#include "SimpleShader.h"
+#include "StateTracker.hpp"
+#include "Texture2D.hpp"
+#include "Vertex.hpp"
+#include <memory>
+#include <vector>
+
+class TextRenderer;
+
+/// <summary>
+/// Defines a batcher that draws the glyph quads of every visible text renderer out of a
+/// single dynamic ring buffer, in the order they were submitted. Consecutive renderers that
+/// share a font atlas are drawn together in one draw. Atlases made of signed
+/// distance fields are drawn with their own pixel shader.
+/// </summary>
+class TextBatcher
+{
+    ImplementNonCopyableClass( TextBatcher );
+    ImplementNonMovableClass( TextBatcher );
+
+    /// <summary>
+    /// Defines a text renderer submitted for drawing this frame.
+    /// </summary>
+    struct Item
+    {
+        const TextRenderer* Renderer;
+        Texture2D* Texture;
+        DirectX::XMFLOAT4X4 World;
+        DirectX::XMFLOAT4 Color;
+        bool IsDistanceField;
+    };
+
+    /// <summary>
+    /// Defines a run of glyphs that share a font atlas.
+    /// </summary>
+    struct Batch
+    {
+        Texture2D* Texture;
+        UINT FirstGlyph;
+        UINT GlyphCount;
+        bool IsDistanceField;
+    };
+
+    static const UINT InitialGlyphCapacity;
+    static const UINT MaxGlyphsPerDraw;
+
+    ID3D11Device* _device;
+    ID3D11DeviceContext* _deviceContext;
+    ComPtr<ID3D11Buffer> _vertexBuffer;
+    ComPtr<ID3D11Buffer> _indexBuffer;
+    std::shared_ptr<SimpleVertexShader> _vertexShader;
+    std::shared_ptr<SimplePixelShader> _pixelShader;
+    std::shared_ptr<SimplePixelShader> _distanceFieldPixelShader;
+    std::vector<Item> _items;
+    std::vector<Batch> _batches;
+    UINT _glyphCapacity;
+    UINT _ringOffset;
+
+    /// <summary>
+    /// Creates a new text batcher.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    TextBatcher( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Creates the index buffer shared by every glyph quad.
+    /// </summary>
+    bool CreateIndexBuffer();
+
+    /// <summary>
+    /// Creates the ring vertex buffer with room for the given number of glyphs.
+    /// </summary>
+    /// <param name="glyphCapacity">The number of glyphs.</param>
+    bool CreateVertexBuffer( UINT glyphCapacity );
+
+    /// <summary>
+    /// Writes the glyph quads of every submitted item into the ring buffer.
+    /// </summary>
+    /// <param name="glyphCount">The total number of glyphs submitted.</param>
+    /// <param name="baseGlyph">Receives the index of the first glyph written in the ring buffer.</param>
+    bool WriteGlyphs( UINT glyphCount, UINT& baseGlyph );
+
+public:
+    /// <summary>
+    /// Attempts to create a new text batcher.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    static std::shared_ptr<TextBatcher> Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Destroys this text batcher.
+    /// </summary>
+    ~TextBatcher();
+
+    /// <summary>
+    /// Begins collecting text for a new frame.
+    /// </summary>
+    void Begin();
+
+    /// <summary>
+    /// Draws all of the text submitted since the last call to Begin.
+    /// </summary>
+    /// <param name="stateTracker">The state tracker to bind through.</param>
+    /// <param name="projection">The (transposed) projection matrix.</param>
+    /// <param name="sampler">The sampler to read the font atlases with.</param>
+    void End( StateTracker* stateTracker, const DirectX::XMFLOAT4X4& projection, ID3D11SamplerState* sampler );
+
+    /// <summary>
+    /// Submits a text renderer to be drawn this frame.
+    /// </summary>
+    /// <param name="renderer">The text renderer.</param>
+    /// <param name="texture">The font atlas the renderer's glyphs live in.</param>
+    /// <param name="color">The color to multiply every glyph by.</param>
+    /// <param name="isDistanceField">True if the font atlas is made of signed distance fields.</param>
+    void Submit( const TextRenderer* renderer, Texture2D* texture, const DirectX::XMFLOAT4& color, bool isDistanceField );
+};
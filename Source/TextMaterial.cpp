@@ -8,9 +8,7 @@ TextMaterial::TextMaterial( GameObject* gameObject )
     : Material( gameObject )
     , _textColor( 0, 0, 0, 0 )
 {
-    // Load the default vertex and pixel shaders
-    assert( _vertexShader->LoadShaderFile( L"Shaders\\TextVertexShader.cso" ) );
-    assert( _pixelShader->LoadShaderFile ( L"Shaders\\TextPixelShader.cso" ) );
+    // The text batcher owns the text shaders and reads our color when it submits text
 }
 
 // Destroys this text material
@@ -30,14 +28,3 @@ void TextMaterial::SetTextColor( const XMFLOAT4& color )
     _textColor = color;
 }
 
-// Sends this material's information to the shaders
-void TextMaterial::UpdateShaderData()
-{
-    // TODO - Set camera projection / view
-
-    // Send our variables
-    assert( _pixelShader->SetFloat4( "TextColor", _textColor ) );
-
-    // Let the base class do its thing
-    Material::UpdateShaderData();
-}
@@ -4,7 +4,8 @@
 #include <DirectXMath.h>
 
 /// <summary>
-/// Defines a material to be used when drawing text.
+/// Defines a material to be used when drawing text. The text batcher multiplies every glyph
+/// by this material's color, so text materials do not bind any shaders of their own.
 /// </summary>
 class TextMaterial : public Material
 {
@@ -32,9 +33,4 @@ public:
     /// </summary>
     /// <param name="color">The new color.</param>
     void SetTextColor( const DirectX::XMFLOAT4& color );
-
-    /// <summary>
-    /// Sends this material's information to the shaders.
-    /// </summary>
-    void UpdateShaderData() override;
 };
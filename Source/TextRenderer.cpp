@@ -3,6 +3,7 @@
 #include "GameObject.hpp"
 #include "RenderManager.hpp"
 #include "Transform.hpp"
+#include "Utf8.hpp"
 #include "Vertex.hpp"
 #include <algorithm> // TODO - Replace with custom math class
 #include <DirectXColors.h>
@@ -14,7 +15,9 @@ using namespace DirectX;
 // Create a new text renderer
 TextRenderer::TextRenderer( GameObject* gameObject )
     : Component( gameObject )
-    , _isMeshDirty( false )
+    , _atlasGeneration( 0 )
+    , _fontSize( 0 )
+    , _areQuadsDirty( false )
 {
     RenderManager::AddTextRenderer( this );
 }
@@ -25,6 +28,16 @@ TextRenderer::~TextRenderer()
     RenderManager::RemoveTextRenderer( this );
 }
 
+// Removes all per-character colors
+void TextRenderer::ClearCharacterColors()
+{
+    if ( !_characterColors.empty() )
+    {
+        _characterColors.clear();
+        _areQuadsDirty = true;
+    }
+}
+
 // Get our font
 const Font* TextRenderer::GetFont() const
 {
@@ -37,20 +50,22 @@ Font* TextRenderer::GetFont()
     return _font.get();
 }
 
-// Get our font's size
+// Get our font size
 unsigned int TextRenderer::GetFontSize() const
 {
-    if ( _font )
-    {
-        return _font->GetCurrentSize();
-    }
-    return 0;
+    return _fontSize;
 }
 
-// Get our mesh
-std::shared_ptr<Mesh> TextRenderer::GetMesh() const
+// Get the number of glyphs that will be drawn
+unsigned int TextRenderer::GetGlyphCount() const
 {
-    return _mesh;
+    return static_cast<unsigned int>( _glyphQuads.size() / VerticesPerGlyph );
+}
+
+// Get our glyph quads
+const std::vector<TextVertex>& TextRenderer::GetGlyphQuads() const
+{
+    return _glyphQuads;
 }
 
 // Get our text
@@ -65,37 +80,51 @@ bool TextRenderer::IsValid() const
     return static_cast<bool>( _font );
 }
 
-// Rebuild our text mesh (expensive operation)
-void TextRenderer::RebuildMesh()
+// Check if our glyph quads need to be rebuilt
+bool TextRenderer::NeedsRebuild()
+{
+    if ( _areQuadsDirty )
+    {
+        return true;
+    }
+    return _font && !_codepoints.empty() && ( _font->GetAtlasGeneration( _fontSize ) != _atlasGeneration );
+}
+
+// Rebuild our glyph quads (CPU only; the text batcher uploads them every frame)
+void TextRenderer::RebuildQuads()
 {
+    _glyphQuads.clear();
+    _areQuadsDirty = false;
+
     // If there's nothing to do, then... don't do anything
-    if ( !_font || _text.empty() || !_isMeshDirty )
+    if ( !_font || _codepoints.empty() || _fontSize == 0 )
     {
         return;
     }
 
 
 
-    // Get some helper variables
-    const unsigned int fontSize = GetFontSize();
-    float xSpace = _font->GetGlyph( ' ', fontSize ).Advance;
-    float ySpace = _font->GetLineSpacing( fontSize );
+    // Get some helper variables (the atlas generation is recorded up front, so that if looking up
+    // our own glyphs makes the atlas evict anything we get rebuilt again)
+    Font::GlyphPage& page = _font->GetPage( _fontSize );
+    _atlasGeneration = page.Atlas->GetGeneration();
+    float scale  = static_cast<float>( _fontSize ) / page.Size; // Only distance field pages differ from our size
+    float xSpace = _font->GetGlyph( page, ' ' ).Advance * scale;
+    float ySpace = page.LineSpacing * scale;
     float x      = 0.0f;
-    float y      = static_cast<float>( fontSize );
-    float uScale = 1.0f / _font->GetTexture( fontSize )->GetWidth();
-    float vScale = 1.0f / _font->GetTexture( fontSize )->GetHeight();
-    char  chPrev = 0;
-    std::vector<TextVertex> vertices;
+    float y      = static_cast<float>( _fontSize );
+    unsigned int chPrev = 0;
+    _glyphQuads.reserve( _codepoints.size() * VerticesPerGlyph );
 
 
 
     // Now go through and create one quad per character
-    for ( size_t i = 0; i < _text.length(); ++i )
+    for ( size_t i = 0; i < _codepoints.size(); ++i )
     {
-        char chCurr = _text[ i ];
+        unsigned int chCurr = _codepoints[ i ];
 
         // Apply the kerning between the previous and current character
-        x += _font->GetKerning( chPrev, chCurr, fontSize );
+        x += _font->GetKerning( page, chPrev, chCurr ) * scale;
         chPrev = chCurr;
 
         // Handle special characters
@@ -120,36 +149,46 @@ void TextRenderer::RebuildMesh()
         }
 
         // Get the glyph for the current character
-        Font::Glyph& glyph = _font->GetGlyph( chCurr, fontSize );
-
-        float left   = glyph.Bounds.X;
-        float top    = glyph.Bounds.Y;
-        float right  = left + glyph.Bounds.Width;
-        float bottom = top + glyph.Bounds.Height;
-
-        float u1 = uScale * ( glyph.TextureBounds.X );
-        float v1 = vScale * ( glyph.TextureBounds.Y );
-        float u2 = uScale * ( glyph.TextureBounds.X + glyph.TextureBounds.Width );
-        float v2 = vScale * ( glyph.TextureBounds.Y + glyph.TextureBounds.Height );
-
-        // Now add the quad
-        vertices.push_back( TextVertex( x + left,  y + top,     u1, v1 ) );
-        vertices.push_back( TextVertex( x + right, y + top,     u2, v1 ) );
-        vertices.push_back( TextVertex( x + left,  y + bottom,  u1, v2 ) );
-        vertices.push_back( TextVertex( x + left,  y + bottom,  u1, v2 ) );
-        vertices.push_back( TextVertex( x + right, y + top,     u2, v1 ) );
-        vertices.push_back( TextVertex( x + right, y + bottom,  u2, v2 ) );
+        Font::Glyph& glyph = _font->GetGlyph( page, chCurr );
+
+        float left   = glyph.Bounds.X * scale;
+        float top    = glyph.Bounds.Y * scale;
+        float right  = left + glyph.Bounds.Width * scale;
+        float bottom = top + glyph.Bounds.Height * scale;
+
+        // Texture coordinates stay in atlas pixels, so the quads survive the atlas growing
+        float u1 = static_cast<float>( glyph.TextureBounds.X );
+        float v1 = static_cast<float>( glyph.TextureBounds.Y );
+        float u2 = static_cast<float>( glyph.TextureBounds.X + glyph.TextureBounds.Width );
+        float v2 = static_cast<float>( glyph.TextureBounds.Y + glyph.TextureBounds.Height );
+
+        // Get the character's tint
+        XMFLOAT4 color( 1.0f, 1.0f, 1.0f, 1.0f );
+        if ( i < _characterColors.size() )
+        {
+            color = _characterColors[ i ];
+        }
+
+        // Now add the quad (the batcher's index buffer turns these into two triangles)
+        _glyphQuads.push_back( TextVertex( x + left,  y + top,    u1, v1, color ) );
+        _glyphQuads.push_back( TextVertex( x + right, y + top,    u2, v1, color ) );
+        _glyphQuads.push_back( TextVertex( x + left,  y + bottom, u1, v2, color ) );
+        _glyphQuads.push_back( TextVertex( x + right, y + bottom, u2, v2, color ) );
 
         // Advance to the next character
-        x += glyph.Advance;
+        x += glyph.Advance * scale;
     }
+}
 
-
-
-    // Create the mesh
-    ID3D11Device* device = _gameObject->GetDevice();
-    std::vector<UINT> indices;
-    _mesh = std::make_shared<Mesh>( device, vertices, indices );
+// Set the tint of a single character
+void TextRenderer::SetCharacterColor( size_t index, const XMFLOAT4& color )
+{
+    if ( index >= _characterColors.size() )
+    {
+        _characterColors.resize( index + 1, XMFLOAT4( 1.0f, 1.0f, 1.0f, 1.0f ) );
+    }
+    _characterColors[ index ] = color;
+    _areQuadsDirty = true;
 }
 
 // Set the font
@@ -158,17 +197,23 @@ void TextRenderer::SetFont( std::shared_ptr<Font> value )
     if ( _font.get() != value.get() )
     {
         _font = value;
-        _isMeshDirty = true;
+        _areQuadsDirty = true;
+
+        // Keep drawing at whatever size the font was set up for unless we've been given one
+        if ( _font && _fontSize == 0 )
+        {
+            _fontSize = _font->GetCurrentSize();
+        }
     }
 }
 
 // Set the font's size
 void TextRenderer::SetFontSize( unsigned int value )
 {
-    if ( _font )
+    if ( _fontSize != value )
     {
-        _font->SetCurrentSize( value );
-        _isMeshDirty = true;
+        _fontSize = value;
+        _areQuadsDirty = true;
     }
 }
 
@@ -178,16 +223,16 @@ void TextRenderer::SetText( const std::string& value )
     if ( _text != value )
     {
         _text = value;
-        _isMeshDirty = true;
+        Utf8::Decode( _text, _codepoints );
+        _areQuadsDirty = true;
     }
 }
 
 // Updates this text renderer
 void TextRenderer::Update()
 {
-    if ( _isMeshDirty )
+    if ( NeedsRebuild() )
     {
-        RebuildMesh();
-        _isMeshDirty = false;
+        RebuildQuads();
     }
 }
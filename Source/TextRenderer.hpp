@@ -1,10 +1,9 @@
 #pragma once
 
 #include "Component.hpp"
-#include "DeviceState.hpp"
 #include "Font.hpp"
-#include "Mesh.hpp"
-#include "SimpleShader.h"
+#include "Vertex.hpp"
+#include <vector>
 
 /// <summary>
 /// Defines a text renderer.
@@ -15,26 +14,36 @@ class TextRenderer : public Component
 
 private:
     std::string _text;
+    std::vector<unsigned int> _codepoints;
     std::shared_ptr<Font> _font;
-    std::shared_ptr<Mesh> _mesh;
-    bool _isMeshDirty;
+    std::vector<TextVertex> _glyphQuads;
+    std::vector<DirectX::XMFLOAT4> _characterColors;
+    unsigned int _atlasGeneration;
+    unsigned int _fontSize;
+    bool _areQuadsDirty;
 
     /// <summary>
-    /// Creates the device states used to render text.
+    /// Gets the font used by this text renderer.
     /// </summary>
-    void CreateDeviceStates();
+    Font* GetFont();
 
     /// <summary>
-    /// Gets the font used by this text renderer.
+    /// Checks to see if our glyph quads need to be rebuilt, either because something about the text
+    /// changed or because the font's atlas moved glyphs around since the quads were built.
     /// </summary>
-    Font* GetFont();
+    bool NeedsRebuild();
 
     /// <summary>
-    /// Rebuilds our text mesh.
+    /// Rebuilds our glyph quads.
     /// </summary>
-    void RebuildMesh();
+    void RebuildQuads();
 
 public:
+    /// <summary>
+    /// The number of vertices used by each glyph quad.
+    /// </summary>
+    static const unsigned int VerticesPerGlyph = 4;
+
     /// <summary>
     /// Creates a new text renderer.
     /// </summary>
@@ -46,20 +55,30 @@ public:
     /// </summary>
     ~TextRenderer();
 
+    /// <summary>
+    /// Removes all per-character colors.
+    /// </summary>
+    void ClearCharacterColors();
+
     /// <summary>
     /// Gets the font used by this text renderer.
     /// </summary>
     const Font* GetFont() const;
 
     /// <summary>
-    /// Gets the current font size.
+    /// Gets the size this text renderer draws its text at.
     /// </summary>
     unsigned int GetFontSize() const;
 
     /// <summary>
-    /// Gets the text mesh.
+    /// Gets the number of glyphs that will be drawn.
+    /// </summary>
+    unsigned int GetGlyphCount() const;
+
+    /// <summary>
+    /// Gets the glyph quads, in local space with texture coordinates in atlas pixels.
     /// </summary>
-    std::shared_ptr<Mesh> GetMesh() const;
+    const std::vector<TextVertex>& GetGlyphQuads() const;
 
     /// <summary>
     /// Gets the text being renderer.
@@ -72,7 +91,14 @@ public:
     bool IsValid() const;
 
     /// <summary>
-    /// Sets this text renderer's font.
+    /// Sets the tint of a single character. The tint is multiplied with the text material's color.
+    /// </summary>
+    /// <param name="index">The index of the character (codepoint, not byte) in the text.</param>
+    /// <param name="color">The character's tint.</param>
+    void SetCharacterColor( size_t index, const DirectX::XMFLOAT4& color );
+
+    /// <summary>
+    /// Sets this text renderer's font. If no font size has been set yet, the font's current size is used.
     /// </summary>
     /// <param name="value">The new font.</param>
     void SetFont( std::shared_ptr<Font> value );
@@ -86,7 +112,7 @@ public:
     /// <summary>
     /// Sets the text to be rendered.
     /// </summary>
-    /// <param name="value">The new text.</param>
+    /// <param name="value">The new text, encoded as UTF-8.</param>
     void SetText( const std::string& value );
 
     /// <summary>
@@ -1,6 +1,9 @@
 #include "Texture2D.hpp"
-
-std::unordered_map<std::string, std::shared_ptr<Texture2D>> Texture2D::_textureCache;
+#include "MappedFile.hpp"
+#include "ResourceManager.hpp"
+#include "TextureCompressor.hpp"
+#include "TextureStreamer.hpp"
+#include <algorithm>
 
 // Create an empty texture
 std::shared_ptr<Texture2D> Texture2D::Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext, unsigned int width, unsigned int height )
@@ -8,39 +11,141 @@ std::shared_ptr<Texture2D> Texture2D::Create( ID3D11Device* device, ID3D11Device
     return std::shared_ptr<Texture2D>( new (std::nothrow) Texture2D( device, deviceContext, width, height, nullptr, false ) );
 }
 
+// Creates an immutable texture and its view from a DDS file
+HRESULT Texture2D::CreateResources( ID3D11Device* device, const DdsFile& file, ID3D11Texture2D** texture, ID3D11ShaderResourceView** shaderResource )
+{
+    // Every mip level is already encoded, so the texture never has to be a render target
+    D3D11_TEXTURE2D_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_TEXTURE2D_DESC ) );
+    desc.Width = file.GetWidth();
+    desc.Height = file.GetHeight();
+    desc.Format = file.GetFormat();
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.MipLevels = file.GetLevelCount();
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> levels( file.GetLevelCount() );
+    for ( unsigned int level = 0; level < file.GetLevelCount(); ++level )
+    {
+        levels[ level ].pSysMem = file.GetLevelData( level );
+        levels[ level ].SysMemPitch = file.GetRowPitch( level );
+        levels[ level ].SysMemSlicePitch = static_cast<UINT>( file.GetLevelSize( level ) );
+    }
+
+    // Create the texture with all of its data in one go
+    HRESULT result = device->CreateTexture2D( &desc, &levels[ 0 ], texture );
+    if ( FAILED( result ) )
+    {
+        return result;
+    }
+
+    // Now create the shader resource view
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    ZeroMemory( &srvDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = desc.MipLevels;
+
+    result = device->CreateShaderResourceView( *texture, &srvDesc, shaderResource );
+    if ( FAILED( result ) )
+    {
+        ReleaseMacro( *texture );
+    }
+    return result;
+}
+
+// Load a texture from a DDS file
+std::shared_ptr<Texture2D> Texture2D::FromDdsFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname )
+{
+    DdsFile file;
+    if ( !file.LoadFromFile( fname ) )
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<Texture2D>( new (std::nothrow) Texture2D( device, deviceContext, file ) );
+}
+
 // Load a texture from a file
-std::shared_ptr<Texture2D> Texture2D::FromFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname )
+std::shared_ptr<Texture2D> Texture2D::FromFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname, bool isStreamed )
 {
-    // Check if the texture has already been loaded
-    auto search = _textureCache.find( fname );
-    if ( search != _textureCache.end() )
+    // Check if the texture has already been loaded; a streamed texture shared with something that
+    // doesn't request screen sizes would never leave its smallest mips, so it stays at full size
+    ResourceCache<Texture2D>& cache = ResourceManager::GetTextures();
+    std::shared_ptr<Texture2D> texture = cache.Find( fname );
+    if ( texture )
     {
-        return search->second;
+        if ( !isStreamed )
+        {
+            TextureStreamer::Pin( texture.get() );
+        }
+        return texture;
     }
 
-    std::shared_ptr<Texture2D> texture;
+    // Check if the same image has already been loaded from somewhere else, hashing the cooked file
+    // if the source image isn't around. Normal maps are decoded differently, so they never match colors
+    const bool isNormalMap = TextureCompressor::IsNormalMap( fname );
+    std::string cookedFileName = TextureCompressor::GetCookedFileName( fname );
+    UINT64 contentHash = 0;
+    {
+        MappedFile file;
+        if ( !file.Open( fname ) && !file.Open( cookedFileName ) )
+        {
+            return nullptr;
+        }
+        contentHash = file.Hash() ^ ( isNormalMap ? 1 : 0 );
+    }
+    texture = cache.FindContent( fname, contentHash );
+    if ( texture )
+    {
+        if ( !isStreamed )
+        {
+            TextureStreamer::Pin( texture.get() );
+        }
+        return texture;
+    }
 
-    // Attempt to load the file as an image
-    Image image;
-    if ( image.LoadFromFile( fname ) )
+    // Prefer streaming the cooked texture if asked to, then loading it whole, then decoding the image.
+    // A cooked texture older than its image is cooked again first so the edited image shows up
+    const bool isCooked = TextureCompressor::IsCookedFileCurrent( fname ) || TextureCompressor::CookFile( fname );
+    if ( isCooked && isStreamed )
+    {
+        texture = TextureStreamer::Load( cookedFileName );
+    }
+    if ( !texture && isCooked )
     {
-        texture = Texture2D::FromImage( device, deviceContext, image );
-        if ( texture )
+        texture = Texture2D::FromDdsFile( device, deviceContext, cookedFileName );
+    }
+    if ( !texture )
+    {
+        Image image;
+        if ( image.LoadFromFile( fname ) )
         {
-            _textureCache[ fname ] = texture;
+            texture = Texture2D::FromImage( device, deviceContext, image, !isNormalMap );
         }
     }
 
+    if ( texture )
+    {
+        cache.Add( fname, contentHash, texture );
+    }
+
     return texture;
 }
 
 // Load a texture from an image
-std::shared_ptr<Texture2D> Texture2D::FromImage( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image )
+std::shared_ptr<Texture2D> Texture2D::FromImage( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image, bool isSrgb )
 {
-    unsigned int width  = image.GetWidth();
-    unsigned int height = image.GetHeight();
-    const void*  pixels = &image._pixels[ 0 ];
-    return std::shared_ptr<Texture2D>( new (std::nothrow) Texture2D( device, deviceContext, width, height, pixels, true ) );
+    std::vector<Image> mips;
+    if ( !image.GenerateMips( ImageFilter::Kaiser, isSrgb, mips ) )
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<Texture2D>( new (std::nothrow) Texture2D( device, deviceContext, image, mips ) );
 }
 
 // Create an empty 2D texture
@@ -99,6 +204,59 @@ Texture2D::Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext,
     }
 }
 
+// Create a 2D texture from a DDS file
+Texture2D::Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const DdsFile& file )
+    : Texture( device, deviceContext )
+    , _texture( nullptr )
+    , _width( file.GetWidth() )
+    , _height( file.GetHeight() )
+{
+    HR( CreateResources( device, file, &_texture, &_shaderResource ) );
+}
+
+// Create a 2D texture from an image and its mip levels
+Texture2D::Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image, const std::vector<Image>& mips )
+    : Texture( device, deviceContext )
+    , _texture( nullptr )
+    , _width( image.GetWidth() )
+    , _height( image.GetHeight() )
+{
+    // Every mip level is already built, so the texture never has to be a render target
+    D3D11_TEXTURE2D_DESC desc;
+    ZeroMemory( &desc, sizeof( D3D11_TEXTURE2D_DESC ) );
+    desc.Width = _width;
+    desc.Height = _height;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.MipLevels = static_cast<UINT>( mips.size() + 1 );
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> levels( desc.MipLevels );
+    for ( UINT level = 0; level < desc.MipLevels; ++level )
+    {
+        const Image& source = ( level == 0 ) ? image : mips[ level - 1 ];
+        levels[ level ].pSysMem = &source._pixels[ 0 ];
+        levels[ level ].SysMemPitch = source.GetWidth() * 4;
+        levels[ level ].SysMemSlicePitch = source.GetWidth() * source.GetHeight() * 4;
+    }
+
+    // Create the texture with all of its data in one go
+    HR( device->CreateTexture2D( &desc, &levels[ 0 ], &_texture ) );
+
+    // Now create the shader resource view
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    ZeroMemory( &srvDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = desc.MipLevels;
+
+    HRESULT result = device->CreateShaderResourceView( _texture, &srvDesc, &_shaderResource );
+    if ( FAILED( result ) ) { ReleaseMacro( _texture ); HR( result ); }
+}
+
 // Destroy this 2D texture
 Texture2D::~Texture2D()
 {
@@ -108,17 +266,59 @@ Texture2D::~Texture2D()
 // Get the texture's height
 unsigned int Texture2D::GetHeight() const
 {
-    return _width;
+    return _height;
+}
+
+// Get the number of bytes the texture's mip levels use
+size_t Texture2D::GetMemorySize() const
+{
+    if ( !_texture )
+    {
+        return 0;
+    }
+
+    // Streamed textures change size as they go, so always ask the texture itself
+    D3D11_TEXTURE2D_DESC desc;
+    _texture->GetDesc( &desc );
+
+    const size_t blockSize = DdsFile::GetBlockSize( desc.Format );
+    size_t bytes = 0;
+    for ( UINT level = 0; level < desc.MipLevels; ++level )
+    {
+        size_t width = std::max( desc.Width >> level, 1U );
+        size_t height = std::max( desc.Height >> level, 1U );
+        if ( blockSize > 0 )
+        {
+            bytes += ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * blockSize;
+        }
+        else
+        {
+            bytes += width * height * 4;
+        }
+    }
+    return bytes;
 }
 
 // Get the texture's width
 unsigned int Texture2D::GetWidth() const
 {
-    return _height;
+    return _width;
+}
+
+// Swaps the texture's resources for new ones
+void Texture2D::ReplaceResources( ID3D11Texture2D* texture, ID3D11ShaderResourceView* shaderResource, unsigned int width, unsigned int height )
+{
+    ReleaseMacro( _shaderResource );
+    ReleaseMacro( _texture );
+
+    _texture = texture;
+    _shaderResource = shaderResource;
+    _width = width;
+    _height = height;
 }
 
 // Updates the given area of the texture
-void Texture2D::UpdateArea( unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data )
+void Texture2D::UpdateArea( unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data, unsigned int rowPitch )
 {
     // Create the subresource box
     D3D11_BOX box;
@@ -130,5 +330,9 @@ void Texture2D::UpdateArea( unsigned int x, unsigned int y, unsigned int width,
     box.back    = 1;
 
     // Update the subresource
-    _deviceContext->UpdateSubresource( _texture, 0, &box, data, width * 4, width * height * 4 );
+    if ( rowPitch == 0 )
+    {
+        rowPitch = width * 4;
+    }
+    _deviceContext->UpdateSubresource( _texture, 0, &box, data, rowPitch, rowPitch * height );
 }
@@ -1,9 +1,9 @@
 #pragma once
 
 #include "Texture.hpp"
+#include "DdsFile.hpp"
 #include "Image.hpp"
 #include <memory>
-#include <unordered_map>
 #include <string>
 
 /// <summary>
@@ -12,9 +12,9 @@
 class Texture2D : public Texture
 {
     friend class Font;
+    friend class GlyphAtlas;
     friend class Image;
-
-    static std::unordered_map<std::string, std::shared_ptr<Texture2D>> _textureCache;
+    friend class TextureStreamer;
 
     ID3D11Texture2D* _texture;
     unsigned int     _width;
@@ -32,14 +32,51 @@ class Texture2D : public Texture
     Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext, unsigned int width, unsigned int height, const void* data, bool genMipMaps );
 
     /// <summary>
-    /// Creates a new 2D texture.
+    /// Creates a new, immutable 2D texture from a DDS file's block-compressed mip chain.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    /// <param name="file">The DDS file.</param>
+    Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const DdsFile& file );
+
+    /// <summary>
+    /// Creates a new, immutable RGBA 2D texture from an image and its mip levels.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    /// <param name="image">The top mip level.</param>
+    /// <param name="mips">The rest of the mip levels, largest first.</param>
+    Texture2D( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image, const std::vector<Image>& mips );
+
+    /// <summary>
+    /// Creates an immutable texture and its shader resource view from a DDS file's mip chain. This
+    /// only touches the device, so it may be called from any thread.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="file">The DDS file.</param>
+    /// <param name="texture">Receives the texture.</param>
+    /// <param name="shaderResource">Receives the shader resource view.</param>
+    static HRESULT CreateResources( ID3D11Device* device, const DdsFile& file, ID3D11Texture2D** texture, ID3D11ShaderResourceView** shaderResource );
+
+    /// <summary>
+    /// Swaps this 2D texture's resources for new ones, taking ownership of them.
+    /// </summary>
+    /// <param name="texture">The new texture.</param>
+    /// <param name="shaderResource">The new shader resource view.</param>
+    /// <param name="width">The width of the new texture.</param>
+    /// <param name="height">The height of the new texture.</param>
+    void ReplaceResources( ID3D11Texture2D* texture, ID3D11ShaderResourceView* shaderResource, unsigned int width, unsigned int height );
+
+    /// <summary>
+    /// Updates an area of this 2D texture.
     /// </summary>
     /// <param name="x">The X coordinate of the area to update.</param>
     /// <param name="y">The Y coordinate of the area to update.</param>
     /// <param name="width">The width of the area to update.</param>
     /// <param name="height">The height of the area to update.</param>
     /// <param name="data">The data for the area to update. (NOTE: Assumed to be RGBA.)</param>
-    void UpdateArea( unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data );
+    /// <param name="rowPitch">The number of bytes between rows of the data, or 0 if the rows are tightly packed.</param>
+    void UpdateArea( unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void* data, unsigned int rowPitch = 0 );
 
 public:
     /// <summary>
@@ -52,20 +89,32 @@ public:
     static std::shared_ptr<Texture2D> Create( ID3D11Device* device, ID3D11DeviceContext* deviceContext, unsigned int width, unsigned int height );
 
     /// <summary>
-    /// Loads a 2D texture from a file.
+    /// Loads a BC1, BC3 or BC5 2D texture and all of its mip levels from a DDS file.
+    /// </summary>
+    /// <param name="device">The device to use.</param>
+    /// <param name="deviceContext">The device context to use.</param>
+    /// <param name="fname">The file to load.</param>
+    static std::shared_ptr<Texture2D> FromDdsFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname );
+
+    /// <summary>
+    /// Loads a 2D texture from a file. If the file has been cooked, the cooked DDS file is loaded
+    /// instead, and can be streamed if the texture streamer is running. Loaded textures are kept in the
+    /// resource manager's texture cache, and are shared with every other path to the same image.
     /// </summary>
     /// <param name="device">The device to use.</param>
     /// <param name="deviceContext">The device context to use.</param>
     /// <param name="fname">The file to load.</param>
-    static std::shared_ptr<Texture2D> FromFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname );
+    /// <param name="isStreamed">True to stream the texture, which only raises its resolution while something requests a screen size for it every frame it's drawn.</param>
+    static std::shared_ptr<Texture2D> FromFile( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& fname, bool isStreamed = false );
 
     /// <summary>
-    /// Loads a 2D texture from an image.
+    /// Loads a 2D texture from an image. The mip chain is built on the CPU and uploaded along with the image.
     /// </summary>
     /// <param name="device">The device to use.</param>
     /// <param name="deviceContext">The device context to use.</param>
     /// <param name="image">The image to load.</param>
-    static std::shared_ptr<Texture2D> FromImage( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image );
+    /// <param name="isSrgb">True if the image holds sRGB colors, false if it holds linear data such as normals.</param>
+    static std::shared_ptr<Texture2D> FromImage( ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Image& image, bool isSrgb = true );
 
     /// <summary>
     /// Destroys this 2D texture.
@@ -77,6 +126,11 @@ public:
     /// </summary>
     unsigned int GetHeight() const;
 
+    /// <summary>
+    /// Gets the number of bytes this 2D texture's mip levels currently use.
+    /// </summary>
+    size_t GetMemorySize() const;
+
     /// <summary>
     /// Gets this 2D texture's width.
     /// </summary>
@@ -0,0 +1,493 @@
+#include "TextureCompressor.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+// The image extensions that get cooked
+static const char* CookableExtensions[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".tiff" };
+
+// Reads a 4x4 block of RGBA pixels, clamping at the image's edges
+static void ReadBlock( const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int blockX, unsigned int blockY, unsigned char block[ 64 ] )
+{
+    for ( unsigned int y = 0; y < 4; ++y )
+    {
+        unsigned int sourceY = std::min( blockY * 4 + y, height - 1 );
+        for ( unsigned int x = 0; x < 4; ++x )
+        {
+            unsigned int sourceX = std::min( blockX * 4 + x, width - 1 );
+            memcpy( block + ( y * 4 + x ) * 4, pixels + ( sourceY * width + sourceX ) * 4, 4 );
+        }
+    }
+}
+
+// Packs an 8-bit color into 5:6:5
+static unsigned short PackColor565( const float color[ 3 ] )
+{
+    int r = static_cast<int>( color[ 0 ] * ( 31.0f / 255.0f ) + 0.5f );
+    int g = static_cast<int>( color[ 1 ] * ( 63.0f / 255.0f ) + 0.5f );
+    int b = static_cast<int>( color[ 2 ] * ( 31.0f / 255.0f ) + 0.5f );
+    r = std::min( std::max( r, 0 ), 31 );
+    g = std::min( std::max( g, 0 ), 63 );
+    b = std::min( std::max( b, 0 ), 31 );
+    return static_cast<unsigned short>( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+// Expands a 5:6:5 color back to 8 bits per channel
+static void UnpackColor565( unsigned short packed, int color[ 3 ] )
+{
+    int r = ( packed >> 11 ) & 31;
+    int g = ( packed >> 5 ) & 63;
+    int b = packed & 31;
+    color[ 0 ] = ( r << 3 ) | ( r >> 2 );
+    color[ 1 ] = ( g << 2 ) | ( g >> 4 );
+    color[ 2 ] = ( b << 3 ) | ( b >> 2 );
+}
+
+// Encodes the RGB channels of a block as a BC1 color block
+static void EncodeColorBlock( const unsigned char block[ 64 ], unsigned char* output )
+{
+    // Find the block's mean color and covariance
+    float mean[ 3 ] = { 0.0f, 0.0f, 0.0f };
+    for ( int i = 0; i < 16; ++i )
+    {
+        mean[ 0 ] += block[ i * 4 + 0 ];
+        mean[ 1 ] += block[ i * 4 + 1 ];
+        mean[ 2 ] += block[ i * 4 + 2 ];
+    }
+    mean[ 0 ] /= 16.0f;
+    mean[ 1 ] /= 16.0f;
+    mean[ 2 ] /= 16.0f;
+
+    float covariance[ 6 ] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for ( int i = 0; i < 16; ++i )
+    {
+        float r = block[ i * 4 + 0 ] - mean[ 0 ];
+        float g = block[ i * 4 + 1 ] - mean[ 1 ];
+        float b = block[ i * 4 + 2 ] - mean[ 2 ];
+        covariance[ 0 ] += r * r;
+        covariance[ 1 ] += r * g;
+        covariance[ 2 ] += r * b;
+        covariance[ 3 ] += g * g;
+        covariance[ 4 ] += g * b;
+        covariance[ 5 ] += b * b;
+    }
+
+    // Find the principal axis with a few rounds of power iteration
+    float axis[ 3 ] = { 1.0f, 1.0f, 1.0f };
+    for ( int iteration = 0; iteration < 4; ++iteration )
+    {
+        float x = covariance[ 0 ] * axis[ 0 ] + covariance[ 1 ] * axis[ 1 ] + covariance[ 2 ] * axis[ 2 ];
+        float y = covariance[ 1 ] * axis[ 0 ] + covariance[ 3 ] * axis[ 1 ] + covariance[ 4 ] * axis[ 2 ];
+        float z = covariance[ 2 ] * axis[ 0 ] + covariance[ 4 ] * axis[ 1 ] + covariance[ 5 ] * axis[ 2 ];
+        float length = std::max( fabsf( x ), std::max( fabsf( y ), fabsf( z ) ) );
+        if ( length < 1e-6f )
+        {
+            break;
+        }
+        axis[ 0 ] = x / length;
+        axis[ 1 ] = y / length;
+        axis[ 2 ] = z / length;
+    }
+
+    // Use the extents of the colors along the axis as the endpoints
+    float axisLengthSquared = axis[ 0 ] * axis[ 0 ] + axis[ 1 ] * axis[ 1 ] + axis[ 2 ] * axis[ 2 ];
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    for ( int i = 0; i < 16; ++i )
+    {
+        float t = ( block[ i * 4 + 0 ] - mean[ 0 ] ) * axis[ 0 ]
+                + ( block[ i * 4 + 1 ] - mean[ 1 ] ) * axis[ 1 ]
+                + ( block[ i * 4 + 2 ] - mean[ 2 ] ) * axis[ 2 ];
+        minimum = std::min( minimum, t );
+        maximum = std::max( maximum, t );
+    }
+    minimum /= axisLengthSquared;
+    maximum /= axisLengthSquared;
+
+    float start[ 3 ];
+    float end[ 3 ];
+    for ( int channel = 0; channel < 3; ++channel )
+    {
+        start[ channel ] = mean[ channel ] + axis[ channel ] * maximum;
+        end[ channel ] = mean[ channel ] + axis[ channel ] * minimum;
+    }
+
+    // The first endpoint must be larger to select four-color mode
+    unsigned short color0 = PackColor565( start );
+    unsigned short color1 = PackColor565( end );
+    if ( color0 < color1 )
+    {
+        std::swap( color0, color1 );
+    }
+
+    // Build the palette and pick the closest entry for each pixel
+    int palette[ 4 ][ 3 ];
+    UnpackColor565( color0, palette[ 0 ] );
+    UnpackColor565( color1, palette[ 1 ] );
+    for ( int channel = 0; channel < 3; ++channel )
+    {
+        palette[ 2 ][ channel ] = ( 2 * palette[ 0 ][ channel ] + palette[ 1 ][ channel ] ) / 3;
+        palette[ 3 ][ channel ] = ( palette[ 0 ][ channel ] + 2 * palette[ 1 ][ channel ] ) / 3;
+    }
+
+    unsigned int indices = 0;
+    if ( color0 != color1 )
+    {
+        for ( int i = 0; i < 16; ++i )
+        {
+            int bestIndex = 0;
+            int bestDistance = INT_MAX;
+            for ( int entry = 0; entry < 4; ++entry )
+            {
+                int r = block[ i * 4 + 0 ] - palette[ entry ][ 0 ];
+                int g = block[ i * 4 + 1 ] - palette[ entry ][ 1 ];
+                int b = block[ i * 4 + 2 ] - palette[ entry ][ 2 ];
+                int distance = r * r + g * g + b * b;
+                if ( distance < bestDistance )
+                {
+                    bestDistance = distance;
+                    bestIndex = entry;
+                }
+            }
+            indices |= static_cast<unsigned int>( bestIndex ) << ( i * 2 );
+        }
+    }
+
+    output[ 0 ] = static_cast<unsigned char>( color0 & 0xFF );
+    output[ 1 ] = static_cast<unsigned char>( color0 >> 8 );
+    output[ 2 ] = static_cast<unsigned char>( color1 & 0xFF );
+    output[ 3 ] = static_cast<unsigned char>( color1 >> 8 );
+    for ( int i = 0; i < 4; ++i )
+    {
+        output[ 4 + i ] = static_cast<unsigned char>( ( indices >> ( i * 8 ) ) & 0xFF );
+    }
+}
+
+// Encodes one channel of a block as a BC4 block (the alpha half of BC3, and each half of BC5)
+static void EncodeChannelBlock( const unsigned char block[ 64 ], int channel, unsigned char* output )
+{
+    int minimum = 255;
+    int maximum = 0;
+    for ( int i = 0; i < 16; ++i )
+    {
+        minimum = std::min( minimum, static_cast<int>( block[ i * 4 + channel ] ) );
+        maximum = std::max( maximum, static_cast<int>( block[ i * 4 + channel ] ) );
+    }
+
+    // With the first endpoint larger, the palette holds the endpoints and six interpolated values
+    int palette[ 8 ];
+    palette[ 0 ] = maximum;
+    palette[ 1 ] = minimum;
+    for ( int entry = 2; entry < 8; ++entry )
+    {
+        palette[ entry ] = ( ( 8 - entry ) * maximum + ( entry - 1 ) * minimum ) / 7;
+    }
+
+    unsigned long long indices = 0;
+    if ( maximum != minimum )
+    {
+        for ( int i = 0; i < 16; ++i )
+        {
+            int value = block[ i * 4 + channel ];
+            int bestIndex = 0;
+            int bestDistance = INT_MAX;
+            for ( int entry = 0; entry < 8; ++entry )
+            {
+                int distance = abs( value - palette[ entry ] );
+                if ( distance < bestDistance )
+                {
+                    bestDistance = distance;
+                    bestIndex = entry;
+                }
+            }
+            indices |= static_cast<unsigned long long>( bestIndex ) << ( i * 3 );
+        }
+    }
+
+    output[ 0 ] = static_cast<unsigned char>( maximum );
+    output[ 1 ] = static_cast<unsigned char>( minimum );
+    for ( int i = 0; i < 6; ++i )
+    {
+        output[ 2 + i ] = static_cast<unsigned char>( ( indices >> ( i * 8 ) ) & 0xFF );
+    }
+}
+
+// Gets the last time a file was written to, or 0 if it doesn't exist
+static unsigned long long GetLastWriteTime( const std::string& fname )
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if ( !GetFileAttributesExA( fname.c_str(), GetFileExInfoStandard, &attributes ) )
+    {
+        return 0;
+    }
+    return ( static_cast<unsigned long long>( attributes.ftLastWriteTime.dwHighDateTime ) << 32 ) | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+// Checks to see if a file name has an extension that gets cooked
+static bool IsCookable( const std::string& fname )
+{
+    size_t dot = fname.find_last_of( '.' );
+    if ( dot == std::string::npos )
+    {
+        return false;
+    }
+
+    std::string extension = fname.substr( dot );
+    for ( auto cookable : CookableExtensions )
+    {
+        if ( 0 == _stricmp( extension.c_str(), cookable ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Encodes an image into blocks
+bool TextureCompressor::Compress( const Image& image, DXGI_FORMAT format, std::vector<unsigned char>& blocks )
+{
+    unsigned int blockSize = DdsFile::GetBlockSize( format );
+    if ( blockSize == 0 || image._width == 0 || image._height == 0 )
+    {
+        return false;
+    }
+
+    const unsigned int blocksWide = ( image._width + 3 ) / 4;
+    const unsigned int blocksHigh = ( image._height + 3 ) / 4;
+    blocks.resize( blocksWide * blocksHigh * blockSize );
+
+    const unsigned char* pixels = &image._pixels[ 0 ];
+    unsigned char* output = &blocks[ 0 ];
+    const unsigned int width = image._width;
+    const unsigned int height = image._height;
+    ThreadPool::ParallelFor( blocksHigh, 4, [ = ]( size_t begin, size_t end )
+    {
+        unsigned char block[ 64 ];
+        for ( size_t blockY = begin; blockY < end; ++blockY )
+        {
+            unsigned char* row = output + blockY * blocksWide * blockSize;
+            for ( unsigned int blockX = 0; blockX < blocksWide; ++blockX )
+            {
+                ReadBlock( pixels, width, height, blockX, static_cast<unsigned int>( blockY ), block );
+
+                unsigned char* target = row + blockX * blockSize;
+                switch ( format )
+                {
+                    case DXGI_FORMAT_BC1_UNORM:
+                        EncodeColorBlock( block, target );
+                        break;
+                    case DXGI_FORMAT_BC3_UNORM:
+                        EncodeChannelBlock( block, 3, target );
+                        EncodeColorBlock( block, target + 8 );
+                        break;
+                    case DXGI_FORMAT_BC5_UNORM:
+                        EncodeChannelBlock( block, 0, target );
+                        EncodeChannelBlock( block, 1, target + 8 );
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    } );
+
+    return true;
+}
+
+// Cooks every out of date image in a directory
+unsigned int TextureCompressor::CookDirectory( const std::string& directory )
+{
+    unsigned int cooked = 0;
+
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA( ( directory + "\\*" ).c_str(), &findData );
+    if ( find == INVALID_HANDLE_VALUE )
+    {
+        return 0;
+    }
+
+    do
+    {
+        if ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+        {
+            continue;
+        }
+
+        // Only cook the images that changed since they were last cooked, or whose cooked file can't be loaded
+        std::string fname = directory + "\\" + findData.cFileName;
+        if ( !IsCookable( fname ) )
+        {
+            continue;
+        }
+
+        if ( IsCookedFileCurrent( fname ) )
+        {
+            continue;
+        }
+
+        if ( CookFile( fname ) )
+        {
+            ++cooked;
+        }
+    }
+    while ( FindNextFileA( find, &findData ) );
+
+    FindClose( find );
+    return cooked;
+}
+
+// Cooks an image file into a DDS file
+bool TextureCompressor::CookFile( const std::string& fname )
+{
+    Image image;
+    if ( !image.LoadFromFile( fname ) )
+    {
+        return false;
+    }
+
+    // Pick the format based on what the texture holds
+    bool isNormalMap = IsNormalMap( fname );
+    DXGI_FORMAT format = DXGI_FORMAT_BC1_UNORM;
+    if ( isNormalMap )
+    {
+        format = DXGI_FORMAT_BC5_UNORM;
+    }
+    else
+    {
+        for ( size_t i = 3; i < image._pixels.size(); i += 4 )
+        {
+            if ( image._pixels[ i ] != 255 )
+            {
+                format = DXGI_FORMAT_BC3_UNORM;
+                break;
+            }
+        }
+    }
+
+    // D3D11 rejects a block-compressed texture whose top level isn't whole blocks, so stretch the
+    // image to fit; normals aren't colors, so they skip the sRGB curve here and when filtering mips
+    const unsigned int width = GetCookedSize( image._width );
+    const unsigned int height = GetCookedSize( image._height );
+    if ( width != image._width || height != image._height )
+    {
+        Image resized;
+        if ( !image.Resize( width, height, ImageFilter::Kaiser, !isNormalMap, resized ) )
+        {
+            return false;
+        }
+        image = resized;
+    }
+
+    // Filter the mip chain in linear space
+    std::vector<Image> mips;
+    if ( !image.GenerateMips( ImageFilter::Kaiser, !isNormalMap, mips ) )
+    {
+        return false;
+    }
+
+    // Encode every mip level down to 1x1
+    DdsFile file;
+    if ( !file.Reset( image._width, image._height, format ) )
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> blocks;
+    for ( size_t level = 0; level <= mips.size(); ++level )
+    {
+        Image& source = ( level == 0 ) ? image : mips[ level - 1 ];
+        if ( isNormalMap && level > 0 )
+        {
+            NormalizeNormals( source );
+        }
+
+        if ( !Compress( source, format, blocks ) || !file.AddLevel( &blocks[ 0 ], blocks.size() ) )
+        {
+            return false;
+        }
+    }
+
+    bool saved = file.Save( GetCookedFileName( fname ) );
+#if defined( _DEBUG ) || defined( DEBUG )
+    std::cout << ( saved ? "Cooked '" : "Failed to cook '" ) << fname << "'" << std::endl;
+#endif
+    return saved;
+}
+
+// Gets the size a side of a texture's top level is cooked at
+unsigned int TextureCompressor::GetCookedSize( unsigned int size )
+{
+    if ( size % 4 == 0 )
+    {
+        return size;
+    }
+
+    const unsigned int alignment = ( size >= 256 ) ? 64 : 4;
+    return ( size + alignment - 1 ) / alignment * alignment;
+}
+
+// Pushes a normal map's normals back out to unit length
+void TextureCompressor::NormalizeNormals( Image& image )
+{
+    for ( size_t i = 0; i < image._pixels.size(); i += 4 )
+    {
+        float normal[ 3 ];
+        for ( int channel = 0; channel < 3; ++channel )
+        {
+            normal[ channel ] = image._pixels[ i + channel ] / 127.5f - 1.0f;
+        }
+
+        float length = sqrtf( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+        if ( length > 1e-6f )
+        {
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                float value = ( normal[ channel ] / length + 1.0f ) * 127.5f + 0.5f;
+                image._pixels[ i + channel ] = static_cast<unsigned char>( std::min( std::max( value, 0.0f ), 255.0f ) );
+            }
+        }
+    }
+}
+
+// Gets the name of an image file's cooked file
+std::string TextureCompressor::GetCookedFileName( const std::string& fname )
+{
+    size_t dot = fname.find_last_of( '.' );
+    size_t slash = fname.find_last_of( "\\/" );
+    if ( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+    {
+        return fname + ".dds";
+    }
+    return fname.substr( 0, dot ) + ".dds";
+}
+
+// Checks to see if an image file's cooked file is up to date
+bool TextureCompressor::IsCookedFileCurrent( const std::string& fname )
+{
+    std::string cookedFileName = GetCookedFileName( fname );
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int levelCount = 0;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    return GetLastWriteTime( cookedFileName ) >= GetLastWriteTime( fname ) && DdsFile::ReadInfo( cookedFileName, width, height, format, levelCount );
+}
+
+// Checks to see if an image file is a normal map
+bool TextureCompressor::IsNormalMap( const std::string& fname )
+{
+    const char* suffix = "normals";
+    const size_t suffixLength = strlen( suffix );
+
+    size_t dot = fname.find_last_of( '.' );
+    std::string name = fname.substr( 0, dot );
+    if ( name.length() < suffixLength )
+    {
+        return false;
+    }
+    return 0 == _stricmp( name.c_str() + name.length() - suffixLength, suffix );
+}
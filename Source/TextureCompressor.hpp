@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Config.hpp"
+#include "DdsFile.hpp"
+#include "Image.hpp"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines the static texture compressor. Textures are cooked ahead of time into DDS files: diffuse
+/// maps become BC1 (or BC3 if they have alpha), normal maps become BC5, and every mip level is
+/// encoded up front so the runtime never has to generate mips on the GPU.
+/// </summary>
+class TextureCompressor
+{
+    ImplementStaticClass( TextureCompressor );
+
+    /// <summary>
+    /// Gets the size a side of a texture's top level is cooked at. Sides that aren't a whole number
+    /// of blocks are stretched to one, and large ones to a multiple of 64 so that the top five mip
+    /// levels stay whole numbers of blocks and can be streamed in on their own.
+    /// </summary>
+    /// <param name="size">The side's size in the source image.</param>
+    static unsigned int GetCookedSize( unsigned int size );
+
+    /// <summary>
+    /// Pushes a normal map's filtered normals back out to unit length.
+    /// </summary>
+    /// <param name="image">The normal map.</param>
+    static void NormalizeNormals( Image& image );
+
+public:
+    /// <summary>
+    /// Encodes an image into 4x4 blocks of the given format. Rows of blocks are spread across the thread pool.
+    /// </summary>
+    /// <param name="image">The image.</param>
+    /// <param name="format">BC1, BC3 or BC5.</param>
+    /// <param name="blocks">Receives the encoded blocks.</param>
+    static bool Compress( const Image& image, DXGI_FORMAT format, std::vector<unsigned char>& blocks );
+
+    /// <summary>
+    /// Cooks every image in the given directory whose cooked file is missing or out of date.
+    /// </summary>
+    /// <param name="directory">The directory.</param>
+    /// <returns>The number of textures cooked.</returns>
+    static unsigned int CookDirectory( const std::string& directory );
+
+    /// <summary>
+    /// Cooks the given image file into a DDS file with a full mip chain.
+    /// </summary>
+    /// <param name="fname">The image file.</param>
+    static bool CookFile( const std::string& fname );
+
+    /// <summary>
+    /// Gets the name of the cooked file for the given image file.
+    /// </summary>
+    /// <param name="fname">The image file.</param>
+    static std::string GetCookedFileName( const std::string& fname );
+
+    /// <summary>
+    /// Checks to see if the given image file's cooked file exists, can be read and is no older than
+    /// the image. A cooked file without its image is always current.
+    /// </summary>
+    /// <param name="fname">The image file.</param>
+    static bool IsCookedFileCurrent( const std::string& fname );
+
+    /// <summary>
+    /// Checks to see if the given image file is a normal map (i.e. its name ends in "Normals").
+    /// </summary>
+    /// <param name="fname">The image file.</param>
+    static bool IsNormalMap( const std::string& fname );
+};
@@ -0,0 +1,435 @@
+#include "TextureStreamer.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#if defined( _DEBUG ) || defined( DEBUG )
+#   include <iostream>
+#endif
+
+const unsigned int                                  TextureStreamer::TailSize = 64;
+const unsigned int                                  TextureStreamer::FramesUntilIdle = 120;
+const size_t                                        TextureStreamer::DefaultBudget = 256 * 1024 * 1024;
+ID3D11Device*                                       TextureStreamer::_device = nullptr;
+ID3D11DeviceContext*                                TextureStreamer::_deviceContext = nullptr;
+std::vector<TextureStreamer::Entry>                 TextureStreamer::_entries;
+std::unordered_map<const Texture2D*, size_t>        TextureStreamer::_entryLookup;
+std::vector<size_t>                                 TextureStreamer::_freeEntries;
+std::thread                                         TextureStreamer::_loader;
+std::mutex                                          TextureStreamer::_mutex;
+std::condition_variable                             TextureStreamer::_requestAdded;
+std::deque<TextureStreamer::LoadRequest>            TextureStreamer::_requests;
+std::vector<TextureStreamer::LoadResult>            TextureStreamer::_results;
+size_t                                              TextureStreamer::_budget = TextureStreamer::DefaultBudget;
+size_t                                              TextureStreamer::_residentBytes = 0;
+unsigned int                                        TextureStreamer::_frame = 0;
+bool                                                TextureStreamer::_isShuttingDown = false;
+
+// Swaps in the textures the loader thread has finished
+void TextureStreamer::ApplyFinishedLoads()
+{
+    std::vector<LoadResult> results;
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        results.swap( _results );
+    }
+
+    for ( auto& result : results )
+    {
+        Entry& entry = _entries[ result.Entry ];
+        entry.PendingLevel = entry.LevelCount;
+
+        // Throw the load away if the texture is gone or the budget shrank while it was loading
+        std::shared_ptr<Texture2D> texture = entry.Texture.lock();
+        if ( !texture || !result.Texture || result.Level < entry.TargetLevel )
+        {
+            ReleaseMacro( result.ShaderResource );
+            ReleaseMacro( result.Texture );
+            continue;
+        }
+
+        _residentBytes += GetLevelBytes( entry, result.Level );
+        _residentBytes -= GetLevelBytes( entry, entry.ResidentLevel );
+        entry.ResidentLevel = result.Level;
+
+        texture->ReplaceResources( result.Texture, result.ShaderResource,
+                                   std::max( entry.Width >> result.Level, 1U ),
+                                   std::max( entry.Height >> result.Level, 1U ) );
+    }
+}
+
+// Lowers a texture's resolution
+void TextureStreamer::DropLevels( Entry& entry, unsigned int level )
+{
+    std::shared_ptr<Texture2D> texture = entry.Texture.lock();
+    if ( !texture || level <= entry.ResidentLevel )
+    {
+        return;
+    }
+
+    // The coarser mips are already on the GPU, so copy them over rather than going back to disk
+    D3D11_TEXTURE2D_DESC desc;
+    texture->_texture->GetDesc( &desc );
+
+    const unsigned int dropped = level - entry.ResidentLevel;
+    desc.Width = std::max( entry.Width >> level, 1U );
+    desc.Height = std::max( entry.Height >> level, 1U );
+    desc.MipLevels -= dropped;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+
+    ID3D11Texture2D* smaller = nullptr;
+    if ( FAILED( _device->CreateTexture2D( &desc, nullptr, &smaller ) ) )
+    {
+        return;
+    }
+    for ( UINT mip = 0; mip < desc.MipLevels; ++mip )
+    {
+        _deviceContext->CopySubresourceRegion( smaller, mip, 0, 0, 0, texture->_texture, mip + dropped, nullptr );
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    ZeroMemory( &srvDesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = desc.MipLevels;
+
+    ID3D11ShaderResourceView* shaderResource = nullptr;
+    if ( FAILED( _device->CreateShaderResourceView( smaller, &srvDesc, &shaderResource ) ) )
+    {
+        ReleaseMacro( smaller );
+        return;
+    }
+
+    _residentBytes += GetLevelBytes( entry, level );
+    _residentBytes -= GetLevelBytes( entry, entry.ResidentLevel );
+    entry.ResidentLevel = level;
+
+    texture->ReplaceResources( smaller, shaderResource, desc.Width, desc.Height );
+}
+
+// Gets the texture memory budget
+size_t TextureStreamer::GetBudget()
+{
+    return _budget;
+}
+
+// Gets the number of bytes a texture uses from the given mip level down
+size_t TextureStreamer::GetLevelBytes( const Entry& entry, unsigned int level )
+{
+    const size_t blockSize = DdsFile::GetBlockSize( entry.Format );
+
+    size_t bytes = 0;
+    for ( unsigned int mip = level; mip < entry.LevelCount; ++mip )
+    {
+        size_t blocksWide = ( std::max( entry.Width >> mip, 1U ) + 3 ) / 4;
+        size_t blocksHigh = ( std::max( entry.Height >> mip, 1U ) + 3 ) / 4;
+        bytes += blocksWide * blocksHigh * blockSize;
+    }
+    return bytes;
+}
+
+// Gets the number of bytes the streamed textures use
+size_t TextureStreamer::GetResidentBytes()
+{
+    return _residentBytes;
+}
+
+// Attempts to initialize the texture streamer
+bool TextureStreamer::Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext )
+{
+    if ( _device )
+    {
+        return true;
+    }
+
+    _device = device;
+    _deviceContext = deviceContext;
+    _isShuttingDown = false;
+    _loader = std::thread( &TextureStreamer::LoaderMain );
+
+    return true;
+}
+
+// Loads the smallest mips of a cooked texture
+std::shared_ptr<Texture2D> TextureStreamer::Load( const std::string& fname )
+{
+    if ( !_device )
+    {
+        return nullptr;
+    }
+
+    Entry entry;
+    if ( !DdsFile::ReadInfo( fname, entry.Width, entry.Height, entry.Format, entry.LevelCount ) )
+    {
+        return nullptr;
+    }
+
+    // Only the mip tail is loaded up front; everything larger is streamed in once it's seen. Any
+    // level down to the tail can become the texture's top level, so each has to be whole blocks
+    entry.TailLevel = 0;
+    while ( entry.TailLevel + 1 < entry.LevelCount && std::max( entry.Width >> entry.TailLevel, entry.Height >> entry.TailLevel ) > TailSize &&
+            DdsFile::IsBlockAligned( entry.Width >> ( entry.TailLevel + 1 ), entry.Height >> ( entry.TailLevel + 1 ) ) )
+    {
+        ++entry.TailLevel;
+    }
+    if ( entry.TailLevel == 0 )
+    {
+        return nullptr;
+    }
+
+    DdsFile file;
+    if ( !file.LoadFromFile( fname, entry.TailLevel ) )
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Texture2D> texture( new (std::nothrow) Texture2D( _device, _deviceContext, file ) );
+    if ( !texture || !texture->_texture )
+    {
+        return nullptr;
+    }
+
+    entry.Texture = texture;
+    entry.Key = texture.get();
+    entry.FileName = fname;
+    entry.ResidentLevel = entry.TailLevel;
+    entry.TargetLevel = entry.TailLevel;
+    entry.PendingLevel = entry.LevelCount;
+    entry.LastRequestFrame = _frame;
+    entry.ScreenSize = 0.0f;
+    entry.IsPinned = false;
+    entry.IsFree = false;
+
+    // Reuse the entry of a texture that has been destroyed, if there is one
+    size_t index = _entries.size();
+    if ( _freeEntries.empty() )
+    {
+        _entries.push_back( entry );
+    }
+    else
+    {
+        index = _freeEntries.back();
+        _freeEntries.pop_back();
+        _entries[ index ] = entry;
+    }
+
+    _residentBytes += GetLevelBytes( entry, entry.TailLevel );
+    _entryLookup[ texture.get() ] = index;
+
+    return texture;
+}
+
+// Runs the loader thread
+void TextureStreamer::LoaderMain()
+{
+    while ( true )
+    {
+        LoadRequest request;
+        {
+            std::unique_lock<std::mutex> lock( _mutex );
+            _requestAdded.wait( lock, []() { return _isShuttingDown || !_requests.empty(); } );
+            if ( _isShuttingDown )
+            {
+                return;
+            }
+            request = _requests.front();
+            _requests.pop_front();
+        }
+
+        // The device is free threaded, so the texture can be created here and just swapped in later
+        LoadResult result;
+        result.Entry = request.Entry;
+        result.Level = request.Level;
+        result.Texture = nullptr;
+        result.ShaderResource = nullptr;
+
+        DdsFile file;
+        if ( file.LoadFromFile( request.FileName, request.Level ) )
+        {
+            Texture2D::CreateResources( _device, file, &result.Texture, &result.ShaderResource );
+        }
+#if defined( _DEBUG ) || defined( DEBUG )
+        else
+        {
+            std::cout << "Failed to stream mip " << request.Level << " of '" << request.FileName << "'" << std::endl;
+        }
+#endif
+
+        std::lock_guard<std::mutex> lock( _mutex );
+        _results.push_back( result );
+    }
+}
+
+// Keeps a streamed texture at full resolution
+void TextureStreamer::Pin( const Texture2D* texture )
+{
+    auto search = _entryLookup.find( texture );
+    if ( search != _entryLookup.end() )
+    {
+        _entries[ search->second ].IsPinned = true;
+    }
+}
+
+// Records how large a texture was drawn this frame
+void TextureStreamer::RequestScreenSize( const Texture2D* texture, float screenSize )
+{
+    auto search = _entryLookup.find( texture );
+    if ( search == _entryLookup.end() )
+    {
+        return;
+    }
+
+    // The first request each frame replaces the size from the last frame it was drawn in
+    Entry& entry = _entries[ search->second ];
+    entry.ScreenSize = ( entry.LastRequestFrame == _frame ) ? std::max( entry.ScreenSize, screenSize ) : screenSize;
+    entry.LastRequestFrame = _frame;
+}
+
+// Forgets a texture that has been destroyed
+void TextureStreamer::ReleaseEntry( size_t index )
+{
+    Entry& entry = _entries[ index ];
+    _residentBytes -= GetLevelBytes( entry, entry.ResidentLevel );
+
+    // A new texture may have been created at the same address since
+    auto search = _entryLookup.find( entry.Key );
+    if ( search != _entryLookup.end() && search->second == index )
+    {
+        _entryLookup.erase( search );
+    }
+
+    entry.Texture.reset();
+    entry.Key = nullptr;
+    entry.FileName.clear();
+    entry.IsFree = true;
+    _freeEntries.push_back( index );
+}
+
+// Sets the texture memory budget
+void TextureStreamer::SetBudget( size_t bytes )
+{
+    _budget = bytes;
+}
+
+// Stops the loader thread and forgets every streamed texture
+void TextureStreamer::Shutdown()
+{
+    if ( !_device )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _isShuttingDown = true;
+    }
+    _requestAdded.notify_all();
+    _loader.join();
+
+    for ( auto& result : _results )
+    {
+        ReleaseMacro( result.ShaderResource );
+        ReleaseMacro( result.Texture );
+    }
+    _results.clear();
+    _requests.clear();
+    _entries.clear();
+    _entryLookup.clear();
+    _freeEntries.clear();
+    _residentBytes = 0;
+    _device = nullptr;
+    _deviceContext = nullptr;
+}
+
+// Applies finished loads and works out every texture's resolution
+void TextureStreamer::Update()
+{
+    if ( !_device )
+    {
+        return;
+    }
+
+    ApplyFinishedLoads();
+
+    // Work out the finest mip each texture can use: one texel per pixel it covers on screen
+    std::vector<size_t> order;
+    std::vector<unsigned int> wantedLevels( _entries.size() );
+    size_t usedBytes = 0;
+    for ( size_t index = 0; index < _entries.size(); ++index )
+    {
+        Entry& entry = _entries[ index ];
+        if ( entry.IsFree )
+        {
+            continue;
+        }
+
+        // Forget destroyed textures once nothing is loading for them anymore
+        if ( entry.Texture.expired() )
+        {
+            if ( entry.PendingLevel == entry.LevelCount )
+            {
+                ReleaseEntry( index );
+            }
+            continue;
+        }
+
+        // Pinned textures always want every mip, and get their share of the budget first. Textures
+        // that haven't been drawn for a while fall back to their tail, but keep their last size
+        unsigned int wanted = entry.TailLevel;
+        if ( entry.IsPinned )
+        {
+            wanted = 0;
+            entry.ScreenSize = FLT_MAX;
+        }
+        else if ( _frame - entry.LastRequestFrame <= FramesUntilIdle )
+        {
+            float ratio = std::max( entry.Width, entry.Height ) / std::max( entry.ScreenSize, 1.0f );
+            wanted = ( ratio <= 1.0f ) ? 0 : std::min( static_cast<unsigned int>( log( ratio ) / log( 2.0f ) ), entry.TailLevel );
+        }
+
+        wantedLevels[ index ] = wanted;
+        usedBytes += GetLevelBytes( entry, entry.TailLevel );
+        order.push_back( index );
+    }
+
+    // Hand out the budget to the textures that are largest on screen first
+    std::sort( order.begin(), order.end(), []( size_t left, size_t right )
+    {
+        return _entries[ left ].ScreenSize > _entries[ right ].ScreenSize;
+    } );
+
+    for ( auto index : order )
+    {
+        Entry& entry = _entries[ index ];
+        const size_t tailBytes = GetLevelBytes( entry, entry.TailLevel );
+
+        unsigned int level = wantedLevels[ index ];
+        while ( level < entry.TailLevel && usedBytes + GetLevelBytes( entry, level ) - tailBytes > _budget )
+        {
+            ++level;
+        }
+        usedBytes += GetLevelBytes( entry, level ) - tailBytes;
+        entry.TargetLevel = level;
+
+        // Finer mips come from disk on the loader thread, coarser ones are copied right away
+        if ( entry.TargetLevel < entry.ResidentLevel && entry.PendingLevel == entry.LevelCount )
+        {
+            entry.PendingLevel = entry.TargetLevel;
+
+            LoadRequest request;
+            request.Entry = index;
+            request.Level = entry.TargetLevel;
+            request.FileName = entry.FileName;
+            {
+                std::lock_guard<std::mutex> lock( _mutex );
+                _requests.push_back( request );
+            }
+            _requestAdded.notify_one();
+        }
+        else if ( entry.TargetLevel > entry.ResidentLevel )
+        {
+            DropLevels( entry, entry.TargetLevel );
+        }
+    }
+
+    ++_frame;
+}
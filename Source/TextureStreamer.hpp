@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Config.hpp"
+#include "Texture2D.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Defines the static texture streamer. Cooked textures start out with only their smallest mips
+/// resident. Each frame, every texture's resolution is raised or lowered based on how large it was
+/// drawn on screen, within a fixed memory budget. Finer mips are read from the cooked files and
+/// created on a background thread, and coarser ones are copied out of the current texture.
+/// </summary>
+class TextureStreamer
+{
+    ImplementStaticClass( TextureStreamer );
+
+    /// <summary>
+    /// Defines a streamed texture.
+    /// </summary>
+    struct Entry
+    {
+        std::weak_ptr<Texture2D> Texture;
+        const Texture2D* Key;
+        std::string FileName;
+        DXGI_FORMAT Format;
+        unsigned int Width;
+        unsigned int Height;
+        unsigned int LevelCount;
+        unsigned int TailLevel;
+        unsigned int ResidentLevel;
+        unsigned int TargetLevel;
+        unsigned int PendingLevel;
+        unsigned int LastRequestFrame;
+        float ScreenSize;
+        bool IsPinned;
+        bool IsFree;
+    };
+
+    /// <summary>
+    /// Defines a request for the loader thread to load a texture from a given mip level down.
+    /// </summary>
+    struct LoadRequest
+    {
+        size_t Entry;
+        unsigned int Level;
+        std::string FileName;
+    };
+
+    /// <summary>
+    /// Defines a texture the loader thread has finished creating.
+    /// </summary>
+    struct LoadResult
+    {
+        size_t Entry;
+        unsigned int Level;
+        ID3D11Texture2D* Texture;
+        ID3D11ShaderResourceView* ShaderResource;
+    };
+
+    static const unsigned int TailSize;
+    static const unsigned int FramesUntilIdle;
+    static const size_t DefaultBudget;
+
+    static ID3D11Device* _device;
+    static ID3D11DeviceContext* _deviceContext;
+    static std::vector<Entry> _entries;
+    static std::unordered_map<const Texture2D*, size_t> _entryLookup;
+    static std::vector<size_t> _freeEntries;
+    static std::thread _loader;
+    static std::mutex _mutex;
+    static std::condition_variable _requestAdded;
+    static std::deque<LoadRequest> _requests;
+    static std::vector<LoadResult> _results;
+    static size_t _budget;
+    static size_t _residentBytes;
+    static unsigned int _frame;
+    static bool _isShuttingDown;
+
+    /// <summary>
+    /// Swaps in the textures the loader thread has finished.
+    /// </summary>
+    static void ApplyFinishedLoads();
+
+    /// <summary>
+    /// Lowers a texture's resolution by copying its coarser mips into a smaller texture.
+    /// </summary>
+    /// <param name="entry">The texture's entry.</param>
+    /// <param name="level">The new first resident mip level.</param>
+    static void DropLevels( Entry& entry, unsigned int level );
+
+    /// <summary>
+    /// Gets the number of bytes a texture uses with the given first resident mip level.
+    /// </summary>
+    /// <param name="entry">The texture's entry.</param>
+    /// <param name="level">The first resident mip level.</param>
+    static size_t GetLevelBytes( const Entry& entry, unsigned int level );
+
+    /// <summary>
+    /// Forgets a texture that has been destroyed, so its entry can be reused.
+    /// </summary>
+    /// <param name="index">The texture's entry index.</param>
+    static void ReleaseEntry( size_t index );
+
+    /// <summary>
+    /// Runs the loader thread.
+    /// </summary>
+    static void LoaderMain();
+
+public:
+    /// <summary>
+    /// Gets the texture memory budget, in bytes.
+    /// </summary>
+    static size_t GetBudget();
+
+    /// <summary>
+    /// Gets the number of bytes the streamed textures currently use.
+    /// </summary>
+    static size_t GetResidentBytes();
+
+    /// <summary>
+    /// Attempts to initialize the texture streamer and start its loader thread.
+    /// </summary>
+    /// <param name="device">The device to create textures on.</param>
+    /// <param name="deviceContext">The device context to copy textures with.</param>
+    static bool Initialize( ID3D11Device* device, ID3D11DeviceContext* deviceContext );
+
+    /// <summary>
+    /// Loads the smallest mips of a cooked texture and starts streaming it. The texture stays at its
+    /// smallest mips until something requests a screen size for it.
+    /// </summary>
+    /// <param name="fname">The cooked DDS file.</param>
+    /// <returns>The texture, or null if the streamer isn't running, the file couldn't be loaded or it has no mips to stream.</returns>
+    static std::shared_ptr<Texture2D> Load( const std::string& fname );
+
+    /// <summary>
+    /// Keeps a streamed texture at full resolution from now on, for when it is shared with
+    /// something that never requests a screen size. Textures that aren't streamed are ignored.
+    /// </summary>
+    /// <param name="texture">The texture.</param>
+    static void Pin( const Texture2D* texture );
+
+    /// <summary>
+    /// Records how large a texture was drawn this frame. Textures that aren't streamed are ignored.
+    /// </summary>
+    /// <param name="texture">The texture.</param>
+    /// <param name="screenSize">The size of the surface the texture covers, in pixels.</param>
+    static void RequestScreenSize( const Texture2D* texture, float screenSize );
+
+    /// <summary>
+    /// Sets the texture memory budget.
+    /// </summary>
+    /// <param name="bytes">The budget, in bytes.</param>
+    static void SetBudget( size_t bytes );
+
+    /// <summary>
+    /// Stops the loader thread and forgets every streamed texture.
+    /// </summary>
+    static void Shutdown();
+
+    /// <summary>
+    /// Applies finished loads, then works out every texture's resolution for the next frame.
+    /// </summary>
+    static void Update();
+};
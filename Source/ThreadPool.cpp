@@ -0,0 +1,143 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <assert.h>
+
+std::vector<std::thread>                        ThreadPool::_workers;
+std::mutex                                      ThreadPool::_mutex;
+std::condition_variable                         ThreadPool::_jobStarted;
+std::condition_variable                         ThreadPool::_jobFinished;
+const std::function<void( size_t, size_t )>*    ThreadPool::_job = nullptr;
+size_t                                          ThreadPool::_jobCount = 0;
+size_t                                          ThreadPool::_jobGrainSize = 1;
+std::atomic<size_t>                             ThreadPool::_nextIndex;
+unsigned int                                    ThreadPool::_busyWorkers = 0;
+unsigned int                                    ThreadPool::_jobGeneration = 0;
+bool                                            ThreadPool::_isShuttingDown = false;
+
+// Gets the number of threads work is spread across
+unsigned int ThreadPool::GetThreadCount()
+{
+    return static_cast<unsigned int>( _workers.size() ) + 1;
+}
+
+// Attempts to start the worker threads
+bool ThreadPool::Initialize( unsigned int workerCount )
+{
+    if ( !_workers.empty() )
+    {
+        return true;
+    }
+
+    // Leave one core for the calling thread
+    if ( workerCount == 0 )
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        workerCount = ( cores > 1 ) ? cores - 1 : 0;
+    }
+
+    _isShuttingDown = false;
+    _nextIndex = 0;
+    for ( unsigned int index = 0; index < workerCount; ++index )
+    {
+        _workers.push_back( std::thread( &ThreadPool::WorkerMain ) );
+    }
+
+    return true;
+}
+
+// Calls the given function on chunks of the range across every thread
+void ThreadPool::ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t, size_t )>& body )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+    grainSize = std::max<size_t>( grainSize, 1 );
+
+    // Small jobs (or having no workers) aren't worth waking anybody up for
+    if ( _workers.empty() || count <= grainSize )
+    {
+        body( 0, count );
+        return;
+    }
+
+    // Publish the job and wake the workers
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        assert( _job == nullptr && "ThreadPool::ParallelFor cannot be nested" );
+        _job = &body;
+        _jobCount = count;
+        _jobGrainSize = grainSize;
+        _nextIndex = 0;
+        _busyWorkers = static_cast<unsigned int>( _workers.size() );
+        ++_jobGeneration;
+    }
+    _jobStarted.notify_all();
+
+    // Help out, then wait for everybody else to finish
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock( _mutex );
+    _jobFinished.wait( lock, []() { return _busyWorkers == 0; } );
+    _job = nullptr;
+}
+
+// Runs chunks of the current job until there are none left
+void ThreadPool::RunChunks()
+{
+    while ( true )
+    {
+        size_t begin = _nextIndex.fetch_add( _jobGrainSize );
+        if ( begin >= _jobCount )
+        {
+            break;
+        }
+
+        size_t end = std::min( begin + _jobGrainSize, _jobCount );
+        ( *_job )( begin, end );
+    }
+}
+
+// Stops and joins all of the worker threads
+void ThreadPool::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _isShuttingDown = true;
+    }
+    _jobStarted.notify_all();
+
+    for ( auto& worker : _workers )
+    {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+// The entry point of each worker thread
+void ThreadPool::WorkerMain()
+{
+    unsigned int lastGeneration = 0;
+    while ( true )
+    {
+        // Wait for a new job (or to be told to stop)
+        {
+            std::unique_lock<std::mutex> lock( _mutex );
+            _jobStarted.wait( lock, [ &lastGeneration ]() { return _isShuttingDown || _jobGeneration != lastGeneration; } );
+            if ( _isShuttingDown )
+            {
+                return;
+            }
+            lastGeneration = _jobGeneration;
+        }
+
+        RunChunks();
+
+        // Let the calling thread know once the last worker is done
+        std::lock_guard<std::mutex> lock( _mutex );
+        if ( --_busyWorkers == 0 )
+        {
+            _jobFinished.notify_one();
+        }
+    }
+}
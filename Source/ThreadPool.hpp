@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Config.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Defines the static thread pool used to spread work across the CPU's cores.
+/// </summary>
+class ThreadPool
+{
+    ImplementStaticClass( ThreadPool );
+
+    static std::vector<std::thread> _workers;
+    static std::mutex _mutex;
+    static std::condition_variable _jobStarted;
+    static std::condition_variable _jobFinished;
+    static const std::function<void( size_t, size_t )>* _job;
+    static size_t _jobCount;
+    static size_t _jobGrainSize;
+    static std::atomic<size_t> _nextIndex;
+    static unsigned int _busyWorkers;
+    static unsigned int _jobGeneration;
+    static bool _isShuttingDown;
+
+    /// <summary>
+    /// Runs chunks of the current job until there are none left.
+    /// </summary>
+    static void RunChunks();
+
+    /// <summary>
+    /// The entry point of each worker thread.
+    /// </summary>
+    static void WorkerMain();
+
+public:
+    /// <summary>
+    /// Gets the number of threads that work is spread across, including the calling thread.
+    /// </summary>
+    static unsigned int GetThreadCount();
+
+    /// <summary>
+    /// Attempts to start the worker threads.
+    /// </summary>
+    /// <param name="workerCount">The number of worker threads, or 0 to use one less than the number of cores.</param>
+    static bool Initialize( unsigned int workerCount = 0 );
+
+    /// <summary>
+    /// Calls the given function on chunks of the range [0, count) across every thread, and waits
+    /// for all of them to finish. The calling thread works on chunks too.
+    /// </summary>
+    /// <param name="count">The number of items.</param>
+    /// <param name="grainSize">The number of items in each chunk.</param>
+    /// <param name="body">The function to call with the start and end of each chunk.</param>
+    static void ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t, size_t )>& body );
+
+    /// <summary>
+    /// Stops and joins all of the worker threads.
+    /// </summary>
+    static void Shutdown();
+};
@@ -0,0 +1,79 @@
+#include "Utf8.hpp"
+
+const unsigned int Utf8::ReplacementCharacter = 0xFFFD;
+
+// Decodes the codepoint starting at the given index
+unsigned int Utf8::DecodeNext( const std::string& text, size_t& index )
+{
+    unsigned char lead = static_cast<unsigned char>( text[ index++ ] );
+
+    // Plain ASCII is by far the most common case
+    if ( lead < 0x80 )
+    {
+        return lead;
+    }
+
+    // Get the number of continuation bytes and the payload bits of the lead byte
+    unsigned int codepoint = 0;
+    unsigned int continuations = 0;
+    if ( ( lead & 0xE0 ) == 0xC0 )
+    {
+        codepoint = lead & 0x1F;
+        continuations = 1;
+    }
+    else if ( ( lead & 0xF0 ) == 0xE0 )
+    {
+        codepoint = lead & 0x0F;
+        continuations = 2;
+    }
+    else if ( ( lead & 0xF8 ) == 0xF0 )
+    {
+        codepoint = lead & 0x07;
+        continuations = 3;
+    }
+    else
+    {
+        // A stray continuation byte or an invalid lead byte
+        return ReplacementCharacter;
+    }
+
+    // Now read the continuation bytes, stopping at the first one that doesn't belong
+    for ( unsigned int count = 0; count < continuations; ++count )
+    {
+        if ( index >= text.length() )
+        {
+            return ReplacementCharacter;
+        }
+
+        unsigned char next = static_cast<unsigned char>( text[ index ] );
+        if ( ( next & 0xC0 ) != 0x80 )
+        {
+            return ReplacementCharacter;
+        }
+
+        codepoint = ( codepoint << 6 ) | ( next & 0x3F );
+        ++index;
+    }
+
+    // Reject overlong encodings, surrogates, and anything past the end of Unicode
+    static const unsigned int MinimumCodepoint[ 4 ] = { 0, 0x80, 0x800, 0x10000 };
+    if ( codepoint < MinimumCodepoint[ continuations ] || codepoint > 0x10FFFF || ( codepoint >= 0xD800 && codepoint <= 0xDFFF ) )
+    {
+        return ReplacementCharacter;
+    }
+
+    return codepoint;
+}
+
+// Decodes an entire string into codepoints
+void Utf8::Decode( const std::string& text, std::vector<unsigned int>& codepoints )
+{
+    codepoints.clear();
+    codepoints.reserve( text.length() );
+
+    size_t index = 0;
+    while ( index < text.length() )
+    {
+        codepoints.push_back( DecodeNext( text, index ) );
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Config.hpp"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Defines a static class for decoding UTF-8 text.
+/// </summary>
+class Utf8
+{
+    ImplementStaticClass( Utf8 );
+
+public:
+    /// <summary>
+    /// The codepoint that invalid or truncated sequences decode to.
+    /// </summary>
+    static const unsigned int ReplacementCharacter;
+
+    /// <summary>
+    /// Decodes the codepoint starting at the given index, then advances the index past it.
+    /// </summary>
+    /// <param name="text">The UTF-8 text.</param>
+    /// <param name="index">The index of the first byte of the codepoint.</param>
+    static unsigned int DecodeNext( const std::string& text, size_t& index );
+
+    /// <summary>
+    /// Decodes an entire string into codepoints.
+    /// </summary>
+    /// <param name="text">The UTF-8 text.</param>
+    /// <param name="codepoints">The vector to fill with codepoints.</param>
+    static void Decode( const std::string& text, std::vector<unsigned int>& codepoints );
+};
@@ -14,11 +14,35 @@ struct Vertex
 };
 
 /// <summary>
-/// Defines a vertex used for the line renderer.
+/// An enumeration of the vertex formats a mesh's vertices can be stored in.
+/// </summary>
+enum class VertexFormat
+{
+    Standard,
+    Compact
+};
+
+/// <summary>
+/// Defines a compact vertex in a mesh. Positions are 16-bit fixed point within the mesh's bounds,
+/// UVs are half floats, and normals and tangents are octahedral encoded into two 16-bit signed
+/// normalized values each. This is 20 bytes, compared to the 44 bytes of a standard vertex.
+/// </summary>
+struct CompactVertex
+{
+    unsigned int PositionXY;
+    unsigned int PositionZ;
+    unsigned int UV;
+    unsigned int Normal;
+    unsigned int Tangent;
+};
+
+/// <summary>
+/// Defines a vertex used for batched lines.
 /// </summary>
 struct LineVertex
 {
-    DirectX::XMFLOAT2 Position;
+    DirectX::XMFLOAT3 Position;
+    DirectX::XMFLOAT4 Color;
 };
 
 struct ParticleVertex
@@ -40,6 +64,7 @@ struct TextVertex
 {
     DirectX::XMFLOAT2 Position;
     DirectX::XMFLOAT2 UV;
+    DirectX::XMFLOAT4 Color;
 
     TextVertex()
         : TextVertex( 0, 0, 0, 0 )
@@ -49,6 +74,14 @@ struct TextVertex
     TextVertex( float x, float y, float u, float v )
         : Position( x, y )
         , UV( u, v )
+        , Color( 1, 1, 1, 1 )
+    {
+    }
+
+    TextVertex( float x, float y, float u, float v, const DirectX::XMFLOAT4& color )
+        : Position( x, y )
+        , UV( u, v )
+        , Color( color )
     {
     }
 };